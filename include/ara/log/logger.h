@@ -19,6 +19,7 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 
 #include "ara/log/common.h"
@@ -246,10 +247,24 @@ public:
      *  @brief Output log text by using Logger  directly.
      * 
      *  @details You can output string logs by using specified log level
-     *   according to a format as printf
+     *   according to a format as printf. The text is formatted directly into
+     *   the payload of a message owned by the call, so it is safe to call
+     *   from several threads at the same time.
+	 *  
+	 */
+    void syslog(LogLevel loglv, const char* fmt,...) __attribute__((format(printf, 3, 4)));
+
+	/*! 
+     *  @brief Output a printf style log in non-verbose mode.
+     * 
+     *  @details The arguments are sent unformatted together with the message id,
+     *   the viewer maps the id to fmt and does the formatting.
 	 *  
+     *  @param loglv the log level of the message
+     *  @param msgId the message id identifying fmt
+     *  @param fmt the format string, only used to know the types of the arguments
 	 */
-    void syslog(LogLevel loglv, const char* fmt,...);
+    void syslogId(LogLevel loglv, uint32_t msgId, const char* fmt,...) __attribute__((format(printf, 4, 5)));
 
     /*! 
      *  @brief Output log text by using Logger  directly.
@@ -319,7 +334,7 @@ private:
     std::unique_ptr<Impl> pImpl; /*!<  @brief the instance of Logger */
 
 private:
-    std::map<LogLevel, LogStream*> m_logstreams;    /*!<   @brief The LogStream object owned by this Logger*/
+    std::map<LogLevel, LogStream*> m_logstreams;    /*!<   @brief Unused, kept for the binary layout of Logger */
 
 };
 
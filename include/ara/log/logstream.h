@@ -21,6 +21,7 @@
 #include <string>
 #include <type_traits>
 #include <deque>
+#include <mutex>
 
 #include "ara/log/common.h"
 #include "ara/log/logging.h"
@@ -31,6 +32,7 @@ namespace log {
 extern bool g_LoggingInit;
 extern int g_BufferSize;
 extern std::deque<void*> g_LogBuffer;
+extern std::mutex g_LogBufferMutex;
 
 class Logger; /*!< forward declare Logger class */
 
@@ -387,6 +389,23 @@ class LogStream final {
   // TODO
   LogStream& operator<<(core::Span<const core::Byte> value) noexcept;
 
+  /*!
+   *  @brief Writes a string or raw value directly from its buffer.
+   *
+   *  @details A value which does not fit into the current message is split
+   * over several messages. Each of them ends with a DltSegmentMarker carrying
+   * the same process and sequence id, so dlt-receive and dlt-convert can
+   * reassemble it. Before logging is initialised only the first part is kept
+   * and its marker is flagged as truncated.
+   *
+   *  @param data the value
+   *  @param size the size of the value in bytes
+   *  @param isString true for an utf8 string, false for raw data
+   *
+   *  @return None
+   */
+  void WriteSegmented(const char* data, size_t size, bool isString) noexcept;
+
   internal::LogReturnValue logRet_{
       internal::LogReturnValue::kReturnOk}; /*!< Inner log status */
   void* logLocalData_ = nullptr;                      /*! context data buffer */
@@ -209,6 +209,24 @@ DltReturnValue dlt_client_get_default_log_level(DltClient *client);
  * @return negative value if there was an error
  */
 int dlt_client_get_software_version(DltClient *client);
+/**
+ * Send an request to get the latency stats of stamped log messages to the dlt daemon
+ * @param client pointer to dlt client structure
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_client_get_latency_stats(DltClient *client);
+/**
+ * Send an request to get the runtime metrics to the dlt daemon
+ * @param client pointer to dlt client structure
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_client_get_metrics(DltClient *client);
+/**
+ * Send an request to get the rate limits and their dropped messages to the dlt daemon
+ * @param client pointer to dlt client structure
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_client_get_rate_limit_status(DltClient *client);
 /**
  * Initialise get log info structure
  * @return void
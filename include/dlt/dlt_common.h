@@ -637,6 +637,85 @@ typedef struct
     uint32_t overflow_counter;      /**< overflow counter */
 } DLT_PACKED DltServiceMessageBufferOverflowResponse;
 
+/**
+ * The structure of one rate limit in the Get Rate Limit Status response
+ */
+typedef struct
+{
+    char apid[DLT_ID_SIZE];         /**< application id */
+    char ctid[DLT_ID_SIZE];         /**< context id, empty if the limit is for the whole application */
+    uint32_t rate;                  /**< messages per second */
+    uint32_t burst;                 /**< maximum number of messages at once */
+    uint32_t dropped;               /**< number of messages dropped by the daemon */
+    uint32_t user_dropped;          /**< number of messages dropped by the applications */
+} DLT_PACKED DltServiceRateLimitInfo;
+
+/**
+ * The structure of the Get Rate Limit Status response,
+ * count DltServiceRateLimitInfo follow
+ */
+typedef struct
+{
+    uint32_t service_id;            /**< service ID */
+    uint8_t status;                 /**< reponse status */
+    uint32_t count;                 /**< number of rate limits */
+} DLT_PACKED DltServiceGetRateLimitStatusResponse;
+
+/**
+ * The stages of the latency trace of a log message
+ */
+typedef enum
+{
+    DLT_LATENCY_STAGE_RECEIVE = 0,  /**< application buffers and FIFO until the daemon received it */
+    DLT_LATENCY_STAGE_PARSE,        /**< parsing and rate limit */
+    DLT_LATENCY_STAGE_ROUTE,        /**< offline trace and offline logstorage */
+    DLT_LATENCY_STAGE_SEND,         /**< client sockets, egress queue or client ring buffer */
+    DLT_LATENCY_STAGE_TOTAL,        /**< from the application until sent */
+    DLT_LATENCY_STAGE_COUNT
+} DltLatencyStage;
+
+/**
+ * The latency of one stage in the Get Latency Stats response, in ns
+ */
+typedef struct
+{
+    uint32_t count;                 /**< number of messages */
+    uint64_t p50;                   /**< median */
+    uint64_t p99;                   /**< 99th percentile */
+    uint64_t max;                   /**< maximum */
+} DLT_PACKED DltServiceLatencyStage;
+
+/**
+ * The latency of the messages of one application in the Get Latency Stats response
+ */
+typedef struct
+{
+    char apid[DLT_ID_SIZE];                                 /**< application id */
+    DltServiceLatencyStage stages[DLT_LATENCY_STAGE_COUNT]; /**< latency per stage */
+} DLT_PACKED DltServiceLatencyInfo;
+
+/**
+ * The structure of the Get Latency Stats response,
+ * count DltServiceLatencyInfo follow
+ */
+typedef struct
+{
+    uint32_t service_id;            /**< service ID */
+    uint8_t status;                 /**< reponse status */
+    uint32_t count;                 /**< number of applications */
+} DLT_PACKED DltServiceGetLatencyStatsResponse;
+
+/**
+ * The structure of the Get Metrics response,
+ * length bytes of metrics in the Prometheus text format follow
+ */
+typedef struct
+{
+    uint32_t service_id;            /**< service ID */
+    uint8_t status;                 /**< reponse status */
+    uint32_t length;                /**< length of the text */
+} DLT_PACKED DltServiceGetMetricsResponse;
+
 typedef struct
 {
     uint32_t service_id;            /**< service ID */
@@ -764,9 +843,79 @@ typedef struct sDltFile
 
     /* current loaded message */
     DltMessage msg;     /**< pointer to message */
-
 } DltFile;
 
+#   define DLT_SEGMENT_MAGIC "DSEG"        /**< magic of the segment marker */
+#   define DLT_SEGMENT_FLAG_LAST 0x0001    /**< set in the marker of the last message of a value */
+#   define DLT_SEGMENT_FLAG_TRUNCATED 0x0002 /**< set with DLT_SEGMENT_FLAG_LAST if the rest of the value was not sent */
+#   define DLT_SEGMENT_MAX_PENDING 16      /**< values reassembled at the same time */
+#   define DLT_SEGMENT_HEADER_SIZE 256     /**< size of the header text of a reassembled value */
+
+/**
+ * The marker which is written as last raw argument into each message of a
+ * value split over several log messages. The following messages only hold
+ * the next part of the value. pid, seq, index and flags are in the byte
+ * order of the message.
+ */
+typedef struct
+{
+    char magic[4];      /**< DLT_SEGMENT_MAGIC */
+    uint32_t pid;       /**< process id of the writer, seq is counted per process */
+    uint32_t seq;       /**< sequence id of the value, the same in all its messages */
+    uint16_t index;     /**< index of the message within the value, starting at 0 */
+    uint16_t flags;     /**< DLT_SEGMENT_FLAG_LAST in the last message, DLT_SEGMENT_FLAG_TRUNCATED */
+} DLT_PACKED DltSegmentMarker;
+
+/**
+ * A value which is reassembled from its messages.
+ */
+typedef struct
+{
+    int used;                                   /**< 1 while the value is reassembled */
+    char ecu[DLT_ID_SIZE];                      /**< ecu id of the messages */
+    char apid[DLT_ID_SIZE];                     /**< application id of the messages */
+    char ctid[DLT_ID_SIZE];                     /**< context id of the messages */
+    uint32_t pid;                               /**< process id of the writer */
+    uint32_t seq;                               /**< sequence id of the value */
+    uint16_t next;                              /**< index of the next expected message */
+    int truncated;                              /**< 1 if the rest of the value was not sent */
+    char header[DLT_SEGMENT_HEADER_SIZE];       /**< header of the first message as text */
+    char *text;                                 /**< payload of the messages as text */
+    size_t length;                              /**< length of text */
+    size_t size;                                /**< allocated size of text */
+} DltSegment;
+
+/**
+ * The structure to reassemble segmented values when printing messages.
+ */
+typedef struct
+{
+    DltSegment segments[DLT_SEGMENT_MAX_PENDING]; /**< values being reassembled */
+    int evict;                                  /**< segment replaced if all are used */
+    char *scratch;                              /**< payload text of one message */
+    size_t scratch_size;                        /**< allocated size of scratch */
+} DltSegmentBuffer;
+
+/**
+ * A syslog message in RFC 3164 or RFC 5424 format, split by
+ * dlt_syslog_parse(). The strings point into the parsed data and are not
+ * terminated, a missing field has length 0.
+ */
+typedef struct
+{
+    int severity;               /**< severity of the PRI part, -1 if the message has none */
+    int facility;               /**< facility of the PRI part, -1 if the message has none */
+    int has_time;               /**< 1 if the message has a timestamp */
+    time_t time;                /**< timestamp, seconds since the epoch */
+    uint32_t usec;              /**< microseconds of the timestamp */
+    const char *hostname;       /**< hostname */
+    uint16_t hostname_length;   /**< length of hostname */
+    const char *tag;            /**< tag or app name, without the pid */
+    uint16_t tag_length;        /**< length of tag */
+    const char *text;           /**< message text */
+    uint16_t text_length;       /**< length of text */
+} DltSyslogMessage;
+
 /**
  * The structure is used to organise the receiving of data
  * including buffer handling.
@@ -1167,6 +1316,72 @@ DltReturnValue dlt_file_message(DltFile *file, int index, int verbose);
  */
 DltReturnValue dlt_file_free(DltFile *file, int verbose);
 
+/**
+ * 检查消息是否以分段标记结尾。
+ * @param msg pointer to structure of organising access to DLT messages
+ * @param marker filled with the marker in host byte order, can be NULL
+ * @return 1 = message ends with a segment marker, 0 = it does not, negative value if there was an error
+ */
+DltReturnValue dlt_message_get_segment(DltMessage *msg, DltSegmentMarker *marker);
+/**
+ * 初始化用于重组分段值的结构。
+ * @param segments pointer to structure of reassembling segmented values
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_segment_init(DltSegmentBuffer *segments);
+/**
+ * 添加一条消息，若其属于分段值则重组。
+ * A message without segment marker is left to the caller to print. The
+ * header and payload text of a complete value stay valid until the next call.
+ * A value whose messages are missing is dropped.
+ * @param segments pointer to structure of reassembling segmented values
+ * @param msg pointer to structure of organising access to DLT messages
+ * @param complete set to the reassembled value once its last message is added, else NULL
+ * @param verbose if set to true verbose information is printed out.
+ * @return 1 = message was added to a value, 0 = message is not segmented, negative value if there was an error
+ */
+DltReturnValue dlt_segment_add(DltSegmentBuffer *segments, DltMessage *msg, DltSegment **complete, int verbose);
+/**
+ * 取出一个尚未完成的分段值。
+ * Used at the end of the input to print the values whose last message did
+ * not arrive. Each call returns one of them, marked as truncated, which
+ * stays valid until the next call.
+ * @param segments pointer to structure of reassembling segmented values
+ * @param pending set to an unfinished value, else NULL
+ * @return 1 = pending is set, 0 = no unfinished value is left, negative value if there was an error
+ */
+DltReturnValue dlt_segment_get_pending(DltSegmentBuffer *segments, DltSegment **pending);
+/**
+ * 释放用于重组分段值的内存。
+ * @param segments pointer to structure of reassembling segmented values
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_segment_free(DltSegmentBuffer *segments);
+/**
+ * 解析 RFC 3164 或 RFC 5424 格式的 syslog 消息。
+ * A message which cannot be parsed is returned as text with severity -1.
+ * Trailing line breaks are removed from the text.
+ * @param data the received message
+ * @param size length of data
+ * @param msg filled with the fields of the message
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_syslog_parse(const char *data, int size, DltSyslogMessage *msg);
+/**
+ * 将 syslog 严重级别映射为 DLT 日志级别。
+ * @param severity severity of the PRI part, -1 if the message has none
+ * @return the DLT log level, DLT_LOG_INFO if severity is unknown
+ */
+DltLogLevelType dlt_syslog_get_log_level(int severity);
+/**
+ * 将 syslog 消息的时间戳转换为 DLT 时间戳。
+ * The wall clock time is converted to the time since boot, using the
+ * current offset between both clocks.
+ * @param msg the parsed message
+ * @return timestamp in 0.1 milliseconds since boot, 0 if the message has no timestamp or it is out of range
+ */
+uint32_t dlt_syslog_get_timestamp(const DltSyslogMessage *msg);
+
 /**
  * 设置内部日志文件名，如果模式2
  * @param filename the filename
@@ -0,0 +1,205 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_compressed_file.h
+ */
+
+#ifndef DLT_COMPRESSED_FILE_H
+#define DLT_COMPRESSED_FILE_H
+
+/*
+ * Block compressed DLT file
+ *
+ * The stored messages (storage header and message) are cut into blocks of
+ * about DLT_COMPRESSED_BLOCK_SIZE bytes, a message is never split over two
+ * blocks. Each block is compressed on its own, so a reader only inflates the
+ * blocks it needs. All numbers are little endian.
+ *
+ *   DltCompressedFileHeader
+ *   DltCompressedBlockHeader, compressed data    (for each block)
+ *   DltCompressedBlockIndex                      (for each block)
+ *   DltCompressedFileFooter
+ *
+ * The index at the end holds the number of messages, the time range and
+ * a bitmap of the application ids of each block. A file without
+ * index, e.g. because the writer was killed, can still be read, its blocks
+ * are found by walking the block headers.
+ *
+ * ECU ids are not indexed. A trace file usually holds the messages of one
+ * ECU, so a bitmap of them would hardly ever rule out a block; filters on
+ * ECU ids are checked per message by the readers.
+ *
+ * dlt_file_open() recognizes these files and reads them like plain DLT
+ * files, positions and file length are those of the uncompressed messages.
+ */
+
+#include <stdint.h>
+
+#include "dlt_common.h"
+
+#define DLT_COMPRESSED_FILE_MAGIC "DLTZ"   /**< magic of the file header */
+#define DLT_COMPRESSED_BLOCK_MAGIC "DLTB"  /**< magic of each block header */
+#define DLT_COMPRESSED_INDEX_MAGIC "DLTI"  /**< magic of the footer */
+#define DLT_COMPRESSED_FILE_VERSION 1
+
+#define DLT_COMPRESSED_CODEC_ZLIB 1        /**< blocks are zlib streams */
+
+/* Size of the uncompressed data of a block */
+#define DLT_COMPRESSED_BLOCK_SIZE (256 * 1024)
+
+/* Bits of the application id bitmap of a block */
+#define DLT_COMPRESSED_BITMAP_BITS 256
+#define DLT_COMPRESSED_BITMAP_WORDS (DLT_COMPRESSED_BITMAP_BITS / 64)
+
+typedef struct
+{
+    char magic[4];           /**< DLT_COMPRESSED_FILE_MAGIC */
+    uint8_t version;         /**< DLT_COMPRESSED_FILE_VERSION */
+    uint8_t codec;           /**< compression of the blocks */
+    uint16_t reserved;
+    uint32_t block_size;     /**< size of the uncompressed data of a block */
+} DLT_PACKED DltCompressedFileHeader;
+
+typedef struct
+{
+    char magic[4];           /**< DLT_COMPRESSED_BLOCK_MAGIC */
+    uint32_t size;           /**< size of the compressed data following */
+    uint32_t length;         /**< size of the uncompressed data */
+} DLT_PACKED DltCompressedBlockHeader;
+
+typedef struct
+{
+    uint64_t offset;         /**< file position of the block header */
+    uint64_t time_min;       /**< earliest storage header time, in us since the epoch */
+    uint64_t time_max;       /**< latest storage header time, in us since the epoch */
+    uint32_t size;           /**< size of the compressed data */
+    uint32_t length;         /**< size of the uncompressed data */
+    uint32_t messages;       /**< number of messages */
+    uint32_t reserved;
+    uint64_t apid[DLT_COMPRESSED_BITMAP_WORDS]; /**< bitmap of the application ids */
+} DLT_PACKED DltCompressedBlockIndex;
+
+typedef struct
+{
+    uint64_t index;          /**< file position of the first DltCompressedBlockIndex */
+    uint32_t blocks;         /**< number of blocks */
+    char magic[4];           /**< DLT_COMPRESSED_INDEX_MAGIC */
+} DLT_PACKED DltCompressedFileFooter;
+
+/**
+ * Writer of a block compressed DLT file.
+ */
+typedef struct
+{
+    int fd;                          /**< output file */
+    uint64_t offset;                 /**< bytes written to the file */
+    uint8_t *block;                  /**< uncompressed data of the current block */
+    uint32_t used;                   /**< bytes used in block */
+    uint8_t *output;                 /**< compressed data of the current block */
+    unsigned long output_size;       /**< size of output */
+    DltCompressedBlockIndex current; /**< index of the current block */
+    DltCompressedBlockIndex *index;  /**< index of the written blocks */
+    uint32_t blocks;                 /**< number of written blocks */
+    uint32_t index_size;             /**< entries allocated in index */
+} DltCompressedWriter;
+
+/**
+ * 开始向文件写入块压缩的DLT消息。
+ * The file header is written at the start of the file.
+ * @param writer pointer to the writer
+ * @param fd file descriptor of the output file, opened for writing
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_compressed_writer_init(DltCompressedWriter *writer, int fd);
+
+/**
+ * 写入一条存储的消息。
+ * The message is given in up to three parts, the first part starts with the
+ * storage header.
+ * @param writer pointer to the writer
+ * @param data1 pointer to first data block to be written
+ * @param size1 size in bytes of first data block to be written
+ * @param data2 pointer to second data block to be written, null if not used
+ * @param size2 size in bytes of second data block to be written, 0 if not used
+ * @param data3 pointer to third data block to be written, null if not used
+ * @param size3 size in bytes of third data block to be written, 0 if not used
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_compressed_writer_add(DltCompressedWriter *writer,
+                                         const uint8_t *data1,
+                                         int size1,
+                                         const uint8_t *data2,
+                                         int size2,
+                                         const uint8_t *data3,
+                                         int size3);
+
+/**
+ * 写入连续存储的多条完整消息。
+ * @param writer pointer to the writer
+ * @param data messages, each starting with its storage header
+ * @param size size of all messages
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_compressed_writer_write(DltCompressedWriter *writer, const uint8_t *data, size_t size);
+
+/**
+ * 获取文件当前的大小。
+ * The data of the current block is counted uncompressed.
+ * @param writer pointer to the writer
+ * @return size in bytes
+ */
+uint64_t dlt_compressed_writer_size(DltCompressedWriter *writer);
+
+/**
+ * 写入最后一个块和索引，并释放写入器。
+ * The file is truncated behind the index, the file descriptor stays open.
+ * @param writer pointer to the writer
+ * @return negative value if there was an error
+ */
+DltReturnValue dlt_compressed_writer_close(DltCompressedWriter *writer);
+
+/**
+ * 打开块压缩的DLT文件进行读取。
+ * Called by dlt_file_open() when the file starts with DLT_COMPRESSED_FILE_MAGIC.
+ * The block index is kept with the stream until the stream is closed.
+ * @param raw compressed file, closed by the returned stream
+ * @param verbose if set to true verbose information is printed out.
+ * @return stream of the uncompressed messages, NULL if there was an error
+ */
+FILE *dlt_compressed_file_open(FILE *raw, int verbose);
+
+/**
+ * 跳过不包含匹配消息的块。
+ * Starting at the current position of the file, all blocks are skipped
+ * which contain none of the application ids of the filter or no message in
+ * the time range. The skipped messages are counted in counter_total.
+ * Nothing is done for plain DLT files or when the position is inside a
+ * block.
+ * @param file pointer to structure of organising access to DLT file
+ * @param filter application ids to look for, NULL or a filter with an empty application id matches all
+ * @param time_begin start of the time range in us since the epoch, 0 for no start
+ * @param time_end end of the time range in us since the epoch, 0 for no end
+ * @param verbose if set to true verbose information is printed out.
+ * @return number of skipped blocks, negative value if there was an error
+ */
+int dlt_compressed_file_skip(DltFile *file,
+                             const DltFilter *filter,
+                             uint64_t time_begin,
+                             uint64_t time_end,
+                             int verbose);
+
+#endif /* DLT_COMPRESSED_FILE_H */
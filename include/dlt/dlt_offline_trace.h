@@ -58,6 +58,7 @@
 #include <limits.h>
 
 #include "dlt_types.h"
+#include "dlt_compressed_file.h"
 
 #define DLT_OFFLINETRACE_FILENAME_BASE "dlt_offlinetrace"
 #define DLT_OFFLINETRACE_FILENAME_INDEX_DELI "."
@@ -72,6 +73,8 @@ typedef struct
     int maxSize;                 /**< (int) Maximum size of all trace files (Default: 4000000) */
     int filenameTimestampBased;  /**< (int) timestamp based or index based (Default: 1 Timestamp based) */
     int ohandle;
+    int compressed;              /**< (int) write block compressed files, set before dlt_offline_trace_init() (Default: 0) */
+    DltCompressedWriter writer;  /**< writer of the current file if compressed */
 } DltOfflineTrace;
 
 /**
@@ -216,6 +216,9 @@ enum dlt_user_services {
     DLT_SERVICE_ID_RESERVED_C = 0xF0C,
     DLT_SERVICE_ID_RESERVED_D = 0xF0D,
     DLT_SERVICE_ID_RESERVED_E = 0xF0E,
+    DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS = 0xF0F,
+    DLT_SERVICE_ID_GET_LATENCY_STATS = 0xF10,
+    DLT_SERVICE_ID_GET_METRICS = 0xF11,
     DLT_USER_SERVICE_ID_LAST_ENTRY
 };
 
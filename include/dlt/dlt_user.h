@@ -88,6 +88,7 @@
 #endif
 
 #   include <pthread.h>
+#   include <stdarg.h>
 
 #   if !defined (__WIN32__)
 #      include <semaphore.h>
@@ -245,6 +246,7 @@ typedef struct
     int8_t enable_local_print;                 /**< Local printing of log messages: 1 enabled, 0 disabled */
     int8_t local_print_mode;                   /**< Local print mode, controlled by environment variable */
     int8_t disable_injection_msg;               /**< Injection msg availability: 1 disabled, 0 enabled (default) */
+    int8_t latency_trace;                      /**< Stamp log messages for latency tracing: 1 enabled, 0 disabled (default) */
 
     int8_t log_state;                          /**< Log state of external connection:
                                                 * 1 client connected,
@@ -759,6 +761,34 @@ DltReturnValue dlt_user_log_write_constant_utf8_string_attr(DltContextData *log,
  */
 DltReturnValue dlt_user_log_write_sized_constant_utf8_string_attr(DltContextData *log, const char *text, uint16_t length, const char *name);
 
+/**
+ * Format a printf-style UTF8 string directly into the payload buffer of a DLT log message.
+ * No intermediate buffer is used; the output is truncated like dlt_user_log_write_utf8_string
+ * when it does not fit into the remaining payload.
+ * dlt_user_log_write_start has to be called before adding any attributes to the log message.
+ * Finish sending log message by calling dlt_user_log_write_finish.
+ * @param log pointer to an object containing information about logging context data
+ * @param format printf-style format string
+ * @param args arguments referenced by @a format
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_user_log_write_vprintf(DltContextData *log, const char *format, va_list args);
+
+/**
+ * Write the arguments of a printf-style format string as separate DLT arguments,
+ * without formatting them. Intended for non-verbose messages started with
+ * dlt_user_log_write_start_id, where the message id identifies the format string
+ * and the viewer does the formatting.
+ * Integer arguments keep the width given by the length modifier, "%s" becomes a
+ * UTF8 string, "%p" a pointer and floating point conversions a float64.
+ * Asterisk width and precision are written as int32 arguments in their place.
+ * @param log pointer to an object containing information about logging context data
+ * @param format printf-style format string
+ * @param args arguments referenced by @a format
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_user_log_write_vprintf_args(DltContextData *log, const char *format, va_list args);
+
 /**
  * Write a binary memory block into a DLT log message.
  * dlt_user_log_write_start has to be called before adding any attributes to the log message.
@@ -1032,6 +1062,10 @@ int dlt_get_log_state();
 
 /**
  *接收到注入消息时调用注册回调函数
+ * The callback is called by an injection thread of libdlt, one callback after
+ * another in the order the injections were received. With DLT_INJECTION_WORKERS
+ * set above 1, callbacks of different services can run at the same time.
+ * Injections still queued when the context is unregistered are dropped.
  * @param handle pointer to an object containing information about one special logging context
  * @param service_id the service id to be waited for
  * @param (*dlt_injection_callback) function pointer to callback function
@@ -1257,6 +1291,24 @@ DltReturnValue dlt_log_marker();
  */
 DltReturnValue dlt_user_check_buffer(int *total_size, int *used_size);
 
+/**
+ * Wait until at least free_percent of the buffer between application and
+ * daemon is free. The caller is woken up as soon as messages were resent
+ * from the buffer instead of polling it with a fixed sleep.
+ * @param free_percent free space to wait for, in percent of the total size
+ * @param timeout maximum time to wait in msec
+ * @return DLT_RETURN_OK if there is enough free space, DLT_RETURN_ERROR on timeout
+ */
+DltReturnValue dlt_user_wait_for_buffer(int free_percent, uint32_t timeout);
+
+/**
+ * Check whether messages logged before the application is registered at the
+ * daemon are kept in the startup ring in shared memory (see environment
+ * variable DLT_USER_STARTUP_SHM_SIZE) instead of the heap.
+ * @return 1 if the startup ring is in use, 0 otherwise
+ */
+int dlt_user_is_startup_shm_active(void);
+
 /**
  *尝试在用户缓冲区中重新发送日志消息。如果dlt_uptime大于
 * dlt_uptime() + DLT_USER_ATEXIT_RESEND_BUFFER_EXIT_TIMEOUT。重发之间的暂停
@@ -66,6 +66,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <regex.h>
 
 #include "dlt_common.h"
 #include "dlt_user.h"
@@ -73,6 +78,22 @@
 
 #define MAXSTRLEN 1024
 
+/* Size of the buffer stdin is read into */
+#define READ_BUF_SIZE (64 * 1024)
+
+/* Default time in ms a batch or a record waiting for continuation lines
+ * is held back */
+#define DEFAULT_LATENCY 100
+
+/* Max time in ms a batch or a record may be held back */
+#define MAX_LATENCY 60000
+
+/* Environment variable setting the size of the log buffer of the DLT library */
+#define LOG_MSG_BUF_LEN_ENV "DLT_LOG_MSG_BUF_LEN"
+
+/* Max number of contexts created for context ids matched by the regex */
+#define MAX_CONTEXTS 32
+
 #define PS_DLT_APP_DESC      "stdin adaptor application"
 #define PS_DLT_CONTEXT_DESC  "stdin adaptor context"
 
@@ -81,22 +102,373 @@
 
 DLT_DECLARE_CONTEXT(mycontext)
 
+typedef struct
+{
+    char ctid[DLT_ID_SIZE];
+    DltContext context;
+} StdinContext;
+
+/* A record: a line, with joining the line and its continuation lines */
+typedef struct
+{
+    int used;
+    char text[MAXSTRLEN];
+    size_t length;
+    DltContext *context;
+    DltLogLevelType level;
+    uint32_t timestamp;             /* time the first line was read, in 0.1 ms */
+} StdinRecord;
+
+/* Message collecting records of the same context and level */
+typedef struct
+{
+    int active;
+    DltContextData log;
+    DltContext *context;
+    DltLogLevelType level;
+    size_t size;
+    uint32_t timestamp;             /* time the first record was read, in 0.1 ms */
+} StdinBatch;
+
+typedef struct
+{
+    int verbosity;
+    int prefix;                     /* parse a level prefix */
+    regex_t level_regex;            /* 1st subexpression level, 2nd context id */
+    int use_level_regex;
+    regex_t join_regex;             /* lines continuing the previous record */
+    int use_join_regex;
+    size_t batch_size;              /* max payload of a batch, 0 sends each record alone */
+    uint32_t latency;               /* in 0.1 ms */
+} StdinOptions;
+
+static StdinContext contexts[MAX_CONTEXTS];
+static int context_count = 0;
+
+static const struct
+{
+    const char *name;
+    DltLogLevelType level;
+} level_names[] = {
+    { "FATAL", DLT_LOG_FATAL }, { "F", DLT_LOG_FATAL }, { "EMERG", DLT_LOG_FATAL },
+    { "ALERT", DLT_LOG_FATAL }, { "CRIT", DLT_LOG_FATAL }, { "CRITICAL", DLT_LOG_FATAL },
+    { "ERROR", DLT_LOG_ERROR }, { "ERR", DLT_LOG_ERROR }, { "E", DLT_LOG_ERROR },
+    { "WARN", DLT_LOG_WARN }, { "WARNING", DLT_LOG_WARN }, { "W", DLT_LOG_WARN },
+    { "INFO", DLT_LOG_INFO }, { "NOTICE", DLT_LOG_INFO }, { "I", DLT_LOG_INFO },
+    { "DEBUG", DLT_LOG_DEBUG }, { "D", DLT_LOG_DEBUG },
+    { "VERBOSE", DLT_LOG_VERBOSE }, { "TRACE", DLT_LOG_VERBOSE }, { "V", DLT_LOG_VERBOSE }
+};
+
+/* Log level of a level name, -1 if the name is unknown */
+static int get_level(const char *name, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(level_names) / sizeof(level_names[0]); i++)
+        if ((strlen(level_names[i].name) == length) && (strncasecmp(level_names[i].name, name, length) == 0))
+            return level_names[i].level;
+
+    return -1;
+}
+
+/* Log level of a prefix like "ERROR:", "[warn]", "W/" or "<3>", -1 if the
+ * line has none */
+static int get_prefix_level(const char *line, size_t length)
+{
+    const char *end = line + length;
+    const char *p = line;
+    const char *name;
+    char close = 0;
+
+    if ((p < end) && ((*p == '[') || (*p == '<'))) {
+        close = (*p == '[') ? ']' : '>';
+        p++;
+    }
+
+    /* kernel and syslog severity */
+    if ((close == '>') && (end - p >= 2) && (p[0] >= '0') && (p[0] <= '7') && (p[1] == '>'))
+        return dlt_syslog_get_log_level(p[0] - '0');
+
+    for (name = p; (p < end) && (((*p >= 'a') && (*p <= 'z')) || ((*p >= 'A') && (*p <= 'Z'))); p++)
+        ;
+
+    if ((p == name) || (p == end))
+        return -1;
+
+    if (close != 0) {
+        if (*p != close)
+            return -1;
+    }
+    /* a word followed by a space only counts if it is no single letter */
+    else if ((*p != ':') && (*p != '/') && !((*p == ' ') && (p - name > 1)))
+    {
+        return -1;
+    }
+
+    return get_level(name, (size_t)(p - name));
+}
+
+/* Context of a context id, registered on first use. Falls back to
+ * mycontext once MAX_CONTEXTS contexts are registered. */
+static DltContext *get_context(const char *id, size_t length)
+{
+    char ctid[DLT_ID_SIZE + 1] = { 0 };
+    char description[64];
+    int i;
+
+    if (length == 0)
+        return &mycontext;
+
+    memcpy(ctid, id, (length < DLT_ID_SIZE) ? length : DLT_ID_SIZE);
+
+    for (i = 0; i < context_count; i++)
+        if (memcmp(contexts[i].ctid, ctid, DLT_ID_SIZE) == 0)
+            return &contexts[i].context;
+
+    if (context_count == MAX_CONTEXTS)
+        return &mycontext;
+
+    snprintf(description, sizeof(description), "stdin adaptor %.*s", (int)length, id);
+
+    if (dlt_register_context(&contexts[context_count].context, ctid, description) < DLT_RETURN_OK)
+        return &mycontext;
+
+    memcpy(contexts[context_count].ctid, ctid, DLT_ID_SIZE);
+
+    return &contexts[context_count++].context;
+}
+
+static void flush_batch(StdinBatch *batch)
+{
+    if (!batch->active)
+        return;
+
+    dlt_user_log_write_finish(&(batch->log));
+    batch->active = 0;
+}
+
+/* Send a record alone or add it to the batch. A batch holds pairs of the
+ * read timestamp and the text of each record. */
+static void send_record(StdinOptions *opts, StdinBatch *batch, StdinRecord *record)
+{
+    DltContextData log;
+    /* type info and value of the timestamp, type info and length of the text */
+    size_t size = 4 + 4 + 4 + 2 + record->length;
+
+    if (!record->used)
+        return;
+
+    record->used = 0;
+
+    if (batch->active && ((batch->context != record->context) || (batch->level != record->level) ||
+                          (batch->size + size > opts->batch_size)))
+        flush_batch(batch);
+
+    if ((opts->batch_size == 0) || (size > opts->batch_size)) {
+        if (dlt_user_log_write_start(record->context, &log, record->level) == DLT_RETURN_TRUE) {
+            log.use_timestamp = DLT_USER_TIMESTAMP;
+            log.user_timestamp = record->timestamp;
+            dlt_user_log_write_sized_string(&log, record->text, (uint16_t)record->length);
+            dlt_user_log_write_finish(&log);
+        }
+
+        return;
+    }
+
+    if (!batch->active) {
+        if (dlt_user_log_write_start(record->context, &(batch->log), record->level) != DLT_RETURN_TRUE)
+            return;
+
+        batch->log.use_timestamp = DLT_USER_TIMESTAMP;
+        batch->log.user_timestamp = record->timestamp;
+        batch->active = 1;
+        batch->context = record->context;
+        batch->level = record->level;
+        batch->size = 0;
+        batch->timestamp = record->timestamp;
+    }
+
+    dlt_user_log_write_uint32(&(batch->log), record->timestamp);
+    dlt_user_log_write_sized_string(&(batch->log), record->text, (uint16_t)record->length);
+    batch->size += size;
+}
+
+/* Handle one line without line break. continued is set for the pieces of
+ * an overlong line after the first, they keep its level and context and
+ * are sent as records of their own. */
+static void add_line(StdinOptions *opts, StdinBatch *batch, StdinRecord *record,
+                     const char *line, size_t length, int continued)
+{
+    regmatch_t match[3];
+    char text[MAXSTRLEN + 1];
+    DltContext *context = &mycontext;
+    int level = -1;
+
+    if ((length > 0) && (line[length - 1] == '\r'))
+        length--;
+
+    memcpy(text, line, length);
+    text[length] = 0;
+
+    /* join lines continuing the pending record, as long as they fit */
+    if (record->used && !continued && opts->use_join_regex &&
+        (regexec(&(opts->join_regex), text, 0, NULL, 0) == 0)) {
+        if (record->length + 1 + length <= MAXSTRLEN) {
+            record->text[record->length++] = '\n';
+            memcpy(record->text + record->length, text, length);
+            record->length += length;
+            return;
+        }
+
+        continued = 1;
+    }
+
+    /* the level and context of the last record stay after it was sent */
+    if (continued) {
+        context = record->context;
+        level = record->level;
+    }
+
+    send_record(opts, batch, record);
+
+    if (!continued) {
+        if (length == 0)
+            return;
+
+        if (opts->use_level_regex && (regexec(&(opts->level_regex), text, 3, match, 0) == 0)) {
+            if (match[1].rm_so >= 0)
+                level = get_level(text + match[1].rm_so, (size_t)(match[1].rm_eo - match[1].rm_so));
+
+            if (match[2].rm_so >= 0)
+                context = get_context(text + match[2].rm_so, (size_t)(match[2].rm_eo - match[2].rm_so));
+        }
+
+        if ((level == -1) && opts->prefix)
+            level = get_prefix_level(text, length);
+
+        if (level == -1)
+            level = opts->verbosity;
+    }
+
+    memcpy(record->text, text, length);
+    record->length = length;
+    record->context = context;
+    record->level = (DltLogLevelType)level;
+    record->timestamp = dlt_uptime();
+    record->used = 1;
+
+    /* without joining there is nothing to wait for */
+    if (!opts->use_join_regex)
+        send_record(opts, batch, record);
+}
+
+/* Length of the first piece of an overlong line, not splitting a UTF-8 character */
+static size_t split_length(const char *line)
+{
+    size_t length = MAXSTRLEN;
+
+    while ((length > MAXSTRLEN - 3) && ((line[length] & 0xC0) == 0x80))
+        length--;
+
+    return length;
+}
+
+/* Time in ms until the pending record or batch is due, -1 if none is pending */
+static int get_timeout(StdinOptions *opts, StdinBatch *batch, StdinRecord *record)
+{
+    uint32_t now = dlt_uptime();
+    uint32_t start;
+
+    if (record->used)
+        start = record->timestamp;
+    else if (batch->active)
+        start = batch->timestamp;
+    else
+        return -1;
+
+    if (now - start >= opts->latency)
+        return 0;
+
+    return (int)((opts->latency - (now - start) + 9) / 10);
+}
+
+/* Max payload of a log message, as the DLT library sizes its log buffer */
+static long get_payload_max(void)
+{
+    const char *env = getenv(LOG_MSG_BUF_LEN_ENV);
+    long size;
+
+    if (env == NULL)
+        return DLT_USER_BUF_MAX_SIZE;
+
+    size = strtol(env, NULL, 10);
+
+    if ((size < 0) || (size > UINT16_MAX))
+        return UINT16_MAX;
+
+    return size;
+}
+
+/* Value of a numeric option from 1 to max, -1 if it is invalid */
+static long parse_number(const char *arg, long max)
+{
+    char *end = NULL;
+    long value;
+
+    errno = 0;
+    value = strtol(arg, &end, 10);
+
+    if ((errno != 0) || (end == arg) || (*end != 0) || (value <= 0) || (value > max))
+        return -1;
+
+    return value;
+}
+
+static int compile_regex(regex_t *regex, const char *pattern)
+{
+    char error[256];
+    int ret = regcomp(regex, pattern, REG_EXTENDED);
+
+    if (ret != 0) {
+        regerror(ret, regex, error, sizeof(error));
+        fprintf(stderr, "Invalid regular expression '%s': %s\n", pattern, error);
+        return -1;
+    }
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
-    char str[MAXSTRLEN];
+    static char buffer[READ_BUF_SIZE];
+    size_t fill = 0;
+    size_t start, length;
+    ssize_t bytes;
+    char *newline;
+    struct pollfd pfd;
+    int timeout;
+    int continued = 0;
     int opt;
 
     char apid[DLT_ID_SIZE];
     char ctid[DLT_ID_SIZE];
     char version[255];
-    int timeout = -1;
-    int verbosity = DLT_LOG_INFO;
+    int resend_timeout = -1;
     int bflag = 0;
+    StdinOptions opts;
+    StdinBatch batch;
+    StdinRecord record;
+
+    memset(&opts, 0, sizeof(opts));
+    memset(&batch, 0, sizeof(batch));
+    memset(&record, 0, sizeof(record));
+    opts.verbosity = DLT_LOG_INFO;
+    opts.latency = DEFAULT_LATENCY * 10;
 
     dlt_set_id(apid, PS_DLT_APP);
     dlt_set_id(ctid, PS_DLT_CONTEXT);
 
-    while ((opt = getopt(argc, argv, "a:c:bht:v:")) != -1)
+    while ((opt = getopt(argc, argv, "a:c:bB:hj:l:pr:t:v:")) != -1)
         switch (opt) {
         case 'a':
         {
@@ -113,9 +485,57 @@ int main(int argc, char *argv[])
             bflag = 1;
             break;
         }
+        case 'B':
+        {
+            /* a larger batch would be truncated by the DLT library */
+            long size = parse_number(optarg, get_payload_max());
+
+            if (size < 0) {
+                fprintf(stderr, "Invalid batch size '%s', accepted values are 1 to %ld\n",
+                        optarg, get_payload_max());
+                return -1;
+            }
+
+            opts.batch_size = (size_t)size;
+            break;
+        }
+        case 'j':
+        {
+            if (compile_regex(&(opts.join_regex), optarg) != 0)
+                return -1;
+
+            opts.use_join_regex = 1;
+            break;
+        }
+        case 'l':
+        {
+            long latency = parse_number(optarg, MAX_LATENCY);
+
+            if (latency < 0) {
+                fprintf(stderr, "Invalid latency '%s', accepted values are 1 to %d\n",
+                        optarg, MAX_LATENCY);
+                return -1;
+            }
+
+            opts.latency = (uint32_t)latency * 10;
+            break;
+        }
+        case 'p':
+        {
+            opts.prefix = 1;
+            break;
+        }
+        case 'r':
+        {
+            if (compile_regex(&(opts.level_regex), optarg) != 0)
+                return -1;
+
+            opts.use_level_regex = 1;
+            break;
+        }
         case 't':
         {
-            timeout = atoi(optarg);
+            resend_timeout = atoi(optarg);
             break;
         }
         case 'h':
@@ -132,45 +552,57 @@ int main(int argc, char *argv[])
             printf("  -t timeout   - Set timeout when sending messages at exit, in ms (Default: 10000 = 10sec)\n");
             printf(
                 "  -v verbosity level - Set verbosity level (Default: INFO, values: FATAL ERROR WARN INFO DEBUG VERBOSE)\n");
+            printf("  -p           - Take the log level from a prefix like 'ERROR:', '[warn]', 'W/' or '<3>'\n");
+            printf("  -r regex     - Take the log level from the 1st and the context id from the 2nd\n");
+            printf("                 subexpression of an extended regular expression\n");
+            printf("                 (e.g. '^([A-Z]+) \\[([A-Za-z]+)\\]'), before -p\n");
+            printf("  -j regex     - Join lines matching the regular expression to the previous line\n");
+            printf("                 (e.g. '^[[:space:]]' for stack traces)\n");
+            printf("  -B size      - Pack lines of the same level and context into messages of up to\n");
+            printf("                 size bytes, each line as read time (uint32, 0.1 ms) and text,\n");
+            printf("                 at most the log buffer size of the DLT library (Default: off)\n");
+            printf("  -l latency   - Max time in ms a line is held back for -B and -j, 1 to %d (Default: %d)\n",
+                   MAX_LATENCY, DEFAULT_LATENCY);
             printf("  -h           - This help\n");
+            printf("Lines longer than %d bytes are sent in pieces.\n", MAXSTRLEN);
             return 0;
             break;
         }
         case 'v':
         {
             if (!strcmp(optarg, "FATAL")) {
-                verbosity = DLT_LOG_FATAL;
+                opts.verbosity = DLT_LOG_FATAL;
                 break;
             }
             else if (!strcmp(optarg, "ERROR"))
             {
-                verbosity = DLT_LOG_ERROR;
+                opts.verbosity = DLT_LOG_ERROR;
                 break;
             }
             else if (!strcmp(optarg, "WARN"))
             {
-                verbosity = DLT_LOG_WARN;
+                opts.verbosity = DLT_LOG_WARN;
                 break;
             }
             else if (!strcmp(optarg, "INFO"))
             {
-                verbosity = DLT_LOG_INFO;
+                opts.verbosity = DLT_LOG_INFO;
                 break;
             }
             else if (!strcmp(optarg, "DEBUG"))
             {
-                verbosity = DLT_LOG_DEBUG;
+                opts.verbosity = DLT_LOG_DEBUG;
                 break;
             }
             else if (!strcmp(optarg, "VERBOSE"))
             {
-                verbosity = DLT_LOG_VERBOSE;
+                opts.verbosity = DLT_LOG_VERBOSE;
                 break;
             }
             else {
                 printf(
                     "Wrong verbosity level, setting to INFO. Accepted values are: FATAL ERROR WARN INFO DEBUG VERBOSE\n");
-                verbosity = DLT_LOG_INFO;
+                opts.verbosity = DLT_LOG_INFO;
                 break;
             }
 
@@ -186,12 +618,79 @@ int main(int argc, char *argv[])
     DLT_REGISTER_APP(apid, PS_DLT_APP_DESC);
     DLT_REGISTER_CONTEXT(mycontext, ctid, PS_DLT_CONTEXT_DESC);
 
-    if (timeout > -1)
-        dlt_set_resend_timeout_atexit(timeout);
+    if (resend_timeout > -1)
+        dlt_set_resend_timeout_atexit(resend_timeout);
+
+    pfd.fd = STDIN_FILENO;
+    pfd.events = POLLIN;
+
+    while (1) {
+        /* send what is held back once its latency is over */
+        timeout = get_timeout(&opts, &batch, &record);
 
-    while (fgets(str, MAXSTRLEN, stdin))
-        if (strcmp(str, "") != 0)
-            DLT_LOG(mycontext, verbosity, DLT_STRING(str));
+        if (timeout == 0) {
+            send_record(&opts, &batch, &record);
+            flush_batch(&batch);
+            continue;
+        }
+
+        if (poll(&pfd, 1, timeout) == 0)
+            continue;
+
+        bytes = read(STDIN_FILENO, buffer + fill, sizeof(buffer) - fill);
+
+        if (bytes < 0) {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        if (bytes == 0)
+            break;
+
+        fill += (size_t)bytes;
+
+        for (start = 0; start < fill; start += length) {
+            newline = memchr(buffer + start, '\n', fill - start);
+
+            if (newline != NULL) {
+                length = (size_t)(newline - (buffer + start));
+
+                if (length <= MAXSTRLEN) {
+                    add_line(&opts, &batch, &record, buffer + start, length, continued);
+                    continued = 0;
+                    length++;
+                    continue;
+                }
+            }
+            else if (fill - start <= MAXSTRLEN) {
+                break; /* wait for the rest of the line */
+            }
+
+            length = split_length(buffer + start);
+            add_line(&opts, &batch, &record, buffer + start, length, continued);
+            continued = 1;
+        }
+
+        memmove(buffer, buffer + start, fill - start);
+        fill -= start;
+    }
+
+    if (fill > 0)
+        add_line(&opts, &batch, &record, buffer, fill, continued);
+
+    send_record(&opts, &batch, &record);
+    flush_batch(&batch);
+
+    if (opts.use_level_regex)
+        regfree(&(opts.level_regex));
+
+    if (opts.use_join_regex)
+        regfree(&(opts.join_regex));
+
+    while (context_count > 0)
+        DLT_UNREGISTER_CONTEXT(contexts[--context_count].context);
 
     DLT_UNREGISTER_CONTEXT(mycontext);
 
@@ -202,4 +701,3 @@ int main(int argc, char *argv[])
 
     return 0;
 }
-
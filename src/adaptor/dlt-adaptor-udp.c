@@ -76,6 +76,7 @@
 #include "dlt_common.h"
 #include "dlt_user.h"
 #include "dlt_user_macros.h"
+#include "dlt_syslog_forward.h"
 
 
 /* Port number, to which the syslogd-ng sends its log messages */
@@ -83,6 +84,10 @@
 
 #define MAXSTRLEN             1024
 
+/* Datagrams read per wake-up */
+#define DEFAULT_BATCH         32
+#define MAX_BATCH             256
+
 #define PU_DLT_APP_DESC      "udp adaptor application"
 #define PU_DLT_CONTEXT_DESC  "udp adaptor context"
 
@@ -91,14 +96,20 @@
 
 DLT_DECLARE_CONTEXT(mycontext)
 
+static DltSyslogForward forward;
+
 int main(int argc, char *argv[])
 {
     int sock;
-    int bytes_read;
-    socklen_t addr_len;
+    int count, i;
     int opt, port;
-    char recv_data[MAXSTRLEN];
-    struct sockaddr_in client_addr, server_addr;
+    int batch = DEFAULT_BATCH;
+    int parse = 0;
+    int max_contexts = 0;
+    char *recv_data;
+    struct mmsghdr *msgs;
+    struct iovec *iovecs;
+    struct sockaddr_in server_addr;
 
     char apid[DLT_ID_SIZE];
     char ctid[DLT_ID_SIZE];
@@ -110,13 +121,24 @@ int main(int argc, char *argv[])
 
     port = RCVPORT;
 
-    while ((opt = getopt(argc, argv, "a:c:hp:v:")) != -1)
+    while ((opt = getopt(argc, argv, "a:b:c:hp:st:v:")) != -1)
         switch (opt) {
         case 'a':
         {
             dlt_set_id(apid, optarg);
             break;
         }
+        case 'b':
+        {
+            batch = atoi(optarg);
+
+            if ((batch < 1) || (batch > MAX_BATCH)) {
+                fprintf(stderr, "Batch size must be between 1 and %d\n", MAX_BATCH);
+                return -1;
+            }
+
+            break;
+        }
         case 'c':
         {
             dlt_set_id(ctid, optarg);
@@ -131,8 +153,15 @@ int main(int argc, char *argv[])
             printf("%s \n", version);
             printf("Options:\n");
             printf("-a apid      - Set application id to apid (default: UDPA)\n");
+            printf("-b count     - Read up to count datagrams per wake-up (default: %d, max: %d)\n",
+                   DEFAULT_BATCH, MAX_BATCH);
             printf("-c ctid      - Set context id to ctid (default: UDPC)\n");
             printf("-p           - Set receive port number for UDP messages (default: %d) \n", port);
+            printf("-s           - Parse syslog messages (RFC 3164 and RFC 5424), log them with their\n");
+            printf("               severity as log level and their timestamp\n");
+            printf("-t count     - With -s, log each tag in its own context, named by the first\n");
+            printf("               four characters of the tag, at most count contexts (max: %d)\n",
+                   DLT_SYSLOG_FORWARD_MAX_CONTEXTS);
             printf(
                 "-v verbosity level - Set verbosity level (Default: INFO, values: FATAL ERROR WARN INFO DEBUG VERBOSE)\n");
             printf("-h           - This help\n");
@@ -144,6 +173,20 @@ int main(int argc, char *argv[])
             port = atoi(optarg);
             break;
         }
+        case 's':
+        {
+            parse = 1;
+            break;
+        }
+        case 't':
+        {
+            max_contexts = atoi(optarg);
+
+            if (max_contexts > DLT_SYSLOG_FORWARD_MAX_CONTEXTS)
+                max_contexts = DLT_SYSLOG_FORWARD_MAX_CONTEXTS;
+
+            break;
+        }
         case 'v':
         {
             if (!strcmp(optarg, "FATAL")) {
@@ -219,36 +262,72 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    addr_len = sizeof(struct sockaddr);
+    recv_data = malloc((size_t)batch * MAXSTRLEN);
+    msgs = calloc((size_t)batch, sizeof(struct mmsghdr));
+    iovecs = calloc((size_t)batch, sizeof(struct iovec));
+
+    if ((recv_data == NULL) || (msgs == NULL) || (iovecs == NULL)) {
+        fprintf(stderr, "Cannot allocate memory\n");
+        free(recv_data);
+        free(msgs);
+        free(iovecs);
+        close(sock);
+        return -1;
+    }
+
+    for (i = 0; i < batch; i++) {
+        iovecs[i].iov_base = recv_data + (size_t)i * MAXSTRLEN;
+        iovecs[i].iov_len = MAXSTRLEN;
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
     DLT_REGISTER_APP(apid, PU_DLT_APP_DESC);
     DLT_REGISTER_CONTEXT(mycontext, ctid, PU_DLT_CONTEXT_DESC);
 
-    while (1) {
-        bytes_read = 0;
+    dlt_syslog_forward_init(&forward, &mycontext, "udp adaptor", (DltLogLevelType)verbosity);
+    forward.map_levels = 1;
+    forward.use_timestamp = 1;
+    forward.max_contexts = max_contexts;
 
-        bytes_read = recvfrom(sock, recv_data, MAXSTRLEN, 0,
-                              (struct sockaddr *)&client_addr, &addr_len);
+    while (1) {
+        /* blocks for the first datagram, then takes all queued ones up to
+         * the batch size */
+        count = recvmmsg(sock, msgs, (unsigned int)batch, MSG_WAITFORONE, NULL);
 
-        if (bytes_read == -1) {
+        if (count == -1) {
             if (errno == EINTR) {
                 continue;
             }
             else {
+                dlt_syslog_forward_free(&forward);
                 DLT_UNREGISTER_CONTEXT(mycontext);
                 DLT_UNREGISTER_APP();
                 exit(1);
             }
         }
 
-        recv_data[bytes_read] = '\0';
+        for (i = 0; i < count; i++) {
+            if (msgs[i].msg_len == 0)
+                continue;
 
-        if (bytes_read != 0)
-            DLT_LOG(mycontext, verbosity, DLT_STRING(recv_data));
+            if (!parse) {
+                DLT_LOG(mycontext, verbosity,
+                        DLT_SIZED_STRING(recv_data + (size_t)i * MAXSTRLEN, (uint16_t)msgs[i].msg_len));
+                continue;
+            }
+
+            dlt_syslog_forward_log(&forward, recv_data + (size_t)i * MAXSTRLEN, (int)msgs[i].msg_len);
+        }
     }
 
+    dlt_syslog_forward_free(&forward);
     DLT_UNREGISTER_CONTEXT(mycontext);
     DLT_UNREGISTER_APP();
 
+    free(recv_data);
+    free(msgs);
+    free(iovecs);
+
     return 0;
 }
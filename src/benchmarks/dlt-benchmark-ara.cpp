@@ -0,0 +1,156 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-benchmark-ara.cpp
+ */
+
+/*
+ * Per-call cost of ara::log::LogStream, with the log level of the logger
+ * enabled and disabled, for LogMode::kRemote or LogMode::kFile.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "ara/log/logger.h"
+#include "ara/log/logging.h"
+#include "dlt-benchmark-common.h"
+
+namespace
+{
+
+void usage()
+{
+    printf("Usage: dlt-benchmark-ara [options]\n");
+    printf("Measure the per-call cost of ara::log::LogStream.\n");
+    printf("Options:\n");
+    printf("  -n count      Number of calls per case (Default: 1000000)\n");
+    printf("  -m sink       remote or file (Default: remote)\n");
+    printf("  -d directory  Directory of the file sink (Default: /tmp)\n");
+    printf("  -o filename   Write the JSON results to file (Default: stdout)\n");
+    printf("  -h            Usage\n");
+}
+
+// Same passes as dlt-benchmark-user: the loop timed as a whole for ns/op,
+// then a sample of calls timed one by one for the latency percentiles.
+void run(ara::log::Logger& logger,
+         ara::log::LogLevel level,
+         const std::string& name,
+         unsigned long count,
+         FILE* out)
+{
+    DltBenchmarkResult result;
+    unsigned long samples = (count < DLT_BENCHMARK_LATENCY_SAMPLES) ? count : DLT_BENCHMARK_LATENCY_SAMPLES;
+
+    if (dlt_benchmark_result_init(&result, name.c_str(), samples) != 0) {
+        return;
+    }
+
+    double cpu = dlt_benchmark_cpu_seconds(0);
+    uint64_t start = dlt_benchmark_now_ns();
+
+    for (unsigned long i = 0; i < count; i++) {
+        logger.WithLevel(level) << "benchmark" << static_cast<uint32_t>(i);
+    }
+
+    result.seconds = static_cast<double>(dlt_benchmark_now_ns() - start) / 1e9;
+    result.cpu_seconds = dlt_benchmark_cpu_seconds(0) - cpu;
+    result.iterations = count;
+
+    uint64_t overhead = dlt_benchmark_timer_overhead_ns();
+
+    for (unsigned long i = 0; i < samples; i++) {
+        uint64_t begin = dlt_benchmark_now_ns();
+        logger.WithLevel(level) << "benchmark" << static_cast<uint32_t>(i);
+        uint64_t elapsed = dlt_benchmark_now_ns() - begin;
+        dlt_benchmark_result_add_sample(&result, (elapsed > overhead) ? elapsed - overhead : 0);
+    }
+
+    dlt_benchmark_result_print(&result);
+    dlt_benchmark_json_result(out, &result);
+    dlt_benchmark_result_free(&result);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    FILE* out = stdout;
+    std::string sink = "remote";
+    const char* directory = "/tmp";
+    const char* ovalue = nullptr;
+    unsigned long count = 1000000;
+    int c;
+
+    while ((c = getopt(argc, argv, "hn:m:d:o:")) != -1) {
+        switch (c) {
+        case 'n':
+            count = strtoul(optarg, nullptr, 10);
+            break;
+        case 'm':
+            sink = optarg;
+            break;
+        case 'd':
+            directory = optarg;
+            break;
+        case 'o':
+            ovalue = optarg;
+            break;
+        case 'h':
+        default:
+            usage();
+            return -1;
+        }
+    }
+
+    if ((count == 0) || ((sink != "remote") && (sink != "file"))) {
+        fprintf(stderr, "ERROR: Invalid arguments\n");
+        usage();
+        return -1;
+    }
+
+    if (ovalue) {
+        out = fopen(ovalue, "w");
+
+        if (out == nullptr) {
+            fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", ovalue);
+            return -1;
+        }
+    }
+
+    ara::log::InitLogging("BNCA",
+                          "LogStream benchmark",
+                          ara::log::LogLevel::kInfo,
+                          (sink == "file") ? ara::log::LogMode::kFile : ara::log::LogMode::kRemote,
+                          directory);
+
+    ara::log::Logger& logger = ara::log::CreateLogger("BNCH", "Benchmark context", ara::log::LogLevel::kInfo);
+
+    dlt_benchmark_json_begin(out, "dlt-benchmark-ara");
+    run(logger, ara::log::LogLevel::kInfo, "logstream_enabled_" + sink, count, out);
+    run(logger, ara::log::LogLevel::kVerbose, "logstream_disabled_" + sink, count, out);
+    dlt_benchmark_json_end(out);
+
+    if (ovalue) {
+        fclose(out);
+    }
+
+    return 0;
+}
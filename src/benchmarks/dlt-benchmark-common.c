@@ -0,0 +1,230 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-benchmark-common.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dlt_version.h"
+#include "dlt-benchmark-common.h"
+
+static int dlt_benchmark_json_results = 0;
+
+uint64_t dlt_benchmark_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+double dlt_benchmark_cpu_seconds(pid_t pid)
+{
+    char filename[64];
+    char buffer[1024];
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    struct timespec ts;
+    FILE *file;
+    char *fields;
+
+    if (pid == 0) {
+        if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+            return -1;
+
+        return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+    }
+
+    snprintf(filename, sizeof(filename), "/proc/%d/stat", (int)pid);
+    file = fopen(filename, "r");
+
+    if (file == NULL)
+        return -1;
+
+    if (fgets(buffer, sizeof(buffer), file) == NULL) {
+        fclose(file);
+        return -1;
+    }
+
+    fclose(file);
+
+    /* the command name may contain spaces, the fields start after it */
+    fields = strrchr(buffer, ')');
+
+    if ((fields == NULL) ||
+        (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                &utime, &stime) != 2))
+        return -1;
+
+    return (double)(utime + stime) / (double)sysconf(_SC_CLK_TCK);
+}
+
+int dlt_benchmark_result_init(DltBenchmarkResult *result, const char *name, unsigned long max_samples)
+{
+    if ((result == NULL) || (name == NULL))
+        return -1;
+
+    memset(result, 0, sizeof(DltBenchmarkResult));
+    strncpy(result->name, name, sizeof(result->name) - 1);
+    result->cpu_seconds = -1;
+
+    if (max_samples > 0) {
+        result->samples = malloc(sizeof(uint64_t) * max_samples);
+
+        if (result->samples == NULL) {
+            fprintf(stderr, "%s: Cannot allocate %lu samples\n", __func__, max_samples);
+            return -1;
+        }
+
+        result->max_samples = max_samples;
+    }
+
+    return 0;
+}
+
+void dlt_benchmark_result_add_sample(DltBenchmarkResult *result, uint64_t ns)
+{
+    if ((result != NULL) && (result->num_samples < result->max_samples))
+        result->samples[result->num_samples++] = ns;
+}
+
+void dlt_benchmark_result_free(DltBenchmarkResult *result)
+{
+    if (result == NULL)
+        return;
+
+    free(result->samples);
+    result->samples = NULL;
+    result->num_samples = 0;
+    result->max_samples = 0;
+}
+
+static int dlt_benchmark_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+uint64_t dlt_benchmark_timer_overhead_ns(void)
+{
+    uint64_t samples[1001];
+    uint64_t begin;
+    int i;
+
+    for (i = 0; i < 1001; i++) {
+        begin = dlt_benchmark_now_ns();
+        samples[i] = dlt_benchmark_now_ns() - begin;
+    }
+
+    qsort(samples, 1001, sizeof(uint64_t), dlt_benchmark_compare);
+
+    return samples[500];
+}
+
+/* Percentile of the sorted samples, per mille */
+static uint64_t dlt_benchmark_percentile(DltBenchmarkResult *result, unsigned int permille)
+{
+    unsigned long index = (unsigned long)(((double)result->num_samples * permille) / 1000);
+
+    if (index >= result->num_samples)
+        index = result->num_samples - 1;
+
+    return result->samples[index];
+}
+
+void dlt_benchmark_result_print(DltBenchmarkResult *result)
+{
+    if (result == NULL)
+        return;
+
+    fprintf(stderr, "%-32s %10lu ops %10.0f ops/s %10.1f ns/op",
+            result->name,
+            result->iterations,
+            (result->seconds > 0) ? (double)result->iterations / result->seconds : 0,
+            (result->iterations > 0) ? result->seconds * 1e9 / (double)result->iterations : 0);
+
+    if (result->num_samples > 0) {
+        qsort(result->samples, result->num_samples, sizeof(uint64_t), dlt_benchmark_compare);
+        fprintf(stderr, "  p50 %llu ns p99 %llu ns",
+                (unsigned long long)dlt_benchmark_percentile(result, 500),
+                (unsigned long long)dlt_benchmark_percentile(result, 990));
+    }
+
+    if (result->dropped > 0)
+        fprintf(stderr, "  %lu dropped", result->dropped);
+
+    fprintf(stderr, "\n");
+}
+
+void dlt_benchmark_json_begin(FILE *out, const char *benchmark)
+{
+    dlt_benchmark_json_results = 0;
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"%s\",\n", benchmark);
+    fprintf(out, "  \"version\": \"%s\",\n", _DLT_PACKAGE_VERSION);
+    fprintf(out, "  \"timestamp\": %ld,\n", (long)time(NULL));
+    fprintf(out, "  \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(out, "  \"results\": [");
+}
+
+void dlt_benchmark_json_result(FILE *out, DltBenchmarkResult *result)
+{
+    if ((out == NULL) || (result == NULL))
+        return;
+
+    fprintf(out, "%s\n    {\n", dlt_benchmark_json_results++ ? "," : "");
+    fprintf(out, "      \"name\": \"%s\",\n", result->name);
+    fprintf(out, "      \"iterations\": %lu,\n", result->iterations);
+    fprintf(out, "      \"dropped\": %lu,\n", result->dropped);
+    fprintf(out, "      \"seconds\": %.6f,\n", result->seconds);
+    fprintf(out, "      \"ops_per_sec\": %.1f,\n",
+            (result->seconds > 0) ? (double)result->iterations / result->seconds : 0);
+    fprintf(out, "      \"ns_per_op\": %.1f",
+            (result->iterations > 0) ? result->seconds * 1e9 / (double)result->iterations : 0);
+
+    if ((result->cpu_seconds >= 0) && (result->iterations > 0))
+        fprintf(out, ",\n      \"cpu_ns_per_op\": %.1f",
+                result->cpu_seconds * 1e9 / (double)result->iterations);
+
+    if (result->num_samples > 0) {
+        qsort(result->samples, result->num_samples, sizeof(uint64_t), dlt_benchmark_compare);
+        fprintf(out, ",\n      \"latency_ns\": {");
+        fprintf(out, " \"min\": %llu,", (unsigned long long)result->samples[0]);
+        fprintf(out, " \"p50\": %llu,", (unsigned long long)dlt_benchmark_percentile(result, 500));
+        fprintf(out, " \"p90\": %llu,", (unsigned long long)dlt_benchmark_percentile(result, 900));
+        fprintf(out, " \"p99\": %llu,", (unsigned long long)dlt_benchmark_percentile(result, 990));
+        fprintf(out, " \"p999\": %llu,", (unsigned long long)dlt_benchmark_percentile(result, 999));
+        fprintf(out, " \"max\": %llu }",
+                (unsigned long long)result->samples[result->num_samples - 1]);
+    }
+
+    fprintf(out, "\n    }");
+}
+
+void dlt_benchmark_json_end(FILE *out)
+{
+    fprintf(out, "\n  ]\n}\n");
+    fflush(out);
+}
@@ -0,0 +1,133 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-benchmark-common.h
+ */
+
+#ifndef SRC_BENCHMARKS_DLT_BENCHMARK_COMMON_H_
+#define SRC_BENCHMARKS_DLT_BENCHMARK_COMMON_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DLT_BENCHMARK_MAX_SAMPLES     1000000 /* Latency samples kept per result */
+#define DLT_BENCHMARK_LATENCY_SAMPLES 100000  /* Calls timed one by one in the latency pass */
+
+/**
+ * Measurement of one benchmark case.
+ */
+typedef struct
+{
+    char name[64];              /**< name of the case */
+    unsigned long iterations;   /**< number of measured operations */
+    unsigned long dropped;      /**< operations which did not complete, e.g. lost messages */
+    double seconds;             /**< wall clock time of all operations */
+    double cpu_seconds;         /**< CPU time spent, negative if not measured */
+    uint64_t *samples;          /**< latency of single operations in ns */
+    unsigned long num_samples;  /**< number of samples */
+    unsigned long max_samples;  /**< size of the sample array */
+} DltBenchmarkResult;
+
+/**
+ * Get a monotonic time stamp.
+ *
+ * @return time in ns
+ */
+uint64_t dlt_benchmark_now_ns(void);
+
+/**
+ * Get the cost of taking two time stamps, to be subtracted from the latency
+ * of a single operation timed with dlt_benchmark_now_ns().
+ *
+ * @return median time between two consecutive time stamps in ns
+ */
+uint64_t dlt_benchmark_timer_overhead_ns(void);
+
+/**
+ * Get the CPU time of a process from /proc, or of the calling process.
+ *
+ * @param pid process, 0 for the calling process
+ * @return CPU time in seconds, negative on error
+ */
+double dlt_benchmark_cpu_seconds(pid_t pid);
+
+/**
+ * Initialise a result.
+ *
+ * @param result result to initialise
+ * @param name name of the benchmark case
+ * @param max_samples number of latency samples to keep, 0 for none
+ * @return 0 on success, -1 on error
+ */
+int dlt_benchmark_result_init(DltBenchmarkResult *result, const char *name, unsigned long max_samples);
+
+/**
+ * Record the latency of one operation. Samples beyond the size of the
+ * sample array are ignored.
+ *
+ * @param result result
+ * @param ns latency in ns
+ */
+void dlt_benchmark_result_add_sample(DltBenchmarkResult *result, uint64_t ns);
+
+/**
+ * Free the samples of a result.
+ *
+ * @param result result
+ */
+void dlt_benchmark_result_free(DltBenchmarkResult *result);
+
+/**
+ * Print a result to stderr.
+ *
+ * @param result result, its samples are sorted
+ */
+void dlt_benchmark_result_print(DltBenchmarkResult *result);
+
+/**
+ * Start the JSON document of a benchmark tool.
+ *
+ * @param out output stream
+ * @param benchmark name of the tool
+ */
+void dlt_benchmark_json_begin(FILE *out, const char *benchmark);
+
+/**
+ * Append a result to the JSON document.
+ *
+ * @param out output stream
+ * @param result result, its samples are sorted
+ */
+void dlt_benchmark_json_result(FILE *out, DltBenchmarkResult *result);
+
+/**
+ * Finish the JSON document.
+ *
+ * @param out output stream
+ */
+void dlt_benchmark_json_end(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_BENCHMARKS_DLT_BENCHMARK_COMMON_H_ */
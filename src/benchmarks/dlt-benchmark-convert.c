@@ -0,0 +1,257 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-benchmark-convert.c
+ */
+
+/*
+ * Parse rate of the DLT file API the way dlt-convert -a uses it: index the
+ * file with dlt_file_read(), then load and convert each message to text.
+ * Without input file, a file of verbose string messages is generated.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dlt_common.h"
+#include "dlt-benchmark-common.h"
+
+#define DLT_BENCHMARK_CONVERT_TEXTBUFSIZE 10024 /* same as dlt-convert */
+
+/**
+ * Print usage information of tool.
+ */
+static void usage(void)
+{
+    char version[255];
+
+    dlt_get_version(version, 255);
+
+    printf("Usage: dlt-benchmark-convert [options] [dltfile]\n");
+    printf("Measure the parse rate of dlt-convert.\n");
+    printf("%s \n", version);
+    printf("Options:\n");
+    printf("  -n messages   Number of generated messages (Default: 1000000)\n");
+    printf("  -s size       Payload size of generated messages (Default: 64)\n");
+    printf("  -o filename   Write the JSON results to file (Default: stdout)\n");
+    printf("  -h            Usage\n");
+}
+
+/* Write a file of verbose log messages with one string argument */
+static int dlt_benchmark_convert_generate(const char *filename, unsigned long count, int size)
+{
+    uint8_t buffer[sizeof(DltStorageHeader) + sizeof(DltStandardHeader) +
+                   DLT_SIZE_WEID + DLT_SIZE_WTMS + sizeof(DltExtendedHeader) +
+                   sizeof(uint32_t) + sizeof(uint16_t) + UINT16_MAX];
+    DltStorageHeader *storage = (DltStorageHeader *)buffer;
+    DltStandardHeader *standard = (DltStandardHeader *)(storage + 1);
+    uint8_t *extra = (uint8_t *)(standard + 1);
+    DltExtendedHeader *extended = (DltExtendedHeader *)(extra + DLT_SIZE_WEID + DLT_SIZE_WTMS);
+    uint8_t *payload = (uint8_t *)(extended + 1);
+    uint32_t type_info = DLT_TYPE_INFO_STRG | DLT_SCOD_ASCII;
+    uint16_t length = (uint16_t)(size + 1);
+    uint32_t tmsp;
+    size_t message_size;
+    unsigned long i;
+    FILE *file;
+
+    if ((size < 1) || (size >= UINT16_MAX))
+        return -1;
+
+    file = fopen(filename, "wb");
+
+    if (file == NULL)
+        return -1;
+
+    memset(buffer, 0, sizeof(buffer));
+    dlt_set_storageheader(storage, "ECU1");
+
+    standard->htyp = DLT_HTYP_UEH | DLT_HTYP_WEID | DLT_HTYP_WTMS | DLT_HTYP_PROTOCOL_VERSION1;
+    message_size = sizeof(DltStandardHeader) + DLT_SIZE_WEID + DLT_SIZE_WTMS +
+        sizeof(DltExtendedHeader) + sizeof(uint32_t) + sizeof(uint16_t) + length;
+    standard->len = DLT_HTOBE_16((uint16_t)message_size);
+
+    dlt_set_id((char *)extra, "ECU1");
+    extended->msin = DLT_MSIN_VERB | (DLT_TYPE_LOG << DLT_MSIN_MSTP_SHIFT) |
+        ((DLT_LOG_INFO << DLT_MSIN_MTIN_SHIFT) & DLT_MSIN_MTIN);
+    extended->noar = 1;
+    dlt_set_id(extended->apid, "BNCC");
+    dlt_set_id(extended->ctid, "BNCH");
+
+    memcpy(payload, &type_info, sizeof(uint32_t));
+    memcpy(payload + sizeof(uint32_t), &length, sizeof(uint16_t));
+    memset(payload + sizeof(uint32_t) + sizeof(uint16_t), 'x', (size_t)size);
+
+    for (i = 0; i < count; i++) {
+        standard->mcnt = (uint8_t)i;
+        tmsp = DLT_HTOBE_32((uint32_t)i);
+        memcpy(extra + DLT_SIZE_WEID, &tmsp, sizeof(uint32_t));
+
+        if (fwrite(buffer, sizeof(DltStorageHeader) + message_size, 1, file) != 1) {
+            fclose(file);
+            return -1;
+        }
+    }
+
+    fclose(file);
+
+    return 0;
+}
+
+/**
+ * Main function of tool.
+ */
+int main(int argc, char *argv[])
+{
+    DltBenchmarkResult read_result;
+    DltBenchmarkResult convert_result;
+    DltFile file;
+    FILE *out = stdout;
+    char generated[] = "/tmp/dlt-benchmark-convert-XXXXXX";
+    char *filename = NULL;
+    char *ovalue = NULL;
+    char *text;
+    unsigned long messages = 1000000;
+    uint64_t start, begin;
+    double cpu;
+    int size = 64;
+    int fd;
+    int c, i;
+
+    while ((c = getopt(argc, argv, "hn:s:o:")) != -1)
+        switch (c) {
+        case 'n':
+        {
+            messages = strtoul(optarg, NULL, 10);
+            break;
+        }
+        case 's':
+        {
+            size = atoi(optarg);
+            break;
+        }
+        case 'o':
+        {
+            ovalue = optarg;
+            break;
+        }
+        case 'h':
+        default:
+        {
+            usage();
+            return -1;
+        }
+        }
+
+    if (optind < argc) {
+        filename = argv[optind];
+    }
+    else {
+        fd = mkstemp(generated);
+
+        if (fd == -1) {
+            fprintf(stderr, "ERROR: Cannot create temporary file\n");
+            return -1;
+        }
+
+        close(fd);
+        filename = generated;
+
+        if (dlt_benchmark_convert_generate(filename, messages, size) != 0) {
+            fprintf(stderr, "ERROR: Cannot generate %s\n", filename);
+            unlink(generated);
+            return -1;
+        }
+    }
+
+    text = malloc(DLT_BENCHMARK_CONVERT_TEXTBUFSIZE);
+
+    if ((text == NULL) ||
+        (dlt_file_init(&file, 0) < DLT_RETURN_OK) ||
+        (dlt_file_open(&file, filename, 0) < DLT_RETURN_OK)) {
+        fprintf(stderr, "ERROR: Cannot open %s\n", filename);
+        free(text);
+        return -1;
+    }
+
+    /* Index the file */
+    dlt_benchmark_result_init(&read_result, "dlt_file_read", 0);
+    cpu = dlt_benchmark_cpu_seconds(0);
+    start = dlt_benchmark_now_ns();
+
+    while (dlt_file_read(&file, 0) >= DLT_RETURN_OK)
+        ;
+
+    read_result.seconds = (double)(dlt_benchmark_now_ns() - start) / 1e9;
+    read_result.cpu_seconds = dlt_benchmark_cpu_seconds(0) - cpu;
+    read_result.iterations = (unsigned long)file.counter;
+
+    /* Load and convert each message as dlt-convert -a does */
+    dlt_benchmark_result_init(&convert_result, "dlt_convert_ascii",
+                              ((unsigned long)file.counter < DLT_BENCHMARK_MAX_SAMPLES) ?
+                              (unsigned long)file.counter : DLT_BENCHMARK_MAX_SAMPLES);
+    cpu = dlt_benchmark_cpu_seconds(0);
+    start = dlt_benchmark_now_ns();
+
+    for (i = 0; i < file.counter; i++) {
+        begin = dlt_benchmark_now_ns();
+
+        if ((dlt_file_message(&file, i, 0) < DLT_RETURN_OK) ||
+            (dlt_message_header(&file.msg, text, DLT_BENCHMARK_CONVERT_TEXTBUFSIZE, 0) < DLT_RETURN_OK) ||
+            (dlt_message_payload(&file.msg, text, DLT_BENCHMARK_CONVERT_TEXTBUFSIZE,
+                                 DLT_OUTPUT_ASCII, 0) < DLT_RETURN_OK))
+            convert_result.dropped++;
+
+        dlt_benchmark_result_add_sample(&convert_result, dlt_benchmark_now_ns() - begin);
+    }
+
+    convert_result.seconds = (double)(dlt_benchmark_now_ns() - start) / 1e9;
+    convert_result.cpu_seconds = dlt_benchmark_cpu_seconds(0) - cpu;
+    convert_result.iterations = (unsigned long)file.counter;
+
+    dlt_file_free(&file, 0);
+    free(text);
+
+    if (filename == generated)
+        unlink(generated);
+
+    if (ovalue) {
+        out = fopen(ovalue, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", ovalue);
+            return -1;
+        }
+    }
+
+    dlt_benchmark_json_begin(out, "dlt-benchmark-convert");
+    dlt_benchmark_result_print(&read_result);
+    dlt_benchmark_json_result(out, &read_result);
+    dlt_benchmark_result_print(&convert_result);
+    dlt_benchmark_json_result(out, &convert_result);
+    dlt_benchmark_json_end(out);
+
+    if (ovalue)
+        fclose(out);
+
+    dlt_benchmark_result_free(&read_result);
+    dlt_benchmark_result_free(&convert_result);
+
+    return 0;
+}
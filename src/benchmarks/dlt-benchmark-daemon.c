@@ -0,0 +1,376 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-benchmark-daemon.c
+ */
+
+/*
+ * Ingestion rate of a running dlt-daemon with N producer processes and
+ * TCP fan-out to M clients. Every message carries the time it was logged,
+ * the clients measure the end-to-end latency from it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "dlt.h"
+#include "dlt_client.h"
+#include "dlt-benchmark-common.h"
+
+#define DLT_BENCHMARK_DAEMON_CTID         "BNCH"
+#define DLT_BENCHMARK_DAEMON_PRODUCERS_MAX 128
+#define DLT_BENCHMARK_DAEMON_CLIENTS_MAX   64
+#define DLT_BENCHMARK_DAEMON_IDLE_MS       2000 /* stop when nothing is received for this long */
+
+typedef struct
+{
+    DltClient client;
+    pthread_t thread;
+    atomic_ulong received;          /* benchmark messages received */
+    _Atomic uint64_t last;          /* time the last message was received */
+    DltBenchmarkResult latency;     /* end-to-end latency */
+} DltBenchmarkDaemonClient;
+
+static DltBenchmarkDaemonClient clients[DLT_BENCHMARK_DAEMON_CLIENTS_MAX];
+
+/**
+ * Print usage information of tool.
+ */
+static void usage(void)
+{
+    char version[255];
+
+    dlt_get_version(version, 255);
+
+    printf("Usage: dlt-benchmark-daemon [options] [hostname]\n");
+    printf("Measure ingestion rate and TCP fan-out of a running dlt-daemon.\n");
+    printf("%s \n", version);
+    printf("Options:\n");
+    printf("  -p producers  Number of producer processes (Default: 4)\n");
+    printf("  -c clients    Number of TCP clients (Default: 1)\n");
+    printf("  -n messages   Number of messages per producer (Default: 100000)\n");
+    printf("  -s size       Payload size in bytes (Default: 64)\n");
+    printf("  -P pid        Measure the CPU time of the dlt-daemon process\n");
+    printf("  -o filename   Write the JSON results to file (Default: stdout)\n");
+    printf("  -h            Usage\n");
+}
+
+static int dlt_benchmark_daemon_callback(DltMessage *message, void *data)
+{
+    DltBenchmarkDaemonClient *client = (DltBenchmarkDaemonClient *)data;
+    uint64_t now = dlt_benchmark_now_ns();
+    uint64_t logged;
+
+    if ((message == NULL) || (client == NULL) || (message->extendedheader == NULL) ||
+        !DLT_IS_HTYP_UEH(message->standardheader->htyp) ||
+        (memcmp(message->extendedheader->ctid, DLT_BENCHMARK_DAEMON_CTID, DLT_ID_SIZE) != 0))
+        return 0;
+
+    /* payload: type info and value of the time stamp, then the string */
+    if (DLT_IS_MSIN_VERB(message->extendedheader->msin) &&
+        (message->datasize >= (int32_t)(sizeof(uint32_t) + sizeof(uint64_t)))) {
+        memcpy(&logged, message->databuffer + sizeof(uint32_t), sizeof(uint64_t));
+        logged = DLT_ENDIAN_GET_64(message->standardheader->htyp, logged);
+
+        if (now >= logged)
+            dlt_benchmark_result_add_sample(&client->latency, now - logged);
+    }
+
+    atomic_fetch_add(&client->received, 1);
+    atomic_store(&client->last, now);
+
+    return 0;
+}
+
+static void *dlt_benchmark_daemon_receive(void *arg)
+{
+    DltBenchmarkDaemonClient *client = (DltBenchmarkDaemonClient *)arg;
+
+    dlt_client_main_loop(&client->client, client, 0);
+
+    return NULL;
+}
+
+/* Producer process: register, wait for the start signal, log */
+static void dlt_benchmark_daemon_produce(int index,
+                                         unsigned long count,
+                                         const char *payload,
+                                         int ready_fd,
+                                         int start_fd)
+{
+    DltContext context;
+    DltContextData data;
+    char apid[DLT_ID_SIZE + 1];
+    char c = 0;
+    unsigned long i;
+
+    snprintf(apid, sizeof(apid), "B%03d", index);
+    dlt_register_app(apid, "Daemon benchmark producer");
+    dlt_register_context(&context, DLT_BENCHMARK_DAEMON_CTID, "Benchmark context");
+
+    if ((write(ready_fd, &c, 1) != 1) || (read(start_fd, &c, 1) != 1))
+        _exit(1);
+
+    for (i = 0; i < count; i++) {
+        if (dlt_user_log_write_start(&context, &data, DLT_LOG_INFO) == DLT_RETURN_TRUE) {
+            dlt_user_log_write_uint64(&data, dlt_benchmark_now_ns());
+            dlt_user_log_write_string(&data, payload);
+            dlt_user_log_write_finish(&data);
+        }
+    }
+
+    dlt_unregister_context(&context);
+    dlt_unregister_app_flush_buffered_logs();
+    _exit(0);
+}
+
+/**
+ * Main function of tool.
+ */
+int main(int argc, char *argv[])
+{
+    DltBenchmarkResult ingest;
+    DltBenchmarkResult fanout;
+    FILE *out = stdout;
+    char host[] = "localhost";
+    char *hostname = host;
+    char *ovalue = NULL;
+    char *payload;
+    char name[64];
+    int ready[2];
+    int start[2];
+    int num_producers = 4;
+    int num_clients = 1;
+    int size = 64;
+    pid_t daemon_pid = 0;
+    unsigned long messages = 100000;
+    unsigned long total, received, last_received = 0;
+    uint64_t begin, idle, last;
+    double cpu = -1;
+    char c = 0;
+    int opt;
+    int i, j;
+
+    while ((opt = getopt(argc, argv, "hp:c:n:s:P:o:")) != -1)
+        switch (opt) {
+        case 'p':
+        {
+            num_producers = atoi(optarg);
+            break;
+        }
+        case 'c':
+        {
+            num_clients = atoi(optarg);
+            break;
+        }
+        case 'n':
+        {
+            messages = strtoul(optarg, NULL, 10);
+            break;
+        }
+        case 's':
+        {
+            size = atoi(optarg);
+            break;
+        }
+        case 'P':
+        {
+            daemon_pid = (pid_t)atoi(optarg);
+            break;
+        }
+        case 'o':
+        {
+            ovalue = optarg;
+            break;
+        }
+        case 'h':
+        default:
+        {
+            usage();
+            return -1;
+        }
+        }
+
+    if ((num_producers < 1) || (num_producers > DLT_BENCHMARK_DAEMON_PRODUCERS_MAX) ||
+        (num_clients < 1) || (num_clients > DLT_BENCHMARK_DAEMON_CLIENTS_MAX) ||
+        (messages == 0) || (size < 1)) {
+        fprintf(stderr, "ERROR: Invalid arguments\n");
+        usage();
+        return -1;
+    }
+
+    if (optind < argc)
+        hostname = argv[optind];
+
+    total = (unsigned long)num_producers * messages;
+
+    payload = malloc((size_t)size + 1);
+
+    if (payload == NULL)
+        return -1;
+
+    memset(payload, 'x', (size_t)size);
+    payload[size] = '\0';
+
+    /* Connect all clients before the producers start */
+    dlt_client_register_message_callback(dlt_benchmark_daemon_callback);
+
+    for (i = 0; i < num_clients; i++) {
+        dlt_client_init(&clients[i].client, 0);
+        atomic_init(&clients[i].received, 0);
+        atomic_init(&clients[i].last, 0);
+
+        if ((dlt_benchmark_result_init(&clients[i].latency, "latency",
+                                       (total < DLT_BENCHMARK_MAX_SAMPLES) ? total : DLT_BENCHMARK_MAX_SAMPLES) != 0) ||
+            (dlt_client_set_server_ip(&clients[i].client, hostname) == -1) ||
+            (dlt_client_connect(&clients[i].client, 0) == DLT_RETURN_ERROR)) {
+            fprintf(stderr, "ERROR: Cannot connect client %d to dlt-daemon\n", i);
+            return -1;
+        }
+
+        pthread_create(&clients[i].thread, NULL, dlt_benchmark_daemon_receive, &clients[i]);
+    }
+
+    if ((pipe(ready) != 0) || (pipe(start) != 0)) {
+        fprintf(stderr, "ERROR: Cannot create pipes\n");
+        return -1;
+    }
+
+    for (i = 0; i < num_producers; i++) {
+        pid_t pid = fork();
+
+        if (pid == 0) {
+            for (j = 0; j < num_clients; j++)
+                close(clients[j].client.sock);
+
+            dlt_benchmark_daemon_produce(i, messages, payload, ready[1], start[0]);
+        }
+        else if (pid < 0) {
+            fprintf(stderr, "ERROR: Cannot fork producer %d\n", i);
+            return -1;
+        }
+    }
+
+    /* start when all producers are registered */
+    for (i = 0; i < num_producers; i++)
+        if (read(ready[0], &c, 1) != 1)
+            return -1;
+
+    if (daemon_pid > 0)
+        cpu = dlt_benchmark_cpu_seconds(daemon_pid);
+
+    begin = idle = dlt_benchmark_now_ns();
+
+    for (i = 0; i < num_producers; i++)
+        if (write(start[1], &c, 1) != 1)
+            return -1;
+
+    /* wait until every client has everything or nothing arrives anymore */
+    for (;;) {
+        usleep(10000);
+
+        received = 0;
+
+        for (i = 0; i < num_clients; i++)
+            received += atomic_load(&clients[i].received);
+
+        if (received >= total * (unsigned long)num_clients)
+            break;
+
+        if (received != last_received) {
+            last_received = received;
+            idle = dlt_benchmark_now_ns();
+        }
+        else if ((dlt_benchmark_now_ns() - idle) / 1000000 > DLT_BENCHMARK_DAEMON_IDLE_MS) {
+            break;
+        }
+    }
+
+    if ((daemon_pid > 0) && (cpu >= 0))
+        cpu = dlt_benchmark_cpu_seconds(daemon_pid) - cpu;
+    else
+        cpu = -1;
+
+    while (wait(NULL) > 0)
+        ;
+
+    for (i = 0; i < num_clients; i++) {
+        shutdown(clients[i].client.sock, SHUT_RDWR);
+        pthread_join(clients[i].thread, NULL);
+        dlt_client_cleanup(&clients[i].client, 0);
+    }
+
+    /* Ingestion: what the first client received */
+    snprintf(name, sizeof(name), "daemon_ingest_%dp", num_producers);
+    ingest = clients[0].latency;
+    strncpy(ingest.name, name, sizeof(ingest.name) - 1);
+    ingest.iterations = atomic_load(&clients[0].received);
+    ingest.dropped = total - ingest.iterations;
+    last = atomic_load(&clients[0].last);
+    ingest.seconds = (last > begin) ? (double)(last - begin) / 1e9 : 0;
+    ingest.cpu_seconds = cpu;
+
+    /* Fan-out: what all clients received, latency of the last one */
+    snprintf(name, sizeof(name), "tcp_fanout_%dp_%dc", num_producers, num_clients);
+    fanout = clients[num_clients - 1].latency;
+    strncpy(fanout.name, name, sizeof(fanout.name) - 1);
+    fanout.iterations = 0;
+    last = begin;
+
+    for (i = 0; i < num_clients; i++) {
+        fanout.iterations += atomic_load(&clients[i].received);
+
+        if (atomic_load(&clients[i].last) > last)
+            last = atomic_load(&clients[i].last);
+    }
+
+    fanout.dropped = total * (unsigned long)num_clients - fanout.iterations;
+    fanout.seconds = (double)(last - begin) / 1e9;
+    fanout.cpu_seconds = cpu;
+
+    if (ovalue) {
+        out = fopen(ovalue, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", ovalue);
+            return -1;
+        }
+    }
+
+    dlt_benchmark_json_begin(out, "dlt-benchmark-daemon");
+    dlt_benchmark_result_print(&ingest);
+    dlt_benchmark_json_result(out, &ingest);
+    dlt_benchmark_result_print(&fanout);
+    dlt_benchmark_json_result(out, &fanout);
+    dlt_benchmark_json_end(out);
+
+    if (ovalue)
+        fclose(out);
+
+    for (i = 0; i < num_clients; i++)
+        dlt_benchmark_result_free(&clients[i].latency);
+
+    free(payload);
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-benchmark-user.c
+ */
+
+/*
+ * Per-call cost of DLT_LOG, with the log level of the context enabled and
+ * disabled, for the remote (daemon) or the file sink of libdlt.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dlt.h"
+#include "dlt-benchmark-common.h"
+
+#define DLT_BENCHMARK_USER_FILE_COUNT 2
+#define DLT_BENCHMARK_USER_FILE_SIZE  (64 * 1024 * 1024)
+
+/**
+ * Print usage information of tool.
+ */
+static void usage(void)
+{
+    char version[255];
+
+    dlt_get_version(version, 255);
+
+    printf("Usage: dlt-benchmark-user [options]\n");
+    printf("Measure the per-call cost of DLT_LOG.\n");
+    printf("%s \n", version);
+    printf("Options:\n");
+    printf("  -n count      Number of calls per case (Default: 1000000)\n");
+    printf("  -m sink       remote or file (Default: remote)\n");
+    printf("  -d directory  Directory of the file sink (Default: /tmp)\n");
+    printf("  -o filename   Write the JSON results to file (Default: stdout)\n");
+    printf("  -h            Usage\n");
+}
+
+static void dlt_benchmark_user_log(DltContext *context, DltLogLevelType level, unsigned long i)
+{
+#if !DLT_DISABLE_MACRO
+    DLT_LOG(*context, level, DLT_STRING("benchmark"), DLT_UINT32((uint32_t)i));
+#else
+    dlt_log_string_int(context, level, "benchmark", (int)i);
+#endif
+}
+
+/*
+ * The loop is timed as a whole for ns/op, as reading the clock costs more
+ * than a call with disabled log level. The latency percentiles are taken in
+ * a second pass over at most DLT_BENCHMARK_LATENCY_SAMPLES calls, timed one
+ * by one and corrected by the cost of the clock.
+ */
+static void dlt_benchmark_user_run(DltContext *context,
+                                   DltLogLevelType level,
+                                   const char *name,
+                                   unsigned long count,
+                                   FILE *out)
+{
+    DltBenchmarkResult result;
+    unsigned long samples = (count < DLT_BENCHMARK_LATENCY_SAMPLES) ? count : DLT_BENCHMARK_LATENCY_SAMPLES;
+    uint64_t start, begin, elapsed, overhead;
+    double cpu;
+    unsigned long i;
+
+    if (dlt_benchmark_result_init(&result, name, samples) != 0)
+        return;
+
+    cpu = dlt_benchmark_cpu_seconds(0);
+    start = dlt_benchmark_now_ns();
+
+    for (i = 0; i < count; i++)
+        dlt_benchmark_user_log(context, level, i);
+
+    result.seconds = (double)(dlt_benchmark_now_ns() - start) / 1e9;
+    result.cpu_seconds = dlt_benchmark_cpu_seconds(0) - cpu;
+    result.iterations = count;
+
+    overhead = dlt_benchmark_timer_overhead_ns();
+
+    for (i = 0; i < samples; i++) {
+        begin = dlt_benchmark_now_ns();
+        dlt_benchmark_user_log(context, level, i);
+        elapsed = dlt_benchmark_now_ns() - begin;
+        dlt_benchmark_result_add_sample(&result, (elapsed > overhead) ? elapsed - overhead : 0);
+    }
+
+    dlt_benchmark_result_print(&result);
+    dlt_benchmark_json_result(out, &result);
+    dlt_benchmark_result_free(&result);
+}
+
+/**
+ * Main function of tool.
+ */
+int main(int argc, char *argv[])
+{
+    DltContext context;
+    FILE *out = stdout;
+    char *sink = "remote";
+    char *directory = "/tmp";
+    char *ovalue = NULL;
+    char name[64];
+    unsigned long count = 1000000;
+    int c;
+
+    while ((c = getopt(argc, argv, "hn:m:d:o:")) != -1)
+        switch (c) {
+        case 'n':
+        {
+            count = strtoul(optarg, NULL, 10);
+            break;
+        }
+        case 'm':
+        {
+            sink = optarg;
+            break;
+        }
+        case 'd':
+        {
+            directory = optarg;
+            break;
+        }
+        case 'o':
+        {
+            ovalue = optarg;
+            break;
+        }
+        case 'h':
+        default:
+        {
+            usage();
+            return -1;
+        }
+        }
+
+    if ((count == 0) || ((strcmp(sink, "remote") != 0) && (strcmp(sink, "file") != 0))) {
+        fprintf(stderr, "ERROR: Invalid arguments\n");
+        usage();
+        return -1;
+    }
+
+    if (ovalue) {
+        out = fopen(ovalue, "w");
+
+        if (out == NULL) {
+            fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", ovalue);
+            return -1;
+        }
+    }
+
+    /* same sink setup as ara::log for LogMode::kFile */
+    if (strcmp(sink, "file") == 0) {
+        if (dlt_init_file_dir(directory,
+                              DLT_BENCHMARK_USER_FILE_COUNT,
+                              DLT_BENCHMARK_USER_FILE_SIZE) < DLT_RETURN_OK) {
+            fprintf(stderr, "ERROR: Cannot log to directory %s\n", directory);
+
+            if (ovalue)
+                fclose(out);
+
+            return -1;
+        }
+
+        dlt_disable_daemon();
+    }
+
+    dlt_register_app("BNCU", "DLT_LOG benchmark");
+    dlt_register_context_ll_ts(&context, "BNCH", "Benchmark context", DLT_LOG_INFO, DLT_TRACE_STATUS_OFF);
+
+    dlt_benchmark_json_begin(out, "dlt-benchmark-user");
+
+    snprintf(name, sizeof(name), "dlt_log_enabled_%s", sink);
+    dlt_benchmark_user_run(&context, DLT_LOG_INFO, name, count, out);
+
+    snprintf(name, sizeof(name), "dlt_log_disabled_%s", sink);
+    dlt_benchmark_user_run(&context, DLT_LOG_VERBOSE, name, count, out);
+
+    dlt_benchmark_json_end(out);
+
+    dlt_unregister_context(&context);
+    dlt_unregister_app();
+
+    if (ovalue)
+        fclose(out);
+
+    return 0;
+}
@@ -55,6 +55,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -76,6 +78,9 @@
 #define DLT_CTRL_APID    "DLTC"
 #define DLT_CTRL_CTID    "DLTC"
 #define DLT_DAEMON_DEFAULT_CTRL_SOCK_PATH "/tmp/dlt-ctrl.sock"
+/* Request sent after operations with several responses, its response tells
+ * that all responses of the operation were received */
+#define DLT_CTRL_BATCH_FENCE DLT_SERVICE_ID_GET_LOCAL_TIME
 
 /** @brief Analyze the daemon answer
  *
@@ -94,10 +99,13 @@ static DltClient g_client;
 static int callback_return = -1;
 static pthread_mutex_t answer_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t answer_cond = PTHREAD_COND_INITIALIZER;
+static DltControlBatch *batch_active; /* batch waiting for responses */
 
 static int local_verbose;
 static char local_ecuid[DLT_CTRL_ECUID_LEN]; /* Name of ECU */
 static int local_timeout;
+static char *local_server; /* host to connect to over TCP */
+static int local_port;
 
 int get_verbosity(void)
 {
@@ -165,6 +173,17 @@ void set_resync_serial_header(const int value)
     g_client.resync_serial_header = value;
 }
 
+void set_server(char *host, int port)
+{
+    free(local_server);
+    local_server = NULL;
+
+    if (host != NULL)
+        local_server = strdup(host);
+
+    local_port = port;
+}
+
 int dlt_parse_config_param(char *config_id, char **config_data)
 {
     FILE *pFile = NULL;
@@ -430,6 +449,18 @@ static int dlt_control_init_connection(DltClient *client, void *cb)
 
     dlt_client_register_message_callback(callback);
 
+    if (local_server != NULL) {
+        client->mode = DLT_CLIENT_MODE_TCP;
+        client->port = local_port;
+
+        if (dlt_client_set_server_ip(client, local_server) == -1) {
+            pr_error("set server ip didn't succeed\n");
+            return -1;
+        }
+
+        return dlt_client_connect(client, get_verbosity());
+    }
+
     client->socketPath = NULL;
 
     if (dlt_parse_config_param("ControlSocketPath", &client->socketPath) != 0) {
@@ -461,6 +492,145 @@ static void *dlt_control_listen_to_daemon(void *data)
     return data;
 }
 
+/** @brief Convert a DLT answer to text
+ *
+ * @param message The DLT answer
+ * @param text Buffer of DLT_RECEIVE_BUFSIZE bytes for the text
+ */
+static void dlt_control_message_text(DltMessage *message, char *text)
+{
+    /* prepare storage header */
+    if (DLT_IS_HTYP_WEID(message->standardheader->htyp))
+        dlt_set_storageheader(message->storageheader, message->headerextra.ecu);
+    else
+        dlt_set_storageheader(message->storageheader, "LCTL");
+
+    dlt_message_header(message, text, DLT_RECEIVE_BUFSIZE, get_verbosity());
+
+    /* Extracting payload */
+    dlt_message_payload(message, text,
+                        DLT_RECEIVE_BUFSIZE,
+                        DLT_OUTPUT_ASCII,
+                        get_verbosity());
+}
+
+/** @brief Get the monotonic time in us */
+static uint64_t dlt_control_batch_now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (uint64_t)t.tv_sec * 1000000ULL + (uint64_t)t.tv_nsec / 1000;
+}
+
+/** @brief Get the service id of the request of an operation */
+static uint32_t dlt_control_batch_service_id(DltControlBatchOp *op)
+{
+    uint32_t id = 0;
+
+    if ((op->body.data != NULL) && (op->body.size >= sizeof(uint32_t)))
+        memcpy(&id, op->body.data, sizeof(uint32_t));
+
+    return id;
+}
+
+/** @brief Match a DLT answer to an operation of the running batch
+ *
+ * The daemon answers the requests of a connection in order, so a response
+ * belongs to the oldest operation of the same service which still waits for
+ * responses, and all operations sent before it got their responses already.
+ * Operations answered with one response per matching context are followed
+ * by a fence request, the response to the fence closes them.
+ * Has to be called with answer_lock held.
+ *
+ * @param batch The running batch
+ * @param message The DLT answer
+ */
+static void dlt_control_batch_answer(DltControlBatch *batch, DltMessage *message)
+{
+    char text[DLT_RECEIVE_BUFSIZE] = { 0 };
+    DltControlBatchOp *op = NULL;
+    uint32_t id_tmp = 0;
+    uint32_t id = 0;
+    uint64_t now;
+    int result;
+    int fence;
+    int i;
+
+    if (!DLT_MSG_IS_CONTROL_RESPONSE(message) ||
+        (message->databuffer == NULL) ||
+        (message->datasize < (int32_t)sizeof(uint32_t)))
+        return;
+
+    memcpy(&id_tmp, message->databuffer, sizeof(uint32_t));
+    id = DLT_ENDIAN_GET_32(message->standardheader->htyp, id_tmp);
+    fence = (id == DLT_CTRL_BATCH_FENCE);
+
+    for (i = batch->first; i < batch->sent; i++) {
+        if (!batch->ops[i].open)
+            continue;
+
+        if ((fence && batch->ops[i].multi) ||
+            (!fence && (dlt_control_batch_service_id(&batch->ops[i]) == id))) {
+            op = &(batch->ops[i]);
+            break;
+        }
+    }
+
+    if (op == NULL) {
+        pr_verbose("Unexpected response to service 0x%x\n", id);
+        return;
+    }
+
+    now = dlt_control_batch_now();
+
+    /* Older operations will not get any response anymore */
+    for (i = batch->first; &(batch->ops[i]) < op; i++) {
+        if (!batch->ops[i].open)
+            continue;
+
+        batch->ops[i].open = 0;
+
+        if (!batch->ops[i].done) {
+            batch->ops[i].done = 1;
+            batch->ops[i].result = -1;
+            batch->ops[i].latency = now - batch->ops[i].sent;
+        }
+    }
+
+    if (fence) {
+        op->open = 0;
+
+        /* no context matched if there was no response */
+        if ((op->responses == 0) && !op->done)
+            op->result = -1;
+    }
+    else {
+        dlt_control_message_text(message, text);
+        result = response_analyzer_cb(text,
+                                      message->databuffer,
+                                      (int) message->datasize);
+
+        /* a single failed response fails the operation */
+        if (!op->done && ((op->responses == 0) || (result != 0)))
+            op->result = result;
+
+        op->responses++;
+
+        if (!op->multi)
+            op->open = 0;
+    }
+
+    if (!op->open && !op->done) {
+        op->done = 1;
+        op->latency = now - op->sent;
+    }
+
+    while ((batch->first < batch->sent) && !batch->ops[batch->first].open)
+        batch->first++;
+}
+
 /** @brief Internal callback for DLT response
  *
  * This function is called by the dlt_client_main_loop once a response is read
@@ -472,6 +642,8 @@ static void *dlt_control_listen_to_daemon(void *data)
  * provided using a global variable.
  * Access to this variable is controlled through a dedicated mutex.
  * New values are signaled using a dedicated condition variable.
+ * While a batch is running the response is matched to its operations
+ * instead.
  *
  * @param message The DLT answer
  * @param data Unused
@@ -488,19 +660,18 @@ static int dlt_control_callback(DltMessage *message, void *data)
         return -1;
     }
 
-    /* prepare storage header */
-    if (DLT_IS_HTYP_WEID(message->standardheader->htyp))
-        dlt_set_storageheader(message->storageheader, message->headerextra.ecu);
-    else
-        dlt_set_storageheader(message->storageheader, "LCTL");
+    pthread_mutex_lock(&answer_lock);
 
-    dlt_message_header(message, text, DLT_RECEIVE_BUFSIZE, get_verbosity());
+    if (batch_active != NULL) {
+        dlt_control_batch_answer(batch_active, message);
+        pthread_cond_signal(&answer_cond);
+        pthread_mutex_unlock(&answer_lock);
+        return 0;
+    }
 
-    /* Extracting payload */
-    dlt_message_payload(message, text,
-                        DLT_RECEIVE_BUFSIZE,
-                        DLT_OUTPUT_ASCII,
-                        get_verbosity());
+    pthread_mutex_unlock(&answer_lock);
+
+    dlt_control_message_text(message, text);
 
     /*
      * Checking payload with the provided callback and return the result
@@ -646,6 +817,506 @@ int dlt_control_deinit(void)
     return dlt_client_cleanup(&g_client, get_verbosity());
 }
 
+/** @brief Append the request of an operation to the send buffer
+ *
+ * @param body The request
+ * @param apid Application id of the extended header or NULL
+ * @param ctid Context id of the extended header or NULL
+ * @param buffer The send buffer, grown as needed
+ * @param length The length of the data in the send buffer
+ * @param size The size of the send buffer
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int dlt_control_batch_append(DltControlMsgBody *body,
+                                    char *apid,
+                                    char *ctid,
+                                    uint8_t **buffer,
+                                    size_t *length,
+                                    size_t *size)
+{
+    DltMessage *msg = NULL;
+    uint8_t *tmp = NULL;
+    size_t header_size;
+    size_t serial_size = 0;
+    size_t needed;
+
+    msg = dlt_control_prepare_message(body);
+
+    if (msg == NULL) {
+        pr_error("Control message preparation failed\n");
+        return -1;
+    }
+
+    if ((apid != NULL) && (apid[0] != '\0'))
+        memcpy(msg->extendedheader->apid, apid, DLT_ID_SIZE);
+
+    if ((ctid != NULL) && (ctid[0] != '\0'))
+        memcpy(msg->extendedheader->ctid, ctid, DLT_ID_SIZE);
+
+    if (g_client.send_serial_header)
+        serial_size = sizeof(dltSerialHeader);
+
+    header_size = (size_t)msg->headersize - sizeof(DltStorageHeader);
+    needed = *length + serial_size + header_size + (size_t)msg->datasize;
+
+    if (needed > *size) {
+        tmp = realloc(*buffer, needed * 2);
+
+        if (tmp == NULL) {
+            pr_error("Cannot allocate memory for the batch\n");
+            dlt_message_free(msg, get_verbosity());
+            free(msg);
+            return -1;
+        }
+
+        *buffer = tmp;
+        *size = needed * 2;
+    }
+
+    memcpy(*buffer + *length, dltSerialHeader, serial_size);
+    *length += serial_size;
+    memcpy(*buffer + *length, msg->headerbuffer + sizeof(DltStorageHeader), header_size);
+    *length += header_size;
+    memcpy(*buffer + *length, msg->databuffer, (size_t)msg->datasize);
+    *length += (size_t)msg->datasize;
+
+    dlt_message_free(msg, get_verbosity());
+    free(msg);
+
+    return 0;
+}
+
+/** @brief Send the whole buffer to the daemon
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int dlt_control_batch_write(uint8_t *buffer, size_t length)
+{
+    ssize_t ret;
+
+    while (length > 0) {
+        ret = send(g_client.sock, buffer, length, 0);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            pr_error("Sending batch to daemon failed: %s\n", strerror(errno));
+            return -1;
+        }
+
+        buffer += ret;
+        length -= (size_t)ret;
+    }
+
+    return 0;
+}
+
+/** @brief Send a batch and wait for the answers
+ *
+ * Up to window requests are sent in one go without waiting for the answers,
+ * each answer received lets the next requests be sent. The answers are
+ * matched to the operations by the listener thread. An operation without
+ * answer within the timeout fails.
+ *
+ * @param batch The batch to be sent
+ * @param window The max number of requests in flight
+ * @param timeout The time to wait for the answer to a request, in ms
+ *
+ * @return The number of failed operations, -1 in case of early error.
+ */
+int dlt_control_batch_send(DltControlBatch *batch, int window, int timeout)
+{
+    DltControlBatchOp *op = NULL;
+    DltControlMsgBody fence_body;
+    uint32_t fence_id = DLT_CTRL_BATCH_FENCE;
+    uint8_t *buffer = NULL;
+    size_t length = 0;
+    size_t size = 0;
+    uint64_t start, now, deadline, wait;
+    struct timespec t;
+    int inflight;
+    int failed = 0;
+    int ret = 0;
+    int i;
+
+    if ((batch == NULL) || (window <= 0) || (timeout <= 0)) {
+        pr_error("%s: Invalid input.\n", __func__);
+        return -1;
+    }
+
+    fence_body.data = &fence_id;
+    fence_body.size = sizeof(uint32_t);
+
+    for (i = 0; i < batch->count; i++) {
+        op = &(batch->ops[i]);
+        op->result = -1;
+        op->responses = 0;
+        op->done = 0;
+        op->open = 0;
+        op->timed_out = 0;
+        op->sent = 0;
+        op->latency = 0;
+    }
+
+    batch->first = 0;
+    batch->sent = 0;
+
+    pthread_mutex_lock(&answer_lock);
+    batch_active = batch;
+    start = dlt_control_batch_now();
+
+    while (1) {
+        now = dlt_control_batch_now();
+        inflight = 0;
+        deadline = 0;
+
+        /* Expire the requests without answer */
+        for (i = batch->first; i < batch->sent; i++) {
+            op = &(batch->ops[i]);
+
+            if (op->done)
+                continue;
+
+            if (now >= op->sent + (uint64_t)timeout * 1000) {
+                op->done = 1;
+                op->timed_out = 1;
+                op->result = -1;
+                op->latency = now - op->sent;
+                continue;
+            }
+
+            /* operations are sent in order, the first one expires first */
+            if (deadline == 0)
+                deadline = op->sent + (uint64_t)timeout * 1000;
+
+            inflight++;
+        }
+
+        if ((batch->sent == batch->count) && (inflight == 0))
+            break;
+
+        if ((batch->sent < batch->count) && (inflight < window)) {
+            length = 0;
+
+            while ((batch->sent < batch->count) && (inflight < window)) {
+                op = &(batch->ops[batch->sent]);
+
+                if ((dlt_control_batch_append(&(op->body), op->apid, op->ctid,
+                                              &buffer, &length, &size) != 0) ||
+                    (op->multi &&
+                     (dlt_control_batch_append(&fence_body, NULL, NULL,
+                                               &buffer, &length, &size) != 0))) {
+                    ret = -1;
+                    break;
+                }
+
+                op->open = 1;
+                op->sent = now;
+                batch->sent++;
+                inflight++;
+            }
+
+            if (ret != 0)
+                break;
+
+            /* The listener thread needs the lock to handle the answers */
+            pthread_mutex_unlock(&answer_lock);
+            ret = dlt_control_batch_write(buffer, length);
+            pthread_mutex_lock(&answer_lock);
+
+            if (ret != 0)
+                break;
+
+            continue;
+        }
+
+        /* Wait for an answer or the first timeout */
+        wait = deadline - now;
+
+        if (clock_gettime(CLOCK_REALTIME, &t) == -1) {
+            pr_error("Cannot read system time.\n");
+            ret = -1;
+            break;
+        }
+
+        t.tv_sec += (time_t)(wait / 1000000);
+        t.tv_nsec += (long)(wait % 1000000) * 1000;
+
+        if (t.tv_nsec >= NANOSEC_PER_SEC) {
+            t.tv_sec++;
+            t.tv_nsec -= NANOSEC_PER_SEC;
+        }
+
+        pthread_cond_timedwait(&answer_cond, &answer_lock, &t);
+    }
+
+    batch->elapsed = dlt_control_batch_now() - start;
+    batch_active = NULL;
+
+    for (i = 0; i < batch->count; i++) {
+        op = &(batch->ops[i]);
+
+        /* The remaining operations fail if sending failed */
+        if (!op->done) {
+            op->done = 1;
+            op->result = -1;
+        }
+
+        if (op->result != 0)
+            failed++;
+    }
+
+    pthread_mutex_unlock(&answer_lock);
+
+    free(buffer);
+
+    if (ret != 0)
+        return -1;
+
+    return failed;
+}
+
+/** @brief Read the operations of a batch
+ *
+ * The words of each line are split at blanks, double quotes group words.
+ *
+ * @param batch The batch to be filled
+ * @param filename The file to read, "-" for stdin
+ * @param parse Function filling an operation from the words of a line
+ *
+ * @return The number of operations read, -1 on error.
+ */
+int dlt_control_batch_read(DltControlBatch *batch,
+                           const char *filename,
+                           int (*parse)(int, char **, DltControlBatchOp *))
+{
+    static char batch_name[] = "batch";
+    char line[DLT_CTRL_BATCH_LINE_MAX] = { 0 };
+    char *argv[DLT_CTRL_BATCH_ARGS_MAX + 1] = { 0 };
+    DltControlBatchOp *ops = NULL;
+    DltControlBatchOp *op = NULL;
+    FILE *file = NULL;
+    char *start = NULL;
+    char *in = NULL;
+    char *out = NULL;
+    size_t length;
+    int line_number = 0;
+    int quoted;
+    int argc;
+
+    if ((batch == NULL) || (filename == NULL) || (parse == NULL)) {
+        pr_error("%s: Invalid input.\n", __func__);
+        return -1;
+    }
+
+    if (strcmp(filename, "-") == 0)
+        file = stdin;
+    else
+        file = fopen(filename, "r");
+
+    if (file == NULL) {
+        pr_error("Cannot open batch file %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        length = strcspn(line, "\r\n");
+
+        if ((line[length] == '\0') && !feof(file)) {
+            pr_error("Line %d of %s is too long\n", line_number, filename);
+            goto error;
+        }
+
+        line[length] = '\0';
+        start = line + strspn(line, " \t");
+
+        if ((*start == '\0') || (*start == '#'))
+            continue;
+
+        if (batch->count >= batch->size) {
+            ops = realloc(batch->ops,
+                          sizeof(DltControlBatchOp) * (size_t)(batch->size ? batch->size * 2 : 64));
+
+            if (ops == NULL) {
+                pr_error("Cannot allocate memory for the batch\n");
+                goto error;
+            }
+
+            batch->ops = ops;
+            batch->size = batch->size ? batch->size * 2 : 64;
+        }
+
+        op = &(batch->ops[batch->count]);
+        memset(op, 0, sizeof(DltControlBatchOp));
+        op->line = line_number;
+        op->name = strdup(start);
+
+        if (op->name == NULL) {
+            pr_error("Cannot allocate memory for the batch\n");
+            goto error;
+        }
+
+        /* Split the line into words */
+        argv[0] = batch_name;
+        argc = 1;
+        in = start;
+
+        while (*in != '\0') {
+            in += strspn(in, " \t");
+
+            if (*in == '\0')
+                break;
+
+            if (argc >= DLT_CTRL_BATCH_ARGS_MAX) {
+                pr_error("Too many arguments at line %d of %s\n", line_number, filename);
+                free(op->name);
+                goto error;
+            }
+
+            argv[argc++] = out = in;
+            quoted = 0;
+
+            while ((*in != '\0') && (quoted || ((*in != ' ') && (*in != '\t')))) {
+                if (*in == '"')
+                    quoted = !quoted;
+                else
+                    *out++ = *in;
+
+                in++;
+            }
+
+            if (*in != '\0')
+                in++;
+
+            *out = '\0';
+        }
+
+        argv[argc] = NULL;
+
+        if (parse(argc, argv, op) != 0) {
+            pr_error("Invalid operation at line %d of %s: %s\n", line_number, filename, op->name);
+            free(op->name);
+            free(op->body.data);
+            goto error;
+        }
+
+        batch->count++;
+    }
+
+    if (file != stdin)
+        fclose(file);
+
+    return batch->count;
+
+error:
+    if (file != stdin)
+        fclose(file);
+
+    return -1;
+}
+
+/** @brief Compare two latencies for qsort */
+static int dlt_control_batch_compare(const void *a, const void *b)
+{
+    uint64_t la = *(const uint64_t *)a;
+    uint64_t lb = *(const uint64_t *)b;
+
+    return (la > lb) - (la < lb);
+}
+
+/** @brief Print the failed operations and the latency of a batch
+ *
+ * The latency of each operation is printed in verbose mode.
+ *
+ * @param batch The batch which was sent
+ */
+void dlt_control_batch_report(DltControlBatch *batch)
+{
+    DltControlBatchOp *op = NULL;
+    uint64_t *latencies = NULL;
+    uint64_t sum = 0;
+    int answered = 0;
+    int failed = 0;
+    int timed_out = 0;
+    int i;
+
+    if ((batch == NULL) || (batch->count == 0))
+        return;
+
+    latencies = calloc((size_t)batch->count, sizeof(uint64_t));
+
+    for (i = 0; i < batch->count; i++) {
+        op = &(batch->ops[i]);
+
+        if (op->result != 0) {
+            failed++;
+
+            if (op->timed_out)
+                timed_out++;
+
+            printf("FAILED line %d: %s (%s)\n",
+                   op->line,
+                   op->name,
+                   op->timed_out ? "timeout" :
+                   (op->sent == 0) ? "not sent" :
+                   (op->responses == 0) ? "no response" : "error");
+        }
+        else if (get_verbosity()) {
+            printf("ok     line %d: %s (%.3f ms)\n",
+                   op->line, op->name, (double)op->latency / 1000);
+        }
+
+        if ((op->sent != 0) && !op->timed_out && (latencies != NULL)) {
+            latencies[answered++] = op->latency;
+            sum += op->latency;
+        }
+    }
+
+    printf("%d operations in %.3f ms (%.0f/s): %d ok, %d failed, %d timed out\n",
+           batch->count,
+           (double)batch->elapsed / 1000,
+           batch->elapsed ? (double)batch->count * 1000000 / (double)batch->elapsed : 0.0,
+           batch->count - failed,
+           failed,
+           timed_out);
+
+    if (answered > 0) {
+        qsort(latencies, (size_t)answered, sizeof(uint64_t), dlt_control_batch_compare);
+
+        printf("Latency: min %.3f ms, avg %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+               (double)latencies[0] / 1000,
+               (double)sum / answered / 1000,
+               (double)latencies[(answered - 1) / 2] / 1000,
+               (double)latencies[((answered * 99) + 99) / 100 - 1] / 1000,
+               (double)latencies[answered - 1] / 1000);
+    }
+
+    free(latencies);
+}
+
+/** @brief Free the operations of a batch
+ *
+ * @param batch The batch to be freed
+ */
+void dlt_control_batch_free(DltControlBatch *batch)
+{
+    int i;
+
+    if (batch == NULL)
+        return;
+
+    for (i = 0; i < batch->count; i++) {
+        free(batch->ops[i].name);
+        free(batch->ops[i].body.data);
+    }
+
+    free(batch->ops);
+    memset(batch, 0, sizeof(DltControlBatch));
+}
+
 
 #ifdef EXTENDED_FILTERING /* EXTENDED_FILTERING */
 #   if defined(__linux__) || defined(__ANDROID_API__)
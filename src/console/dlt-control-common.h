@@ -61,6 +61,41 @@ typedef struct
     uint32_t size;   /**< size of that data */
 } DltControlMsgBody;
 
+/* Requests in flight at once in batch mode */
+#define DLT_CTRL_BATCH_WINDOW 32
+/* Max length of a line of a batch file */
+#define DLT_CTRL_BATCH_LINE_MAX 1024
+/* Max number of arguments on a line of a batch file */
+#define DLT_CTRL_BATCH_ARGS_MAX 32
+
+/* One operation of a batch, sent without waiting for the previous answers */
+typedef struct
+{
+    DltControlMsgBody body; /**< request to be send to DLT Daemon */
+    char apid[DLT_ID_SIZE]; /**< application id of the extended header, DLTC if empty */
+    char ctid[DLT_ID_SIZE]; /**< context id of the extended header, DLTC if empty */
+    int multi;              /**< 1 if the daemon answers with one response per matching context */
+    char *name;             /**< text of the operation, printed in the report */
+    int line;               /**< line of the operation in the batch file */
+    int result;             /**< analyzer return value, -1 on error or timeout */
+    int responses;          /**< number of responses received */
+    int done;               /**< 1 once the result is known */
+    int open;               /**< 1 while responses to the request may still come */
+    int timed_out;          /**< 1 if no answer came within the timeout */
+    uint64_t sent;          /**< time the request was sent, in us */
+    uint64_t latency;       /**< time from sending the request to its answer, in us */
+} DltControlBatchOp;
+
+typedef struct
+{
+    DltControlBatchOp *ops; /**< operations in the order of the batch file */
+    int count;              /**< number of operations */
+    int size;               /**< number of allocated operations */
+    int first;              /**< first operation which may still get responses */
+    int sent;               /**< number of operations sent */
+    uint64_t elapsed;       /**< time to run the whole batch, in us */
+} DltControlBatch;
+
 /* As verbosity, ecuid, timeout, send_serial_header, resync_serial_header are
  * needed during the communication, defining getter and setters here.
  * Then there is no need to define them in the control's user application.
@@ -91,6 +126,28 @@ int dlt_control_send_message(DltControlMsgBody *, int);
 /* Destroys the connection to the daemon */
 int dlt_control_deinit(void);
 
+/* Connect over TCP to the given host instead of the control socket.
+ * To be called before dlt_control_init. */
+void set_server(char *host, int port);
+
+/* Read the operations of a batch from a file, "-" for stdin. The words of
+ * each line are given to parse as arguments to fill one operation. Empty
+ * lines and lines starting with '#' are skipped. */
+int dlt_control_batch_read(DltControlBatch *batch,
+                           const char *filename,
+                           int (*parse)(int, char **, DltControlBatchOp *));
+
+/* Send all operations of a batch over the connection with up to window
+ * requests in flight and match the answers to them. The timeout is in ms
+ * per operation. Returns the number of failed operations, -1 on error. */
+int dlt_control_batch_send(DltControlBatch *batch, int window, int timeout);
+
+/* Print the failed operations and the latency of the batch */
+void dlt_control_batch_report(DltControlBatch *batch);
+
+/* Free the operations of a batch */
+void dlt_control_batch_free(DltControlBatch *batch);
+
 #ifdef EXTENDED_FILTERING
 /**
  * Load json filter from file.
@@ -103,7 +103,11 @@ typedef struct {
     int gflag;
     int jvalue;
     int kvalue;
+    int Lvalue;
+    int Mvalue;
+    int qvalue;
     int bvalue;
+    char *Bvalue;
     int port;
     int sendSerialHeaderFlag;
     int resyncSerialHeaderFlag;
@@ -140,6 +144,7 @@ void usage()
     printf("  -m message    Control message injection in ASCII\n");
     printf("  -x message    Control message injection in Hex e.g. 'ad 01 24 ef'\n");
     printf("  -t milliseconds Timeout to terminate application (Default:1000)'\n");
+    printf("                  With -B timeout of each operation\n");
     printf("  -l loglevel      Set the log level (0=off - 6=verbose default= -1)\n");
     printf("      supported options:\n");
     printf("       -l level -a apid -c ctid\n");
@@ -163,6 +168,13 @@ void usage()
     printf("  -g              Reset to factory default\n");
     printf("  -j              Get log info\n");
     printf("  -k              Get software version\n");
+    printf("  -L              Get latency stats of applications started with DLT_LATENCY_TRACE\n");
+    printf("  -M              Get runtime metrics of the daemon\n");
+    printf("  -q              Get rate limits and the messages dropped by the daemon and the applications\n");
+    printf("  -B file         Send the operations of a file, '-' for stdin, over one connection\n");
+    printf("                  without waiting for each response and print a report.\n");
+    printf("                  Each line holds the options of one operation, e.g. -l 4 -a APP -c CON\n");
+    printf("                  supported options: -a -c -s -m -x -l -r -d -f -i -o -g\n");
     printf("  -u              unix port\n");
     printf("  -p port       Use the given port instead the default port\n");
     printf("                Cannot be used with serial devices\n");
@@ -282,6 +294,373 @@ void dlt_process_get_software_version(void)
     resp = NULL;
 }
 
+/**
+ * Function for sending get latency stats ctrl msg and printing the response.
+ */
+void dlt_process_get_latency_stats(void)
+{
+    DltServiceGetLatencyStatsResponse resp;
+
+    /* prepare request data */
+    resp.service_id = DLT_SERVICE_ID_GET_LATENCY_STATS;
+    resp.status = DLT_SERVICE_RESPONSE_ERROR;
+    resp.count = 0;
+
+    /* send control message*/
+    if (dlt_client_get_latency_stats(&g_dltclient) != DLT_RETURN_OK) {
+        fprintf(stderr, "ERROR: Get latency stats failed.\n");
+        return;
+    }
+
+    if (dlt_client_main_loop(&g_dltclient, (void *)&resp, 0) == DLT_RETURN_TRUE)
+        fprintf(stdout, "DLT-daemon's response is invalid.\n");
+
+    if ((resp.status == DLT_SERVICE_RESPONSE_OK) && (resp.count == 0))
+        printf("No stamped log messages received\n");
+}
+
+/**
+ * Function for sending get metrics ctrl msg and printing the response.
+ */
+void dlt_process_get_metrics(void)
+{
+    DltServiceGetMetricsResponse resp;
+
+    /* prepare request data */
+    resp.service_id = DLT_SERVICE_ID_GET_METRICS;
+    resp.status = DLT_SERVICE_RESPONSE_ERROR;
+    resp.length = 0;
+
+    /* send control message*/
+    if (dlt_client_get_metrics(&g_dltclient) != DLT_RETURN_OK) {
+        fprintf(stderr, "ERROR: Get metrics failed.\n");
+        return;
+    }
+
+    if (dlt_client_main_loop(&g_dltclient, (void *)&resp, 0) == DLT_RETURN_TRUE)
+        fprintf(stdout, "DLT-daemon's response is invalid.\n");
+}
+
+/**
+ * Function for sending get rate limit status ctrl msg and printing the response.
+ */
+void dlt_process_get_rate_limit_status(void)
+{
+    DltServiceGetRateLimitStatusResponse resp;
+
+    /* prepare request data */
+    resp.service_id = DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS;
+    resp.status = DLT_SERVICE_RESPONSE_ERROR;
+    resp.count = 0;
+
+    /* send control message*/
+    if (dlt_client_get_rate_limit_status(&g_dltclient) != DLT_RETURN_OK) {
+        fprintf(stderr, "ERROR: Get rate limit status failed.\n");
+        return;
+    }
+
+    if (dlt_client_main_loop(&g_dltclient, (void *)&resp, 0) == DLT_RETURN_TRUE)
+        fprintf(stdout, "DLT-daemon's response is invalid.\n");
+
+    if ((resp.status == DLT_SERVICE_RESPONSE_OK) && (resp.count == 0))
+        printf("No rate limits configured\n");
+}
+
+/**
+ * Allocate the request of a batch operation.
+ */
+static void *dlt_batch_op_alloc(DltControlBatchOp *op, uint32_t size)
+{
+    op->body.data = calloc(1, size);
+
+    if (op->body.data != NULL)
+        op->body.size = size;
+
+    return op->body.data;
+}
+
+/**
+ * Fill an operation of a batch from the options on a line of the batch file.
+ * The options are the ones of a single dlt-control call.
+ */
+static int dlt_parse_batch_op(int argc, char *argv[], DltControlBatchOp *op)
+{
+    char *apid = NULL;
+    char *ctid = NULL;
+    char *message = NULL;
+    char *hex = NULL;
+    uint32_t service = 0;
+    int loglevel = DLT_INVALID_LOG_LEVEL;
+    int tracestatus = DLT_INVALID_TRACE_STATUS;
+    int default_loglevel = -1;
+    int default_tracestatus = -1;
+    int timing = -1;
+    int store = 0;
+    int reset = 0;
+    int c;
+
+    optind = 1;
+
+    while ((c = getopt(argc, argv, "a:c:s:m:x:l:r:d:f:i:og")) != -1)
+        switch (c) {
+        case 'a':
+        {
+            apid = optarg;
+
+            if (strlen(apid) > DLT_ID_SIZE) {
+                fprintf(stderr, "Invalid application id\n");
+                return -1;
+            }
+
+            break;
+        }
+        case 'c':
+        {
+            ctid = optarg;
+
+            if (strlen(ctid) > DLT_ID_SIZE) {
+                fprintf(stderr, "Invalid context id\n");
+                return -1;
+            }
+
+            break;
+        }
+        case 's':
+        {
+            service = (uint32_t) atoi(optarg);
+            break;
+        }
+        case 'm':
+        {
+            message = optarg;
+            break;
+        }
+        case 'x':
+        {
+            hex = optarg;
+            break;
+        }
+        case 'l':
+        {
+            loglevel = (int) strtol(optarg, NULL, 10);
+
+            if ((loglevel < DLT_LOG_DEFAULT) || (loglevel > DLT_LOG_VERBOSE)) {
+                fprintf(stderr, "invalid log level, supported log level 0-6\n");
+                return -1;
+            }
+
+            break;
+        }
+        case 'r':
+        {
+            tracestatus = (int) strtol(optarg, NULL, 10);
+
+            if ((tracestatus < DLT_TRACE_STATUS_DEFAULT) || (tracestatus > DLT_TRACE_STATUS_ON)) {
+                fprintf(stderr, "invalid trace status, supported trace status -1, 0, 1\n");
+                return -1;
+            }
+
+            break;
+        }
+        case 'd':
+        {
+            default_loglevel = atoi(optarg);
+            break;
+        }
+        case 'f':
+        {
+            default_tracestatus = atoi(optarg);
+            break;
+        }
+        case 'i':
+        {
+            timing = atoi(optarg);
+            break;
+        }
+        case 'o':
+        {
+            store = 1;
+            break;
+        }
+        case 'g':
+        {
+            reset = 1;
+            break;
+        }
+        default:
+        {
+            fprintf(stderr, "Option -%c not allowed in a batch\n", isprint(optopt) ? optopt : '?');
+            return -1;
+        }
+        }
+
+    if (optind < argc) {
+        fprintf(stderr, "Unexpected argument '%s'\n", argv[optind]);
+        return -1;
+    }
+
+    if ((message != NULL || hex != NULL) && apid && ctid) {
+        /* injection, sent to the context itself */
+        uint8_t buffer[1024];
+        int size = (int) sizeof(buffer);
+        uint8_t *payload;
+
+        if (message != NULL) {
+            size = (int) strlen(message);
+
+            if (size > (int) sizeof(buffer)) {
+                fprintf(stderr, "Injection message too long\n");
+                return -1;
+            }
+
+            memcpy(buffer, message, (size_t) size);
+        }
+        else {
+            dlt_hex_ascii_to_binary(hex, buffer, &size);
+        }
+
+        payload = dlt_batch_op_alloc(op, (uint32_t) (sizeof(uint32_t) + sizeof(uint32_t) + (uint32_t) size));
+
+        if (payload == NULL)
+            return -1;
+
+        memcpy(payload, &service, sizeof(uint32_t));
+        memcpy(payload + sizeof(uint32_t), &size, sizeof(uint32_t));
+        memcpy(payload + sizeof(uint32_t) + sizeof(uint32_t), buffer, (size_t) size);
+        dlt_set_id(op->apid, apid);
+        dlt_set_id(op->ctid, ctid);
+    }
+    else if ((loglevel != DLT_INVALID_LOG_LEVEL) || (tracestatus != DLT_INVALID_TRACE_STATUS))
+    {
+        int level = (loglevel != DLT_INVALID_LOG_LEVEL) ? loglevel : tracestatus;
+
+        if ((apid == NULL) && (ctid == NULL)) {
+            DltServiceSetDefaultLogLevel *req = dlt_batch_op_alloc(op, sizeof(DltServiceSetDefaultLogLevel));
+
+            if (req == NULL)
+                return -1;
+
+            req->service_id = (loglevel != DLT_INVALID_LOG_LEVEL) ?
+                DLT_SERVICE_ID_SET_ALL_LOG_LEVEL : DLT_SERVICE_ID_SET_ALL_TRACE_STATUS;
+            req->log_level = (uint8_t) level;
+            dlt_set_id(req->com, "remo");
+        }
+        else {
+            DltServiceSetLogLevel *req = dlt_batch_op_alloc(op, sizeof(DltServiceSetLogLevel));
+
+            if (req == NULL)
+                return -1;
+
+            req->service_id = (loglevel != DLT_INVALID_LOG_LEVEL) ?
+                DLT_SERVICE_ID_SET_LOG_LEVEL : DLT_SERVICE_ID_SET_TRACE_STATUS;
+            dlt_set_id(req->apid, apid);
+            dlt_set_id(req->ctid, ctid);
+            req->log_level = (uint8_t) level;
+            dlt_set_id(req->com, "remo");
+
+            /* the daemon answers once per context matching only one id */
+            op->multi = (apid == NULL) || (ctid == NULL);
+        }
+    }
+    else if ((default_loglevel != -1) || (default_tracestatus != -1))
+    {
+        DltServiceSetDefaultLogLevel *req = dlt_batch_op_alloc(op, sizeof(DltServiceSetDefaultLogLevel));
+
+        if (req == NULL)
+            return -1;
+
+        req->service_id = (default_loglevel != -1) ?
+            DLT_SERVICE_ID_SET_DEFAULT_LOG_LEVEL : DLT_SERVICE_ID_SET_DEFAULT_TRACE_STATUS;
+        req->log_level = (uint8_t) ((default_loglevel != -1) ? default_loglevel : default_tracestatus);
+        dlt_set_id(req->com, "remo");
+    }
+    else if (timing != -1)
+    {
+        DltServiceSetVerboseMode *req = dlt_batch_op_alloc(op, sizeof(DltServiceSetVerboseMode));
+
+        if (req == NULL)
+            return -1;
+
+        req->service_id = DLT_SERVICE_ID_SET_TIMING_PACKETS;
+        req->new_status = (uint8_t) timing;
+    }
+    else if (store || reset)
+    {
+        uint32_t *service_id = dlt_batch_op_alloc(op, sizeof(uint32_t));
+
+        if (service_id == NULL)
+            return -1;
+
+        *service_id = store ? DLT_SERVICE_ID_STORE_CONFIG : DLT_SERVICE_ID_RESET_TO_FACTORY_DEFAULT;
+    }
+    else {
+        fprintf(stderr, "No operation given\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Check the status of a response to a batch operation.
+ */
+static int dlt_analyze_batch_response(char *text, void *payload, int len)
+{
+    (void)text;
+
+    if ((payload == NULL) || (len < (int) sizeof(DltServiceResponse)))
+        return -1;
+
+    return (((DltServiceResponse *)payload)->status == DLT_SERVICE_RESPONSE_OK) ? 0 : -1;
+}
+
+/**
+ * Send the operations of a batch file over one connection and print a report.
+ */
+int dlt_process_batch(DltReceiveData *dltdata)
+{
+    DltControlBatch batch = { 0 };
+    char ecuid[DLT_ID_SIZE + 1] = { 0 };
+    int ret = 0;
+
+    if (g_dltclient.mode == DLT_CLIENT_MODE_SERIAL) {
+        fprintf(stderr, "ERROR: Batch is not available for serial devices\n");
+        return -1;
+    }
+
+    if (dlt_control_batch_read(&batch, dltdata->Bvalue, dlt_parse_batch_op) <= 0) {
+        fprintf(stderr, "ERROR: No valid operation in batch file %s\n", dltdata->Bvalue);
+        dlt_control_batch_free(&batch);
+        return -1;
+    }
+
+    if (g_dltclient.mode == DLT_CLIENT_MODE_TCP)
+        set_server(g_dltclient.servIP, g_dltclient.port);
+
+    memcpy(ecuid, dltdata->ecuid, DLT_ID_SIZE);
+
+    if (ecuid[0] == '\0')
+        dlt_set_id(ecuid, DLT_CTRL_DEFAULT_ECUID);
+
+    set_send_serial_header(dltdata->sendSerialHeaderFlag);
+    set_resync_serial_header(dltdata->resyncSerialHeaderFlag);
+
+    if (dlt_control_init(dlt_analyze_batch_response, ecuid, dltdata->vflag) != 0) {
+        fprintf(stderr, "ERROR: Could not connect to the daemon\n");
+        ret = -1;
+    }
+    else {
+        ret = dlt_control_batch_send(&batch, DLT_CTRL_BATCH_WINDOW, dltdata->tvalue);
+        dlt_control_batch_report(&batch);
+        dlt_control_deinit();
+    }
+
+    set_server(NULL, 0);
+    dlt_control_batch_free(&batch);
+
+    return (ret == 0) ? 0 : -1;
+}
+
 /**
  * Main function of tool.
  */
@@ -313,7 +692,7 @@ int main(int argc, char *argv[])
     /* Default return value */
     ret = 0;
 
-    while ((c = getopt (argc, argv, "vhSRye:b:a:c:s:m:x:t:l:r:d:f:i:ogjkup:")) != -1)
+    while ((c = getopt (argc, argv, "vhSRye:b:B:a:c:s:m:x:t:l:r:d:f:i:ogjkLMqup:")) != -1)
         switch (c) {
         case 'v':
         {
@@ -350,6 +729,11 @@ int main(int argc, char *argv[])
             dltdata.bvalue = atoi(optarg);
             break;
         }
+        case 'B':
+        {
+            dltdata.Bvalue = optarg;
+            break;
+        }
 
         case 'a':
         {
@@ -450,6 +834,21 @@ int main(int argc, char *argv[])
             dltdata.kvalue = 1;
             break;
         }
+        case 'L':
+        {
+            dltdata.Lvalue = 1;
+            break;
+        }
+        case 'M':
+        {
+            dltdata.Mvalue = 1;
+            break;
+        }
+        case 'q':
+        {
+            dltdata.qvalue = 1;
+            break;
+        }
         case 'u':
         {
             dltdata.yflag = DLT_CLIENT_MODE_UNIX;
@@ -565,8 +964,12 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (dltdata.Bvalue != NULL) {
+        /* send the operations of the batch file */
+        ret = dlt_process_batch(&dltdata);
+    }
     /* Connect to TCP socket or open serial device */
-    if (dlt_client_connect(&g_dltclient, dltdata.vflag) != DLT_RETURN_ERROR) {
+    else if (dlt_client_connect(&g_dltclient, dltdata.vflag) != DLT_RETURN_ERROR) {
         /* send injection message */
         if (dltdata.mvalue && dltdata.avalue && dltdata.cvalue) {
             /* ASCII */
@@ -746,6 +1149,23 @@ int main(int argc, char *argv[])
             printf("Get software version:\n");
             dlt_process_get_software_version();
         }
+        else if (dltdata.Lvalue == 1)
+        {
+            /* Get latency stats */
+            printf("Get latency stats:\n");
+            dlt_process_get_latency_stats();
+        }
+        else if (dltdata.Mvalue == 1)
+        {
+            /* Get metrics */
+            dlt_process_get_metrics();
+        }
+        else if (dltdata.qvalue == 1)
+        {
+            /* Get rate limit status */
+            printf("Get rate limit status:\n");
+            dlt_process_get_rate_limit_status();
+        }
 
         /* Dlt Client Main Loop */
         /*dlt_client_main_loop(&dltclient, &dltdata, dltdata.vflag); */
@@ -795,7 +1215,8 @@ int dlt_receive_message_callback(DltMessage *message, void *data)
     DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
     id = DLT_ENDIAN_GET_32(message->standardheader->htyp, uint32_tmp);
 
-    if ((id > DLT_SERVICE_ID) && (id < DLT_SERVICE_ID_LAST_ENTRY) &&
+    if ((((id > DLT_SERVICE_ID) && (id < DLT_SERVICE_ID_LAST_ENTRY)) ||
+         ((id > DLT_USER_SERVICE_ID) && (id < DLT_USER_SERVICE_ID_LAST_ENTRY))) &&
         (id == req_header->service_id)) {
         switch (id) {
             case DLT_SERVICE_ID_GET_LOG_INFO:
@@ -877,6 +1298,134 @@ int dlt_receive_message_callback(DltMessage *message, void *data)
                 dlt_client_cleanup(&g_dltclient, 0);
                 break;
             }
+            case DLT_SERVICE_ID_GET_LATENCY_STATS:
+            {
+                static const char *const stage_names[DLT_LATENCY_STAGE_COUNT] = {
+                    "receive", "parse", "route", "send", "total"
+                };
+                DltServiceGetLatencyStatsResponse *resp =
+                    (DltServiceGetLatencyStatsResponse *)data;
+                char apid[DLT_ID_SIZE + 1] = { 0 };
+                uint64_t uint64_tmp = 0;
+                uint64_t p50, p99, max;
+                uint32_t count, i;
+                int j;
+
+                DLT_MSG_READ_VALUE(resp->status, ptr, datalength, uint8_t);
+                DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                resp->count = DLT_ENDIAN_GET_32(message->standardheader->htyp,
+                                                uint32_tmp);
+
+                if ((resp->status != DLT_SERVICE_RESPONSE_OK) || (datalength < 0)) {
+                    fprintf(stderr, "GET_LATENCY_STATS failed [status=%d]\n",
+                            resp->status);
+                    dlt_client_cleanup(&g_dltclient, 0);
+                    return -1;
+                }
+
+                /* latencies are in ns, printed in us */
+                for (i = 0; i < resp->count; i++) {
+                    if (datalength < (int32_t)sizeof(DltServiceLatencyInfo))
+                        break;
+
+                    memcpy(apid, ptr, DLT_ID_SIZE);
+                    ptr += DLT_ID_SIZE;
+                    datalength -= DLT_ID_SIZE;
+                    printf("APID:%4s\n", apid);
+
+                    for (j = 0; j < DLT_LATENCY_STAGE_COUNT; j++) {
+                        DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                        count = DLT_ENDIAN_GET_32(message->standardheader->htyp, uint32_tmp);
+                        DLT_MSG_READ_VALUE(uint64_tmp, ptr, datalength, uint64_t);
+                        p50 = DLT_ENDIAN_GET_64(message->standardheader->htyp, uint64_tmp);
+                        DLT_MSG_READ_VALUE(uint64_tmp, ptr, datalength, uint64_t);
+                        p99 = DLT_ENDIAN_GET_64(message->standardheader->htyp, uint64_tmp);
+                        DLT_MSG_READ_VALUE(uint64_tmp, ptr, datalength, uint64_t);
+                        max = DLT_ENDIAN_GET_64(message->standardheader->htyp, uint64_tmp);
+
+                        printf("  %-8s count %10u  p50 %12.1f us  p99 %12.1f us  max %12.1f us\n",
+                               stage_names[j], count,
+                               (double)p50 / 1000, (double)p99 / 1000, (double)max / 1000);
+                    }
+                }
+
+                dlt_client_cleanup(&g_dltclient, 0);
+                break;
+            }
+            case DLT_SERVICE_ID_GET_METRICS:
+            {
+                DltServiceGetMetricsResponse *resp =
+                    (DltServiceGetMetricsResponse *)data;
+
+                DLT_MSG_READ_VALUE(resp->status, ptr, datalength, uint8_t);
+                DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                resp->length = DLT_ENDIAN_GET_32(message->standardheader->htyp,
+                                                 uint32_tmp);
+
+                if ((resp->status != DLT_SERVICE_RESPONSE_OK) || (datalength < 0)) {
+                    fprintf(stderr, "GET_METRICS failed [status=%d]\n",
+                            resp->status);
+                    dlt_client_cleanup(&g_dltclient, 0);
+                    return -1;
+                }
+
+                /* the text is already in the Prometheus text format */
+                if (resp->length > (uint32_t)datalength)
+                    resp->length = (uint32_t)datalength;
+
+                fwrite(ptr, 1, resp->length, stdout);
+
+                dlt_client_cleanup(&g_dltclient, 0);
+                break;
+            }
+            case DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS:
+            {
+                DltServiceGetRateLimitStatusResponse *resp =
+                    (DltServiceGetRateLimitStatusResponse *)data;
+                char apid[DLT_ID_SIZE + 1] = { 0 };
+                char ctid[DLT_ID_SIZE + 1] = { 0 };
+                uint32_t rate, burst, dropped, user_dropped, i;
+
+                DLT_MSG_READ_VALUE(resp->status, ptr, datalength, uint8_t);
+                DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                resp->count = DLT_ENDIAN_GET_32(message->standardheader->htyp,
+                                                uint32_tmp);
+
+                if ((resp->status != DLT_SERVICE_RESPONSE_OK) || (datalength < 0)) {
+                    fprintf(stderr, "GET_RATE_LIMIT_STATUS failed [status=%d]\n",
+                            resp->status);
+                    dlt_client_cleanup(&g_dltclient, 0);
+                    return -1;
+                }
+
+                /* dropped by the daemon, user_dropped by the library of the application */
+                for (i = 0; i < resp->count; i++) {
+                    if (datalength < (int32_t)sizeof(DltServiceRateLimitInfo))
+                        break;
+
+                    memcpy(apid, ptr, DLT_ID_SIZE);
+                    ptr += DLT_ID_SIZE;
+                    memcpy(ctid, ptr, DLT_ID_SIZE);
+                    ptr += DLT_ID_SIZE;
+                    datalength -= 2 * DLT_ID_SIZE;
+
+                    DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                    rate = DLT_ENDIAN_GET_32(message->standardheader->htyp, uint32_tmp);
+                    DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                    burst = DLT_ENDIAN_GET_32(message->standardheader->htyp, uint32_tmp);
+                    DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                    dropped = DLT_ENDIAN_GET_32(message->standardheader->htyp, uint32_tmp);
+                    DLT_MSG_READ_VALUE(uint32_tmp, ptr, datalength, uint32_t);
+                    user_dropped = DLT_ENDIAN_GET_32(message->standardheader->htyp, uint32_tmp);
+
+                    printf("APID:%-4s CTID:%-4s rate %8u/s  burst %8u  dropped daemon %10u  application %10u\n",
+                           apid, (ctid[0] != '\0') ? ctid : "*",
+                           rate, burst, dropped, user_dropped);
+                }
+
+                dlt_client_cleanup(&g_dltclient, 0);
+                break;
+            }
             default:
             {
                 break;
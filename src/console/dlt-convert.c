@@ -88,6 +88,7 @@
 #include <sys/uio.h> /* writev() */
 
 #include "dlt_common.h"
+#include "dlt_compressed_file.h"
 
 #define COMMAND_SIZE        1024    /* Size of command */
 #define FILENAME_SIZE       1024    /* Size of filename */
@@ -124,6 +125,7 @@ void usage()
     printf("  -e number     Last message to be handled\n");
     printf("  -w            Follow dlt file while file is increasing\n");
     printf("  -t            Handling input compressed files (tar.gz)\n");
+    printf("  -z            Write the output file block compressed, see -o\n");
 }
 
 char *get_filename_ext(const char *filename)
@@ -198,6 +200,9 @@ int main(int argc, char *argv[])
     int mflag = 0;
     int wflag = 0;
     int tflag = 0;
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    int zflag = 0;
+#endif
     char *fvalue = 0;
     char *bvalue = 0;
     char *evalue = 0;
@@ -208,8 +213,13 @@ int main(int argc, char *argv[])
 
     DltFile file;
     DltFilter filter;
+    DltSegmentBuffer segments;
+    DltSegment *segment = NULL;
 
     int ohandle = -1;
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    DltCompressedWriter writer;
+#endif
 
     int num, begin, end;
 
@@ -228,7 +238,7 @@ int main(int argc, char *argv[])
 
     opterr = 0;
 
-    while ((c = getopt (argc, argv, "vcashxmwtf:b:e:o:")) != -1) {
+    while ((c = getopt (argc, argv, "vcashxmwtzf:b:e:o:")) != -1) {
         switch (c)
         {
         case 'v':
@@ -271,6 +281,17 @@ int main(int argc, char *argv[])
             tflag = 1;
             break;
         }
+        case 'z':
+        {
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+            zflag = 1;
+            break;
+#else
+            fprintf (stderr,
+                     "Compressed files are not supported. Please build with the corresponding cmake option to use it.\n");
+            return -1;
+#endif
+        }
         case 'h':
         {
             usage();
@@ -319,6 +340,9 @@ int main(int argc, char *argv[])
     /* Initialize structure to use DLT file */
     dlt_file_init(&file, vflag);
 
+    /* Initialize structure to reassemble values split over several messages */
+    dlt_segment_init(&segments);
+
     /* first parse filter file if filter parameter is used */
     if (fvalue) {
         if (dlt_filter_load(&filter, fvalue, vflag) < DLT_RETURN_OK) {
@@ -337,6 +361,15 @@ int main(int argc, char *argv[])
             fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", ovalue);
             return -1;
         }
+
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+        if (zflag && (dlt_compressed_writer_init(&writer, ohandle) < DLT_RETURN_OK)) {
+            close(ohandle);
+            dlt_file_free(&file, vflag);
+            fprintf(stderr, "ERROR: Output file %s cannot be written!\n", ovalue);
+            return -1;
+        }
+#endif
     }
 
     if (tflag) {
@@ -438,6 +471,13 @@ int main(int argc, char *argv[])
                     printf("%d ", num);
                     dlt_message_print_hex(&(file.msg), text, DLT_CONVERT_TEXTBUFSIZE, vflag);
                 }
+                else if (aflag &&
+                         (dlt_segment_add(&segments, &(file.msg), &segment, vflag) == DLT_RETURN_TRUE)) {
+                    /* printed with the number of its last message once it is complete */
+                    if (segment != NULL)
+                        printf("%d %s [%s]%s\n", num, segment->header, segment->text,
+                               segment->truncated ? " (truncated)" : "");
+                }
                 else if (aflag) {
                     printf("%d ", num);
 
@@ -462,6 +502,21 @@ int main(int argc, char *argv[])
                 }
 
                 /* if file output enabled write message */
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+                if (ovalue && zflag) {
+                    if (dlt_compressed_writer_add(&writer,
+                                                  file.msg.headerbuffer, (int)file.msg.headersize,
+                                                  file.msg.databuffer, (int)file.msg.datasize,
+                                                  NULL, 0) < DLT_RETURN_OK) {
+                        fprintf(stderr, "ERROR: Writing compressed output file failed!\n");
+                        close(ohandle);
+                        dlt_file_free(&file, vflag);
+                        dlt_segment_free(&segments);
+                        return -1;
+                    }
+                }
+                else
+#endif
                 if (ovalue) {
                     iov[0].iov_base = file.msg.headerbuffer;
                     iov[0].iov_len = (uint32_t) file.msg.headersize;
@@ -474,6 +529,7 @@ int main(int argc, char *argv[])
                         printf("in main: writev(ohandle, iov, 2); returned an error!");
                         close(ohandle);
                         dlt_file_free(&file, vflag);
+                        dlt_segment_free(&segments);
                         return -1;
                     }
                 }
@@ -509,8 +565,14 @@ int main(int argc, char *argv[])
         }
     }
 
-    if (ovalue)
+    if (ovalue) {
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+        if (zflag && (dlt_compressed_writer_close(&writer) < DLT_RETURN_OK))
+            fprintf(stderr, "ERROR: Writing compressed output file failed!\n");
+#endif
+
         close(ohandle);
+    }
 
     if (tflag) {
         empty_dir(DLT_CONVERT_WS);
@@ -530,7 +592,13 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    /* values whose last message is missing are printed without a message number */
+    while (aflag && (dlt_segment_get_pending(&segments, &segment) == DLT_RETURN_TRUE))
+        printf("- %s [%s] (truncated)\n", segment->header, segment->text);
+
     dlt_file_free(&file, vflag);
 
+    dlt_segment_free(&segments);
+
     return 0;
 }
@@ -0,0 +1,1581 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-query.c
+ */
+
+/*
+ * Query DLT files by time range, ECU, application and context id and log
+ * level.
+ *
+ * Each file gets a sidecar index <file>.dltidx. The index cuts the file into
+ * segments of about DLT_QUERY_SEGMENT_SIZE bytes and stores for each segment
+ * its position, time range and log levels, and for each ECU, application and
+ * context id the list of segments containing it. A query only reads the
+ * segments which can contain a match, files without such segment are not
+ * opened at all. The index is built by the first query of a file, in the
+ * same pass that answers the query, and is rebuilt when size or modification
+ * time of the file change.
+ *
+ * With -n no index is built. Files written block compressed by
+ * dlt_compressed_writer are then read with the block index at their end,
+ * which skips the blocks outside the time range or without the queried
+ * application ids. ECU ids, context ids and log levels are only checked
+ * per message.
+ *
+ * The files are queried in parallel. Of each match only time, position and
+ * size are kept in memory. The matches of each file are sorted by time and
+ * merged into one time ordered output, reading each message again from its
+ * file when it is output.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "dlt_common.h"
+#include "dlt_compressed_file.h"
+
+#define DLT_QUERY_TEXTBUFSIZE      10024   /* Size of buffer for text output */
+#define DLT_QUERY_INDEX_SUFFIX     ".dltidx"
+#define DLT_QUERY_INDEX_MAGIC      "DLTQ"
+#define DLT_QUERY_INDEX_VERSION    1
+#define DLT_QUERY_SEGMENT_SIZE     (64 * 1024) /* uncompressed bytes of a segment */
+#define DLT_QUERY_MAX_IDS          16      /* ids of each kind in a query */
+#define DLT_QUERY_MAX_THREADS      64
+#define DLT_QUERY_OUTPUT_BUFFER    (1024 * 1024)
+#define DLT_QUERY_LEVEL_OTHER      0       /* level bit of messages which are no log messages */
+
+typedef enum
+{
+    DLT_QUERY_ECU = 0,
+    DLT_QUERY_APID,
+    DLT_QUERY_CTID,
+    DLT_QUERY_ID_TYPES
+} DltQueryIdType;
+
+/* Layout of the index file, in the byte order of the host which wrote it:
+ * header, segments, ids, postings. */
+typedef struct
+{
+    char magic[4];           /**< DLT_QUERY_INDEX_MAGIC */
+    uint32_t version;        /**< DLT_QUERY_INDEX_VERSION */
+    uint64_t file_size;      /**< size of the indexed file */
+    int64_t file_mtime_sec;  /**< modification time of the indexed file */
+    int64_t file_mtime_nsec;
+    uint32_t segment_size;   /**< DLT_QUERY_SEGMENT_SIZE */
+    uint32_t segments;       /**< number of segments */
+    uint32_t ids;            /**< number of ids */
+    uint32_t postings;       /**< number of postings */
+} DltQueryIndexHeader;
+
+typedef struct
+{
+    uint64_t offset;         /**< position of the first message */
+    uint64_t end;            /**< position behind the last message */
+    uint64_t time_min;       /**< earliest storage header time, in us since the epoch */
+    uint64_t time_max;       /**< latest storage header time, in us since the epoch */
+    uint32_t messages;       /**< number of messages */
+    uint32_t levels;         /**< bit n set if a log message of level n is contained */
+} DltQuerySegment;
+
+typedef struct
+{
+    uint32_t type;           /**< DltQueryIdType */
+    char id[DLT_ID_SIZE];    /**< ECU, application or context id */
+    uint32_t first;          /**< first posting, the segments containing the id */
+    uint32_t count;          /**< number of postings */
+} DltQueryId;
+
+typedef struct
+{
+    DltQueryIndexHeader header;
+    DltQuerySegment *segments;
+    DltQueryId *ids;
+    uint32_t *postings;
+} DltQueryIndex;
+
+/* An id with its postings while an index is built */
+typedef struct
+{
+    DltQueryId id;           /**< id, count is the number of postings */
+    uint32_t *postings;      /**< segments containing the id */
+    uint32_t size;           /**< entries allocated in postings */
+} DltQueryBuildId;
+
+typedef struct
+{
+    DltQuerySegment *segments;
+    uint32_t segments_size;  /**< entries allocated in segments */
+    uint32_t segment_count;
+    DltQueryBuildId *table;  /**< open addressing hash table of the ids */
+    uint32_t table_size;     /**< slots of table, a power of two */
+    uint32_t id_count;
+    uint32_t posting_count;
+} DltQueryBuilder;
+
+typedef struct
+{
+    char ids[DLT_QUERY_ID_TYPES][DLT_QUERY_MAX_IDS][DLT_ID_SIZE];
+    int id_count[DLT_QUERY_ID_TYPES];
+    int level;               /**< highest log level to match, 0 for all messages */
+    uint64_t time_begin;     /**< start of the time range in us, 0 for no start */
+    uint64_t time_end;       /**< end of the time range in us (exclusive), 0 for no end */
+    int count_only;          /**< only count the matches */
+    int rebuild;             /**< ignore existing indexes */
+    int save;                /**< write the indexes */
+    int verbose;
+} DltQuery;
+
+typedef struct
+{
+    uint64_t time;           /**< storage header time in us */
+    uint64_t offset;         /**< position of the storage header in the data of the file */
+    uint32_t size;           /**< size of the message including the storage header */
+} DltQueryMatch;
+
+typedef struct
+{
+    char *name;
+    DltFile *reader;         /**< file the matches are read from while merging */
+    DltQueryMatch *matches;
+    uint32_t match_count;
+    uint32_t match_size;
+    uint32_t next;           /**< next match to output */
+    uint64_t matched;        /**< matching messages, also when only counted */
+    uint64_t scanned;        /**< messages read */
+    uint32_t segments;       /**< segments in the index */
+    uint32_t segments_read;  /**< segments read by the query */
+    uint32_t blocks_skipped; /**< blocks of a compressed file skipped by its block index */
+    int indexed;             /**< 1 if an existing index was used */
+    int compressed;          /**< 1 if the file is block compressed */
+    int error;
+} DltQueryFile;
+
+typedef struct
+{
+    const DltQuery *query;
+    DltQueryFile *files;
+    unsigned int file_count;
+    atomic_uint next;        /**< next file to be queried */
+} DltQueryContext;
+
+/**
+ * Print usage information of tool.
+ */
+void usage()
+{
+    char version[DLT_QUERY_TEXTBUFSIZE];
+
+    dlt_get_version(version, 255);
+
+    printf("Usage: dlt-query [options] file|directory ...\n");
+    printf("Query DLT files by time range, ids and log level.\n");
+    printf("An index <file>%s is kept next to each file to read only the parts\n", DLT_QUERY_INDEX_SUFFIX);
+    printf("which can contain matches. The matches of all files are printed in time order.\n");
+    printf("Of a directory all DLT files directly in it are queried.\n");
+    printf("%s \n", version);
+    printf("Commands:\n");
+    printf("  -h            Usage\n");
+    printf("  -a            Print DLT messages; payload as ASCII (default)\n");
+    printf("  -x            Print DLT messages; payload as hex\n");
+    printf("  -m            Print DLT messages; payload as hex and ASCII\n");
+    printf("  -s            Print DLT messages; only headers\n");
+    printf("  -o filename   Output messages in new DLT file\n");
+    printf("  -c            Count number of matching messages\n");
+    printf("Options:\n");
+    printf("  -v            Verbose mode\n");
+    printf("  -b time       Start of the time range, \"YYYY-MM-DD HH:MM:SS[.us]\" or seconds since the epoch\n");
+    printf("  -e time       End of the time range (exclusive)\n");
+    printf("  -E ecus       Comma separated ECU ids\n");
+    printf("  -A apids      Comma separated application ids\n");
+    printf("  -C ctids      Comma separated context ids\n");
+    printf("  -l level      Log messages of this level or more severe\n");
+    printf("                (fatal, error, warn, info, debug, verbose or 1-6)\n");
+    printf("  -j threads    Number of files queried in parallel (default: number of CPUs)\n");
+    printf("  -r            Rebuild the indexes\n");
+    printf("  -n            Do not write indexes; compressed files without index are\n");
+    printf("                read with their block index instead\n");
+}
+
+/*
+ * parse a time given as local date and time or as seconds since the epoch
+ */
+static int dlt_query_parse_time(const char *text, uint64_t *time_us)
+{
+    struct tm tm;
+    const char *end;
+    char *number_end = NULL;
+    uint64_t seconds;
+    uint64_t micros = 0;
+    uint64_t scale = 100000;
+
+    memset(&tm, 0, sizeof(tm));
+
+    end = strptime(text, "%Y-%m-%d %H:%M:%S", &tm);
+
+    if (end == NULL)
+        end = strptime(text, "%Y-%m-%dT%H:%M:%S", &tm);
+
+    if (end != NULL) {
+        time_t t;
+
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+
+        if (t == (time_t)-1)
+            return -1;
+
+        seconds = (uint64_t)t;
+    }
+    else {
+        errno = 0;
+        seconds = strtoull(text, &number_end, 10);
+
+        if ((errno != 0) || (number_end == text))
+            return -1;
+
+        end = number_end;
+    }
+
+    if (*end == '.') {
+        for (end++; isdigit((unsigned char)*end); end++) {
+            micros += (uint64_t)(*end - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    if (*end != '\0')
+        return -1;
+
+    *time_us = seconds * 1000000 + micros;
+
+    return 0;
+}
+
+/*
+ * parse a log level given by name or number
+ */
+static int dlt_query_parse_level(const char *text)
+{
+    static const char *names[] = { "fatal", "error", "warn", "info", "debug", "verbose" };
+    int level;
+
+    for (level = 0; level < (int)(sizeof(names) / sizeof(names[0])); level++)
+        if (strcasecmp(text, names[level]) == 0)
+            return level + DLT_LOG_FATAL;
+
+    level = atoi(text);
+
+    if ((level < DLT_LOG_FATAL) || (level > DLT_LOG_VERBOSE))
+        return -1;
+
+    return level;
+}
+
+/*
+ * parse a comma separated list of ids
+ */
+static int dlt_query_parse_ids(DltQuery *query, DltQueryIdType type, char *text)
+{
+    char *save = NULL;
+    char *id;
+
+    for (id = strtok_r(text, ",", &save); id != NULL; id = strtok_r(NULL, ",", &save)) {
+        if (query->id_count[type] >= DLT_QUERY_MAX_IDS) {
+            fprintf(stderr, "ERROR: Too many ids, at most %d are allowed\n", DLT_QUERY_MAX_IDS);
+            return -1;
+        }
+
+        dlt_set_id(query->ids[type][query->id_count[type]], id);
+        query->id_count[type]++;
+    }
+
+    return 0;
+}
+
+static uint64_t dlt_query_message_time(DltMessage *msg)
+{
+    return (uint64_t)msg->storageheader->seconds * 1000000 + (uint64_t)(uint32_t)msg->storageheader->microseconds;
+}
+
+/*
+ * log level bit of a message for DltQuerySegment.levels
+ */
+static uint32_t dlt_query_message_level(DltMessage *msg)
+{
+    if ((msg->extendedheader == NULL) ||
+        (DLT_GET_MSIN_MSTP(msg->extendedheader->msin) != DLT_TYPE_LOG))
+        return DLT_QUERY_LEVEL_OTHER;
+
+    return (uint32_t)DLT_GET_MSIN_MTIN(msg->extendedheader->msin);
+}
+
+static int dlt_query_id_in(const char ids[][DLT_ID_SIZE], int count, const char *id)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
+        if (memcmp(ids[i], id, DLT_ID_SIZE) == 0)
+            return 1;
+
+    return 0;
+}
+
+/*
+ * check a message whose headers are read against the query
+ */
+static int dlt_query_match(const DltQuery *query, DltMessage *msg, uint64_t time_us)
+{
+    uint32_t level;
+
+    if ((query->time_begin != 0) && (time_us < query->time_begin))
+        return 0;
+
+    if ((query->time_end != 0) && (time_us >= query->time_end))
+        return 0;
+
+    if ((query->id_count[DLT_QUERY_ECU] > 0) &&
+        !dlt_query_id_in(query->ids[DLT_QUERY_ECU], query->id_count[DLT_QUERY_ECU], msg->storageheader->ecu))
+        return 0;
+
+    if ((query->id_count[DLT_QUERY_APID] > 0) || (query->id_count[DLT_QUERY_CTID] > 0)) {
+        if (msg->extendedheader == NULL)
+            return 0;
+
+        if ((query->id_count[DLT_QUERY_APID] > 0) &&
+            !dlt_query_id_in(query->ids[DLT_QUERY_APID], query->id_count[DLT_QUERY_APID],
+                             msg->extendedheader->apid))
+            return 0;
+
+        if ((query->id_count[DLT_QUERY_CTID] > 0) &&
+            !dlt_query_id_in(query->ids[DLT_QUERY_CTID], query->id_count[DLT_QUERY_CTID],
+                             msg->extendedheader->ctid))
+            return 0;
+    }
+
+    if (query->level > 0) {
+        level = dlt_query_message_level(msg);
+
+        if ((level == DLT_QUERY_LEVEL_OTHER) || (level > (uint32_t)query->level))
+            return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * keep time, position and size of a matching message of a file
+ */
+static int dlt_query_add_match(DltQueryFile *qf, uint64_t position, uint32_t size, uint64_t time_us)
+{
+    DltQueryMatch *match;
+
+    if (qf->match_count == qf->match_size) {
+        uint32_t match_size = qf->match_size ? qf->match_size * 2 : 1024;
+        DltQueryMatch *matches = realloc(qf->matches, match_size * sizeof(DltQueryMatch));
+
+        if (matches == NULL)
+            return -1;
+
+        qf->matches = matches;
+        qf->match_size = match_size;
+    }
+
+    match = &qf->matches[qf->match_count++];
+    match->time = time_us;
+    match->offset = position;
+    match->size = size;
+
+    return 0;
+}
+
+static uint32_t dlt_query_hash(uint32_t type, const char *id)
+{
+    uint32_t hash = 2166136261u ^ type;
+    int i;
+
+    for (i = 0; i < DLT_ID_SIZE; i++) {
+        hash ^= (uint8_t)id[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static DltQueryBuildId *dlt_query_builder_find(DltQueryBuilder *builder, uint32_t type, const char *id)
+{
+    uint32_t slot = dlt_query_hash(type, id) & (builder->table_size - 1);
+
+    while (builder->table[slot].postings != NULL) {
+        if ((builder->table[slot].id.type == type) &&
+            (memcmp(builder->table[slot].id.id, id, DLT_ID_SIZE) == 0))
+            break;
+
+        slot = (slot + 1) & (builder->table_size - 1);
+    }
+
+    return &builder->table[slot];
+}
+
+/*
+ * double the size of the id table, keeping it at most half full
+ */
+static int dlt_query_builder_grow(DltQueryBuilder *builder)
+{
+    DltQueryBuildId *old = builder->table;
+    uint32_t old_size = builder->table_size;
+    uint32_t i;
+
+    builder->table_size = old_size ? old_size * 2 : 64;
+    builder->table = calloc(builder->table_size, sizeof(DltQueryBuildId));
+
+    if (builder->table == NULL) {
+        builder->table = old;
+        builder->table_size = old_size;
+        return -1;
+    }
+
+    for (i = 0; i < old_size; i++)
+        if (old[i].postings != NULL)
+            *dlt_query_builder_find(builder, old[i].id.type, old[i].id.id) = old[i];
+
+    free(old);
+
+    return 0;
+}
+
+static int dlt_query_builder_post(DltQueryBuilder *builder, uint32_t type, const char *id, uint32_t segment)
+{
+    DltQueryBuildId *entry;
+
+    if ((builder->id_count + 1) * 2 > builder->table_size)
+        if (dlt_query_builder_grow(builder) < 0)
+            return -1;
+
+    entry = dlt_query_builder_find(builder, type, id);
+
+    if (entry->postings == NULL) {
+        entry->postings = malloc(16 * sizeof(uint32_t));
+
+        if (entry->postings == NULL)
+            return -1;
+
+        entry->size = 16;
+        entry->id.type = type;
+        memcpy(entry->id.id, id, DLT_ID_SIZE);
+        entry->id.count = 0;
+        builder->id_count++;
+    }
+    else if (entry->postings[entry->id.count - 1] == segment) {
+        return 0;
+    }
+
+    if (entry->id.count == entry->size) {
+        uint32_t *postings = realloc(entry->postings, entry->size * 2 * sizeof(uint32_t));
+
+        if (postings == NULL)
+            return -1;
+
+        entry->postings = postings;
+        entry->size *= 2;
+    }
+
+    entry->postings[entry->id.count++] = segment;
+    builder->posting_count++;
+
+    return 0;
+}
+
+/*
+ * add a message whose headers are read to the index
+ */
+static int dlt_query_builder_add(DltQueryBuilder *builder, DltMessage *msg, uint64_t position, uint64_t time_us)
+{
+    DltQuerySegment *segment = NULL;
+    uint32_t number;
+
+    if (builder->segment_count > 0)
+        segment = &builder->segments[builder->segment_count - 1];
+
+    if ((segment == NULL) || (position - segment->offset >= DLT_QUERY_SEGMENT_SIZE)) {
+        if (builder->segment_count == builder->segments_size) {
+            uint32_t size = builder->segments_size ? builder->segments_size * 2 : 256;
+            DltQuerySegment *segments = realloc(builder->segments, size * sizeof(DltQuerySegment));
+
+            if (segments == NULL)
+                return -1;
+
+            builder->segments = segments;
+            builder->segments_size = size;
+        }
+
+        segment = &builder->segments[builder->segment_count++];
+        memset(segment, 0, sizeof(DltQuerySegment));
+        segment->offset = position;
+        segment->time_min = time_us;
+        segment->time_max = time_us;
+    }
+
+    number = builder->segment_count - 1;
+
+    segment->end = position + msg->headersize + msg->datasize;
+    segment->messages++;
+    segment->levels |= 1u << dlt_query_message_level(msg);
+
+    if (time_us < segment->time_min)
+        segment->time_min = time_us;
+
+    if (time_us > segment->time_max)
+        segment->time_max = time_us;
+
+    if (dlt_query_builder_post(builder, DLT_QUERY_ECU, msg->storageheader->ecu, number) < 0)
+        return -1;
+
+    if (msg->extendedheader != NULL) {
+        if (dlt_query_builder_post(builder, DLT_QUERY_APID, msg->extendedheader->apid, number) < 0)
+            return -1;
+
+        if (dlt_query_builder_post(builder, DLT_QUERY_CTID, msg->extendedheader->ctid, number) < 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+static int dlt_query_compare_ids(const void *a, const void *b)
+{
+    const DltQueryId *id_a = a;
+    const DltQueryId *id_b = b;
+
+    if (id_a->type != id_b->type)
+        return (id_a->type < id_b->type) ? -1 : 1;
+
+    return memcmp(id_a->id, id_b->id, DLT_ID_SIZE);
+}
+
+/*
+ * move the built index into an index, the builder is freed
+ */
+static int dlt_query_builder_finish(DltQueryBuilder *builder, DltQueryIndex *index, struct stat *st)
+{
+    uint32_t i;
+    uint32_t n = 0;
+    uint32_t first = 0;
+    int ret = 0;
+
+    memset(index, 0, sizeof(DltQueryIndex));
+    memcpy(index->header.magic, DLT_QUERY_INDEX_MAGIC, sizeof(index->header.magic));
+    index->header.version = DLT_QUERY_INDEX_VERSION;
+    index->header.file_size = (uint64_t)st->st_size;
+    index->header.file_mtime_sec = (int64_t)st->st_mtim.tv_sec;
+    index->header.file_mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+    index->header.segment_size = DLT_QUERY_SEGMENT_SIZE;
+
+    index->segments = builder->segments;
+    index->header.segments = builder->segment_count;
+    builder->segments = NULL;
+
+    index->ids = malloc((builder->id_count + 1) * sizeof(DltQueryId));
+    index->postings = malloc((builder->posting_count + 1) * sizeof(uint32_t));
+
+    if ((index->ids == NULL) || (index->postings == NULL))
+        ret = -1;
+
+    for (i = 0; i < builder->table_size; i++)
+        if ((ret == 0) && (builder->table[i].postings != NULL))
+            index->ids[n++] = builder->table[i].id;
+
+    if (ret == 0) {
+        qsort(index->ids, n, sizeof(DltQueryId), dlt_query_compare_ids);
+
+        for (i = 0; i < n; i++) {
+            DltQueryBuildId *entry = dlt_query_builder_find(builder, index->ids[i].type, index->ids[i].id);
+
+            memcpy(index->postings + first, entry->postings, entry->id.count * sizeof(uint32_t));
+            index->ids[i].first = first;
+            first += entry->id.count;
+        }
+
+        index->header.ids = n;
+        index->header.postings = first;
+    }
+
+    for (i = 0; i < builder->table_size; i++)
+        free(builder->table[i].postings);
+
+    free(builder->table);
+    memset(builder, 0, sizeof(DltQueryBuilder));
+
+    return ret;
+}
+
+static void dlt_query_index_free(DltQueryIndex *index)
+{
+    free(index->segments);
+    free(index->ids);
+    free(index->postings);
+    memset(index, 0, sizeof(DltQueryIndex));
+}
+
+static void dlt_query_index_name(const char *name, char *index_name, size_t size)
+{
+    snprintf(index_name, size, "%s%s", name, DLT_QUERY_INDEX_SUFFIX);
+}
+
+/*
+ * load the index of a file, fails if it is missing or outdated
+ */
+static int dlt_query_index_load(DltQueryIndex *index, const char *name, struct stat *st)
+{
+    char index_name[PATH_MAX];
+    struct stat index_st;
+    DltQueryIndexHeader *header = &index->header;
+    FILE *handle;
+    uint64_t size;
+    uint32_t i;
+    int ret = -1;
+
+    memset(index, 0, sizeof(DltQueryIndex));
+    dlt_query_index_name(name, index_name, sizeof(index_name));
+
+    handle = fopen(index_name, "rb");
+
+    if (handle == NULL)
+        return -1;
+
+    if ((fstat(fileno(handle), &index_st) != 0) ||
+        (fread(header, sizeof(DltQueryIndexHeader), 1, handle) != 1))
+        goto out;
+
+    if ((memcmp(header->magic, DLT_QUERY_INDEX_MAGIC, sizeof(header->magic)) != 0) ||
+        (header->version != DLT_QUERY_INDEX_VERSION) ||
+        (header->segment_size != DLT_QUERY_SEGMENT_SIZE) ||
+        (header->file_size != (uint64_t)st->st_size) ||
+        (header->file_mtime_sec != (int64_t)st->st_mtim.tv_sec) ||
+        (header->file_mtime_nsec != (int64_t)st->st_mtim.tv_nsec))
+        goto out;
+
+    size = sizeof(DltQueryIndexHeader) +
+        (uint64_t)header->segments * sizeof(DltQuerySegment) +
+        (uint64_t)header->ids * sizeof(DltQueryId) +
+        (uint64_t)header->postings * sizeof(uint32_t);
+
+    if (size != (uint64_t)index_st.st_size)
+        goto out;
+
+    index->segments = malloc((header->segments + 1) * sizeof(DltQuerySegment));
+    index->ids = malloc((header->ids + 1) * sizeof(DltQueryId));
+    index->postings = malloc((header->postings + 1) * sizeof(uint32_t));
+
+    if ((index->segments == NULL) || (index->ids == NULL) || (index->postings == NULL) ||
+        (fread(index->segments, sizeof(DltQuerySegment), header->segments, handle) != header->segments) ||
+        (fread(index->ids, sizeof(DltQueryId), header->ids, handle) != header->ids) ||
+        (fread(index->postings, sizeof(uint32_t), header->postings, handle) != header->postings))
+        goto out;
+
+    for (i = 0; i < header->ids; i++)
+        if ((index->ids[i].first > header->postings) ||
+            (index->ids[i].count > header->postings - index->ids[i].first))
+            goto out;
+
+    for (i = 0; i < header->postings; i++)
+        if (index->postings[i] >= header->segments)
+            goto out;
+
+    ret = 0;
+
+out:
+    fclose(handle);
+
+    if (ret < 0)
+        dlt_query_index_free(index);
+
+    return ret;
+}
+
+/*
+ * write the index of a file, replacing the old index at once
+ */
+static int dlt_query_index_save(DltQueryIndex *index, const char *name, int verbose)
+{
+    char index_name[PATH_MAX];
+    char temp_name[PATH_MAX + 32];
+    FILE *handle;
+    int ret = 0;
+
+    dlt_query_index_name(name, index_name, sizeof(index_name));
+    snprintf(temp_name, sizeof(temp_name), "%s.%d", index_name, (int)getpid());
+
+    handle = fopen(temp_name, "wb");
+
+    if (handle == NULL) {
+        if (verbose)
+            fprintf(stderr, "Index %s cannot be written: %s\n", index_name, strerror(errno));
+
+        return -1;
+    }
+
+    if ((fwrite(&index->header, sizeof(DltQueryIndexHeader), 1, handle) != 1) ||
+        (fwrite(index->segments, sizeof(DltQuerySegment), index->header.segments, handle) != index->header.segments) ||
+        (fwrite(index->ids, sizeof(DltQueryId), index->header.ids, handle) != index->header.ids) ||
+        (fwrite(index->postings, sizeof(uint32_t), index->header.postings, handle) != index->header.postings))
+        ret = -1;
+
+    if (fclose(handle) != 0)
+        ret = -1;
+
+    if ((ret == 0) && (rename(temp_name, index_name) != 0))
+        ret = -1;
+
+    if (ret < 0) {
+        fprintf(stderr, "Index %s cannot be written: %s\n", index_name, strerror(errno));
+        unlink(temp_name);
+    }
+
+    return ret;
+}
+
+/*
+ * select the segments of an index which can contain matches
+ */
+static uint32_t dlt_query_select(const DltQuery *query, DltQueryIndex *index, uint8_t *selected)
+{
+    uint32_t levels = (query->level > 0) ? ((1u << (query->level + 1)) - 2) : UINT32_MAX;
+    uint8_t *mask;
+    uint32_t count = 0;
+    uint32_t i, j, k;
+    int type, n;
+
+    memset(selected, 1, index->header.segments);
+
+    mask = malloc(index->header.segments + 1);
+
+    if (mask == NULL)
+        return index->header.segments;
+
+    for (type = 0; type < DLT_QUERY_ID_TYPES; type++) {
+        if (query->id_count[type] == 0)
+            continue;
+
+        memset(mask, 0, index->header.segments);
+
+        for (n = 0; n < query->id_count[type]; n++) {
+            DltQueryId key;
+            DltQueryId *id;
+
+            key.type = (uint32_t)type;
+            memcpy(key.id, query->ids[type][n], DLT_ID_SIZE);
+            id = bsearch(&key, index->ids, index->header.ids, sizeof(DltQueryId), dlt_query_compare_ids);
+
+            if (id == NULL)
+                continue;
+
+            for (k = 0; k < id->count; k++)
+                mask[index->postings[id->first + k]] = 1;
+        }
+
+        for (j = 0; j < index->header.segments; j++)
+            selected[j] &= mask[j];
+    }
+
+    free(mask);
+
+    for (i = 0; i < index->header.segments; i++) {
+        DltQuerySegment *segment = &index->segments[i];
+
+        if (selected[i] &&
+            (((query->time_begin != 0) && (segment->time_max < query->time_begin)) ||
+             ((query->time_end != 0) && (segment->time_min >= query->time_end)) ||
+             ((segment->levels & levels) == 0)))
+            selected[i] = 0;
+
+        count += selected[i];
+    }
+
+    return count;
+}
+
+/*
+ * read the messages from position up to end, checking each against the
+ * query and adding it to the index if a builder is given; blocks of a
+ * compressed file without match of the query are skipped if blocks is given
+ */
+static int dlt_query_scan(const DltQuery *query,
+                          DltQueryFile *qf,
+                          DltFile *file,
+                          uint64_t position,
+                          uint64_t end,
+                          DltQueryBuilder *builder,
+                          const DltFilter *blocks)
+{
+    const off_t header_size = (off_t)(sizeof(DltStorageHeader) + sizeof(DltStandardHeader));
+    uint64_t time_us;
+    off_t current;
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    int skipped;
+#endif
+
+    if (fseeko(file->handle, (off_t)position, SEEK_SET) != 0)
+        return -1;
+
+    while (position < end) {
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+        if (blocks) {
+            /* the end of the block index range is inclusive */
+            file->file_position = position;
+            skipped = dlt_compressed_file_skip(file, blocks, query->time_begin,
+                                               (query->time_end != 0) ? query->time_end - 1 : 0, 0);
+
+            if (skipped > 0) {
+                qf->blocks_skipped += (uint32_t)skipped;
+                position = file->file_position;
+
+                if (fseeko(file->handle, (off_t)position, SEEK_SET) != 0)
+                    return -1;
+            }
+        }
+#else
+        (void)blocks;
+#endif
+
+        if (dlt_file_read_header(file, 0) < DLT_RETURN_OK)
+            break;
+
+        /* the storage header may be found behind the expected position */
+        current = ftello(file->handle);
+
+        if (current < header_size)
+            return -1;
+
+        position = (uint64_t)(current - header_size);
+
+        if (position >= end)
+            break;
+
+        file->msg.extendedheader = NULL;
+
+        if (dlt_file_read_header_extended(file, 0) < DLT_RETURN_OK)
+            break;
+
+        time_us = dlt_query_message_time(&file->msg);
+        qf->scanned++;
+
+        if (builder && (dlt_query_builder_add(builder, &file->msg, position, time_us) < 0))
+            return -1;
+
+        if (dlt_query_match(query, &file->msg, time_us)) {
+            qf->matched++;
+
+            /* the message is read again when it is output */
+            if (!query->count_only &&
+                (dlt_query_add_match(qf, position,
+                                     (uint32_t)(file->msg.headersize + file->msg.datasize),
+                                     time_us) < 0))
+                return -1;
+        }
+
+        if (fseeko(file->handle, (off_t)file->msg.datasize, SEEK_CUR) != 0)
+            break;
+
+        position += file->msg.headersize + file->msg.datasize;
+    }
+
+    return 0;
+}
+
+static int dlt_query_compare_matches(const void *a, const void *b)
+{
+    const DltQueryMatch *match_a = a;
+    const DltQueryMatch *match_b = b;
+
+    if (match_a->time != match_b->time)
+        return (match_a->time < match_b->time) ? -1 : 1;
+
+    /* keep the order of the file for messages with the same time */
+    if (match_a->offset != match_b->offset)
+        return (match_a->offset < match_b->offset) ? -1 : 1;
+
+    return 0;
+}
+
+/*
+ * 0 for no DLT file, 1 for a plain and 2 for a block compressed DLT file
+ */
+static int dlt_query_file_type(const char *name)
+{
+    char magic[4];
+    FILE *handle = fopen(name, "rb");
+    int ret = 0;
+
+    if (handle == NULL)
+        return 0;
+
+    if (fread(magic, sizeof(magic), 1, handle) == 1) {
+        if (memcmp(magic, DLT_COMPRESSED_FILE_MAGIC, sizeof(magic)) == 0)
+            ret = 2;
+        else if ((memcmp(magic, "DLT", 3) == 0) && (magic[3] == 0x01))
+            ret = 1;
+    }
+
+    fclose(handle);
+
+    return ret;
+}
+
+/*
+ * answer the query for one file, building its index if needed
+ */
+static void dlt_query_file(const DltQuery *query, DltQueryFile *qf)
+{
+    DltQueryIndex index;
+    DltQueryBuilder builder;
+    DltFilter filter;
+    DltFile file;
+    struct stat st;
+    uint8_t *selected = NULL;
+    uint32_t i;
+    int n;
+
+    memset(&index, 0, sizeof(index));
+    memset(&builder, 0, sizeof(builder));
+
+    if (stat(qf->name, &st) != 0) {
+        fprintf(stderr, "ERROR: File %s cannot be opened: %s\n", qf->name, strerror(errno));
+        qf->error = 1;
+        return;
+    }
+
+    if (!query->rebuild && (dlt_query_index_load(&index, qf->name, &st) == 0)) {
+        qf->indexed = 1;
+        qf->segments = index.header.segments;
+
+        selected = malloc(index.header.segments + 1);
+
+        if (selected == NULL) {
+            qf->error = 1;
+            dlt_query_index_free(&index);
+            return;
+        }
+
+        /* nothing to read in this file */
+        if (dlt_query_select(query, &index, selected) == 0) {
+            free(selected);
+            dlt_query_index_free(&index);
+            return;
+        }
+    }
+
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    qf->compressed = (dlt_query_file_type(qf->name) == 2);
+#endif
+
+    dlt_file_init(&file, 0);
+
+    if (dlt_file_open(&file, qf->name, 0) < DLT_RETURN_OK) {
+        fprintf(stderr, "ERROR: File %s cannot be opened\n", qf->name);
+        qf->error = 1;
+    }
+    else if (qf->indexed) {
+        for (i = 0; (i < index.header.segments) && !qf->error; i++) {
+            if (!selected[i])
+                continue;
+
+            qf->segments_read++;
+
+            if (dlt_query_scan(query, qf, &file, index.segments[i].offset, index.segments[i].end, NULL, NULL) < 0)
+                qf->error = 1;
+        }
+    }
+    else if (qf->compressed && !query->save) {
+        /* no index is kept, the block index of the file does its job */
+        memset(&filter, 0, sizeof(filter));
+
+        for (n = 0; n < query->id_count[DLT_QUERY_APID]; n++)
+            memcpy(filter.apid[n], query->ids[DLT_QUERY_APID][n], DLT_ID_SIZE);
+
+        filter.counter = query->id_count[DLT_QUERY_APID];
+
+        if (dlt_query_scan(query, qf, &file, 0, UINT64_MAX, NULL, &filter) < 0)
+            qf->error = 1;
+    }
+    else {
+        /* build the index while answering the query */
+        if (dlt_query_scan(query, qf, &file, 0, UINT64_MAX, &builder, NULL) < 0)
+            qf->error = 1;
+
+        if (dlt_query_builder_finish(&builder, &index, &st) < 0) {
+            qf->error = 1;
+        }
+        else {
+            qf->segments = index.header.segments;
+            qf->segments_read = index.header.segments;
+
+            if (query->save && !qf->error)
+                dlt_query_index_save(&index, qf->name, query->verbose);
+        }
+    }
+
+    if (qf->error)
+        fprintf(stderr, "ERROR: Query of file %s failed\n", qf->name);
+
+    dlt_file_free(&file, 0);
+    dlt_query_index_free(&index);
+    free(selected);
+
+    qsort(qf->matches, qf->match_count, sizeof(DltQueryMatch), dlt_query_compare_matches);
+}
+
+static void *dlt_query_thread(void *arg)
+{
+    DltQueryContext *context = arg;
+    unsigned int i;
+
+    while ((i = atomic_fetch_add(&context->next, 1)) < context->file_count)
+        dlt_query_file(context->query, &context->files[i]);
+
+    return NULL;
+}
+
+/*
+ * check if a file starts like a plain or compressed DLT file
+ */
+static int dlt_query_compare_names(const void *a, const void *b)
+{
+    return strcmp(((const DltQueryFile *)a)->name, ((const DltQueryFile *)b)->name);
+}
+
+static int dlt_query_add_file(DltQueryFile **files, unsigned int *count, unsigned int *size, const char *name)
+{
+    if (*count == *size) {
+        unsigned int new_size = *size ? *size * 2 : 64;
+        DltQueryFile *new_files = realloc(*files, new_size * sizeof(DltQueryFile));
+
+        if (new_files == NULL)
+            return -1;
+
+        *files = new_files;
+        *size = new_size;
+    }
+
+    memset(&(*files)[*count], 0, sizeof(DltQueryFile));
+    (*files)[*count].name = strdup(name);
+
+    if ((*files)[*count].name == NULL)
+        return -1;
+
+    (*count)++;
+
+    return 0;
+}
+
+/*
+ * collect the files of the arguments, of directories the DLT files in them
+ */
+static int dlt_query_collect(char **paths, int path_count, DltQueryFile **files, unsigned int *count)
+{
+    unsigned int size = 0;
+    unsigned int first;
+    int i;
+
+    for (i = 0; i < path_count; i++) {
+        struct stat st;
+        struct dirent *entry;
+        DIR *dir;
+
+        if (stat(paths[i], &st) != 0) {
+            fprintf(stderr, "ERROR: %s cannot be opened: %s\n", paths[i], strerror(errno));
+            return -1;
+        }
+
+        if (!S_ISDIR(st.st_mode)) {
+            if (dlt_query_add_file(files, count, &size, paths[i]) < 0)
+                return -1;
+
+            continue;
+        }
+
+        dir = opendir(paths[i]);
+
+        if (dir == NULL) {
+            fprintf(stderr, "ERROR: %s cannot be opened: %s\n", paths[i], strerror(errno));
+            return -1;
+        }
+
+        first = *count;
+
+        while ((entry = readdir(dir)) != NULL) {
+            char name[PATH_MAX];
+
+            if (snprintf(name, sizeof(name), "%s/%s", paths[i], entry->d_name) >= (int)sizeof(name))
+                continue;
+
+            if ((stat(name, &st) != 0) || !S_ISREG(st.st_mode) || (dlt_query_file_type(name) == 0))
+                continue;
+
+            if (dlt_query_add_file(files, count, &size, name) < 0) {
+                closedir(dir);
+                return -1;
+            }
+        }
+
+        closedir(dir);
+
+        qsort(*files + first, *count - first, sizeof(DltQueryFile), dlt_query_compare_names);
+    }
+
+    return 0;
+}
+
+/*
+ * read the message of the next match of a file, the file is opened on its
+ * first match and closed after its last one
+ */
+static uint8_t *dlt_query_read_match(DltQueryFile *qf, uint8_t *buffer)
+{
+    DltQueryMatch *match = &qf->matches[qf->next];
+
+    if (qf->reader == NULL) {
+        qf->reader = malloc(sizeof(DltFile));
+
+        if (qf->reader == NULL)
+            return NULL;
+
+        dlt_file_init(qf->reader, 0);
+
+        if (dlt_file_open(qf->reader, qf->name, 0) < DLT_RETURN_OK) {
+            fprintf(stderr, "ERROR: File %s cannot be opened\n", qf->name);
+            return NULL;
+        }
+    }
+
+    if ((fseeko(qf->reader->handle, (off_t)match->offset, SEEK_SET) != 0) ||
+        (fread(buffer, match->size, 1, qf->reader->handle) != 1)) {
+        fprintf(stderr, "ERROR: Reading file %s failed\n", qf->name);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+static void dlt_query_close_reader(DltQueryFile *qf)
+{
+    if (qf->reader == NULL)
+        return;
+
+    dlt_file_free(qf->reader, 0);
+    free(qf->reader);
+    qf->reader = NULL;
+}
+
+/*
+ * heap of the files ordered by the time of their next match
+ */
+static int dlt_query_heap_less(DltQueryFile *files, unsigned int a, unsigned int b)
+{
+    uint64_t time_a = files[a].matches[files[a].next].time;
+    uint64_t time_b = files[b].matches[files[b].next].time;
+
+    if (time_a != time_b)
+        return time_a < time_b;
+
+    return a < b;
+}
+
+static void dlt_query_heap_down(DltQueryFile *files, unsigned int *heap, unsigned int count, unsigned int i)
+{
+    while (1) {
+        unsigned int child = 2 * i + 1;
+        unsigned int tmp;
+
+        if (child >= count)
+            break;
+
+        if ((child + 1 < count) && dlt_query_heap_less(files, heap[child + 1], heap[child]))
+            child++;
+
+        if (!dlt_query_heap_less(files, heap[child], heap[i]))
+            break;
+
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+/**
+ * Main function of tool.
+ */
+int main(int argc, char *argv[])
+{
+    DltQuery query;
+    DltQueryContext context;
+    DltQueryFile *files = NULL;
+    unsigned int file_count = 0;
+    unsigned int *heap = NULL;
+    unsigned int heap_count = 0;
+    pthread_t threads[DLT_QUERY_MAX_THREADS];
+    int thread_count = 0;
+    int started = 0;
+    uint64_t matched = 0;
+    uint64_t scanned = 0;
+    uint64_t num = 0;
+    unsigned int i;
+    int ret = 0;
+    int c;
+
+    int aflag = 0;
+    int xflag = 0;
+    int mflag = 0;
+    int sflag = 0;
+    int cflag = 0;
+    char *ovalue = NULL;
+    FILE *output = NULL;
+
+    DltMessage msg;
+    static char text[DLT_QUERY_TEXTBUFSIZE];
+    /* a message with storage header, the message length is 16 bit */
+    static uint8_t data[sizeof(DltStorageHeader) + UINT16_MAX];
+
+    memset(&query, 0, sizeof(query));
+    query.save = 1;
+
+    opterr = 0;
+
+    while ((c = getopt(argc, argv, "vhaxmsco:b:e:E:A:C:l:j:rn")) != -1)
+        switch (c) {
+        case 'v':
+        {
+            query.verbose = 1;
+            break;
+        }
+        case 'h':
+        {
+            usage();
+            return -1;
+        }
+        case 'a':
+        {
+            aflag = 1;
+            break;
+        }
+        case 'x':
+        {
+            xflag = 1;
+            break;
+        }
+        case 'm':
+        {
+            mflag = 1;
+            break;
+        }
+        case 's':
+        {
+            sflag = 1;
+            break;
+        }
+        case 'c':
+        {
+            cflag = 1;
+            break;
+        }
+        case 'o':
+        {
+            ovalue = optarg;
+            break;
+        }
+        case 'b':
+        case 'e':
+        {
+            if (dlt_query_parse_time(optarg, (c == 'b') ? &query.time_begin : &query.time_end) < 0) {
+                fprintf(stderr, "ERROR: Invalid time %s\n", optarg);
+                return -1;
+            }
+
+            break;
+        }
+        case 'E':
+        {
+            if (dlt_query_parse_ids(&query, DLT_QUERY_ECU, optarg) < 0)
+                return -1;
+
+            break;
+        }
+        case 'A':
+        {
+            if (dlt_query_parse_ids(&query, DLT_QUERY_APID, optarg) < 0)
+                return -1;
+
+            break;
+        }
+        case 'C':
+        {
+            if (dlt_query_parse_ids(&query, DLT_QUERY_CTID, optarg) < 0)
+                return -1;
+
+            break;
+        }
+        case 'l':
+        {
+            query.level = dlt_query_parse_level(optarg);
+
+            if (query.level < 0) {
+                fprintf(stderr, "ERROR: Invalid log level %s\n", optarg);
+                return -1;
+            }
+
+            break;
+        }
+        case 'j':
+        {
+            thread_count = atoi(optarg);
+
+            if ((thread_count < 1) || (thread_count > DLT_QUERY_MAX_THREADS)) {
+                fprintf(stderr, "ERROR: Number of threads must be between 1 and %d\n", DLT_QUERY_MAX_THREADS);
+                return -1;
+            }
+
+            break;
+        }
+        case 'r':
+        {
+            query.rebuild = 1;
+            break;
+        }
+        case 'n':
+        {
+            query.save = 0;
+            break;
+        }
+        case '?':
+        {
+            if ((optopt == 'o') || (optopt == 'b') || (optopt == 'e') || (optopt == 'E') ||
+                (optopt == 'A') || (optopt == 'C') || (optopt == 'l') || (optopt == 'j'))
+                fprintf(stderr, "Option -%c requires an argument.\n", optopt);
+            else if (isprint(optopt))
+                fprintf(stderr, "Unknown option `-%c'.\n", optopt);
+            else
+                fprintf(stderr, "Unknown option character `\\x%x'.\n", optopt);
+
+            /* unknown or wrong option used, show usage information and terminate */
+            usage();
+            return -1;
+        }
+        default:
+        {
+            abort();
+            return -1;    /*for parasoft */
+        }
+        }
+
+    if (optind >= argc) {
+        fprintf(stderr, "ERROR: Need a file or directory to query!\n");
+        usage();
+        return -1;
+    }
+
+    if ((query.time_begin != 0) && (query.time_end != 0) && (query.time_end <= query.time_begin)) {
+        fprintf(stderr, "ERROR: End of the time range is not after its start!\n");
+        return -1;
+    }
+
+    /* print messages by default */
+    if (!xflag && !mflag && !sflag && !cflag && !ovalue)
+        aflag = 1;
+
+    /* only count, the messages need not be read */
+    if (!aflag && !xflag && !mflag && !sflag && !ovalue)
+        query.count_only = 1;
+
+    if (dlt_query_collect(argv + optind, argc - optind, &files, &file_count) < 0) {
+        ret = -1;
+        goto out;
+    }
+
+    if (ovalue) {
+        output = fopen(ovalue, "wb");
+
+        if (output == NULL) {
+            fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", ovalue);
+            ret = -1;
+            goto out;
+        }
+
+        setvbuf(output, NULL, _IOFBF, DLT_QUERY_OUTPUT_BUFFER);
+    }
+
+    /* query the files in parallel */
+    if (thread_count == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        thread_count = (cpus > 0) ? (int)cpus : 1;
+
+        if (thread_count > DLT_QUERY_MAX_THREADS)
+            thread_count = DLT_QUERY_MAX_THREADS;
+    }
+
+    if ((unsigned int)thread_count > file_count)
+        thread_count = (int)file_count;
+
+    context.query = &query;
+    context.files = files;
+    context.file_count = file_count;
+    atomic_init(&context.next, 0);
+
+    for (started = 0; started < thread_count; started++)
+        if (pthread_create(&threads[started], NULL, dlt_query_thread, &context) != 0)
+            break;
+
+    /* query the remaining files here if not all threads could be started */
+    if (started < thread_count)
+        dlt_query_thread(&context);
+
+    for (i = 0; i < (unsigned int)started; i++)
+        pthread_join(threads[i], NULL);
+
+    for (i = 0; i < file_count; i++) {
+        if (query.verbose && !files[i].indexed && files[i].compressed && !query.save)
+            fprintf(stderr, "%s: block index, %u blocks skipped, %" PRIu64 " messages read, %" PRIu64 " matches\n",
+                    files[i].name, files[i].blocks_skipped, files[i].scanned, files[i].matched);
+        else if (query.verbose)
+            fprintf(stderr, "%s: %s, %u of %u segments read, %" PRIu64 " messages read, %" PRIu64 " matches\n",
+                    files[i].name, files[i].indexed ? "indexed" : "index built",
+                    files[i].segments_read, files[i].segments, files[i].scanned, files[i].matched);
+
+        if (files[i].error)
+            ret = -1;
+
+        matched += files[i].matched;
+        scanned += files[i].scanned;
+    }
+
+    /* merge the matches of all files in time order */
+    heap = malloc((file_count + 1) * sizeof(unsigned int));
+
+    if (heap == NULL) {
+        ret = -1;
+        goto out;
+    }
+
+    for (i = 0; i < file_count; i++)
+        if (files[i].match_count > 0)
+            heap[heap_count++] = i;
+
+    for (i = heap_count / 2; i > 0; i--)
+        dlt_query_heap_down(files, heap, heap_count, i - 1);
+
+    dlt_message_init(&msg, 0);
+
+    while (heap_count > 0) {
+        DltQueryFile *qf = &files[heap[0]];
+        DltQueryMatch *match = &qf->matches[qf->next];
+
+        if (dlt_query_read_match(qf, data) == NULL) {
+            ret = -1;
+            break;
+        }
+
+        if (output && (fwrite(data, match->size, 1, output) != 1)) {
+            fprintf(stderr, "ERROR: Writing output file %s failed!\n", ovalue);
+            ret = -1;
+            break;
+        }
+
+        if (aflag || xflag || mflag || sflag) {
+            /* the storage header is not parsed by dlt_message_read() */
+            memcpy(msg.headerbuffer, data, sizeof(DltStorageHeader));
+            msg.extendedheader = NULL;
+
+            if (dlt_message_read(&msg, data + sizeof(DltStorageHeader),
+                                 match->size - (unsigned int)sizeof(DltStorageHeader), 0, 0) ==
+                DLT_MESSAGE_ERROR_OK) {
+                if (xflag) {
+                    printf("%" PRIu64 " ", num);
+                    dlt_message_print_hex(&msg, text, DLT_QUERY_TEXTBUFSIZE, 0);
+                }
+                else if (aflag) {
+                    printf("%" PRIu64 " ", num);
+
+                    dlt_message_header(&msg, text, DLT_QUERY_TEXTBUFSIZE, 0);
+
+                    printf("%s ", text);
+
+                    dlt_message_payload(&msg, text, DLT_QUERY_TEXTBUFSIZE, DLT_OUTPUT_ASCII, 0);
+
+                    printf("[%s]\n", text);
+                }
+                else if (mflag) {
+                    printf("%" PRIu64 " ", num);
+                    dlt_message_print_mixed_plain(&msg, text, DLT_QUERY_TEXTBUFSIZE, 0);
+                }
+                else if (sflag) {
+                    printf("%" PRIu64 " ", num);
+
+                    dlt_message_header(&msg, text, DLT_QUERY_TEXTBUFSIZE, 0);
+
+                    printf("%s \n", text);
+                }
+            }
+        }
+
+        num++;
+
+        if (++qf->next == qf->match_count) {
+            dlt_query_close_reader(qf);
+            heap[0] = heap[--heap_count];
+        }
+
+        dlt_query_heap_down(files, heap, heap_count, 0);
+    }
+
+    dlt_message_free(&msg, 0);
+
+    if (cflag)
+        printf("Matching messages: %" PRIu64 " of %" PRIu64 " messages read in %u files\n",
+               matched, scanned, file_count);
+
+out:
+    if (output && (fclose(output) != 0)) {
+        fprintf(stderr, "ERROR: Writing output file %s failed!\n", ovalue);
+        ret = -1;
+    }
+
+    for (i = 0; i < file_count; i++) {
+        dlt_query_close_reader(&files[i]);
+        free(files[i].name);
+        free(files[i].matches);
+    }
+
+    free(files);
+    free(heap);
+
+    return ret;
+}
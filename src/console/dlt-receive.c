@@ -70,7 +70,6 @@
 #include <stdlib.h>     /* for atoi() */
 #include <sys/stat.h>   /* for S_IRUSR, S_IWUSR, S_IRGRP, S_IROTH */
 #include <fcntl.h>      /* for open() */
-#include <sys/uio.h>    /* for writev() */
 #include <errno.h>
 #include <string.h>
 #include <glob.h>
@@ -83,12 +82,24 @@
 #   include <limits.h>
 #endif
 #include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "dlt_client.h"
+#include "dlt_compressed_file.h"
 #include "dlt-control-common.h"
 
 #define DLT_RECEIVE_ECU_ID "RECV"
 
+/* Number of output buffers, the receive path fills one while the others are written */
+#define DLT_RECEIVE_BUFFER_COUNT 8
+/* Default and smallest size of an output buffer, a buffer must hold the largest message */
+#define DLT_RECEIVE_BUFFER_SIZE (1024 * 1024)
+#define DLT_RECEIVE_BUFFER_MIN (128 * 1024)
+/* A partly filled buffer is written when no buffer was full for this time, in s */
+#define DLT_RECEIVE_FLUSH_INTERVAL 1
+
 DltClient dltclient;
 
 void signal_handler(int signal)
@@ -111,6 +122,38 @@ void signal_handler(int signal)
 /* Function prototypes */
 int dlt_receive_message_callback(DltMessage *message, void *data);
 
+typedef enum {
+    DLT_RECEIVE_FSYNC_NONE = 0, /* leave it to the kernel */
+    DLT_RECEIVE_FSYNC_ROTATE,   /* sync each output file when it is closed */
+    DLT_RECEIVE_FSYNC_BUFFER    /* sync after each buffer written */
+} DltReceiveFsyncPolicy;
+
+typedef struct {
+    uint8_t *data;
+    size_t used;
+    int64_t offset; /* position in the output file */
+    int rotate;     /* open the next output file before writing this buffer */
+} DltReceiveBuffer;
+
+typedef struct {
+    pthread_t thread;
+    int started;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;   /* signaled when a buffer is queued or given back */
+    DltReceiveBuffer buffers[DLT_RECEIVE_BUFFER_COUNT];
+    size_t size;           /* size of each buffer */
+    DltReceiveBuffer *current; /* buffer filled by the receive path */
+    DltReceiveBuffer *queue[DLT_RECEIVE_BUFFER_COUNT]; /* full buffers, in file order */
+    int queue_first;
+    int queue_count;
+    DltReceiveBuffer *free[DLT_RECEIVE_BUFFER_COUNT];
+    int free_count;
+    int stop;
+    int error;             /* writing failed, further messages are dropped */
+    int64_t written;       /* bytes written into the current output file */
+    uint64_t stalls;       /* times the receive path waited for a free buffer */
+} DltReceiveWriter;
+
 typedef struct {
     int aflag;
     int sflag;
@@ -119,6 +162,7 @@ typedef struct {
     int vflag;
     int yflag;
     int uflag;
+    int zflag;          /* write block compressed output files */
     char *ovalue;
     char *ovaluebase; /* ovalue without ".dlt" */
     char *fvalue;       /* filename for space separated filter file (<AppID> <ContextID>) */
@@ -134,7 +178,12 @@ typedef struct {
     int part_num;    /* number of current output file if limit was exceeded */
     DltFile file;
     DltFilter filter;
+    DltSegmentBuffer segments; /* values split over several messages */
     int port;
+    size_t buffer_size; /* size of the output buffers */
+    DltReceiveFsyncPolicy fsync_policy;
+    DltReceiveWriter writer;
+    DltCompressedWriter compressed; /* writer of the current output file with -z */
 } DltReceiveData;
 
 /**
@@ -167,6 +216,12 @@ void usage()
     printf("  -c limit      Restrict file size to <limit> bytes when output to file\n");
     printf("                When limit is reached, a new file is opened. Use K,M,G as\n");
     printf("                suffix to specify kilo-, mega-, giga-bytes respectively\n");
+    printf("  -B size       Size of the output buffers (Default: 1M, minimum: 128K)\n");
+    printf("                Use K,M as suffix to specify kilo-, mega-bytes respectively\n");
+    printf("  -z            Write block compressed output files, the limit of -c\n");
+    printf("                applies to the uncompressed size\n");
+    printf("  -F policy     Sync the output file: none, rotate (when a file is closed)\n");
+    printf("                or buffer (after each output buffer) (Default: none)\n");
     printf("  -f filename   Enable filtering of messages with space separated list (<AppID> <ContextID>)\n");
     printf("  -j filename   Enable filtering of messages with filter defined in json file\n");
     printf("  -p port       Use the given port instead the default port\n");
@@ -307,6 +362,366 @@ void dlt_receive_close_output_file(DltReceiveData *dltdata)
     }
 }
 
+/*
+ * Output file writer
+ *
+ * The receive path copies each message into a large buffer. Full buffers are
+ * written by the writer thread, which also opens the next file when the size
+ * limit is reached, so the receive path never waits for the disk unless all
+ * buffers are in use.
+ */
+
+/* Put a buffer at the end of the write queue, called with the lock held */
+static void dlt_receive_writer_queue(DltReceiveWriter *writer, DltReceiveBuffer *buffer)
+{
+    writer->queue[(writer->queue_first + writer->queue_count) % DLT_RECEIVE_BUFFER_COUNT] = buffer;
+    writer->queue_count++;
+    pthread_cond_broadcast(&writer->cond);
+}
+
+/* Take a free buffer as the one to be filled, called with the lock held */
+static void dlt_receive_writer_next(DltReceiveWriter *writer)
+{
+    writer->current = writer->free[--writer->free_count];
+    writer->current->used = 0;
+    writer->current->rotate = 0;
+}
+
+/* Give a written buffer back to the receive path */
+static void dlt_receive_writer_release(DltReceiveWriter *writer, DltReceiveBuffer *buffer)
+{
+    pthread_mutex_lock(&writer->lock);
+    writer->free[writer->free_count++] = buffer;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/* Stop writing after an error, the following messages are dropped */
+static void dlt_receive_writer_fail(DltReceiveWriter *writer, const char *what, int error)
+{
+    pthread_mutex_lock(&writer->lock);
+
+    if (!writer->error)
+        dlt_vlog(LOG_ERR, "ERROR: %s failed: %s, messages are not stored anymore!\n",
+                 what, strerror(error));
+
+    writer->error = 1;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->lock);
+}
+
+/* Write a buffer at its offset in the file */
+static int dlt_receive_writer_pwrite(DltReceiveData *dltdata, DltReceiveBuffer *buffer)
+{
+    size_t done = 0;
+    ssize_t ret;
+
+    while (done < buffer->used) {
+        ret = pwrite(dltdata->ohandle, buffer->data + done, buffer->used - done,
+                     (off_t)(buffer->offset + (int64_t)done));
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            dlt_receive_writer_fail(&dltdata->writer, "Writing output file", errno);
+            return -1;
+        }
+
+        done += (size_t)ret;
+    }
+
+    return 0;
+}
+
+/* Sync the data of the output file if the policy asks for it after each buffer */
+static void dlt_receive_writer_sync_buffer(DltReceiveData *dltdata)
+{
+    if ((dltdata->fsync_policy == DLT_RECEIVE_FSYNC_BUFFER) && (fdatasync(dltdata->ohandle) != 0))
+        dlt_vlog(LOG_WARNING, "fdatasync of %s failed: %s\n", dltdata->ovalue, strerror(errno));
+}
+
+/* Reserve the disk space of a whole split file, the file size stays the
+ * size of the data written */
+static void dlt_receive_writer_preallocate(DltReceiveData *dltdata)
+{
+#ifdef __linux__
+    if ((dltdata->climit > 0) && (dltdata->ohandle >= 0) &&
+        (fallocate(dltdata->ohandle, FALLOC_FL_KEEP_SIZE, 0, (off_t)dltdata->climit) != 0) &&
+        dltdata->vflag)
+        dlt_vlog(LOG_INFO, "Cannot preallocate %s: %s\n", dltdata->ovalue, strerror(errno));
+#else
+    (void)dltdata;
+#endif
+}
+
+/* Start writing a new output file */
+static int dlt_receive_writer_begin_file(DltReceiveData *dltdata)
+{
+    dltdata->writer.written = 0;
+
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    if (dltdata->zflag) {
+        if (dlt_compressed_writer_init(&(dltdata->compressed), dltdata->ohandle) < DLT_RETURN_OK)
+            return -1;
+
+        return 0;
+    }
+#endif
+
+    dlt_receive_writer_preallocate(dltdata);
+
+    return 0;
+}
+
+/* Complete the current output file once all its data is written */
+static void dlt_receive_writer_finish_file(DltReceiveData *dltdata)
+{
+    if (dltdata->ohandle < 0)
+        return;
+
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    /* write the last block and the index */
+    if (dltdata->zflag) {
+        if (dlt_compressed_writer_close(&(dltdata->compressed)) == DLT_RETURN_ERROR)
+            dlt_vlog(LOG_WARNING, "Cannot write the index of %s\n", dltdata->ovalue);
+
+        dltdata->writer.written = (int64_t)dltdata->compressed.offset;
+    }
+#endif
+
+    /* drop preallocated space and old data behind the messages */
+    if (ftruncate(dltdata->ohandle, (off_t)dltdata->writer.written) != 0)
+        dlt_vlog(LOG_WARNING, "Cannot truncate %s: %s\n", dltdata->ovalue, strerror(errno));
+
+    if ((dltdata->fsync_policy != DLT_RECEIVE_FSYNC_NONE) && (fsync(dltdata->ohandle) != 0))
+        dlt_vlog(LOG_WARNING, "fsync of %s failed: %s\n", dltdata->ovalue, strerror(errno));
+}
+
+/* Close the output file and open the next one */
+static int dlt_receive_writer_rotate(DltReceiveData *dltdata)
+{
+    dlt_receive_writer_finish_file(dltdata);
+    dlt_receive_close_output_file(dltdata);
+
+    if (dlt_receive_open_output_file(dltdata) < 0) {
+        dlt_receive_writer_fail(&dltdata->writer, "Opening log when maximum filesize was reached", errno);
+        return -1;
+    }
+
+    if (dlt_receive_writer_begin_file(dltdata) < 0) {
+        dlt_receive_writer_fail(&dltdata->writer, "Writing header of the next log", EIO);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Write a full buffer, it is given back once written */
+static void dlt_receive_writer_write(DltReceiveData *dltdata, DltReceiveBuffer *buffer)
+{
+    DltReceiveWriter *writer = &dltdata->writer;
+
+    if (buffer->rotate && !writer->error)
+        dlt_receive_writer_rotate(dltdata);
+
+    if (writer->error || (dltdata->ohandle < 0)) {
+        dlt_receive_writer_release(writer, buffer);
+        return;
+    }
+
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    if (dltdata->zflag) {
+        if (dlt_compressed_writer_write(&(dltdata->compressed), buffer->data, buffer->used) < DLT_RETURN_OK)
+            dlt_receive_writer_fail(writer, "Writing compressed output file", EIO);
+        else
+            dlt_receive_writer_sync_buffer(dltdata);
+
+        dlt_receive_writer_release(writer, buffer);
+        return;
+    }
+#endif
+
+    buffer->offset = writer->written;
+    writer->written += (int64_t)buffer->used;
+
+    if (dlt_receive_writer_pwrite(dltdata, buffer) == 0)
+        dlt_receive_writer_sync_buffer(dltdata);
+
+    dlt_receive_writer_release(writer, buffer);
+}
+
+static void *dlt_receive_writer_thread(void *data)
+{
+    DltReceiveData *dltdata = (DltReceiveData *)data;
+    DltReceiveWriter *writer = &dltdata->writer;
+    DltReceiveBuffer *buffer = NULL;
+    struct timespec t;
+
+    pthread_mutex_lock(&writer->lock);
+
+    while (1) {
+        if (writer->queue_count > 0) {
+            buffer = writer->queue[writer->queue_first];
+            writer->queue_first = (writer->queue_first + 1) % DLT_RECEIVE_BUFFER_COUNT;
+            writer->queue_count--;
+
+            pthread_mutex_unlock(&writer->lock);
+            dlt_receive_writer_write(dltdata, buffer);
+            pthread_mutex_lock(&writer->lock);
+            continue;
+        }
+
+        if (writer->stop)
+            break;
+
+        clock_gettime(CLOCK_REALTIME, &t);
+        t.tv_sec += DLT_RECEIVE_FLUSH_INTERVAL;
+
+        /* write a partly filled buffer when no message came for a while */
+        if ((pthread_cond_timedwait(&writer->cond, &writer->lock, &t) == ETIMEDOUT) &&
+            (writer->queue_count == 0) && (writer->current->used > 0) && (writer->free_count > 0)) {
+            dlt_receive_writer_queue(writer, writer->current);
+            dlt_receive_writer_next(writer);
+        }
+    }
+
+    pthread_mutex_unlock(&writer->lock);
+
+    dlt_receive_writer_finish_file(dltdata);
+
+    return NULL;
+}
+
+/*
+ * start the writer thread of the output file
+ */
+static int dlt_receive_writer_start(DltReceiveData *dltdata)
+{
+    DltReceiveWriter *writer = &dltdata->writer;
+    int i;
+
+    memset(writer, 0, sizeof(DltReceiveWriter));
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->cond, NULL);
+    writer->size = dltdata->buffer_size;
+
+    for (i = 0; i < DLT_RECEIVE_BUFFER_COUNT; i++) {
+        writer->buffers[i].data = malloc(writer->size);
+
+        if (writer->buffers[i].data == NULL) {
+            fprintf(stderr, "ERROR: Cannot allocate output buffers of %zu bytes\n", writer->size);
+            return -1;
+        }
+
+        writer->free[writer->free_count++] = &(writer->buffers[i]);
+    }
+
+    dlt_receive_writer_next(writer);
+
+    if (dlt_receive_writer_begin_file(dltdata) < 0) {
+        fprintf(stderr, "ERROR: Cannot write output file %s\n", dltdata->ovalue);
+        return -1;
+    }
+
+    if (pthread_create(&writer->thread, NULL, dlt_receive_writer_thread, dltdata) != 0) {
+        fprintf(stderr, "ERROR: Cannot create writer thread\n");
+        return -1;
+    }
+
+    writer->started = 1;
+
+    return 0;
+}
+
+/*
+ * write the remaining messages and stop the writer thread
+ */
+static void dlt_receive_writer_stop(DltReceiveData *dltdata)
+{
+    DltReceiveWriter *writer = &dltdata->writer;
+    int i;
+
+    if (writer->started) {
+        pthread_mutex_lock(&writer->lock);
+
+        if (writer->current->used > 0)
+            dlt_receive_writer_queue(writer, writer->current);
+
+        writer->stop = 1;
+        pthread_cond_broadcast(&writer->cond);
+        pthread_mutex_unlock(&writer->lock);
+
+        pthread_join(writer->thread, NULL);
+        writer->started = 0;
+
+        if (dltdata->vflag && (writer->stalls > 0))
+            dlt_vlog(LOG_INFO, "Receiving waited %" PRIu64 " times for the disk\n", writer->stalls);
+    }
+
+    for (i = 0; i < DLT_RECEIVE_BUFFER_COUNT; i++) {
+        free(writer->buffers[i].data);
+        writer->buffers[i].data = NULL;
+    }
+
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->lock);
+}
+
+/*
+ * copy a message into the output buffer, the size limit of the output
+ * file is checked here so that each file ends with a whole message
+ */
+static int dlt_receive_writer_add(DltReceiveData *dltdata, DltMessage *message)
+{
+    DltReceiveWriter *writer = &dltdata->writer;
+    size_t size = (size_t)message->headersize + (size_t)message->datasize;
+    int rotate = 0;
+
+    if (size > writer->size)
+        return -1;
+
+    if (dltdata->climit > -1) {
+        if ((int64_t)size + dltdata->totalbytes > dltdata->climit) {
+            rotate = 1;
+            dltdata->totalbytes = 0;
+        }
+
+        dltdata->totalbytes += (int64_t)size;
+    }
+
+    pthread_mutex_lock(&writer->lock);
+
+    if (writer->error) {
+        pthread_mutex_unlock(&writer->lock);
+        return -1;
+    }
+
+    if ((rotate || (writer->current->used + size > writer->size)) && (writer->current->used > 0)) {
+        dlt_receive_writer_queue(writer, writer->current);
+
+        if (writer->free_count == 0)
+            writer->stalls++;
+
+        while (writer->free_count == 0)
+            pthread_cond_wait(&writer->cond, &writer->lock);
+
+        dlt_receive_writer_next(writer);
+    }
+
+    if (rotate)
+        writer->current->rotate = 1;
+
+    memcpy(writer->current->data + writer->current->used, message->headerbuffer, (size_t)message->headersize);
+    writer->current->used += (size_t)message->headersize;
+    memcpy(writer->current->data + writer->current->used, message->databuffer, (size_t)message->datasize);
+    writer->current->used += (size_t)message->datasize;
+
+    pthread_mutex_unlock(&writer->lock);
+
+    return 0;
+}
+
 
 /**
  * Main function of tool.
@@ -314,6 +729,7 @@ void dlt_receive_close_output_file(DltReceiveData *dltdata)
 int main(int argc, char *argv[])
 {
     DltReceiveData dltdata;
+    DltSegment *segment = NULL;
     int c;
     int index;
 
@@ -325,6 +741,7 @@ int main(int argc, char *argv[])
     dltdata.vflag = 0;
     dltdata.yflag = 0;
     dltdata.uflag = 0;
+    dltdata.zflag = 0;
     dltdata.ovalue = 0;
     dltdata.ovaluebase = 0;
     dltdata.fvalue = 0;
@@ -338,6 +755,9 @@ int main(int argc, char *argv[])
     dltdata.totalbytes = 0;
     dltdata.part_num = -1;
     dltdata.port = 3490;
+    dltdata.buffer_size = DLT_RECEIVE_BUFFER_SIZE;
+    dltdata.fsync_policy = DLT_RECEIVE_FSYNC_NONE;
+    memset(&(dltdata.writer), 0, sizeof(dltdata.writer));
 
     /* Config signal handler */
     struct sigaction act;
@@ -354,7 +774,7 @@ int main(int argc, char *argv[])
     /* Fetch command line arguments */
     opterr = 0;
 
-    while ((c = getopt (argc, argv, "vashSRyuxmf:j:o:e:b:c:p:")) != -1)
+    while ((c = getopt (argc, argv, "vashSRyuxmzf:j:o:e:b:c:p:B:F:")) != -1)
         switch (c) {
         case 'v':
         {
@@ -406,6 +826,17 @@ int main(int argc, char *argv[])
             dltdata.uflag = 1;
             break;
         }
+        case 'z':
+        {
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+            dltdata.zflag = 1;
+            break;
+#else
+            fprintf (stderr,
+                     "Compressed files are not supported. Please build with the corresponding cmake option to use it.\n");
+            return -1;
+#endif
+        }
         case 'f':
         {
             dltdata.fvalue = optarg;
@@ -470,9 +901,41 @@ int main(int argc, char *argv[])
 
             break;
         }
+        case 'B':
+        {
+            int64_t size = convert_arg_to_byte_size(optarg);
+
+            if ((size < DLT_RECEIVE_BUFFER_MIN) || (size > INT32_MAX)) {
+                fprintf (stderr, "Invalid argument for option -B.\n");
+                usage();
+                return -1;
+            }
+
+            dltdata.buffer_size = (size_t)size;
+            break;
+        }
+        case 'F':
+        {
+            if (strcmp(optarg, "none") == 0) {
+                dltdata.fsync_policy = DLT_RECEIVE_FSYNC_NONE;
+            }
+            else if (strcmp(optarg, "rotate") == 0) {
+                dltdata.fsync_policy = DLT_RECEIVE_FSYNC_ROTATE;
+            }
+            else if (strcmp(optarg, "buffer") == 0) {
+                dltdata.fsync_policy = DLT_RECEIVE_FSYNC_BUFFER;
+            }
+            else {
+                fprintf (stderr, "Invalid argument for option -F.\n");
+                usage();
+                return -1;
+            }
+
+            break;
+        }
         case '?':
         {
-            if ((optopt == 'o') || (optopt == 'f') || (optopt == 'c'))
+            if ((optopt == 'o') || (optopt == 'f') || (optopt == 'c') || (optopt == 'B') || (optopt == 'F'))
                 fprintf (stderr, "Option -%c requires an argument.\n", optopt);
             else if (isprint (optopt))
                 fprintf (stderr, "Unknown option `-%c'.\n", optopt);
@@ -544,6 +1007,9 @@ int main(int argc, char *argv[])
     /* initialise structure to use DLT file */
     dlt_file_init(&(dltdata.file), dltdata.vflag);
 
+    /* initialise structure to reassemble segmented values */
+    dlt_segment_init(&(dltdata.segments));
+
     /* first parse filter file if filter parameter is used */
     dlt_filter_init(&(dltdata.filter), dltdata.vflag);
 
@@ -585,6 +1051,13 @@ int main(int argc, char *argv[])
             fprintf(stderr, "ERROR: Output file %s cannot be opened!\n", dltdata.ovalue);
             return -1;
         }
+
+        if (dlt_receive_writer_start(&dltdata) < 0) {
+            dlt_receive_writer_stop(&dltdata);
+            close(dltdata.ohandle);
+            dlt_file_free(&(dltdata.file), dltdata.vflag);
+            return -1;
+        }
     }
 
     if (dltdata.evalue)
@@ -603,13 +1076,21 @@ int main(int argc, char *argv[])
     }
 
     /* dlt-receive cleanup */
-    if (dltdata.ovalue)
+    if (dltdata.ovalue) {
+        dlt_receive_writer_stop(&dltdata);
         close(dltdata.ohandle);
+    }
 
     free(dltdata.ovaluebase);
 
     dlt_file_free(&(dltdata.file), dltdata.vflag);
 
+    /* values whose last message did not arrive before the connection ended */
+    while (dltdata.aflag && (dlt_segment_get_pending(&(dltdata.segments), &segment) == DLT_RETURN_TRUE))
+        printf("%s [%s] (truncated)\n", segment->header, segment->text);
+
+    dlt_segment_free(&(dltdata.segments));
+
     dlt_filter_free(&(dltdata.filter), dltdata.vflag);
 
     return 0;
@@ -619,9 +1100,7 @@ int dlt_receive_message_callback(DltMessage *message, void *data)
 {
     DltReceiveData *dltdata;
     static char text[DLT_RECEIVE_BUFSIZE];
-
-    struct iovec iov[2];
-    int bytes_written;
+    DltSegment *segment = NULL;
 
     if ((message == 0) || (data == 0))
         return -1;
@@ -641,6 +1120,15 @@ int dlt_receive_message_callback(DltMessage *message, void *data)
             dlt_message_print_hex(message, text, DLT_RECEIVE_BUFSIZE, dltdata->vflag);
             printf("Session ID:%lu\n",message->headerextra.seid);
         }
+        else if (dltdata->aflag &&
+                 (dlt_segment_add(&(dltdata->segments), message, &segment, dltdata->vflag) == DLT_RETURN_TRUE))
+        {
+            /* a value split over several messages is printed once it is complete */
+            if (segment != NULL) {
+                printf("%s [%s]%s\n", segment->header, segment->text, segment->truncated ? " (truncated)" : "");
+                printf("Session ID:%u\n",message->headerextra.seid);
+            }
+        }
         else if (dltdata->aflag)
         {
 
@@ -668,37 +1156,8 @@ int dlt_receive_message_callback(DltMessage *message, void *data)
         }
 
         /* if file output enabled write message */
-        if (dltdata->ovalue) {
-            iov[0].iov_base = message->headerbuffer;
-            iov[0].iov_len = (uint32_t)message->headersize;
-            iov[1].iov_base = message->databuffer;
-            iov[1].iov_len = (uint32_t)message->datasize;
-
-            if (dltdata->climit > -1) {
-                uint32_t bytes_to_write = message->headersize + message->datasize;
-
-                if ((bytes_to_write + dltdata->totalbytes > dltdata->climit)) {
-                    dlt_receive_close_output_file(dltdata);
-
-                    if (dlt_receive_open_output_file(dltdata) < 0) {
-                        printf(
-                            "ERROR: dlt_receive_message_callback: Unable to open log when maximum filesize was reached!\n");
-                        return -1;
-                    }
-
-                    dltdata->totalbytes = 0;
-                }
-            }
-
-            bytes_written = (int)writev(dltdata->ohandle, iov, 2);
-
-            dltdata->totalbytes += bytes_written;
-
-            if (0 > bytes_written) {
-                printf("dlt_receive_message_callback: writev(dltdata->ohandle, iov, 2); returned an error!");
-                return -1;
-            }
-        }
+        if (dltdata->ovalue && (dlt_receive_writer_add(dltdata, message) < 0))
+            return -1;
     }
 
     return 0;
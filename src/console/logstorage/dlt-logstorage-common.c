@@ -321,3 +321,30 @@ int dlt_logstorage_send_event(int type, char *mount_point)
 
     return ret;
 }
+
+/** @brief Prepare a logstorage event as operation of a batch
+ *
+ * @param op The operation to fill
+ * @param type The type of the event (Mounted/Unmounting)
+ * @param mount_point The mount point for this event
+ *
+ * @return 0 On success, -1 otherwise.
+ */
+int dlt_logstorage_batch_event(DltControlBatchOp *op, int type, char *mount_point)
+{
+    DltControlMsgBody *msg_body = NULL;
+
+    if (op == NULL)
+        return -1;
+
+    /* mount_point is checked against NULL in the preparation */
+    if (!prepare_message_body(&msg_body, type, mount_point)) {
+        pr_error("Data for Dlt Message body is NULL\n");
+        return -1;
+    }
+
+    op->body = *msg_body;
+    free(msg_body);
+
+    return 0;
+}
@@ -68,6 +68,17 @@ int dlt_logstorage_deinit_handler(void);
  */
 int dlt_logstorage_send_event(int, char *);
 
+/**
+ * Prepare an event as operation of a batch
+ *
+ * @param op The operation to fill
+ * @param type Event type (EVENT_UNMOUNTING/EVENT_MOUNTED/EVENT_SYNC_CACHE)
+ * @param mount_point The mount point path concerned by this event
+ *
+ * @return  0 on success, -1 on error
+ */
+int dlt_logstorage_batch_event(DltControlBatchOp *, int, char *);
+
 /** @brief Search for config file in given mount point
  *
  * The file is searched at the top directory. The function exits once it
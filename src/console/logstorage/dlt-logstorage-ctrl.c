@@ -78,6 +78,7 @@
 
 #define DLT_LOGSTORAGE_CTRL_EXIT 1
 static int must_exit;
+static char *batch_file; /* file with the commands of a batch */
 struct dlt_event {
     struct pollfd pfd;
     void *func;
@@ -386,6 +387,119 @@ static int dlt_logstorage_ctrl_single_request()
     return ret;
 }
 
+static struct option batch_options[] = {
+    {"command",       required_argument,  0,  'c'},
+    {"path",          required_argument,  0,  'p'},
+    {"snapshot",      optional_argument,  0,  's'},
+    {0,               0,                  0,  0}
+};
+
+/** @brief Fill an operation of a batch from the options on a line
+ *
+ * A line holds the options -c and -p, or -s of one command.
+ *
+ * @param argc The amount of arguments
+ * @param argv The table of arguments
+ * @param op The operation to fill
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+static int dlt_logstorage_ctrl_parse_batch_op(int argc, char *argv[], DltControlBatchOp *op)
+{
+    char path[DLT_MOUNT_PATH_MAX] = { 0 };
+    int type = EVENT_MOUNTED;
+    int c = -1;
+
+    optind = 1;
+
+    while ((c = getopt_long(argc, argv, ":c:p:s::", batch_options, NULL)) != -1)
+        switch (c) {
+        case 'c':
+            type = (int) strtol(optarg, NULL, 10);
+            break;
+        case 's':
+            type = EVENT_SYNC_CACHE;
+
+            if (optarg == NULL)
+                break;
+
+            /* fall through */
+        case 'p':
+
+            if (strlen(optarg) >= DLT_MOUNT_PATH_MAX) {
+                pr_error("Mount path '%s' too long\n", optarg);
+                return -1;
+            }
+
+            strncpy(path, optarg, DLT_MOUNT_PATH_MAX - 1);
+            break;
+        default:
+            pr_error("Only -c, -p and -s are allowed in a batch\n");
+            return -1;
+        }
+
+    if (optind < argc) {
+        pr_error("Unexpected argument '%s'\n", argv[optind]);
+        return -1;
+    }
+
+    /* in case sync all caches, an empty path is given */
+    if (type != EVENT_SYNC_CACHE) {
+        if (!dlt_logstorage_check_config_file(path)) {
+            pr_error("No '%s' file available at: %s\n", CONF_NAME, path);
+            return -1;
+        }
+
+        if (!dlt_logstorage_check_directory_permission(path)) {
+            pr_error("'%s' is not writable\n", path);
+            return -1;
+        }
+    }
+
+    return dlt_logstorage_batch_event(op, type, path);
+}
+
+/** @brief Send the commands of a batch file to DLT daemon
+ *
+ * All commands are sent over one connection without waiting for each
+ * response, a report of the failed commands and the latencies is printed.
+ *
+ * @return 0 if all commands succeeded, -1 otherwise.
+ */
+static int dlt_logstorage_ctrl_batch_request(void)
+{
+    DltControlBatch batch = { 0 };
+    int ret = 0;
+
+    if (dlt_control_batch_read(&batch, batch_file, dlt_logstorage_ctrl_parse_batch_op) <= 0) {
+        pr_error("No valid command in batch file %s\n", batch_file);
+        dlt_control_batch_free(&batch);
+        return -1;
+    }
+
+    /* Initializing the communication with the daemon */
+    while (dlt_control_init(analyze_response, get_ecuid(), get_verbosity()) &&
+           !dlt_logstorage_must_exit()) {
+        pr_error("Failed to initialize connection with the daemon.\n");
+        pr_error("Retrying to connect in %ds.\n", get_timeout());
+        sleep( (unsigned int) get_timeout());
+    }
+
+    if (dlt_logstorage_must_exit()) {
+        pr_verbose("Exiting.\n");
+        dlt_control_batch_free(&batch);
+        return -1;
+    }
+
+    ret = dlt_control_batch_send(&batch, DLT_CTRL_BATCH_WINDOW, get_timeout() * 1000);
+    dlt_control_batch_report(&batch);
+
+    dlt_control_deinit();
+    dlt_control_batch_free(&batch);
+
+    return (ret == 0) ? 0 : -1;
+}
+
 /** @brief Print out the application help
  */
 static void usage(void)
@@ -395,6 +509,8 @@ static void usage(void)
            "a certain logstorage device\n");
     printf("\n");
     printf("Options:\n");
+    printf("  -b --batch=file            Send the commands of a file, '-' for stdin\n");
+    printf("                             Each line holds -c and -p, or -s[path]\n");
     printf("  -c --command               Connection type: connect = 1, disconnect = 0\n");
     printf("  -d[prop] --daemonize=prop  Run as daemon: prop = use proprietary handler\n");
     printf("                             'prop' may be replaced by any meaningful word\n");
@@ -412,6 +528,7 @@ static void usage(void)
 }
 
 static struct option long_options[] = {
+    {"batch",         required_argument,  0,  'b'},
     {"command",       required_argument,  0,  'c'},
     {"daemonize",     optional_argument,  0,  'd'},
     {"ecuid",         required_argument,  0,  'e'},
@@ -441,7 +558,7 @@ static int parse_args(int argc, char *argv[])
 
     while ((c = getopt_long(argc,
                             argv,
-                            ":s::t:hSRe:p:d::c:v",
+                            ":s::t:hSRe:p:d::c:vb:",
                             long_options,
                             &long_index)) != -1)
         switch (c) {
@@ -491,6 +608,9 @@ static int parse_args(int argc, char *argv[])
         case 'c':
             set_default_event_type(strtol(optarg, NULL, 10));
             break;
+        case 'b':
+            batch_file = optarg;
+            break;
         case 'v':
             set_verbosity(1);
             pr_verbose("Now in verbose mode.\n");
@@ -521,6 +641,11 @@ static int parse_args(int argc, char *argv[])
         return -1;
     }
 
+    if ((batch_file != NULL) && (get_handler_type() != CTRL_NOHANDLER)) {
+        pr_error("Batch not available in daemon mode\n");
+        return -1;
+    }
+
     return 0;
 }
 
@@ -558,7 +683,15 @@ int main(int argc, char *argv[])
 
     /* all parameter valid, start communication with daemon or setup
      * communication with control daemon */
-    if (get_handler_type() == CTRL_NOHANDLER) {
+    if (batch_file != NULL) {
+        pr_verbose("Batch.\n");
+
+        ret = dlt_logstorage_ctrl_batch_request();
+
+        if (ret < 0)
+            pr_error("Some commands of the batch failed.\n");
+    }
+    else if (get_handler_type() == CTRL_NOHANDLER) {
         pr_verbose("One shot.\n");
 
         ret = dlt_logstorage_ctrl_single_request();
@@ -32,6 +32,7 @@
 #include <sys/un.h>
 #include <arpa/inet.h>  /* for sockaddr_in and inet_addr() */
 #include <stdlib.h>     /* for atoi() and exit() */
+#include <stddef.h>     /* for offsetof() */
 #include <string.h>     /* for memset() */
 #include <unistd.h>     /* for close() and access */
 #include <fcntl.h>
@@ -40,6 +41,7 @@
 #include <errno.h>
 #include <pthread.h>
 #include <grp.h>
+#include <dirent.h>
 
 #ifdef linux
 #   include <sys/timerfd.h>
@@ -72,6 +74,7 @@
 #include "dlt_daemon_connection.h"
 #include "dlt_daemon_event_handler.h"
 #include "dlt_daemon_offline_logstorage.h"
+#include "dlt_daemon_metrics.h"
 #include "dlt_gateway.h"
 
 #ifdef UDP_CONNECTION_SUPPORT
@@ -93,10 +96,6 @@ static int dlt_daemon_check_numeric_setting(char *token,
                                             char *value,
                                             unsigned long *data);
 
-#ifdef DLT_SYSTEMD_WATCHDOG_ENABLE
-static uint32_t watchdog_trigger_interval;  /* watchdog trigger interval in [s] */
-#endif
-
 /* used in main event loop and signal handler */
 int g_exit = 0;
 
@@ -339,6 +338,7 @@ int option_file_parser(DltDaemonLocal *daemon_local)
     daemon_local->flags.offlineTraceFileSize = 1000000;
     daemon_local->flags.offlineTraceMaxSize = 4000000;
     daemon_local->flags.offlineTraceFilenameTimestampBased = 1;
+    daemon_local->flags.offlineTraceCompression = 0;
     daemon_local->flags.loggingMode = DLT_LOG_TO_CONSOLE;
     daemon_local->flags.loggingLevel = LOG_INFO;
 
@@ -361,6 +361,9 @@ int option_file_parser(DltDaemonLocal *daemon_local)
     daemon_local->RingbufferMinSize = DLT_DAEMON_RINGBUFFER_MIN_SIZE;
     daemon_local->RingbufferMaxSize = DLT_DAEMON_RINGBUFFER_MAX_SIZE;
     daemon_local->RingbufferStepSize = DLT_DAEMON_RINGBUFFER_STEP_SIZE;
+    daemon_local->RingbufferClassLimits[DLT_DAEMON_RINGBUFFER_CLASS_HIGH] = DLT_DAEMON_RINGBUFFER_HIGH_LIMIT;
+    daemon_local->RingbufferClassLimits[DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM] = DLT_DAEMON_RINGBUFFER_MEDIUM_LIMIT;
+    daemon_local->RingbufferClassLimits[DLT_DAEMON_RINGBUFFER_CLASS_LOW] = DLT_DAEMON_RINGBUFFER_LOW_LIMIT;
     daemon_local->daemonFifoSize = 0;
     daemon_local->flags.sendECUSoftwareVersion = 0;
     memset(daemon_local->flags.pathToECUSoftwareVersion, 0, sizeof(daemon_local->flags.pathToECUSoftwareVersion));
@@ -374,6 +377,13 @@ int option_file_parser(DltDaemonLocal *daemon_local)
     daemon_local->flags.offlineLogstorageCacheSize = 30000; /* 30MB */
     dlt_daemon_logstorage_set_logstorage_cache_size(
         daemon_local->flags.offlineLogstorageCacheSize);
+    daemon_local->flags.offlineLogstorageWorker = 1;
+    daemon_local->flags.offlineLogstorageQueueSize = DLT_DAEMON_LOGSTORAGE_QUEUE_SIZE;
+    daemon_local->flags.offlineLogstorageQueueBlocking = 1;
+    daemon_local->flags.pipelineMode = 0;
+    daemon_local->flags.pipelineQueueSize = DLT_DAEMON_EGRESS_QUEUE_SIZE;
+    daemon_local->flags.ingestionThreads = DLT_DAEMON_INGRESS_THREADS;
+    daemon_local->flags.serialQueueSize = DLT_DAEMON_SERIAL_QUEUE_SIZE;
     strncpy(daemon_local->flags.ctrlSockPath,
             DLT_DAEMON_DEFAULT_CTRL_SOCK_PATH,
             sizeof(daemon_local->flags.ctrlSockPath));
@@ -399,9 +409,11 @@ int option_file_parser(DltDaemonLocal *daemon_local)
     daemon_local->UDPConnectionSetup = MULTICAST_CONNECTION_ENABLED;
     strncpy(daemon_local->UDPMulticastIPAddress, MULTICASTIPADDRESS, MULTICASTIP_MAX_SIZE - 1);
     daemon_local->UDPMulticastIPPort = MULTICASTIPPORT;
+    daemon_local->UDPMulticastMTU = MULTICAST_MTU;
 #endif
     daemon_local->flags.ipNodes = NULL;
     daemon_local->flags.injectionMode = 1;
+    daemon_local->flags.rateLimits[0] = 0;
 
     /* open configuration file */
     if (daemon_local->flags.cvalue[0])
@@ -500,6 +512,15 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                         daemon_local->flags.bvalue[NAME_MAX] = 0;
                         /*printf("Option: %s=%s\n",token,value); */
                     }
+                    else if (strcmp(token, "RS232QueueSize") == 0)
+                    {
+                        if (atoi(value) >= 0)
+                            daemon_local->flags.serialQueueSize = (unsigned int)atoi(value);
+                        else
+                            dlt_vlog(LOG_WARNING,
+                                     "Invalid RS232QueueSize: %s, using default %u\n",
+                                     value, daemon_local->flags.serialQueueSize);
+                    }
                     else if (strcmp(token, "ECUId") == 0)
                     {
                         strncpy(daemon_local->flags.evalue, value, NAME_MAX);
@@ -553,6 +574,16 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                                 value, &(daemon_local->RingbufferStepSize)) < 0)
                             return -1;
                     }
+                    else if (strcmp(token, "RingbufferClassLimits") == 0)
+                    {
+                        unsigned int *limits = daemon_local->RingbufferClassLimits;
+
+                        if ((sscanf(value, "%u:%u:%u", &limits[0], &limits[1], &limits[2]) != 3) ||
+                            (limits[0] > 100) || (limits[1] > 100) || (limits[2] > 100)) {
+                            dlt_vlog(LOG_ERR, "Invalid ring buffer class limits: %s\n", value);
+                            return -1;
+                        }
+                    }
                     else if (strcmp(token, "SharedMemorySize") == 0)
                     {
                         daemon_local->flags.sharedMemorySize = atoi(value);
@@ -581,6 +612,15 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                         daemon_local->flags.offlineTraceFilenameTimestampBased = atoi(value);
                         /*printf("Option: %s=%s\n",token,value); */
                     }
+                    else if (strcmp(token, "OfflineTraceCompression") == 0)
+                    {
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+                        daemon_local->flags.offlineTraceCompression = atoi(value);
+#else
+                        if (atoi(value))
+                            dlt_log(LOG_WARNING, "OfflineTraceCompression is not supported by this build\n");
+#endif
+                    }
                     else if (strcmp(token, "SendECUSoftwareVersion") == 0)
                     {
                         daemon_local->flags.sendECUSoftwareVersion = atoi(value);
@@ -633,6 +673,45 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                         dlt_daemon_logstorage_set_logstorage_cache_size(
                             daemon_local->flags.offlineLogstorageCacheSize);
                     }
+                    else if (strcmp(token, "OfflineLogstorageWorker") == 0)
+                    {
+                        daemon_local->flags.offlineLogstorageWorker = atoi(value);
+                    }
+                    else if (strcmp(token, "OfflineLogstorageQueueSize") == 0)
+                    {
+                        if (atoi(value) > 0)
+                            daemon_local->flags.offlineLogstorageQueueSize = (unsigned int)atoi(value);
+                        else
+                            dlt_vlog(LOG_WARNING,
+                                     "Invalid OfflineLogstorageQueueSize: %s, using default %u\n",
+                                     value, daemon_local->flags.offlineLogstorageQueueSize);
+                    }
+                    else if (strcmp(token, "OfflineLogstorageQueueBlocking") == 0)
+                    {
+                        daemon_local->flags.offlineLogstorageQueueBlocking = atoi(value);
+                    }
+                    else if (strcmp(token, "PipelineMode") == 0)
+                    {
+                        daemon_local->flags.pipelineMode = atoi(value);
+                    }
+                    else if (strcmp(token, "PipelineQueueSize") == 0)
+                    {
+                        if (atoi(value) > 0)
+                            daemon_local->flags.pipelineQueueSize = (unsigned int)atoi(value);
+                        else
+                            dlt_vlog(LOG_WARNING,
+                                     "Invalid PipelineQueueSize: %s, using default %u\n",
+                                     value, daemon_local->flags.pipelineQueueSize);
+                    }
+                    else if (strcmp(token, "IngestionThreads") == 0)
+                    {
+                        if ((atoi(value) >= 0) && (atoi(value) <= DLT_DAEMON_INGRESS_MAX_THREADS))
+                            daemon_local->flags.ingestionThreads = atoi(value);
+                        else
+                            dlt_vlog(LOG_WARNING,
+                                     "Invalid IngestionThreads: %s, using default %d\n",
+                                     value, daemon_local->flags.ingestionThreads);
+                    }
                     else if (strcmp(token, "ControlSocketPath") == 0)
                     {
                         memset(
@@ -644,6 +723,17 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                             value,
                             DLT_DAEMON_FLAG_MAX - 1);
                     }
+                    else if (strcmp(token, "MetricsSocketPath") == 0)
+                    {
+                        memset(
+                            daemon_local->flags.metricsSockPath,
+                            0,
+                            DLT_DAEMON_FLAG_MAX);
+                        strncpy(
+                            daemon_local->flags.metricsSockPath,
+                            value,
+                            DLT_DAEMON_FLAG_MAX - 1);
+                    }
                     else if (strcmp(token, "GatewayMode") == 0)
                     {
                         daemon_local->flags.gatewayMode = atoi(value);
@@ -749,6 +839,20 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                     {
                         daemon_local->UDPMulticastIPPort = strtol(value, NULL, 10);
                     }
+                    else if (strcmp(token, "UDPMulticastMTU") == 0)
+                    {
+                        const long longval = strtol(value, NULL, 10);
+
+                        if ((longval >= 0) && (longval <= UDP_DATAGRAM_MAX_SIZE)) {
+                            daemon_local->UDPMulticastMTU = longval;
+                            printf("Option: %s=%s\n", token, value);
+                        }
+                        else {
+                            fprintf(stderr,
+                                    "Invalid value for UDPMulticastMTU set to default %d\n",
+                                    MULTICAST_MTU);
+                        }
+                    }
 #endif
                     else if (strcmp(token, "BindAddress") == 0)
                     {
@@ -799,6 +903,22 @@ int option_file_parser(DltDaemonLocal *daemon_local)
                     else if (strcmp(token, "InjectionMode") == 0) {
                         daemon_local->flags.injectionMode = atoi(value);
                     }
+                    else if (strcmp(token, "RateLimit") == 0)
+                    {
+                        /* option can be given several times */
+                        size_t used = strlen(daemon_local->flags.rateLimits);
+
+                        if (used + strlen(value) + 2 > sizeof(daemon_local->flags.rateLimits)) {
+                            fprintf(stderr, "Too many rate limits, ignoring %s\n", value);
+                        }
+                        else {
+                            if (used > 0)
+                                strcat(daemon_local->flags.rateLimits, ",");
+
+                            strcat(daemon_local->flags.rateLimits, value);
+                            printf("Option: %s=%s\n", token, value);
+                        }
+                    }
                     else {
                         fprintf(stderr, "Unknown option: %s=%s\n", token, value);
                     }
@@ -917,9 +1037,11 @@ int main(int argc, char *argv[])
     DltDaemonLocal daemon_local;
     DltDaemon daemon;
     int back = 0;
+    int fd = -1;
 
     memset(&daemon_local, 0, sizeof(DltDaemonLocal));
     memset(&daemon, 0, sizeof(DltDaemon));
+    dlt_daemon_metrics_init(&daemon_local.metrics);
 
     /* Command line option handling */
     if ((back = option_handling(&daemon_local, argc, argv)) < 0) {
@@ -979,6 +1101,28 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    /* The egress thread serves the clients as soon as they are registered */
+    if (daemon_local.flags.pipelineMode &&
+        (dlt_daemon_egress_init(&daemon_local.egress,
+                                daemon_local.flags.pipelineQueueSize,
+                                daemon_local.flags.lflag) == -1)) {
+        dlt_log(LOG_CRIT, "Initialization of client egress failed!\n");
+        return -1;
+    }
+
+    /* The ingestion threads read from the applications as soon as they connect */
+    if (daemon_local.flags.pipelineMode && (daemon_local.flags.ingestionThreads > 0) &&
+        ((dlt_daemon_ingress_init(&daemon_local.ingress,
+                                  daemon_local.flags.ingestionThreads) == -1) ||
+         (dlt_connection_create(&daemon_local,
+                                &daemon_local.pEvent,
+                                daemon_local.ingress.event_fd,
+                                POLLIN,
+                                DLT_CONNECTION_APP_INGRESS) == -1))) {
+        dlt_log(LOG_CRIT, "Initialization of application ingestion failed!\n");
+        return -1;
+    }
+
     /* --- Daemon connection init begin */
     if (dlt_daemon_local_connection_init(&daemon, &daemon_local, daemon_local.flags.vflag) == -1) {
         dlt_log(LOG_CRIT, "Initialization of local connections failed!\n");
@@ -1026,7 +1170,6 @@ int main(int argc, char *argv[])
         if (watchdogUSec)
             watchdogTimeoutSeconds = atoi(watchdogUSec) / 2000000;
 
-        watchdog_trigger_interval = watchdogTimeoutSeconds;
         create_timer_fd(&daemon_local,
                         watchdogTimeoutSeconds,
                         watchdogTimeoutSeconds,
@@ -1084,12 +1227,33 @@ int main(int argc, char *argv[])
                             "Daemon launched. Starting to output traces...",
                             daemon_local.flags.vflag);
 
+    /* Forward what applications which ended before they could register left behind */
+    dlt_daemon_process_startup_shm_orphans(&daemon, &daemon_local, daemon_local.flags.vflag);
+
     /* Even handling loop. */
-    while ((back >= 0) && (g_exit >= 0))
+    while ((back >= 0) && (g_exit >= 0)) {
         back = dlt_daemon_handle_event(&daemon_local.pEvent,
                                        &daemon,
                                        &daemon_local);
 
+        /* close the clients the egress thread failed to send to */
+        while ((fd = dlt_daemon_egress_get_failed(&daemon_local.egress)) >= 0)
+            dlt_daemon_close_socket(fd, &daemon, &daemon_local, daemon_local.flags.vflag);
+
+        /* replay the ring buffer in batches between the events */
+        if ((back >= 0) && (daemon.state == DLT_DAEMON_STATE_SEND_BUFFER))
+            dlt_daemon_send_ringbuffer_to_client(&daemon,
+                                                 &daemon_local,
+                                                 daemon_local.flags.vflag);
+
+#ifdef UDP_CONNECTION_SUPPORT
+        /* send the multicast datagrams packed while handling the event */
+        dlt_daemon_udp_flush();
+#endif
+
+        dlt_daemon_metrics_loop_end(&daemon_local.metrics);
+    }
+
     snprintf(local_str, DLT_DAEMON_TEXTBUFSIZE, "Exiting DLT daemon... [%d]",
              g_signo);
     dlt_daemon_log_internal(&daemon, &daemon_local, local_str,
@@ -1178,6 +1342,41 @@ int dlt_daemon_local_init_p1(DltDaemon *daemon, DltDaemonLocal *daemon_local, in
     return DLT_RETURN_OK;
 }
 
+/* Start one I/O worker thread per offline logstorage device */
+static int dlt_daemon_local_logstorage_worker_init(DltDaemon *daemon, DltDaemonLocal *daemon_local)
+{
+    int i = 0;
+    DltLogStorageUserConfig file_config;
+
+    daemon->storage_worker = calloc((size_t)daemon_local->flags.offlineLogstorageMaxDevices,
+                                    sizeof(DltDaemonLogstorageWorker));
+
+    if (daemon->storage_worker == NULL)
+        return -1;
+
+    file_config.logfile_timestamp = daemon_local->flags.offlineLogstorageTimestamp;
+    file_config.logfile_delimiter = daemon_local->flags.offlineLogstorageDelimiter;
+    file_config.logfile_maxcounter = daemon_local->flags.offlineLogstorageMaxCounter;
+    file_config.logfile_counteridxlen = daemon_local->flags.offlineLogstorageMaxCounterIdx;
+
+    for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+        if (dlt_daemon_logstorage_worker_init(&daemon->storage_worker[i],
+                                              &daemon->storage_handle[i],
+                                              &file_config,
+                                              daemon_local->flags.offlineLogstorageQueueSize,
+                                              daemon_local->flags.offlineLogstorageQueueBlocking) == -1) {
+            while (--i >= 0)
+                dlt_daemon_logstorage_worker_free(&daemon->storage_worker[i]);
+
+            free(daemon->storage_worker);
+            daemon->storage_worker = NULL;
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 int dlt_daemon_local_init_p2(DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
 {
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -1197,9 +1396,19 @@ int dlt_daemon_local_init_p2(DltDaemon *daemon, DltDaemonLocal *daemon_local, in
         return -1;
     }
 
+    dlt_daemon_ringbuffer_set_limits(&(daemon->client_ringbuffer), daemon_local->RingbufferClassLimits);
+
+    if (daemon_local->flags.rateLimits[0] &&
+        (dlt_daemon_rate_limits_init(daemon, daemon_local->flags.rateLimits, verbose) == -1)) {
+        dlt_log(LOG_ERR, "Could not initialize rate limits\n");
+        return -1;
+    }
+
     /* init offline trace */
     if (((daemon->mode == DLT_USER_MODE_INTERNAL) || (daemon->mode == DLT_USER_MODE_BOTH)) &&
         daemon_local->flags.offlineTraceDirectory[0]) {
+        daemon_local->offlineTrace.compressed = daemon_local->flags.offlineTraceCompression;
+
         if (dlt_offline_trace_init(&(daemon_local->offlineTrace),
                                    daemon_local->flags.offlineTraceDirectory,
                                    daemon_local->flags.offlineTraceFileSize,
@@ -1220,6 +1429,12 @@ int dlt_daemon_local_init_p2(DltDaemon *daemon, DltDaemonLocal *daemon_local, in
         }
 
         memset(daemon->storage_handle, 0, (sizeof(DltLogStorage) * daemon_local->flags.offlineLogstorageMaxDevices));
+
+        if ((daemon_local->flags.offlineLogstorageWorker || daemon_local->flags.pipelineMode) &&
+            (dlt_daemon_local_logstorage_worker_init(daemon, daemon_local) == -1)) {
+            dlt_log(LOG_ERR, "Could not start offline logstorage workers\n");
+            return -1;
+        }
     }
 
     /* Set ECU id of daemon */
@@ -1333,11 +1548,33 @@ static int dlt_daemon_init_serial(DltDaemonLocal *daemon_local)
         return -1;
     }
 
-    return dlt_connection_create(daemon_local,
-                                 &daemon_local->pEvent,
-                                 fd,
-                                 POLLIN,
-                                 DLT_CONNECTION_CLIENT_MSG_SERIAL);
+    if (dlt_connection_create(daemon_local,
+                              &daemon_local->pEvent,
+                              fd,
+                              POLLIN,
+                              DLT_CONNECTION_CLIENT_MSG_SERIAL) != 0)
+        return -1;
+
+    /* The egress thread of the pipelined mode writes the device itself */
+    if (!daemon_local->flags.pipelineMode && (daemon_local->flags.serialQueueSize > 0)) {
+        DltConnection *con = dlt_event_handler_find_connection(&daemon_local->pEvent, fd);
+        int flags = fcntl(fd, F_GETFL);
+
+        if (con != NULL)
+            con->serial_queue = dlt_daemon_serial_queue_create(daemon_local->flags.serialQueueSize);
+
+        if ((con == NULL) || (con->serial_queue == NULL) ||
+            (flags < 0) || (fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+            dlt_log(LOG_WARNING, "Serial output queue not available, writing directly\n");
+
+            if (con != NULL) {
+                dlt_daemon_serial_queue_free(con->serial_queue);
+                con->serial_queue = NULL;
+            }
+        }
+    }
+
+    return 0;
 }
 
 #ifdef DLT_DAEMON_USE_FIFO_IPC
@@ -1663,6 +1900,12 @@ int dlt_daemon_local_connection_init(DltDaemon *daemon,
         return DLT_RETURN_ERROR;
     }
 
+    /* create and open unix socket serving metrics snapshots, if configured */
+    if (dlt_daemon_metrics_init_socket(daemon_local) < 0) {
+        dlt_log(LOG_ERR, "Could not initialize metrics socket.\n");
+        return DLT_RETURN_ERROR;
+    }
+
     /* Init serial */
     if (dlt_daemon_init_serial(daemon_local) < 0) {
         dlt_log(LOG_ERR, "Could not initialize daemon data\n");
@@ -1748,6 +1991,8 @@ int dlt_daemon_local_ecu_version_init(DltDaemon *daemon, DltDaemonLocal *daemon_
 
 void dlt_daemon_local_cleanup(DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
 {
+    int i = 0;
+
     PRINT_FUNCTION_VERBOSE(verbose);
 
     if ((daemon == 0) || (daemon_local == 0)) {
@@ -1755,11 +2000,21 @@ void dlt_daemon_local_cleanup(DltDaemon *daemon, DltDaemonLocal *daemon_local, i
         return;
     }
 
+    /* The ingestion threads use the application connections until they are stopped */
+    dlt_daemon_ingress_log_stats(&daemon_local->ingress);
+    dlt_daemon_ingress_free(&daemon_local->ingress);
+
+    /* The egress thread uses the client connections until it is stopped */
+    dlt_daemon_egress_log_stats(&daemon_local->egress);
+    dlt_daemon_egress_free(&daemon_local->egress);
+
     /* Don't receive event anymore */
     dlt_event_handler_cleanup_connections(&daemon_local->pEvent);
 
     dlt_message_free(&(daemon_local->msg), daemon_local->flags.vflag);
 
+    dlt_daemon_latency_free(&daemon_local->latency);
+
     /* free shared memory */
     if (daemon_local->flags.offlineTraceDirectory[0])
         dlt_offline_trace_free(&(daemon_local->offlineTrace));
@@ -1788,6 +2043,16 @@ void dlt_daemon_local_cleanup(DltDaemon *daemon, DltDaemonLocal *daemon_local, i
                                       daemon_local,
                                       daemon_local->flags.vflag);
 
+        if (daemon->storage_worker != NULL) {
+            for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+                dlt_daemon_logstorage_worker_log_stats(&daemon->storage_worker[i], i);
+                dlt_daemon_logstorage_worker_free(&daemon->storage_worker[i]);
+            }
+
+            free(daemon->storage_worker);
+            daemon->storage_worker = NULL;
+        }
+
         free(daemon->storage_handle);
     }
 
@@ -1796,6 +2061,9 @@ void dlt_daemon_local_cleanup(DltDaemon *daemon, DltDaemonLocal *daemon_local, i
 
     unlink(daemon_local->flags.ctrlSockPath);
 
+    if (daemon_local->flags.metricsSockPath[0] != '\0')
+        unlink(daemon_local->flags.metricsSockPath);
+
     /* free IP list */
     free(daemon_local->flags.ipNodes);
 }
@@ -2130,6 +2398,7 @@ int dlt_daemon_process_client_connect(DltDaemon *daemon,
             dlt_log(LOG_DEBUG, "Send ring-buffer to client\n");
 
         dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_SEND_BUFFER);
+        dlt_daemon_ringbuffer_log_stats(&(daemon->client_ringbuffer));
 
         if (dlt_daemon_send_ringbuffer_to_client(daemon, daemon_local, verbose) == -1) {
             dlt_log(LOG_WARNING, "Can't send contents of ringbuffer to clients\n");
@@ -2171,12 +2440,16 @@ int dlt_daemon_process_client_messages(DltDaemon *daemon,
         return -1;
     }
 
+    dlt_daemon_metrics_received(&daemon_local->metrics, must_close_socket);
+
     /* Process all received messages */
     while (dlt_message_read(&(daemon_local->msg),
                             (uint8_t *)receiver->buf,
                             (unsigned int) receiver->bytesRcvd,
                             daemon_local->flags.nflag,
                             daemon_local->flags.vflag) == DLT_MESSAGE_ERROR_OK) {
+        dlt_daemon_metrics_message_received(&daemon_local->metrics);
+
         /* Check for control message */
         if ((0 < receiver->fd) &&
             DLT_MSG_IS_CONTROL_REQUEST(&(daemon_local->msg)))
@@ -2227,6 +2500,7 @@ int dlt_daemon_process_client_messages_serial(DltDaemon *daemon,
                                               int verbose)
 {
     int bytes_to_be_removed = 0;
+    int received = 0;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -2237,19 +2511,25 @@ int dlt_daemon_process_client_messages_serial(DltDaemon *daemon,
         return -1;
     }
 
-    if (dlt_receiver_receive(receiver) <= 0) {
+    received = dlt_receiver_receive(receiver);
+
+    if (received <= 0) {
         dlt_log(LOG_WARNING,
                 "dlt_receiver_receive_fd() for messages from serial interface "
                 "failed!\n");
         return -1;
     }
 
+    dlt_daemon_metrics_received(&daemon_local->metrics, received);
+
     /* Process all received messages */
     while (dlt_message_read(&(daemon_local->msg),
                             (uint8_t *)receiver->buf,
                             (unsigned int) receiver->bytesRcvd,
                             daemon_local->flags.mflag,
                             daemon_local->flags.vflag) == DLT_MESSAGE_ERROR_OK) {
+        dlt_daemon_metrics_message_received(&daemon_local->metrics);
+
         /* Check for control message */
         if (DLT_MSG_IS_CONTROL_REQUEST(&(daemon_local->msg))) {
             if (dlt_daemon_client_process_control(receiver->fd,
@@ -2393,6 +2673,7 @@ int dlt_daemon_process_control_messages(
     int verbose)
 {
     int bytes_to_be_removed = 0;
+    int received = 0;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -2403,7 +2684,9 @@ int dlt_daemon_process_control_messages(
         return -1;
     }
 
-    if (dlt_receiver_receive(receiver) <= 0) {
+    received = dlt_receiver_receive(receiver);
+
+    if (received <= 0) {
         dlt_daemon_close_socket(receiver->fd,
                                 daemon,
                                 daemon_local,
@@ -2414,6 +2697,8 @@ int dlt_daemon_process_control_messages(
         return 0;
     }
 
+    dlt_daemon_metrics_received(&daemon_local->metrics, received);
+
     /* Process all received messages */
     while (dlt_message_read(
                &(daemon_local->msg),
@@ -2421,6 +2706,8 @@ int dlt_daemon_process_control_messages(
                (unsigned int) receiver->bytesRcvd,
                daemon_local->flags.nflag,
                daemon_local->flags.vflag) == DLT_MESSAGE_ERROR_OK) {
+        dlt_daemon_metrics_message_received(&daemon_local->metrics);
+
         /* Check for control message */
         if ((receiver->fd > 0) &&
             DLT_MSG_IS_CONTROL_REQUEST(&(daemon_local->msg)))
@@ -2492,43 +2779,115 @@ static dlt_daemon_process_user_message_func process_user_func[DLT_USER_MESSAGE_N
     dlt_daemon_process_user_message_not_sup,
     dlt_daemon_process_user_message_marker,
     dlt_daemon_process_user_message_not_sup,
-    dlt_daemon_process_user_message_not_sup
+    dlt_daemon_process_user_message_log,
+    dlt_daemon_process_user_message_rate_limit_dropped
 };
 
-int dlt_daemon_process_user_messages(DltDaemon *daemon,
-                                     DltDaemonLocal *daemon_local,
-                                     DltReceiver *receiver,
-                                     int verbose)
+int dlt_daemon_user_message_size(const char *buf, int size)
 {
-    int offset = 0;
-    int run_loop = 1;
-    int32_t min_size = (int32_t) sizeof(DltUserHeader);
-    DltUserHeader *userheader;
-    int recv;
+    DltUserHeader *userheader = (DltUserHeader *)buf;
+    DltUserControlMsgRegisterApplication userapp;
+    DltUserControlMsgRegisterContext userctxt;
+    int header_size = (int) sizeof(DltUserHeader);
+    int len = 0;
+#ifndef DLT_SHM_ENABLE
+    uint16_t stdlen = 0;
+#endif
 
-    PRINT_FUNCTION_VERBOSE(verbose);
+    if ((buf == NULL) || (size < header_size))
+        return 0;
 
-    if ((daemon == NULL) || (daemon_local == NULL) || (receiver == NULL)) {
-        dlt_log(LOG_ERR,
-                "Invalid function parameters used for function "
-                "dlt_daemon_process_user_messages()\n");
+    if (!dlt_user_check_userheader(userheader))
         return -1;
-    }
 
-    recv = dlt_receiver_receive(receiver);
+    /* the sizes the handlers remove from the receiver */
+    switch (userheader->message) {
+    case DLT_USER_MESSAGE_LOG_TRACE:
+        header_size += (int) sizeof(DltUserControlMsgLogTrace);
+    /* FALL THROUGH */
+    case DLT_USER_MESSAGE_LOG:
+#ifdef DLT_SHM_ENABLE
+        /* the message itself is in the shared memory */
+        len = header_size;
+#else
+        if (size < header_size + (int) sizeof(dltSerialHeader))
+            return 0;
 
-    if (recv <= 0 && receiver->type == DLT_RECEIVE_SOCKET) {
-        dlt_daemon_close_socket(receiver->fd,
-                                daemon,
-                                daemon_local,
-                                verbose);
-        return 0;
-    }
-    else if (recv < 0) {
-        dlt_log(LOG_WARNING,
-                "dlt_receiver_receive_fd() for user messages failed!\n");
+        if (memcmp(buf + header_size, dltSerialHeader, sizeof(dltSerialHeader)) == 0)
+            header_size += (int) sizeof(dltSerialHeader);
+
+        if (size < header_size + (int) sizeof(DltStandardHeader))
+            return 0;
+
+        memcpy(&stdlen, buf + header_size + offsetof(DltStandardHeader, len), sizeof(stdlen));
+        len = DLT_BETOH_16(stdlen);
+
+        if (len < (int) sizeof(DltStandardHeader))
+            return -1;
+
+        len += header_size;
+#endif
+        break;
+    case DLT_USER_MESSAGE_REGISTER_APPLICATION:
+        len = header_size + (int) sizeof(DltUserControlMsgRegisterApplication);
+
+        if (size < len)
+            return 0;
+
+        memcpy(&userapp, buf + header_size, sizeof(userapp));
+        len += (int) ((userapp.description_length > DLT_DAEMON_DESCSIZE) ?
+                      DLT_DAEMON_DESCSIZE : userapp.description_length);
+        break;
+    case DLT_USER_MESSAGE_REGISTER_CONTEXT:
+        len = header_size + (int) sizeof(DltUserControlMsgRegisterContext);
+
+        if (size < len)
+            return 0;
+
+        memcpy(&userctxt, buf + header_size, sizeof(userctxt));
+        len += (int) ((userctxt.description_length > DLT_DAEMON_DESCSIZE) ?
+                      DLT_DAEMON_DESCSIZE : userctxt.description_length);
+        break;
+    case DLT_USER_MESSAGE_UNREGISTER_APPLICATION:
+        len = header_size + (int) sizeof(DltUserControlMsgUnregisterApplication);
+        break;
+    case DLT_USER_MESSAGE_UNREGISTER_CONTEXT:
+        len = header_size + (int) sizeof(DltUserControlMsgUnregisterContext);
+        break;
+    case DLT_USER_MESSAGE_OVERFLOW:
+        len = header_size + (int) sizeof(DltUserControlMsgBufferOverflow);
+        break;
+    case DLT_USER_MESSAGE_APP_LL_TS:
+        len = header_size + (int) sizeof(DltUserControlMsgAppLogLevelTraceStatus);
+        break;
+    case DLT_USER_MESSAGE_MARKER:
+        len = header_size + (int) sizeof(DltUserControlMsgLogMode);
+        break;
+    case DLT_USER_MESSAGE_RATE_LIMIT_DROPPED:
+        len = header_size + (int) sizeof(DltUserControlMsgRateLimitDropped);
+        break;
+    default:
+        /* not supported, only the user header is removed */
+        len = header_size;
+        break;
+    }
+
+    /* never completed in a receive buffer */
+    if (len > DLT_RECEIVE_BUFSIZE)
         return -1;
-    }
+
+    return (size < len) ? 0 : len;
+}
+
+/* Hand the user messages in the buffer of a receiver to their handlers */
+static void dlt_daemon_process_user_message_buffer(DltDaemon *daemon,
+                                                   DltDaemonLocal *daemon_local,
+                                                   DltReceiver *receiver)
+{
+    int offset = 0;
+    int run_loop = 1;
+    int32_t min_size = (int32_t) sizeof(DltUserHeader);
+    DltUserHeader *userheader;
 
     /* look through buffer as long as data is in there */
     while ((receiver->bytesRcvd >= min_size) && run_loop) {
@@ -2557,12 +2916,53 @@ int dlt_daemon_process_user_messages(DltDaemon *daemon,
         else
             func = process_user_func[userheader->message];
 
+        dlt_daemon_metrics_message_received(&daemon_local->metrics);
+
         if (func(daemon,
                  daemon_local,
                  receiver,
                  daemon_local->flags.vflag) == -1)
             run_loop = 0;
     }
+}
+
+int dlt_daemon_process_user_messages(DltDaemon *daemon,
+                                     DltDaemonLocal *daemon_local,
+                                     DltReceiver *receiver,
+                                     int verbose)
+{
+    int recv;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (receiver == NULL)) {
+        dlt_log(LOG_ERR,
+                "Invalid function parameters used for function "
+                "dlt_daemon_process_user_messages()\n");
+        return -1;
+    }
+
+    recv = dlt_receiver_receive(receiver);
+
+    if (recv <= 0 && receiver->type == DLT_RECEIVE_SOCKET) {
+        dlt_daemon_close_socket(receiver->fd,
+                                daemon,
+                                daemon_local,
+                                verbose);
+        return 0;
+    }
+    else if (recv < 0) {
+        dlt_log(LOG_WARNING,
+                "dlt_receiver_receive_fd() for user messages failed!\n");
+        return -1;
+    }
+
+    dlt_daemon_metrics_received(&daemon_local->metrics, recv);
+
+    /* end of the receive stage of stamped messages */
+    daemon_local->latency.received = dlt_daemon_latency_now();
+
+    dlt_daemon_process_user_message_buffer(daemon, daemon_local, receiver);
 
     /* keep not read data in buffer */
     if (dlt_receiver_move_to_begin(receiver) == -1) {
@@ -2575,6 +2975,281 @@ int dlt_daemon_process_user_messages(DltDaemon *daemon,
     return 0;
 }
 
+int dlt_daemon_process_ingress(DltDaemon *daemon,
+                               DltDaemonLocal *daemon_local,
+                               DltReceiver *receiver,
+                               int verbose)
+{
+    DltDaemonIngressChunk *chunk;
+    DltConnection *con;
+    DltReceiver rec;
+    int before;
+    int ret = 0;
+    int i;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (receiver == NULL)) {
+        dlt_vlog(LOG_ERR, "Invalid function parameters used for %s\n",
+                 __func__);
+        return -1;
+    }
+
+    dlt_daemon_ingress_clear(&daemon_local->ingress);
+
+    /* route a batch, the other events are handled in between */
+    for (i = 0; (i < DLT_DAEMON_INGRESS_BATCH_SIZE) && (ret == 0); i++) {
+        chunk = dlt_daemon_ingress_pop(&daemon_local->ingress);
+
+        if (chunk == NULL)
+            break;
+
+        con = dlt_event_handler_find_connection(&daemon_local->pEvent, chunk->fd);
+
+        /* the connection was closed since, its descriptor may be reused */
+        if ((con == NULL) || (con->id != chunk->id)) {
+            free(chunk);
+            continue;
+        }
+
+        if (chunk->closed) {
+            if (con->receiver->type == DLT_RECEIVE_SOCKET) {
+                dlt_daemon_close_socket(chunk->fd, daemon, daemon_local, verbose);
+            }
+            else {
+                dlt_log(LOG_WARNING,
+                        "dlt_receiver_receive_fd() for user messages failed!\n");
+                ret = -1;
+            }
+
+            free(chunk);
+            continue;
+        }
+
+        daemon_local->metrics.current = con;
+        dlt_daemon_metrics_received(&daemon_local->metrics, chunk->bytes);
+
+        /* end of the receive stage of stamped messages */
+        daemon_local->latency.received = chunk->received;
+
+        /* the chunk holds complete messages only */
+        memset(&rec, 0, sizeof(DltReceiver));
+        rec.buffer = (char *)chunk->data;
+        rec.buf = (char *)chunk->data;
+        rec.bytesRcvd = chunk->size;
+        rec.buffersize = (uint32_t) chunk->size;
+        rec.fd = con->receiver->fd;
+        rec.type = con->receiver->type;
+
+        while (rec.bytesRcvd >= (int32_t) sizeof(DltUserHeader)) {
+            before = rec.bytesRcvd;
+            dlt_daemon_process_user_message_buffer(daemon, daemon_local, &rec);
+
+            /* skip what a handler refused, there is no more data to wait for */
+            if (rec.bytesRcvd == before)
+                dlt_receiver_remove(&rec, (int) sizeof(DltUserHeader));
+        }
+
+        daemon_local->metrics.current = NULL;
+        free(chunk);
+    }
+
+    dlt_daemon_ingress_rearm(&daemon_local->ingress);
+
+    return ret;
+}
+
+int dlt_daemon_process_startup_shm(DltDaemon *daemon,
+                                   DltDaemonLocal *daemon_local,
+                                   pid_t pid,
+                                   const char *apid,
+                                   int orphan,
+                                   int verbose)
+{
+    DltUserStartupShm shm;
+    DltUserHeader *userheader;
+    DltReceiver rec;
+    char path[DLT_PATH_MAX];
+    char id[DLT_ID_SIZE + 1] = { '\0' };
+    unsigned char *buf = NULL;
+    int size = 0;
+    int num = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL)) {
+        dlt_vlog(LOG_ERR, "Invalid function parameters used for %s\n",
+                 __func__);
+        return -1;
+    }
+
+    /* most applications do not use a startup ring */
+    if (dlt_user_startup_shm_open(&shm, pid) != DLT_RETURN_OK)
+        return 0;
+
+    dlt_user_startup_shm_path(path, sizeof(path), pid);
+
+    /* A registered application marks its ring before it registers.
+     * The ring of an application which is gone can be taken in any state. */
+    if ((shm.head->state != DLT_USER_STARTUP_SHM_STATE_HANDOVER) &&
+        !(orphan && (shm.head->state == DLT_USER_STARTUP_SHM_STATE_ACTIVE))) {
+        if (shm.head->state == DLT_USER_STARTUP_SHM_STATE_DRAINED)
+            unlink(path);
+
+        dlt_user_startup_shm_close(&shm);
+        return 0;
+    }
+
+    /* never forward the content twice */
+    shm.head->state = DLT_USER_STARTUP_SHM_STATE_DRAINED;
+
+    if (apid == NULL)
+        apid = shm.head->apid;
+
+    memcpy(id, apid, DLT_ID_SIZE);
+
+    buf = malloc(shm.buffer.size);
+
+    if (buf == NULL) {
+        dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+        dlt_user_startup_shm_close(&shm);
+        unlink(path);
+        return -1;
+    }
+
+    while ((size = dlt_buffer_pull(&(shm.buffer), buf, (int) shm.buffer.size)) > 0) {
+        userheader = (DltUserHeader *)buf;
+
+        if ((size < (int) sizeof(DltUserHeader)) || !dlt_user_check_userheader(userheader))
+            continue;
+
+        switch (userheader->message) {
+        case DLT_USER_MESSAGE_LOG:
+        case DLT_USER_MESSAGE_LOG_TRACE:
+        {
+            int header_size = (int) sizeof(DltUserHeader);
+            DltUserControlMsgLogTrace trace = { 0 };
+            uint64_t received = 0;
+
+            /* the time in the startup ring counts as receive stage */
+            if (userheader->message == DLT_USER_MESSAGE_LOG_TRACE) {
+                if (size < header_size + (int) sizeof(DltUserControlMsgLogTrace))
+                    break;
+
+                memcpy(&trace, buf + header_size, sizeof(DltUserControlMsgLogTrace));
+                header_size += (int) sizeof(DltUserControlMsgLogTrace);
+                received = dlt_daemon_latency_now();
+            }
+
+            if (dlt_message_read(&(daemon_local->msg),
+                                 buf + header_size,
+                                 (unsigned int) (size - header_size),
+                                 0,
+                                 verbose) != DLT_MESSAGE_ERROR_OK)
+                break;
+
+            /* messages logged before the registration have no application id */
+            if (DLT_IS_HTYP_UEH(daemon_local->msg.standardheader->htyp) &&
+                (daemon_local->msg.extendedheader->apid[0] == '\0'))
+                dlt_set_id(daemon_local->msg.extendedheader->apid, id);
+
+            if (trace.timestamp != 0) {
+                dlt_daemon_latency_begin(&daemon_local->latency, trace.timestamp, received);
+                dlt_daemon_latency_stamp(&daemon_local->latency, DLT_LATENCY_STAGE_PARSE);
+            }
+
+            dlt_daemon_client_send_message_to_all_client(daemon, daemon_local, verbose);
+            dlt_daemon_latency_end(&daemon_local->latency,
+                                   DLT_IS_HTYP_UEH(daemon_local->msg.standardheader->htyp) ?
+                                   daemon_local->msg.extendedheader->apid : id);
+            num++;
+            break;
+        }
+        case DLT_USER_MESSAGE_REGISTER_APPLICATION:
+        case DLT_USER_MESSAGE_UNREGISTER_APPLICATION:
+        {
+            /* the application is registered by its own message */
+            break;
+        }
+        default:
+        {
+            /* contexts of an application which is gone are of no use */
+            if (orphan || (userheader->message >= DLT_USER_MESSAGE_NOT_SUPPORTED))
+                break;
+
+            if ((userheader->message == DLT_USER_MESSAGE_REGISTER_CONTEXT) &&
+                (size >= (int) (sizeof(DltUserHeader) + sizeof(DltUserControlMsgRegisterContext)))) {
+                DltUserControlMsgRegisterContext *usercontext =
+                    (DltUserControlMsgRegisterContext *)(buf + sizeof(DltUserHeader));
+
+                if (usercontext->apid[0] == '\0')
+                    dlt_set_id(usercontext->apid, id);
+            }
+
+            /* process it like it was received from the application */
+            memset(&rec, 0, sizeof(DltReceiver));
+            rec.buffer = (char *)buf;
+            rec.buf = (char *)buf;
+            rec.bytesRcvd = size;
+            rec.buffersize = size;
+            rec.fd = -1;
+            rec.type = DLT_RECEIVE_FD;
+
+            process_user_func[userheader->message](daemon, daemon_local, &rec, verbose);
+            break;
+        }
+        }
+    }
+
+    free(buf);
+    dlt_user_startup_shm_close(&shm);
+
+    /* the application removes the ring on its own, if the daemon is not allowed to */
+    if ((unlink(path) != 0) && (errno != ENOENT))
+        dlt_vlog(LOG_DEBUG, "%s: cannot remove %s: %s\n", __func__, path, strerror(errno));
+
+    dlt_vlog(LOG_INFO, "Forwarded %d messages of startup ring of ApplicationID '%.4s' PID %d\n",
+             num, id, (int) pid);
+
+    return num;
+}
+
+void dlt_daemon_process_startup_shm_orphans(DltDaemon *daemon,
+                                            DltDaemonLocal *daemon_local,
+                                            int verbose)
+{
+    DIR *dir;
+    struct dirent *entry;
+    size_t prefix_len = strlen(DLT_USER_STARTUP_SHM_PREFIX);
+    char *end = NULL;
+    long pid;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    dir = opendir(DLT_USER_STARTUP_SHM_DIR);
+
+    if (dir == NULL)
+        return;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, DLT_USER_STARTUP_SHM_PREFIX, prefix_len) != 0)
+            continue;
+
+        pid = strtol(entry->d_name + prefix_len, &end, 10);
+
+        if ((end == NULL) || (*end != '\0') || (pid <= 0))
+            continue;
+
+        /* a running application hands its ring over when it registers */
+        if ((kill((pid_t) pid, 0) == 0) || (errno != ESRCH))
+            continue;
+
+        dlt_daemon_process_startup_shm(daemon, daemon_local, (pid_t) pid, NULL, 1, verbose);
+    }
+
+    closedir(dir);
+}
+
 int dlt_daemon_process_user_message_overflow(DltDaemon *daemon,
                                              DltDaemonLocal *daemon_local,
                                              DltReceiver *rec,
@@ -2613,6 +3288,44 @@ int dlt_daemon_process_user_message_overflow(DltDaemon *daemon,
     return 0;
 }
 
+int dlt_daemon_process_user_message_rate_limit_dropped(DltDaemon *daemon,
+                                                       DltDaemonLocal *daemon_local,
+                                                       DltReceiver *rec,
+                                                       int verbose)
+{
+    uint32_t len = sizeof(DltUserControlMsgRateLimitDropped);
+    DltUserControlMsgRateLimitDropped userpayload;
+    DltDaemonRateLimit *limit;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (rec == NULL)) {
+        dlt_vlog(LOG_ERR, "Invalid function parameters used for %s\n",
+                 __func__);
+        return -1;
+    }
+
+    if (dlt_receiver_check_and_get(rec,
+                                   &userpayload,
+                                   len,
+                                   DLT_RCV_SKIP_HEADER | DLT_RCV_REMOVE) < 0)
+        /* Not enough bytes received */
+        return -1;
+
+    /* counted apart from the messages the daemon drops by the same limit */
+    limit = dlt_daemon_rate_limit_find(daemon, userpayload.apid, userpayload.ctid, verbose);
+
+    if (limit != NULL)
+        limit->user_dropped += userpayload.dropped;
+
+    dlt_daemon_metrics_drop_count(&(daemon_local->metrics.main),
+                                  userpayload.apid,
+                                  DLT_DAEMON_DROP_RATE_LIMIT_USER,
+                                  userpayload.dropped);
+
+    return 0;
+}
+
 int dlt_daemon_send_message_overflow(DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
 {
     int ret;
@@ -2748,6 +3461,14 @@ int dlt_daemon_process_user_message_register_application(DltDaemon *daemon,
         dlt_vlog(LOG_DEBUG, "%s%s", local_str, "\n");
     }
 
+    /* Forward the messages the application stored in its startup ring */
+    dlt_daemon_process_startup_shm(daemon,
+                                   daemon_local,
+                                   application->pid,
+                                   application->apid,
+                                   0,
+                                   verbose);
+
     return 0;
 }
 
@@ -3135,6 +3856,35 @@ int dlt_daemon_process_user_message_unregister_context(DltDaemon *daemon,
     return 0;
 }
 
+/**
+ * Check the message in daemon_local->msg against its rate limit
+ * @return 1 if the message exceeds the limit and shall be dropped, 0 otherwise
+ */
+static int dlt_daemon_check_rate_limit(DltDaemon *daemon,
+                                       DltDaemonLocal *daemon_local,
+                                       int verbose)
+{
+    DltDaemonRateLimit *limit;
+
+    if ((daemon->num_rate_limits == 0) ||
+        !DLT_IS_HTYP_UEH(daemon_local->msg.standardheader->htyp))
+        return 0;
+
+    limit = dlt_daemon_rate_limit_find(daemon,
+                                       daemon_local->msg.extendedheader->apid,
+                                       daemon_local->msg.extendedheader->ctid,
+                                       verbose);
+
+    if ((limit == NULL) || dlt_token_bucket_take(&(limit->bucket)))
+        return 0;
+
+    dlt_daemon_metrics_drop(&(daemon_local->metrics.main),
+                            daemon_local->msg.extendedheader->apid,
+                            DLT_DAEMON_DROP_RATE_LIMIT);
+
+    return 1;
+}
+
 int dlt_daemon_process_user_message_log(DltDaemon *daemon,
                                         DltDaemonLocal *daemon_local,
                                         DltReceiver *rec,
@@ -3142,6 +3892,8 @@ int dlt_daemon_process_user_message_log(DltDaemon *daemon,
 {
     int ret = 0;
     int size = 0;
+    int header_size = (int) sizeof(DltUserHeader);
+    DltUserControlMsgLogTrace trace = { 0 };
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -3150,12 +3902,21 @@ int dlt_daemon_process_user_message_log(DltDaemon *daemon,
         return DLT_DAEMON_ERROR_UNKNOWN;
     }
 
+    /* the message of a stamped log follows the stamp */
+    if (((DltUserHeader *)rec->buf)->message == DLT_USER_MESSAGE_LOG_TRACE) {
+        if (rec->bytesRcvd < header_size + (int) sizeof(DltUserControlMsgLogTrace))
+            return DLT_DAEMON_ERROR_UNKNOWN;
+
+        memcpy(&trace, rec->buf + header_size, sizeof(DltUserControlMsgLogTrace));
+        header_size += (int) sizeof(DltUserControlMsgLogTrace);
+    }
+
 #ifdef DLT_SHM_ENABLE
 
     /** In case of SHM, the header still received via fifo/unix_socket receiver,
      * so we need to remove header from the receiver.
      */
-    if (dlt_receiver_remove(rec, sizeof(DltUserHeader)) < 0)
+    if (dlt_receiver_remove(rec, header_size) < 0)
         /* Not enough bytes received to remove*/
         return DLT_DAEMON_ERROR_UNKNOWN;
 
@@ -3177,6 +3938,11 @@ int dlt_daemon_process_user_message_log(DltDaemon *daemon,
             return DLT_DAEMON_ERROR_UNKNOWN;
         }
 
+        dlt_daemon_metrics_log(&daemon_local->metrics, &(daemon_local->msg));
+
+        if (dlt_daemon_check_rate_limit(daemon, daemon_local, verbose))
+            continue;
+
         ret = dlt_daemon_client_send_message_to_all_client(daemon,
                                                            daemon_local, verbose);
 
@@ -3186,8 +3952,8 @@ int dlt_daemon_process_user_message_log(DltDaemon *daemon,
 
 #else
     ret = dlt_message_read(&(daemon_local->msg),
-                           (unsigned char *)rec->buf + sizeof(DltUserHeader),
-                           (unsigned int) ((unsigned int) rec->bytesRcvd - sizeof(DltUserHeader)),
+                           (unsigned char *)rec->buf + header_size,
+                           (unsigned int) (rec->bytesRcvd - header_size),
                            0,
                            verbose);
 
@@ -3205,12 +3971,24 @@ int dlt_daemon_process_user_message_log(DltDaemon *daemon,
         return DLT_DAEMON_ERROR_UNKNOWN;
     }
 
-    dlt_daemon_client_send_message_to_all_client(daemon, daemon_local, verbose);
+    dlt_daemon_metrics_log(&daemon_local->metrics, &(daemon_local->msg));
+
+    if (!dlt_daemon_check_rate_limit(daemon, daemon_local, verbose)) {
+        if (trace.timestamp != 0) {
+            dlt_daemon_latency_begin(&daemon_local->latency, trace.timestamp, daemon_local->latency.received);
+            dlt_daemon_latency_stamp(&daemon_local->latency, DLT_LATENCY_STAGE_PARSE);
+        }
+
+        dlt_daemon_client_send_message_to_all_client(daemon, daemon_local, verbose);
+
+        dlt_daemon_latency_end(&daemon_local->latency,
+                               DLT_IS_HTYP_UEH(daemon_local->msg.standardheader->htyp) ?
+                               daemon_local->msg.extendedheader->apid : NULL);
+    }
 
     /* keep not read data in buffer */
     size = (int) (daemon_local->msg.headersize +
-        daemon_local->msg.datasize - sizeof(DltStorageHeader) +
-        sizeof(DltUserHeader));
+        daemon_local->msg.datasize - sizeof(DltStorageHeader)) + header_size;
 
     if (daemon_local->msg.found_serialheader)
         size += (int) sizeof(dltSerialHeader);
@@ -3366,12 +4144,10 @@ int dlt_daemon_process_user_message_marker(DltDaemon *daemon,
 
 int dlt_daemon_send_ringbuffer_to_client(DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
 {
-    int ret;
-    static uint8_t data[DLT_DAEMON_RCVBUFSIZE];
-    int length;
-#ifdef DLT_SYSTEMD_WATCHDOG_ENABLE
-    uint32_t curr_time;
-#endif
+    static struct iovec iov[DLT_DAEMON_IOV_MAX];
+    DltBuffer *buffer;
+    int iovcnt;
+    int messages = 0;
 
     PRINT_FUNCTION_VERBOSE(verbose);
 
@@ -3380,46 +4156,44 @@ int dlt_daemon_send_ringbuffer_to_client(DltDaemon *daemon, DltDaemonLocal *daem
         return DLT_DAEMON_ERROR_UNKNOWN;
     }
 
-    if (dlt_buffer_get_message_count(&(daemon->client_ringbuffer)) <= 0) {
+    if (dlt_daemon_ringbuffer_get_message_count(&(daemon->client_ringbuffer)) <= 0) {
         dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_SEND_DIRECT);
         return DLT_DAEMON_ERROR_OK;
     }
 
-#ifdef DLT_SYSTEMD_WATCHDOG_ENABLE
-
-    if (sd_notify(0, "WATCHDOG=1") < 0)
-        dlt_log(LOG_WARNING, "Could not reset systemd watchdog\n");
-
-    curr_time = dlt_uptime();
-#endif
-
-    while ((length = dlt_buffer_copy(&(daemon->client_ringbuffer), data, sizeof(data))) > 0) {
-#ifdef DLT_SYSTEMD_WATCHDOG_ENABLE
-
-        if ((dlt_uptime() - curr_time) / 10000 >= watchdog_trigger_interval) {
-            if (sd_notify(0, "WATCHDOG=1") < 0)
-                dlt_log(LOG_WARNING, "Could not reset systemd watchdog\n");
-
-            curr_time = dlt_uptime();
-        }
+    /* Only one batch is sent per call, the event loop keeps calling this
+     * function while in SEND_BUFFER state, so that applications are still
+     * served during the replay. The highest class is sent first.
+     * Messages are sent directly from the ring buffer memory. They are not
+     * sent by UDP multicast again, this was done when they were buffered. */
+    buffer = dlt_daemon_ringbuffer_next(&(daemon->client_ringbuffer));
+    iovcnt = dlt_daemon_ringbuffer_map(buffer,
+                                       iov,
+                                       DLT_DAEMON_IOV_MAX,
+                                       daemon->sendserialheader,
+                                       DLT_DAEMON_RINGBUFFER_REPLAY_SIZE,
+                                       &messages);
+
+    if (iovcnt <= 0) {
+        /* the block head is corrupted, dlt_buffer_remove() resets the buffer */
+        dlt_buffer_remove(buffer);
+        return DLT_DAEMON_ERROR_UNKNOWN;
+    }
 
-#endif
+    /* messages queued for the egress thread were received before */
+    dlt_daemon_egress_drain(&daemon_local->egress);
 
-        if ((ret =
-                 dlt_daemon_client_send(DLT_DAEMON_SEND_FORCE, daemon, daemon_local, 0, 0, data, length, 0, 0,
-                                        verbose)))
-            return ret;
+    if (!dlt_daemon_client_send_all_iov(daemon, daemon_local, iov, iovcnt, messages, verbose))
+        return DLT_DAEMON_ERROR_SEND_FAILED;
 
-        dlt_buffer_remove(&(daemon->client_ringbuffer));
+    while (messages-- > 0)
+        dlt_buffer_remove(buffer);
 
-        if (daemon->state != DLT_DAEMON_STATE_SEND_BUFFER)
-            dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_SEND_BUFFER);
+    if (daemon->state != DLT_DAEMON_STATE_SEND_BUFFER)
+        dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_SEND_BUFFER);
 
-        if (dlt_buffer_get_message_count(&(daemon->client_ringbuffer)) <= 0) {
-            dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_SEND_DIRECT);
-            return DLT_DAEMON_ERROR_OK;
-        }
-    }
+    if (dlt_daemon_ringbuffer_get_message_count(&(daemon->client_ringbuffer)) <= 0)
+        dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_SEND_DIRECT);
 
     return DLT_DAEMON_ERROR_OK;
 }
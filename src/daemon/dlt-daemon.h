@@ -76,8 +76,13 @@
 #include "dlt_daemon_event_handler_types.h"
 #include "dlt_gateway_types.h"
 #include "dlt_offline_trace.h"
+#include "dlt_daemon_egress.h"
+#include "dlt_daemon_ingress.h"
+#include "dlt_daemon_latency.h"
+#include "dlt_daemon_metrics_types.h"
 
 #define DLT_DAEMON_FLAG_MAX 256
+#define DLT_DAEMON_RATE_LIMIT_CONFIG_MAX 1024
 
 /**
  * The flags of a dlt daemon.
@@ -96,6 +101,7 @@ typedef struct
     char evalue[NAME_MAX + 1];   /**< (String: ECU ID) Set ECU ID (Default: ECU1) */
     char bvalue[NAME_MAX + 1];   /**< (String: Baudrate) Serial device baudrate (Default: 115200) */
     char yvalue[NAME_MAX + 1];   /**< (String: Devicename) Additional support for serial device */
+    unsigned int serialQueueSize; /**< (int) Bytes queued for the serial device, 0 to write directly (Default: 65536) */
     char ivalue[NAME_MAX + 1];   /**< (String: Directory) Directory where to store the persistant configuration (Default: /tmp) */
     char cvalue[NAME_MAX + 1];   /**< (String: Directory) Filename of DLT configuration file (Default: /etc/dlt.conf) */
     int sharedMemorySize;        /**< (int) Size of shared memory (Default: 100000) */
@@ -104,6 +110,7 @@ typedef struct
     int offlineTraceFileSize;     /**< (int) Maximum size in bytes of one trace file (Default: 1000000) */
     int offlineTraceMaxSize;     /**< (int) Maximum size of all trace files (Default: 4000000) */
     int offlineTraceFilenameTimestampBased;  /**< (int) timestamp based or index based (Default: 1 Timestamp based) */
+    int offlineTraceCompression; /**< (Boolean) write block compressed offline trace files (Default: 0) */
     int loggingMode;     /**< (int) The logging console for internal logging of dlt-daemon (Default: 0) */
     int loggingLevel;     /**< (int) The logging level for internal logging of dlt-daemon (Default: 6) */
     char loggingFilename[DLT_DAEMON_FLAG_MAX]; /**< (String: Filename) The logging filename if internal logging mode is log to file (Default: /tmp/log) */
@@ -117,6 +124,12 @@ typedef struct
     unsigned int offlineLogstorageMaxCounter; /**< (int) Maximum offline logstorage file counter index until wraparound  */
     unsigned int offlineLogstorageMaxCounterIdx; /**< (int) String len of  offlineLogstorageMaxCounter*/
     unsigned int offlineLogstorageCacheSize; /**< Max cache size offline logstorage cache */
+    int offlineLogstorageWorker; /**< (Boolean) Write offline logstorage in one thread per device */
+    unsigned int offlineLogstorageQueueSize; /**< (int) Messages queued per offline logstorage device */
+    int offlineLogstorageQueueBlocking; /**< (Boolean) Block instead of dropping when a device queue is full */
+    int pipelineMode; /**< (Boolean) Send to clients and logstorage devices from egress threads */
+    unsigned int pipelineQueueSize; /**< (int) Messages queued for the network clients in pipelined mode */
+    int ingestionThreads; /**< (int) Threads reading from the applications in pipelined mode, 0 to read in the event loop */
 #ifdef DLT_DAEMON_USE_UNIX_SOCKET_IPC
     char appSockPath[DLT_DAEMON_FLAG_MAX]; /**< Path to User socket */
 #else /* DLT_DAEMON_USE_FIFO_IPC */
@@ -129,6 +142,7 @@ typedef struct
 #endif
     unsigned int port; /**< port number */
     char ctrlSockPath[DLT_DAEMON_FLAG_MAX]; /**< Path to Control socket */
+    char metricsSockPath[DLT_DAEMON_FLAG_MAX]; /**< Path to Metrics socket, empty if disabled */
     int gatewayMode; /**< (Boolean) Gateway Mode */
     char gatewayConfigFile[DLT_DAEMON_FLAG_MAX]; /**< Gateway config file path */
     int autoResponseGetLogInfoOption;   /**< (int) The Option of automatic get log info response during context registration. (Default: 7)*/
@@ -137,6 +151,7 @@ typedef struct
     int enforceContextLLAndTS;  /**< (Boolean) Enforce log-level, trace-status not to exceed contextLogLevel, contextTraceStatus */
     DltBindAddress_t* ipNodes; /**< (String: BindAddress) The daemon accepts connections only on this list of IP addresses */
     int injectionMode;  /**< (Boolean) Injection mode */
+    char rateLimits[DLT_DAEMON_RATE_LIMIT_CONFIG_MAX]; /**< (String) Rate limits APID:CTID:rate:burst separated by ',' */
 } DltDaemonFlags;
 /**
  * The global parameters of a dlt daemon.
@@ -155,15 +170,21 @@ typedef struct
     unsigned char *recv_buf_shm;   /**< buffer for receive message from shm */
 #endif
     DltOfflineTrace offlineTrace; /**< Offline trace handling */
+    DltDaemonEgress egress; /**< Network egress thread of the pipelined mode */
+    DltDaemonIngress ingress; /**< Ingestion threads of the pipelined mode */
+    DltDaemonLatency latency; /**< Latency trace of stamped log messages */
+    DltDaemonMetrics metrics; /**< Runtime counters of the daemon */
     int timeoutOnSend;
     unsigned long RingbufferMinSize;
     unsigned long RingbufferMaxSize;
     unsigned long RingbufferStepSize;
+    unsigned int RingbufferClassLimits[DLT_DAEMON_RINGBUFFER_CLASS_MAX]; /**< share of RingbufferMaxSize per class in percent */
     unsigned long daemonFifoSize;
 #ifdef UDP_CONNECTION_SUPPORT
     int UDPConnectionSetup; /* enable/disable the UDP connection */
     char UDPMulticastIPAddress[MULTICASTIP_MAX_SIZE]; /* multicast ip addres */
     int UDPMulticastIPPort; /* multicast port */
+    int UDPMulticastMTU; /* max size of a multicast datagram */
 #endif
 } DltDaemonLocal;
 
@@ -210,6 +231,7 @@ int dlt_daemon_process_client_messages_serial(DltDaemon *daemon,
                                               DltReceiver *recv,
                                               int verbose);
 int dlt_daemon_process_user_messages(DltDaemon *daemon, DltDaemonLocal *daemon_local, DltReceiver *recv, int verbose);
+int dlt_daemon_process_ingress(DltDaemon *daemon, DltDaemonLocal *daemon_local, DltReceiver *recv, int verbose);
 int dlt_daemon_process_one_s_timer(DltDaemon *daemon, DltDaemonLocal *daemon_local, DltReceiver *recv, int verbose);
 int dlt_daemon_process_sixty_s_timer(DltDaemon *daemon, DltDaemonLocal *daemon_local, DltReceiver *recv, int verbose);
 int dlt_daemon_process_systemd_timer(DltDaemon *daemon, DltDaemonLocal *daemon_local, DltReceiver *recv, int verbose);
@@ -257,6 +279,20 @@ int dlt_daemon_process_user_message_marker(DltDaemon *daemon,
                                            DltDaemonLocal *daemon_local,
                                            DltReceiver *rec,
                                            int verbose);
+int dlt_daemon_process_user_message_rate_limit_dropped(DltDaemon *daemon,
+                                                       DltDaemonLocal *daemon_local,
+                                                       DltReceiver *rec,
+                                                       int verbose);
+int dlt_daemon_user_message_size(const char *buf, int size);
+int dlt_daemon_process_startup_shm(DltDaemon *daemon,
+                                   DltDaemonLocal *daemon_local,
+                                   pid_t pid,
+                                   const char *apid,
+                                   int orphan,
+                                   int verbose);
+void dlt_daemon_process_startup_shm_orphans(DltDaemon *daemon,
+                                            DltDaemonLocal *daemon_local,
+                                            int verbose);
 
 int dlt_daemon_send_ringbuffer_to_client(DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose);
 void dlt_daemon_timingpacket_thread(void *ptr);
@@ -85,6 +85,12 @@
 /* Size of receive buffer for serial connection (from dlt client) */
 #define DLT_DAEMON_RCVBUFSIZESERIAL 10024
 
+/* Maximum number of iovecs per send call, IOV_MAX on Linux */
+#define DLT_DAEMON_IOV_MAX          1024
+
+/* Maximum number of bytes sent per batch when replaying the ring buffer */
+#define DLT_DAEMON_RINGBUFFER_REPLAY_SIZE (256 * 1024)
+
 /* Size of buffer for text output */
 #define DLT_DAEMON_TEXTSIZE         10024
 
@@ -103,6 +109,9 @@
 /* Default baudrate for serial interface */
 #define DLT_DAEMON_SERIAL_DEFAULT_BAUDRATE 115200
 
+/* Default size of the output queue of the serial interface in bytes */
+#define DLT_DAEMON_SERIAL_QUEUE_SIZE (64 * 1024)
+
 /************************/
 /* Don't change please! */
 /************************/
@@ -64,6 +64,7 @@
 #include "dlt_daemon_event_handler.h"
 
 #include "dlt_daemon_offline_logstorage.h"
+#include "dlt_daemon_metrics.h"
 #include "dlt_gateway.h"
 
 /** Inline function to calculate/set the requested log level or traces status
@@ -150,9 +151,19 @@ static int dlt_daemon_client_send_all_multiple(DltDaemon *daemon,
                                     daemon_local,
                                     verbose);
         }
+        else {
+            dlt_event_handler_update_output(&(daemon_local->pEvent), temp);
+        }
 
-        if (ret != DLT_DAEMON_ERROR_OK)
-            dlt_vlog(LOG_WARNING, "%s: send dlt message failed\n", __func__);
+        if (ret != DLT_DAEMON_ERROR_OK) {
+            /* a full serial queue already warned once */
+            if (ret != DLT_DAEMON_ERROR_BUFFER_FULL)
+                dlt_vlog(LOG_WARNING, "%s: send dlt message failed\n", __func__);
+
+            dlt_daemon_metrics_drop(&(daemon_local->metrics.main),
+                                    dlt_daemon_metrics_get_apid(data1, size1),
+                                    DLT_DAEMON_DROP_CLIENT_SLOW);
+        }
         else
             /* If sent to at  least one client,
              * then do not store in ring buffer
@@ -163,6 +174,65 @@ static int dlt_daemon_client_send_all_multiple(DltDaemon *daemon,
     return sent;
 }
 
+int dlt_daemon_client_send_all_iov(DltDaemon *daemon,
+                                   DltDaemonLocal *daemon_local,
+                                   const struct iovec *iov,
+                                   int iovcnt,
+                                   int messages,
+                                   int verbose)
+{
+    static struct iovec vector[DLT_DAEMON_IOV_MAX];
+    int sent = 0;
+    unsigned int i = 0;
+    int ret = 0;
+    DltConnection *temp = NULL;
+    int type_mask =
+        (DLT_CON_MASK_CLIENT_MSG_TCP | DLT_CON_MASK_CLIENT_MSG_SERIAL);
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (iov == NULL) ||
+        (iovcnt <= 0) || (iovcnt > DLT_DAEMON_IOV_MAX)) {
+        dlt_vlog(LOG_ERR, "%s: Invalid parameters\n", __func__);
+        return 0;
+    }
+
+    for (i = 0; i < daemon_local->pEvent.nfds; i++)
+    {
+        temp = dlt_event_handler_find_connection(&(daemon_local->pEvent),
+                                        daemon_local->pEvent.pfd[i].fd);
+
+        if ((temp == NULL) || (temp->receiver == NULL) ||
+            !((1 << temp->type) & type_mask))
+            continue;
+
+        /* the vector is consumed while sending */
+        memcpy(vector, iov, sizeof(struct iovec) * (size_t)iovcnt);
+
+        DLT_DAEMON_SEM_LOCK();
+        ret = dlt_connection_send_iov(temp, vector, iovcnt, messages);
+        DLT_DAEMON_SEM_FREE();
+
+        if ((ret != DLT_DAEMON_ERROR_OK) &&
+            (DLT_CONNECTION_CLIENT_MSG_TCP == temp->type)) {
+            dlt_daemon_close_socket(temp->receiver->fd,
+                                    daemon,
+                                    daemon_local,
+                                    verbose);
+        }
+        else {
+            dlt_event_handler_update_output(&(daemon_local->pEvent), temp);
+        }
+
+        if (ret != DLT_DAEMON_ERROR_OK)
+            dlt_vlog(LOG_WARNING, "%s: send dlt messages failed\n", __func__);
+        else
+            sent = 1;
+    }
+
+    return sent;
+}
+
 int dlt_daemon_client_send(int sock,
                            DltDaemon *daemon,
                            DltDaemonLocal *daemon_local,
@@ -182,31 +252,43 @@ int dlt_daemon_client_send(int sock,
     }
 
     if ((sock != DLT_DAEMON_SEND_TO_ALL) && (sock != DLT_DAEMON_SEND_FORCE)) {
+        /* the egress thread may be sending to the same client */
+        int acquired = dlt_daemon_egress_acquire_client(&daemon_local->egress, sock);
+
         /* Send message to specific socket */
         if (isatty(sock)) {
+            DltConnection *con = dlt_event_handler_find_connection(&(daemon_local->pEvent), sock);
+
             DLT_DAEMON_SEM_LOCK();
 
-            if ((ret = dlt_daemon_serial_send(sock, data1, size1, data2, size2, (char) daemon->sendserialheader))) {
-                DLT_DAEMON_SEM_FREE();
-                dlt_vlog(LOG_WARNING, "%s: serial send dlt message failed\n", __func__);
-                return ret;
-            }
+            /* responses are queued behind the log messages already queued */
+            if ((con != NULL) && (con->serial_queue != NULL))
+                ret = dlt_connection_send_serial(con, data1, size1, data2, size2,
+                                                 daemon->sendserialheader,
+                                                 DLT_DAEMON_SERIAL_LEVEL_CONTROL);
+            else
+                ret = dlt_daemon_serial_send(sock, data1, size1, data2, size2, (char) daemon->sendserialheader);
 
             DLT_DAEMON_SEM_FREE();
+
+            if (ret)
+                dlt_vlog(LOG_WARNING, "%s: serial send dlt message failed\n", __func__);
+            else
+                dlt_event_handler_update_output(&(daemon_local->pEvent), con);
         }
         else {
             DLT_DAEMON_SEM_LOCK();
+            ret = dlt_daemon_socket_send(sock, data1, size1, data2, size2, (char) daemon->sendserialheader);
+            DLT_DAEMON_SEM_FREE();
 
-            if ((ret = dlt_daemon_socket_send(sock, data1, size1, data2, size2, (char) daemon->sendserialheader))) {
-                DLT_DAEMON_SEM_FREE();
+            if (ret)
                 dlt_vlog(LOG_WARNING, "%s: socket send dlt message failed\n", __func__);
-                return ret;
-            }
-
-            DLT_DAEMON_SEM_FREE();
         }
 
-        return DLT_DAEMON_ERROR_OK;
+        if (acquired)
+            dlt_daemon_egress_release_client(&daemon_local->egress, sock);
+
+        return ret;
     }
 
     /* write message to offline trace */
@@ -232,16 +314,21 @@ int dlt_daemon_client_send(int sock,
         /* write messages to offline logstorage only if there is an extended header set
          * this need to be checked because the function is dlt_daemon_client_send is called by
          * newly introduced dlt_daemon_log_internal */
-        if (daemon_local->flags.offlineLogstorageMaxDevices > 0)
-            dlt_daemon_logstorage_write(daemon,
-                                        &daemon_local->flags,
-                                        storage_header,
-                                        storage_header_size,
-                                        data1,
-                                        size1,
-                                        data2,
-                                        size2);
-    }
+        if ((daemon_local->flags.offlineLogstorageMaxDevices > 0) &&
+            (dlt_daemon_logstorage_write(daemon,
+                                         &daemon_local->flags,
+                                         storage_header,
+                                         storage_header_size,
+                                         data1,
+                                         size1,
+                                         data2,
+                                         size2) > 0))
+            dlt_daemon_metrics_drop(&(daemon_local->metrics.main),
+                                    dlt_daemon_metrics_get_apid(data1, size1),
+                                    DLT_DAEMON_DROP_LOGSTORAGE);
+    }
+
+    dlt_daemon_latency_stamp(&daemon_local->latency, DLT_LATENCY_STAGE_ROUTE);
 
     /* send messages to daemon socket */
     if ((daemon->mode == DLT_USER_MODE_EXTERNAL) || (daemon->mode == DLT_USER_MODE_BOTH)) {
@@ -256,7 +343,23 @@ int dlt_daemon_client_send(int sock,
 
 #endif
 
-        if ((sock == DLT_DAEMON_SEND_FORCE) || (daemon->state == DLT_DAEMON_STATE_SEND_DIRECT)) {
+        if ((sock == DLT_DAEMON_SEND_TO_ALL) &&
+            (daemon->state == DLT_DAEMON_STATE_SEND_DIRECT) &&
+            dlt_daemon_egress_is_active(&daemon_local->egress)) {
+            /* The egress thread sends the message. If its queue is full,
+             * the message is dropped instead of buffered, which would
+             * change the order. */
+            if (dlt_daemon_egress_enqueue(&daemon_local->egress, data1, size1, data2, size2) != 0)
+                dlt_daemon_metrics_drop(&(daemon_local->metrics.main),
+                                        dlt_daemon_metrics_get_apid(data1, size1),
+                                        DLT_DAEMON_DROP_CLIENT_SLOW);
+
+            sent = 1;
+        }
+        else if ((sock == DLT_DAEMON_SEND_FORCE) || (daemon->state == DLT_DAEMON_STATE_SEND_DIRECT)) {
+            /* forced messages are sent after the queued ones */
+            dlt_daemon_egress_drain(&daemon_local->egress);
+
             sent = dlt_daemon_client_send_all_multiple(daemon,
                                                        daemon_local,
                                                        data1,
@@ -274,21 +377,24 @@ int dlt_daemon_client_send(int sock,
     if ((sock != DLT_DAEMON_SEND_FORCE) &&
         ((daemon->state == DLT_DAEMON_STATE_BUFFER) || (daemon->state == DLT_DAEMON_STATE_SEND_BUFFER) ||
          (daemon->state == DLT_DAEMON_STATE_BUFFER_FULL))) {
-        if (daemon->state != DLT_DAEMON_STATE_BUFFER_FULL) {
-            DLT_DAEMON_SEM_LOCK();
-            /* Store message in history buffer */
-            ret = dlt_buffer_push3(&(daemon->client_ringbuffer), data1, (unsigned int) size1, data2, (unsigned int) size2, 0, 0);
-            DLT_DAEMON_SEM_FREE();
+        DLT_DAEMON_SEM_LOCK();
+        /* Store message in history buffer, even when full a message may
+         * replace messages of lower priority */
+        ret = dlt_daemon_ringbuffer_push(&(daemon->client_ringbuffer), data1, size1, data2, size2);
+        DLT_DAEMON_SEM_FREE();
 
-            if (ret < DLT_RETURN_OK) {
+        if (ret < DLT_RETURN_OK) {
+            if (daemon->state != DLT_DAEMON_STATE_BUFFER_FULL)
                 dlt_daemon_change_state(daemon, DLT_DAEMON_STATE_BUFFER_FULL);
-            }
-        }
-        if (daemon->state == DLT_DAEMON_STATE_BUFFER_FULL) {
+
             daemon->overflow_counter += 1;
             if (daemon->overflow_counter == 1)
                 dlt_vlog(LOG_INFO, "%s: Buffer is full! Messages will be discarded.\n", __func__);
 
+            dlt_daemon_metrics_drop(&(daemon_local->metrics.main),
+                                    dlt_daemon_metrics_get_apid(data1, size1),
+                                    DLT_DAEMON_DROP_BUFFER_FULL);
+
             return DLT_DAEMON_ERROR_BUFFER_FULL;
         }
     } else {
@@ -705,6 +811,21 @@ int dlt_daemon_client_process_control(int sock,
             dlt_daemon_control_set_all_trace_status(sock, daemon, daemon_local, msg, verbose);
             break;
         }
+        case DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS:
+        {
+            dlt_daemon_control_get_rate_limit_status(sock, daemon, daemon_local, verbose);
+            break;
+        }
+        case DLT_SERVICE_ID_GET_LATENCY_STATS:
+        {
+            dlt_daemon_control_get_latency_stats(sock, daemon, daemon_local, verbose);
+            break;
+        }
+        case DLT_SERVICE_ID_GET_METRICS:
+        {
+            dlt_daemon_control_get_metrics(sock, daemon, daemon_local, verbose);
+            break;
+        }
         default:
         {
             dlt_daemon_control_service_response(sock,
@@ -1270,6 +1391,219 @@ int dlt_daemon_control_message_buffer_overflow(int sock,
     return DLT_DAEMON_ERROR_OK;
 }
 
+void dlt_daemon_control_get_rate_limit_status(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
+{
+    DltMessage msg;
+    DltServiceGetRateLimitStatusResponse *resp;
+    DltServiceRateLimitInfo *info;
+    int i;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if (daemon == NULL)
+        return;
+
+    /* initialise new message */
+    if (dlt_message_init(&msg, 0) == DLT_RETURN_ERROR) {
+        dlt_daemon_control_service_response(sock,
+                                            daemon,
+                                            daemon_local,
+                                            DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS,
+                                            DLT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    /* prepare payload of data */
+    msg.datasize = (uint32_t) (sizeof(DltServiceGetRateLimitStatusResponse) +
+        sizeof(DltServiceRateLimitInfo) * (size_t) daemon->num_rate_limits);
+
+    if (msg.databuffer && (msg.databuffersize < msg.datasize)) {
+        free(msg.databuffer);
+        msg.databuffer = 0;
+    }
+
+    if (msg.databuffer == 0) {
+        msg.databuffer = (uint8_t *)malloc(msg.datasize);
+        msg.databuffersize = msg.datasize;
+    }
+
+    if (msg.databuffer == 0) {
+        dlt_daemon_control_service_response(sock,
+                                            daemon,
+                                            daemon_local,
+                                            DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS,
+                                            DLT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    resp = (DltServiceGetRateLimitStatusResponse *)msg.databuffer;
+    resp->service_id = DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS;
+    resp->status = DLT_SERVICE_RESPONSE_OK;
+    resp->count = (uint32_t) daemon->num_rate_limits;
+
+    info = (DltServiceRateLimitInfo *)(msg.databuffer + sizeof(DltServiceGetRateLimitStatusResponse));
+
+    for (i = 0; i < daemon->num_rate_limits; i++) {
+        memcpy(info[i].apid, daemon->rate_limits[i].apid, DLT_ID_SIZE);
+        memcpy(info[i].ctid, daemon->rate_limits[i].ctid, DLT_ID_SIZE);
+        info[i].rate = daemon->rate_limits[i].bucket.rate;
+        info[i].burst = daemon->rate_limits[i].bucket.burst;
+        info[i].dropped = daemon->rate_limits[i].bucket.dropped;
+        info[i].user_dropped = daemon->rate_limits[i].user_dropped;
+    }
+
+    /* send message */
+    dlt_daemon_client_send_control_message(sock, daemon, daemon_local, &msg, "", "", verbose);
+
+    /* free message */
+    dlt_message_free(&msg, 0);
+}
+
+void dlt_daemon_control_get_latency_stats(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
+{
+    DltMessage msg;
+    DltServiceGetLatencyStatsResponse *resp;
+    DltServiceLatencyInfo *info;
+    DltDaemonLatency *latency;
+    int i, j;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL))
+        return;
+
+    latency = &daemon_local->latency;
+
+    /* initialise new message */
+    if (dlt_message_init(&msg, 0) == DLT_RETURN_ERROR) {
+        dlt_daemon_control_service_response(sock,
+                                            daemon,
+                                            daemon_local,
+                                            DLT_SERVICE_ID_GET_LATENCY_STATS,
+                                            DLT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    /* prepare payload of data */
+    msg.datasize = (uint32_t) (sizeof(DltServiceGetLatencyStatsResponse) +
+        sizeof(DltServiceLatencyInfo) * (size_t) latency->num_apps);
+
+    if (msg.databuffer && (msg.databuffersize < msg.datasize)) {
+        free(msg.databuffer);
+        msg.databuffer = 0;
+    }
+
+    if (msg.databuffer == 0) {
+        msg.databuffer = (uint8_t *)malloc(msg.datasize);
+        msg.databuffersize = msg.datasize;
+    }
+
+    if (msg.databuffer == 0) {
+        dlt_daemon_control_service_response(sock,
+                                            daemon,
+                                            daemon_local,
+                                            DLT_SERVICE_ID_GET_LATENCY_STATS,
+                                            DLT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    resp = (DltServiceGetLatencyStatsResponse *)msg.databuffer;
+    resp->service_id = DLT_SERVICE_ID_GET_LATENCY_STATS;
+    resp->status = DLT_SERVICE_RESPONSE_OK;
+    resp->count = (uint32_t) latency->num_apps;
+
+    info = (DltServiceLatencyInfo *)(msg.databuffer + sizeof(DltServiceGetLatencyStatsResponse));
+
+    for (i = 0; i < latency->num_apps; i++) {
+        memcpy(info[i].apid, latency->apps[i].apid, DLT_ID_SIZE);
+
+        for (j = 0; j < DLT_LATENCY_STAGE_COUNT; j++)
+            dlt_daemon_latency_get_stage(&(latency->apps[i].stages[j]), &(info[i].stages[j]));
+    }
+
+    /* send message */
+    dlt_daemon_client_send_control_message(sock, daemon, daemon_local, &msg, "", "", verbose);
+
+    /* free message */
+    dlt_message_free(&msg, 0);
+}
+
+void dlt_daemon_control_get_metrics(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose)
+{
+    DltMessage msg;
+    DltServiceGetMetricsResponse *resp;
+    char *text;
+    int size = 0;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL))
+        return;
+
+    text = dlt_daemon_metrics_print(daemon, daemon_local, &size);
+
+    /* initialise new message */
+    if ((text == NULL) || (dlt_message_init(&msg, 0) == DLT_RETURN_ERROR)) {
+        free(text);
+        dlt_daemon_control_service_response(sock,
+                                            daemon,
+                                            daemon_local,
+                                            DLT_SERVICE_ID_GET_METRICS,
+                                            DLT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    /* the text is cut after the last complete line fitting into one message */
+    if (size > DLT_DAEMON_METRICS_CONTROL_SIZE) {
+        size = DLT_DAEMON_METRICS_CONTROL_SIZE;
+
+        while ((size > 0) && (text[size - 1] != '\n'))
+            size--;
+    }
+
+    /* prepare payload of data */
+    msg.datasize = (uint32_t) (sizeof(DltServiceGetMetricsResponse) + (size_t) size);
+
+    if (msg.databuffer && (msg.databuffersize < msg.datasize)) {
+        free(msg.databuffer);
+        msg.databuffer = 0;
+    }
+
+    if (msg.databuffer == 0) {
+        msg.databuffer = (uint8_t *)malloc(msg.datasize);
+        msg.databuffersize = msg.datasize;
+    }
+
+    if (msg.databuffer == 0) {
+        free(text);
+        dlt_daemon_control_service_response(sock,
+                                            daemon,
+                                            daemon_local,
+                                            DLT_SERVICE_ID_GET_METRICS,
+                                            DLT_SERVICE_RESPONSE_ERROR,
+                                            verbose);
+        return;
+    }
+
+    resp = (DltServiceGetMetricsResponse *)msg.databuffer;
+    resp->service_id = DLT_SERVICE_ID_GET_METRICS;
+    resp->status = DLT_SERVICE_RESPONSE_OK;
+    resp->length = (uint32_t) size;
+    memcpy(msg.databuffer + sizeof(DltServiceGetMetricsResponse), text, (size_t) size);
+    free(text);
+
+    /* send message */
+    dlt_daemon_client_send_control_message(sock, daemon, daemon_local, &msg, "", "", verbose);
+
+    /* free message */
+    dlt_message_free(&msg, 0);
+}
+
 void dlt_daemon_control_service_response(int sock,
                                          DltDaemon *daemon,
                                          DltDaemonLocal *daemon_local,
@@ -2292,6 +2626,8 @@ int dlt_daemon_process_one_s_timer(DltDaemon *daemon,
                                         daemon_local,
                                         daemon_local->flags.vflag);
 
+    dlt_daemon_metrics_update_rates(&daemon_local->metrics);
+
     dlt_log(LOG_DEBUG, "Timer timingpacket\n");
 
     return 0;
@@ -2520,7 +2856,9 @@ void dlt_daemon_control_service_logstorage(int sock,
     device = &daemon->storage_handle[device_index];
 
     if (req->connection_type == DLT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) {
+        dlt_daemon_logstorage_lock(daemon, device_index);
         ret = dlt_logstorage_device_connected(device, req->mount_point);
+        dlt_daemon_logstorage_unlock(daemon, device_index);
 
         if (ret == 1) {
             dlt_daemon_control_service_response(sock,
@@ -2573,8 +2911,14 @@ void dlt_daemon_control_service_logstorage(int sock,
             (int) daemon_local->flags.offlineLogstorageMaxDevices,
             verbose);
 
+        dlt_daemon_logstorage_lock(daemon, device_index);
         dlt_logstorage_device_disconnected(&(daemon->storage_handle[device_index]),
                                            DLT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+        dlt_daemon_logstorage_unlock(daemon, device_index);
+
+        if (daemon->storage_worker != NULL)
+            dlt_daemon_logstorage_worker_log_stats(&daemon->storage_worker[device_index],
+                                                   device_index);
 
         dlt_daemon_control_service_response(sock,
                                             daemon,
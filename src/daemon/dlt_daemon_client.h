@@ -64,6 +64,25 @@
 #include <dlt_offline_trace.h>
 #include <sys/time.h>
 
+/**
+ * Send a list of buffers holding complete messages to all clients, used to
+ * replay the ring buffer. Messages are not written to offline trace or
+ * offline logstorage.
+ * @param daemon pointer to dlt daemon structure
+ * @param daemon_local pointer to dlt daemon local structure
+ * @param iov buffers to be sent
+ * @param iovcnt number of buffers, at most DLT_DAEMON_IOV_MAX
+ * @param messages number of messages in the buffers
+ * @param verbose if set to true verbose information is printed out.
+ * @return 1 if the buffers were sent to at least one client, 0 otherwise
+ */
+int dlt_daemon_client_send_all_iov(DltDaemon *daemon,
+                                   DltDaemonLocal *daemon_local,
+                                   const struct iovec *iov,
+                                   int iovcnt,
+                                   int messages,
+                                   int verbose);
+
 /**
  * Send out message to client or store message in offline trace.
  * @param sock connection handle used for sending response
@@ -137,6 +156,30 @@ void dlt_daemon_control_get_log_info(int sock,
  * @param verbose if set to true verbose information is printed out.
  */
 void dlt_daemon_control_get_software_version(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose);
+/**
+ * Process and generate response to received get rate limit status control message
+ * @param sock connection handle used for sending response
+ * @param daemon pointer to dlt daemon structure
+ * @param daemon_local pointer to dlt daemon local structure
+ * @param verbose if set to true verbose information is printed out.
+ */
+void dlt_daemon_control_get_rate_limit_status(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose);
+/**
+ * Process and generate response to received get latency stats control message
+ * @param sock connection handle used for sending response
+ * @param daemon pointer to dlt daemon structure
+ * @param daemon_local pointer to dlt daemon local structure
+ * @param verbose if set to true verbose information is printed out.
+ */
+void dlt_daemon_control_get_latency_stats(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose);
+/**
+ * Process and generate response to received get metrics control message
+ * @param sock connection handle used for sending response
+ * @param daemon pointer to dlt daemon structure
+ * @param daemon_local pointer to dlt daemon local structure
+ * @param verbose if set to true verbose information is printed out.
+ */
+void dlt_daemon_control_get_metrics(int sock, DltDaemon *daemon, DltDaemonLocal *daemon_local, int verbose);
 /**
  * Process and generate response to received get default log level control message
  * @param sock connection handle used for sending response
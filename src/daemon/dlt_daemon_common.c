@@ -237,13 +237,18 @@ int dlt_daemon_init(DltDaemon *daemon,
     dlt_vlog(LOG_INFO, "Ringbuffer configuration: %lu/%lu/%lu\n",
              RingbufferMinSize, RingbufferMaxSize, RingbufferStepSize);
 
-    if (dlt_buffer_init_dynamic(&(daemon->client_ringbuffer),
-                                (uint32_t) RingbufferMinSize,
-                                (uint32_t) RingbufferMaxSize,
-                                (uint32_t) RingbufferStepSize) < DLT_RETURN_OK)
+    if (dlt_daemon_ringbuffer_init(&(daemon->client_ringbuffer),
+                                   (uint32_t) RingbufferMinSize,
+                                   (uint32_t) RingbufferMaxSize,
+                                   (uint32_t) RingbufferStepSize) < DLT_RETURN_OK)
         return -1;
 
     daemon->storage_handle = NULL;
+    daemon->storage_worker = NULL;
+
+    daemon->rate_limits = NULL;
+    daemon->num_rate_limits = 0;
+
     return 0;
 }
 
@@ -274,7 +279,11 @@ int dlt_daemon_free(DltDaemon *daemon, int verbose)
         free(app_recv_buffer);
 
     /* free ringbuffer */
-    dlt_buffer_free_dynamic(&(daemon->client_ringbuffer));
+    dlt_daemon_ringbuffer_free(&(daemon->client_ringbuffer));
+
+    free(daemon->rate_limits);
+    daemon->rate_limits = NULL;
+    daemon->num_rate_limits = 0;
 
     return 0;
 }
@@ -1395,10 +1404,151 @@ int dlt_daemon_user_send_log_level(DltDaemon *daemon, DltDaemonContext *context,
                 dlt_daemon_application_reset_user_handle(daemon, app, verbose);
         }
     }
+    else {
+        /* the application drops excess messages before they are sent */
+        dlt_daemon_user_send_rate_limit(daemon, context, verbose);
+    }
 
     return (ret == DLT_RETURN_OK) ? DLT_RETURN_OK : DLT_RETURN_ERROR;
 }
 
+int dlt_daemon_user_send_rate_limit(DltDaemon *daemon, DltDaemonContext *context, int verbose)
+{
+    DltUserHeader userheader;
+    DltUserControlMsgRateLimit usercontext;
+    DltDaemonRateLimit *limit;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (context == NULL)) {
+        dlt_vlog(LOG_ERR, "NULL parameter in %s", __func__);
+        return -1;
+    }
+
+    limit = dlt_daemon_rate_limit_find(daemon, context->apid, context->ctid, verbose);
+
+    if (limit == NULL)
+        return 0;
+
+    if (dlt_user_set_userheader(&userheader, DLT_USER_MESSAGE_RATE_LIMIT) < DLT_RETURN_OK) {
+        dlt_vlog(LOG_ERR, "Failed to set userheader in %s", __func__);
+        return -1;
+    }
+
+    /* A limit of the whole application is applied to each context by the
+     * application, the daemon limits the sum of all contexts. */
+    usercontext.log_level_pos = context->log_level_pos;
+    usercontext.rate = limit->bucket.rate;
+    usercontext.burst = limit->bucket.burst;
+
+    if (dlt_user_log_out2(context->user_handle,
+                          &(userheader), sizeof(DltUserHeader),
+                          &(usercontext), sizeof(DltUserControlMsgRateLimit)) < DLT_RETURN_OK) {
+        dlt_vlog(LOG_WARNING, "Failed to send rate limit to context %.4s:%.4s\n",
+                 context->apid, context->ctid);
+        return -1;
+    }
+
+    return 0;
+}
+
+int dlt_daemon_rate_limits_init(DltDaemon *daemon, const char *config, int verbose)
+{
+    char buf[DLT_DAEMON_RATE_LIMIT_CONFIG_MAX];
+    char *save = NULL;
+    char *tok;
+    char *apid;
+    char *ctid;
+    char *rate;
+    char *burst;
+    DltDaemonRateLimit *limit;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (config == NULL))
+        return -1;
+
+    strncpy(buf, config, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    for (tok = strtok_r(buf, ",", &save); tok != NULL; tok = strtok_r(NULL, ",", &save)) {
+        /* APID:CTID:rate:burst, strtok() would skip an empty CTID */
+        apid = tok;
+        ctid = strchr(apid, ':');
+        rate = (ctid != NULL) ? strchr(ctid + 1, ':') : NULL;
+        burst = (rate != NULL) ? strchr(rate + 1, ':') : NULL;
+
+        if ((burst == NULL) || (ctid == apid) || (ctid - apid > DLT_ID_SIZE)) {
+            dlt_vlog(LOG_WARNING, "Invalid rate limit '%s', expected APID:CTID:rate:burst\n", tok);
+            continue;
+        }
+
+        *ctid++ = '\0';
+        *rate++ = '\0';
+        *burst++ = '\0';
+
+        if ((strcmp(ctid, "*") == 0))
+            ctid[0] = '\0';
+
+        if (strlen(ctid) > DLT_ID_SIZE) {
+            dlt_vlog(LOG_WARNING, "Invalid context id in rate limit of %s\n", apid);
+            continue;
+        }
+
+        limit = realloc(daemon->rate_limits,
+                        sizeof(DltDaemonRateLimit) * (size_t)(daemon->num_rate_limits + 1));
+
+        if (limit == NULL) {
+            dlt_log(LOG_ERR, "Cannot allocate memory for rate limits\n");
+            return -1;
+        }
+
+        daemon->rate_limits = limit;
+        limit = &(daemon->rate_limits[daemon->num_rate_limits]);
+        memset(limit, 0, sizeof(DltDaemonRateLimit));
+        dlt_set_id(limit->apid, apid);
+        dlt_set_id(limit->ctid, ctid);
+        dlt_token_bucket_init(&(limit->bucket),
+                              (uint32_t)strtoul(rate, NULL, 10),
+                              (uint32_t)strtoul(burst, NULL, 10));
+        daemon->num_rate_limits++;
+
+        dlt_vlog(LOG_INFO, "Rate limit %.4s:%.4s %u messages/s, burst %u\n",
+                 limit->apid, limit->ctid[0] ? limit->ctid : "*",
+                 limit->bucket.rate, limit->bucket.burst);
+    }
+
+    return 0;
+}
+
+DltDaemonRateLimit *dlt_daemon_rate_limit_find(DltDaemon *daemon,
+                                               const char *apid,
+                                               const char *ctid,
+                                               int verbose)
+{
+    DltDaemonRateLimit *app_limit = NULL;
+    int i;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (apid == NULL) || (ctid == NULL))
+        return NULL;
+
+    for (i = 0; i < daemon->num_rate_limits; i++) {
+        DltDaemonRateLimit *limit = &(daemon->rate_limits[i]);
+
+        if (memcmp(limit->apid, apid, DLT_ID_SIZE) != 0)
+            continue;
+
+        if (limit->ctid[0] == '\0')
+            app_limit = limit;
+        else if (memcmp(limit->ctid, ctid, DLT_ID_SIZE) == 0)
+            return limit;
+    }
+
+    return app_limit;
+}
+
 int dlt_daemon_user_send_log_state(DltDaemon *daemon, DltDaemonApplication *app, int verbose)
 {
     DltUserHeader userheader;
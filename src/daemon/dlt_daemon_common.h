@@ -80,7 +80,10 @@
 #   include <stdbool.h>
 #   include "dlt_common.h"
 #   include "dlt_user.h"
+#   include "dlt_user_shared.h"
+#   include "dlt_daemon_ringbuffer.h"
 #   include "dlt_offline_logstorage.h"
+#   include "dlt_daemon_offline_logstorage_worker.h"
 #   include "dlt_gateway_types.h"
 
 #   ifdef __cplusplus
@@ -111,6 +114,8 @@ extern sem_t dlt_daemon_mutex;
     #      define MULTICASTIP_MAX_SIZE 256
     #      define MULTICAST_CONNECTION_DISABLED 0
     #      define MULTICAST_CONNECTION_ENABLED 1
+    #      define MULTICAST_MTU 1472 /* Ethernet MTU without IPv4 and UDP headers */
+    #      define UDP_DATAGRAM_MAX_SIZE 65507
 #   endif
 
 /**
@@ -154,6 +159,17 @@ typedef struct
     bool predefined; /**< set to true if this context is predefined by runtime configuration file */
 } DltDaemonContext;
 
+/**
+ * The rate limit of an application or of a single context.
+ */
+typedef struct
+{
+    char apid[DLT_ID_SIZE];               /**< application id */
+    char ctid[DLT_ID_SIZE];               /**< context id, empty if the limit is for the whole application */
+    DltTokenBucket bucket;                /**< token bucket of the limit */
+    uint32_t user_dropped;                /**< messages dropped by the applications with this limit */
+} DltDaemonRateLimit;
+
 /*
  * The parameter of registered users list
  */
@@ -181,7 +197,7 @@ typedef struct
     char ecuid[DLT_ID_SIZE];       /**< ECU ID of daemon */
     int sendserialheader;          /**< 1: send serial header; 0 don't send serial header */
     int timingpackets;              /**< 1: send continous timing packets; 0 don't send continous timing packets */
-    DltBuffer client_ringbuffer; /**< Ring-buffer for storing received logs while no client connection is available */
+    DltDaemonRingbuffer client_ringbuffer; /**< Ring-buffer for storing received logs while no client connection is available */
     char runtime_application_cfg[PATH_MAX + 1]; /**< Path and filename of persistent application configuration. Set to path max, as it specifies a full path*/
     char runtime_context_cfg[PATH_MAX + 1]; /**< Path and filename of persistent context configuration */
     char runtime_configuration[PATH_MAX + 1]; /**< Path and filename of persistent configuration */
@@ -190,7 +206,10 @@ typedef struct
     char *ECUVersionString; /**< Version string to send to client. Loaded from a file at startup. May be null. */
     DltDaemonState state;   /**< the current logging state of dlt daemon. */
     DltLogStorage *storage_handle;
+    DltDaemonLogstorageWorker *storage_worker; /**< I/O worker of each storage device, NULL if writes are synchronous */
     int maintain_logstorage_loglevel;     /* Permission to maintain the logstorage loglevel*/
+    DltDaemonRateLimit *rate_limits; /**< rate limits of applications and contexts */
+    int num_rate_limits;             /**< number of rate limits */
 } DltDaemon;
 
 /**
@@ -452,6 +471,41 @@ int dlt_daemon_configuration_save(DltDaemon *daemon, const char *filename, int v
  */
 int dlt_daemon_user_send_log_level(DltDaemon *daemon, DltDaemonContext *context, int verbose);
 
+/**
+ * Send user message DLT_USER_MESSAGE_RATE_LIMIT to user application,
+ * if a rate limit is configured for the context
+ * @param daemon pointer to dlt daemon structure
+ * @param context pointer to context for response
+ * @param verbose if set to true verbose information is printed out.
+ * @return negative value if there was an error
+ */
+int dlt_daemon_user_send_rate_limit(DltDaemon *daemon, DltDaemonContext *context, int verbose);
+
+/**
+ * Initialise the rate limits of the daemon from the configuration.
+ * Limits are separated by ',', each limit is given as APID:CTID:rate:burst.
+ * CTID can be empty or '*' to limit all contexts of the application together.
+ * @param daemon pointer to dlt daemon structure
+ * @param config configured rate limits
+ * @param verbose if set to true verbose information is printed out.
+ * @return negative value if there was an error
+ */
+int dlt_daemon_rate_limits_init(DltDaemon *daemon, const char *config, int verbose);
+
+/**
+ * Find the rate limit of a message. The limit of the context is preferred
+ * to the limit of the application.
+ * @param daemon pointer to dlt daemon structure
+ * @param apid application id
+ * @param ctid context id
+ * @param verbose if set to true verbose information is printed out.
+ * @return pointer to rate limit, NULL if the message is not limited
+ */
+DltDaemonRateLimit *dlt_daemon_rate_limit_find(DltDaemon *daemon,
+                                               const char *apid,
+                                               const char *ctid,
+                                               int verbose);
+
 /**
  * Send user message DLT_USER_MESSAGE_LOG_STATE to user application
  * @param daemon pointer to dlt daemon structure
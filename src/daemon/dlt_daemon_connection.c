@@ -29,12 +29,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <unistd.h>
+#include <poll.h>
 
 #include <sys/socket.h>
 #include <syslog.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #include "dlt_daemon_connection_types.h"
 #include "dlt_daemon_connection.h"
@@ -46,6 +49,8 @@
 #include "dlt_common.h"
 #include "dlt_gateway.h"
 #include "dlt_daemon_socket.h"
+#include "dlt_daemon_metrics.h"
+#include "dlt_daemon_serial.h"
 
 static DltConnectionId connectionId;
 extern char *app_recv_buffer;
@@ -78,8 +83,10 @@ DLT_STATIC int dlt_connection_send(DltConnection *conn,
     switch (type) {
     case DLT_CONNECTION_CLIENT_MSG_SERIAL:
 
-        if (write(conn->receiver->fd, msg, msg_size) > 0)
+        if (write(conn->receiver->fd, msg, msg_size) > 0) {
+            atomic_fetch_add_explicit(&conn->bytes_out, msg_size, memory_order_relaxed);
             return DLT_DAEMON_ERROR_OK;
+        }
 
         return DLT_DAEMON_ERROR_UNKNOWN;
 
@@ -87,6 +94,10 @@ DLT_STATIC int dlt_connection_send(DltConnection *conn,
         ret = dlt_daemon_socket_sendreliable(conn->receiver->fd,
                                              msg,
                                              msg_size);
+
+        if (ret == DLT_DAEMON_ERROR_OK)
+            atomic_fetch_add_explicit(&conn->bytes_out, msg_size, memory_order_relaxed);
+
         return ret;
     default:
         return DLT_DAEMON_ERROR_UNKNOWN;
@@ -119,6 +130,15 @@ int dlt_connection_send_multiple(DltConnection *con,
     if (con == NULL)
         return DLT_DAEMON_ERROR_UNKNOWN;
 
+    if (con->type == DLT_CONNECTION_CLIENT_MSG_SERIAL)
+        return dlt_connection_send_serial(con,
+                                          data1,
+                                          size1,
+                                          data2,
+                                          size2,
+                                          sendserialheader,
+                                          dlt_daemon_serial_get_level(data1, size1));
+
     if (sendserialheader)
         ret = dlt_connection_send(con,
                                   (void *)dltSerialHeader,
@@ -130,9 +150,221 @@ int dlt_connection_send_multiple(DltConnection *con,
     if ((data2 != NULL) && (ret == DLT_RETURN_OK))
         ret = dlt_connection_send(con, data2, size2);
 
+    if (ret == DLT_RETURN_OK)
+        atomic_fetch_add_explicit(&con->messages_out, 1, memory_order_relaxed);
+
     return ret;
 }
 
+/** @brief Send a message through a serial connection.
+ *
+ * The serial header and the message are written at once. If the connection
+ * has an output queue, the message is queued and as much of the queue as
+ * the device accepts is written, the rest is written once the event loop
+ * polls the device writable.
+ *
+ * @param con The serial connection.
+ * @param data1 The first part of the message.
+ * @param size1 The size of the first part.
+ * @param data2 The second part of the message.
+ * @param size2 The size of the second part.
+ * @param sendserialheader Whether we need or not to send the serial header.
+ * @param level The level deciding which messages are dropped first.
+ *
+ * @return DLT_DAEMON_ERROR_OK on success, DLT_DAEMON_ERROR_BUFFER_FULL if
+ *         the queue is full, DLT_DAEMON_ERROR_SEND_FAILED on write failure,
+ *         DLT_DAEMON_ERROR_UNKNOWN otherwise.
+ */
+int dlt_connection_send_serial(DltConnection *con,
+                               void *data1,
+                               int size1,
+                               void *data2,
+                               int size2,
+                               int sendserialheader,
+                               uint8_t level)
+{
+    DltDaemonSerialQueue *queue = NULL;
+    int ret = 0;
+
+    if ((con == NULL) || (con->receiver == NULL) ||
+        (con->type != DLT_CONNECTION_CLIENT_MSG_SERIAL))
+        return DLT_DAEMON_ERROR_UNKNOWN;
+
+    queue = con->serial_queue;
+
+    if (queue == NULL) {
+        ret = dlt_daemon_serial_send(con->receiver->fd,
+                                     data1,
+                                     size1,
+                                     data2,
+                                     size2,
+                                     (char)sendserialheader);
+
+        if (ret != DLT_DAEMON_ERROR_OK)
+            return ret;
+
+        atomic_fetch_add_explicit(&con->bytes_out,
+                                  (sendserialheader ? sizeof(dltSerialHeader) : 0) +
+                                  (uint64_t)((data1 && (size1 > 0)) ? size1 : 0) +
+                                  (uint64_t)((data2 && (size2 > 0)) ? size2 : 0),
+                                  memory_order_relaxed);
+        atomic_fetch_add_explicit(&con->messages_out, 1, memory_order_relaxed);
+
+        return DLT_DAEMON_ERROR_OK;
+    }
+
+    ret = dlt_daemon_serial_queue_add(queue,
+                                      data1,
+                                      size1,
+                                      data2,
+                                      size2,
+                                      (char)sendserialheader,
+                                      level);
+
+    if (ret == DLT_DAEMON_ERROR_BUFFER_FULL) {
+        if (!queue->dropping) {
+            dlt_vlog(LOG_WARNING,
+                     "Serial device cannot keep up, dropping messages of the lowest level\n");
+            queue->dropping = 1;
+        }
+
+        return ret;
+    }
+
+    if (ret != DLT_DAEMON_ERROR_OK)
+        return ret;
+
+    return dlt_connection_flush(con);
+}
+
+/** @brief Write the output queue of a serial connection.
+ *
+ * Only what the device accepts without blocking is written.
+ *
+ * @param con The serial connection.
+ *
+ * @return DLT_DAEMON_ERROR_OK on success, DLT_DAEMON_ERROR_SEND_FAILED
+ *         on write failure.
+ */
+int dlt_connection_flush(DltConnection *con)
+{
+    int messages = 0;
+    int ret = 0;
+
+    if ((con == NULL) || (con->receiver == NULL) || (con->serial_queue == NULL))
+        return DLT_DAEMON_ERROR_OK;
+
+    ret = dlt_daemon_serial_queue_flush(con->serial_queue, con->receiver->fd, &messages);
+
+    if (ret < 0) {
+        dlt_vlog(LOG_WARNING,
+                 "%s: write failed [errno: %d]!\n", __func__, errno);
+        return DLT_DAEMON_ERROR_SEND_FAILED;
+    }
+
+    atomic_fetch_add_explicit(&con->bytes_out, (uint64_t)ret, memory_order_relaxed);
+    atomic_fetch_add_explicit(&con->messages_out, (uint64_t)messages, memory_order_relaxed);
+
+    if (!dlt_daemon_serial_queue_pending(con->serial_queue) && con->serial_queue->dropping) {
+        dlt_vlog(LOG_INFO, "Serial device caught up, %" PRIu64 " messages dropped so far\n",
+                 con->serial_queue->dropped);
+        con->serial_queue->dropping = 0;
+    }
+
+    return DLT_DAEMON_ERROR_OK;
+}
+
+/* Wait until a non-blocking device is writable */
+static int dlt_connection_wait_output(DltConnection *con)
+{
+    struct pollfd pfd;
+
+    pfd.fd = con->receiver->fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+
+    if ((poll(&pfd, 1, -1) < 0) && (errno != EINTR))
+        return DLT_DAEMON_ERROR_SEND_FAILED;
+
+    return DLT_DAEMON_ERROR_OK;
+}
+
+/** @brief Send a list of buffers through a connection with as few calls as possible.
+ *
+ * The iovecs are updated while the data is sent, they have to be set up
+ * again before the next call.
+ *
+ * @param con The connection to send the data through.
+ * @param iov The buffers to be sent.
+ * @param iovcnt The number of buffers.
+ * @param messages The number of messages in the buffers.
+ *
+ * @return DLT_DAEMON_ERROR_OK on success, DLT_DAEMON_ERROR_SEND_FAILED
+ *         on send failure, DLT_DAEMON_ERROR_UNKNOWN otherwise.
+ */
+int dlt_connection_send_iov(DltConnection *con, struct iovec *iov, int iovcnt, int messages)
+{
+    struct msghdr msg;
+    ssize_t ret = 0;
+
+    if ((con == NULL) || (con->receiver == NULL) || (iov == NULL))
+        return DLT_DAEMON_ERROR_UNKNOWN;
+
+    /* the queued messages go first to keep the order */
+    while (dlt_daemon_serial_queue_pending(con->serial_queue))
+        if ((dlt_connection_flush(con) != DLT_DAEMON_ERROR_OK) ||
+            (dlt_daemon_serial_queue_pending(con->serial_queue) &&
+             (dlt_connection_wait_output(con) != DLT_DAEMON_ERROR_OK)))
+            return DLT_DAEMON_ERROR_SEND_FAILED;
+
+    while (iovcnt > 0) {
+        if (con->type == DLT_CONNECTION_CLIENT_MSG_TCP) {
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = (size_t)iovcnt;
+            ret = sendmsg(con->receiver->fd, &msg, 0);
+        }
+        else if (con->type == DLT_CONNECTION_CLIENT_MSG_SERIAL) {
+            ret = writev(con->receiver->fd, iov, iovcnt);
+        }
+        else {
+            return DLT_DAEMON_ERROR_UNKNOWN;
+        }
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if (((errno == EAGAIN) || (errno == EWOULDBLOCK)) &&
+                (con->type == DLT_CONNECTION_CLIENT_MSG_SERIAL) &&
+                (dlt_connection_wait_output(con) == DLT_DAEMON_ERROR_OK))
+                continue;
+
+            dlt_vlog(LOG_WARNING,
+                     "%s: send failed [errno: %d]!\n", __func__, errno);
+            return DLT_DAEMON_ERROR_SEND_FAILED;
+        }
+
+        atomic_fetch_add_explicit(&con->bytes_out, (uint64_t)ret, memory_order_relaxed);
+
+        /* skip what was sent, a partial send may stop within a buffer */
+        while ((iovcnt > 0) && ((size_t)ret >= iov->iov_len)) {
+            ret -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + ret;
+            iov->iov_len -= (size_t)ret;
+        }
+    }
+
+    atomic_fetch_add_explicit(&con->messages_out, (uint64_t)messages, memory_order_relaxed);
+
+    return DLT_DAEMON_ERROR_OK;
+}
+
 /** @brief Get the next connection filtered with a type mask.
  *
  * In some cases we need the next connection available of a specific type or
@@ -200,6 +432,8 @@ DLT_STATIC DltReceiver *dlt_connection_get_receiver(DltDaemonLocal *daemon_local
     switch (type) {
     case DLT_CONNECTION_CONTROL_CONNECT:
     /* FALL THROUGH */
+    case DLT_CONNECTION_METRICS_CONNECT:
+    /* FALL THROUGH */
     case DLT_CONNECTION_CONTROL_MSG:
     /* FALL THROUGH */
     case DLT_CONNECTION_CLIENT_CONNECT:
@@ -248,6 +482,8 @@ DLT_STATIC DltReceiver *dlt_connection_get_receiver(DltDaemonLocal *daemon_local
 #endif
     /* FALL THROUGH */
     case DLT_CONNECTION_GATEWAY_TIMER:
+    /* FALL THROUGH */
+    case DLT_CONNECTION_APP_INGRESS:
         ret = calloc(1, sizeof(DltReceiver));
 
         if (ret)
@@ -325,6 +561,12 @@ void *dlt_connection_get_callback(DltConnection *con)
     case DLT_CONNECTION_GATEWAY_TIMER:
         ret = dlt_gateway_process_gateway_timer;
         break;
+    case DLT_CONNECTION_METRICS_CONNECT:
+        ret = dlt_daemon_process_metrics_connect;
+        break;
+    case DLT_CONNECTION_APP_INGRESS:
+        ret = dlt_daemon_process_ingress;
+        break;
     default:
         ret = NULL;
     }
@@ -344,6 +586,8 @@ void *dlt_connection_get_callback(DltConnection *con)
 void dlt_connection_destroy(DltConnection *to_destroy)
 {
     to_destroy->id = 0;
+    dlt_daemon_serial_queue_free(to_destroy->serial_queue);
+    to_destroy->serial_queue = NULL;
     close(to_destroy->receiver->fd);
     dlt_connection_destroy_receiver(to_destroy);
     free(to_destroy);
@@ -28,11 +28,16 @@
 #ifndef DLT_DAEMON_CONNECTION_H
 #define DLT_DAEMON_CONNECTION_H
 
+#include <sys/uio.h>
+
 #include "dlt_daemon_connection_types.h"
 #include "dlt_daemon_event_handler_types.h"
 #include "dlt-daemon.h"
 
 int dlt_connection_send_multiple(DltConnection *, void *, int, void *, int, int);
+int dlt_connection_send_iov(DltConnection *, struct iovec *, int, int);
+int dlt_connection_send_serial(DltConnection *, void *, int, void *, int, int, uint8_t);
+int dlt_connection_flush(DltConnection *);
 
 DltConnection *dlt_connection_get_next(DltConnection *, int);
 int dlt_connection_create_remaining(DltDaemonLocal *);
@@ -27,6 +27,8 @@
 
 #ifndef DLT_DAEMON_CONNECTION_TYPES_H
 #define DLT_DAEMON_CONNECTION_TYPES_H
+#include <stdatomic.h>
+
 #include "dlt_common.h"
 
 typedef enum {
@@ -51,6 +53,8 @@ typedef enum {
     DLT_CONNECTION_CONTROL_MSG,
     DLT_CONNECTION_GATEWAY,
     DLT_CONNECTION_GATEWAY_TIMER,
+    DLT_CONNECTION_METRICS_CONNECT,
+    DLT_CONNECTION_APP_INGRESS,
     DLT_CONNECTION_TYPE_MAX
 } DltConnectionType;
 
@@ -66,6 +70,8 @@ typedef enum {
 #define DLT_CON_MASK_CONTROL_MSG        (1 << DLT_CONNECTION_CONTROL_MSG)
 #define DLT_CON_MASK_GATEWAY            (1 << DLT_CONNECTION_GATEWAY)
 #define DLT_CON_MASK_GATEWAY_TIMER      (1 << DLT_CONNECTION_GATEWAY_TIMER)
+#define DLT_CON_MASK_METRICS_CONNECT    (1 << DLT_CONNECTION_METRICS_CONNECT)
+#define DLT_CON_MASK_APP_INGRESS        (1 << DLT_CONNECTION_APP_INGRESS)
 #define DLT_CON_MASK_ALL                (0xffff)
 
 typedef uintptr_t DltConnectionId;
@@ -80,6 +86,11 @@ typedef struct DltConnection {
     DltConnectionStatus status; /**< Status of connection */
     struct DltConnection *next;   /**< For multiple client connection using linked list */
     int ev_mask; /**< Mask to set when registering the connection for events */
+    _Atomic uint64_t bytes_in; /**< Bytes received */
+    _Atomic uint64_t bytes_out; /**< Bytes sent */
+    _Atomic uint64_t messages_in; /**< Messages received */
+    _Atomic uint64_t messages_out; /**< Messages sent */
+    struct DltDaemonSerialQueue *serial_queue; /**< Output queue of a non-blocking serial connection, NULL if written directly */
 } DltConnection;
 
 #endif /* DLT_DAEMON_CONNECTION_TYPES_H */
@@ -0,0 +1,484 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_egress.c
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <sys/uio.h>
+
+#include "dlt_common.h"
+#include "dlt-daemon.h"
+#include "dlt-daemon_cfg.h"
+#include "dlt_daemon_common.h"
+#include "dlt_daemon_connection.h"
+#include "dlt_daemon_egress.h"
+
+/* Clients are added in steps of this many entries */
+#define DLT_DAEMON_EGRESS_CLIENT_STEP 4
+
+#if ((3 * DLT_DAEMON_EGRESS_BATCH_SIZE) > DLT_DAEMON_IOV_MAX)
+#   error "DLT_DAEMON_EGRESS_BATCH_SIZE does not fit in DLT_DAEMON_IOV_MAX"
+#endif
+
+/* Index of a client, -1 if it is not served. Called with the lock held. */
+static int dlt_daemon_egress_find_client(DltDaemonEgress *egress, DltConnection *con, int fd)
+{
+    int i;
+
+    for (i = 0; i < egress->num_clients; i++)
+        if ((egress->clients[i].con == con) ||
+            ((con == NULL) && (egress->clients[i].con->receiver->fd == fd)))
+            return i;
+
+    return -1;
+}
+
+/* Take the next client the batch was not sent to yet, NULL when all are
+ * done. Called with the lock held, waits for clients in use by the event
+ * loop. */
+static DltDaemonEgressClient *dlt_daemon_egress_next_client(DltDaemonEgress *egress)
+{
+    int waiting;
+    int i;
+
+    for (;;) {
+        waiting = 0;
+
+        for (i = 0; i < egress->num_clients; i++) {
+            if (egress->clients[i].batch == egress->batch)
+                continue;
+
+            if (egress->clients[i].busy) {
+                waiting = 1;
+                continue;
+            }
+
+            egress->clients[i].batch = egress->batch;
+
+            if (!egress->clients[i].failed)
+                return &egress->clients[i];
+        }
+
+        if (!waiting)
+            return NULL;
+
+        pthread_cond_wait(&egress->cond, &egress->lock);
+    }
+}
+
+/* Send one batch of messages to all clients */
+static void dlt_daemon_egress_send(DltDaemonEgress *egress,
+                                   DltDaemonEgressMsg **msgs,
+                                   int count)
+{
+    static struct iovec iov[DLT_DAEMON_IOV_MAX];
+    static struct iovec vector[DLT_DAEMON_IOV_MAX];
+    DltDaemonEgressClient *client;
+    DltConnection *con;
+    int iovcnt = 0;
+    int i;
+    int ret;
+
+    for (i = 0; i < count; i++) {
+        if (egress->serialheader) {
+            iov[iovcnt].iov_base = (void *)dltSerialHeader;
+            iov[iovcnt].iov_len = sizeof(dltSerialHeader);
+            iovcnt++;
+        }
+
+        iov[iovcnt].iov_base = msgs[i]->data;
+        iov[iovcnt].iov_len = (size_t)msgs[i]->size1;
+        iovcnt++;
+
+        if (msgs[i]->size2 > 0) {
+            iov[iovcnt].iov_base = msgs[i]->data + msgs[i]->size1;
+            iov[iovcnt].iov_len = (size_t)msgs[i]->size2;
+            iovcnt++;
+        }
+    }
+
+    pthread_mutex_lock(&egress->lock);
+
+    egress->batch++;
+
+    while ((client = dlt_daemon_egress_next_client(egress)) != NULL) {
+        client->busy = 1;
+        con = client->con;
+
+        /* a busy client is not removed, the others may be */
+        pthread_mutex_unlock(&egress->lock);
+
+        /* the vector is consumed while sending */
+        memcpy(vector, iov, sizeof(struct iovec) * (size_t)iovcnt);
+
+        ret = dlt_connection_send_iov(con, vector, iovcnt, count);
+
+        if (ret != DLT_DAEMON_ERROR_OK)
+            dlt_vlog(LOG_WARNING, "%s: send dlt messages failed\n", __func__);
+
+        pthread_mutex_lock(&egress->lock);
+
+        client = &egress->clients[dlt_daemon_egress_find_client(egress, con, -1)];
+        client->busy = 0;
+
+        /* as in the event loop, only TCP clients are closed */
+        if ((ret != DLT_DAEMON_ERROR_OK) && (con->type == DLT_CONNECTION_CLIENT_MSG_TCP)) {
+            client->failed = 1;
+            atomic_store(&egress->failed, 1);
+        }
+
+        pthread_cond_broadcast(&egress->cond);
+    }
+
+    pthread_mutex_unlock(&egress->lock);
+}
+
+static void *dlt_daemon_egress_run(void *arg)
+{
+    DltDaemonEgress *egress = (DltDaemonEgress *)arg;
+    DltDaemonEgressMsg *msgs[DLT_DAEMON_EGRESS_BATCH_SIZE];
+    unsigned int tail;
+    int count;
+    int i;
+
+    for (;;) {
+        if (sem_wait(&egress->items) != 0) {
+            if (errno == EINTR)
+                continue;
+
+            dlt_vlog(LOG_ERR, "%s: sem_wait failed: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        tail = atomic_load(&egress->tail);
+
+        /* woken up without message: stop request */
+        if (tail == atomic_load(&egress->head)) {
+            if (!atomic_load(&egress->running))
+                break;
+
+            continue;
+        }
+
+        /* take what is queued up to a batch, one item was already counted */
+        msgs[0] = egress->queue[tail % egress->size];
+        count = 1;
+
+        while ((count < DLT_DAEMON_EGRESS_BATCH_SIZE) &&
+               (tail + (unsigned int)count != atomic_load(&egress->head)) &&
+               (sem_trywait(&egress->items) == 0)) {
+            msgs[count] = egress->queue[(tail + (unsigned int)count) % egress->size];
+            count++;
+        }
+
+        dlt_daemon_egress_send(egress, msgs, count);
+
+        pthread_mutex_lock(&egress->lock);
+        atomic_store(&egress->tail, tail + (unsigned int)count);
+        pthread_cond_broadcast(&egress->cond);
+        pthread_mutex_unlock(&egress->lock);
+
+        for (i = 0; i < count; i++) {
+            free(msgs[i]);
+            sem_post(&egress->slots);
+        }
+    }
+
+    return NULL;
+}
+
+int dlt_daemon_egress_init(DltDaemonEgress *egress, unsigned int size, int serialheader)
+{
+    if ((egress == NULL) || (size == 0))
+        return -1;
+
+    memset(egress, 0, sizeof(DltDaemonEgress));
+
+    egress->queue = calloc(size, sizeof(DltDaemonEgressMsg *));
+
+    if (egress->queue == NULL) {
+        dlt_vlog(LOG_ERR, "%s: Cannot allocate queue of %u entries\n", __func__, size);
+        return -1;
+    }
+
+    egress->size = size;
+    egress->serialheader = serialheader;
+    atomic_init(&egress->head, 0);
+    atomic_init(&egress->tail, 0);
+    atomic_init(&egress->max_depth, 0);
+    atomic_init(&egress->dropped, 0);
+    atomic_init(&egress->failed, 0);
+    atomic_init(&egress->running, 1);
+
+    if ((pthread_mutex_init(&egress->lock, NULL) != 0) ||
+        (pthread_cond_init(&egress->cond, NULL) != 0) ||
+        (sem_init(&egress->items, 0, 0) != 0) ||
+        (sem_init(&egress->slots, 0, size) != 0)) {
+        dlt_vlog(LOG_ERR, "%s: Cannot initialize synchronization\n", __func__);
+        free(egress->queue);
+        egress->queue = NULL;
+        return -1;
+    }
+
+    if (pthread_create(&egress->thread, NULL, dlt_daemon_egress_run, egress) != 0) {
+        dlt_vlog(LOG_ERR, "%s: Cannot create egress thread\n", __func__);
+        sem_destroy(&egress->slots);
+        sem_destroy(&egress->items);
+        pthread_cond_destroy(&egress->cond);
+        pthread_mutex_destroy(&egress->lock);
+        free(egress->queue);
+        egress->queue = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+void dlt_daemon_egress_free(DltDaemonEgress *egress)
+{
+    if ((egress == NULL) || (egress->queue == NULL))
+        return;
+
+    /* the thread sends what is queued before it sees the stop request */
+    atomic_store(&egress->running, 0);
+    sem_post(&egress->items);
+    pthread_join(egress->thread, NULL);
+
+    sem_destroy(&egress->slots);
+    sem_destroy(&egress->items);
+    pthread_cond_destroy(&egress->cond);
+    pthread_mutex_destroy(&egress->lock);
+    free(egress->clients);
+    egress->clients = NULL;
+    egress->num_clients = 0;
+    egress->max_clients = 0;
+    free(egress->queue);
+    egress->queue = NULL;
+}
+
+int dlt_daemon_egress_is_active(DltDaemonEgress *egress)
+{
+    return (egress != NULL) && (egress->queue != NULL);
+}
+
+int dlt_daemon_egress_add_client(DltDaemonEgress *egress, DltConnection *con)
+{
+    DltDaemonEgressClient *clients;
+
+    if ((egress == NULL) || (egress->queue == NULL) || (con == NULL))
+        return -1;
+
+    pthread_mutex_lock(&egress->lock);
+
+    if (egress->num_clients == egress->max_clients) {
+        clients = realloc(egress->clients,
+                          sizeof(DltDaemonEgressClient) *
+                          (size_t)(egress->max_clients + DLT_DAEMON_EGRESS_CLIENT_STEP));
+
+        if (clients == NULL) {
+            pthread_mutex_unlock(&egress->lock);
+            dlt_vlog(LOG_ERR, "%s: Cannot allocate client entry\n", __func__);
+            return -1;
+        }
+
+        egress->clients = clients;
+        egress->max_clients += DLT_DAEMON_EGRESS_CLIENT_STEP;
+    }
+
+    /* the client gets the messages of the next batch */
+    egress->clients[egress->num_clients].con = con;
+    egress->clients[egress->num_clients].failed = 0;
+    egress->clients[egress->num_clients].busy = 0;
+    egress->clients[egress->num_clients].batch = egress->batch;
+    egress->num_clients++;
+
+    pthread_mutex_unlock(&egress->lock);
+
+    return 0;
+}
+
+void dlt_daemon_egress_remove_client(DltDaemonEgress *egress, DltConnection *con)
+{
+    int i;
+
+    if ((egress == NULL) || (egress->queue == NULL) || (con == NULL))
+        return;
+
+    pthread_mutex_lock(&egress->lock);
+
+    while (((i = dlt_daemon_egress_find_client(egress, con, -1)) >= 0) &&
+           egress->clients[i].busy)
+        pthread_cond_wait(&egress->cond, &egress->lock);
+
+    if (i >= 0) {
+        egress->num_clients--;
+        memmove(&egress->clients[i],
+                &egress->clients[i + 1],
+                sizeof(DltDaemonEgressClient) * (size_t)(egress->num_clients - i));
+    }
+
+    pthread_mutex_unlock(&egress->lock);
+}
+
+int dlt_daemon_egress_acquire_client(DltDaemonEgress *egress, int fd)
+{
+    int i;
+
+    if ((egress == NULL) || (egress->queue == NULL))
+        return 0;
+
+    pthread_mutex_lock(&egress->lock);
+
+    while (((i = dlt_daemon_egress_find_client(egress, NULL, fd)) >= 0) &&
+           egress->clients[i].busy)
+        pthread_cond_wait(&egress->cond, &egress->lock);
+
+    if (i >= 0)
+        egress->clients[i].busy = 1;
+
+    pthread_mutex_unlock(&egress->lock);
+
+    return i >= 0;
+}
+
+void dlt_daemon_egress_release_client(DltDaemonEgress *egress, int fd)
+{
+    int i;
+
+    if ((egress == NULL) || (egress->queue == NULL))
+        return;
+
+    pthread_mutex_lock(&egress->lock);
+
+    i = dlt_daemon_egress_find_client(egress, NULL, fd);
+
+    if (i >= 0)
+        egress->clients[i].busy = 0;
+
+    pthread_cond_broadcast(&egress->cond);
+    pthread_mutex_unlock(&egress->lock);
+}
+
+int dlt_daemon_egress_enqueue(DltDaemonEgress *egress,
+                              void *data1,
+                              int size1,
+                              void *data2,
+                              int size2)
+{
+    DltDaemonEgressMsg *msg;
+    unsigned int head;
+    unsigned int depth;
+
+    if ((egress == NULL) || (egress->queue == NULL) || (data1 == NULL) ||
+        (size1 <= 0) || (size2 < 0) || ((size2 > 0) && (data2 == NULL)))
+        return -1;
+
+    if (sem_trywait(&egress->slots) != 0) {
+        if (atomic_fetch_add(&egress->dropped, 1) == 0)
+            dlt_vlog(LOG_WARNING, "%s: Client queue is full! Messages will be discarded.\n",
+                     __func__);
+
+        return -1;
+    }
+
+    msg = malloc(sizeof(DltDaemonEgressMsg) + (size_t)size1 + (size_t)size2);
+
+    if (msg == NULL) {
+        sem_post(&egress->slots);
+        return -1;
+    }
+
+    msg->size1 = size1;
+    msg->size2 = size2;
+    memcpy(msg->data, data1, (size_t)size1);
+
+    if (size2 > 0)
+        memcpy(msg->data + size1, data2, (size_t)size2);
+
+    head = atomic_load(&egress->head);
+    egress->queue[head % egress->size] = msg;
+    atomic_store(&egress->head, head + 1);
+
+    depth = head + 1 - atomic_load(&egress->tail);
+
+    if (depth > atomic_load(&egress->max_depth))
+        atomic_store(&egress->max_depth, depth);
+
+    sem_post(&egress->items);
+
+    return 0;
+}
+
+void dlt_daemon_egress_drain(DltDaemonEgress *egress)
+{
+    if ((egress == NULL) || (egress->queue == NULL))
+        return;
+
+    /* head is only advanced by the caller, so the queue cannot grow here */
+    pthread_mutex_lock(&egress->lock);
+
+    while (atomic_load(&egress->tail) != atomic_load(&egress->head))
+        pthread_cond_wait(&egress->cond, &egress->lock);
+
+    pthread_mutex_unlock(&egress->lock);
+}
+
+int dlt_daemon_egress_get_failed(DltDaemonEgress *egress)
+{
+    int fd = -1;
+    int i;
+
+    if ((egress == NULL) || (egress->queue == NULL) || !atomic_load(&egress->failed))
+        return -1;
+
+    pthread_mutex_lock(&egress->lock);
+
+    for (i = 0; i < egress->num_clients; i++) {
+        if (egress->clients[i].failed && !egress->clients[i].busy) {
+            fd = egress->clients[i].con->receiver->fd;
+            egress->num_clients--;
+            memmove(&egress->clients[i],
+                    &egress->clients[i + 1],
+                    sizeof(DltDaemonEgressClient) * (size_t)(egress->num_clients - i));
+            break;
+        }
+    }
+
+    if (fd == -1)
+        atomic_store(&egress->failed, 0);
+
+    pthread_mutex_unlock(&egress->lock);
+
+    return fd;
+}
+
+void dlt_daemon_egress_log_stats(DltDaemonEgress *egress)
+{
+    if ((egress == NULL) || (egress->queue == NULL))
+        return;
+
+    dlt_vlog(LOG_INFO,
+             "Client egress: queue depth %u (max %u of %u), %u messages dropped\n",
+             atomic_load(&egress->head) - atomic_load(&egress->tail),
+             atomic_load(&egress->max_depth),
+             egress->size,
+             atomic_load(&egress->dropped));
+}
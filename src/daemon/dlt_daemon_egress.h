@@ -0,0 +1,209 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_egress.h
+ */
+
+#ifndef DLT_DAEMON_EGRESS_H
+#define DLT_DAEMON_EGRESS_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#include "dlt_daemon_connection_types.h"
+
+#define DLT_DAEMON_EGRESS_QUEUE_SIZE 4096 /* Default number of messages queued for the clients */
+#define DLT_DAEMON_EGRESS_BATCH_SIZE 256  /* Max messages sent to the clients in one call */
+
+/**
+ * A message queued for the network clients.
+ */
+typedef struct
+{
+    int size1;              /**< size of the message header */
+    int size2;              /**< size of the payload */
+    unsigned char data[];   /**< message header and payload */
+} DltDaemonEgressMsg;
+
+/**
+ * A TCP or serial client served by the egress thread.
+ */
+typedef struct
+{
+    DltConnection *con;     /**< connection owned by the event handler */
+    int failed;             /**< set when sending failed, the event loop closes it */
+    int busy;               /**< a thread is sending to the client */
+    unsigned int batch;     /**< last batch sent to the client */
+} DltDaemonEgressClient;
+
+/**
+ * Network egress stage of the pipelined mode.
+ *
+ * The event loop routes the messages of all applications, so it is the
+ * only producer of the queue, and the egress thread, which sends
+ * the queued messages to all TCP and serial clients, the only consumer.
+ * Head and tail are updated without lock. The semaphores only put the
+ * threads to sleep when the queue is empty or full.
+ *
+ * Ordering guarantees:
+ * - Log messages reach every client in the order the event loop received
+ *   them, so the messages of one application keep their order.
+ * - Control responses to the requesting client and messages sent with
+ *   DLT_DAEMON_SEND_FORCE are sent by the event loop. Responses may
+ *   overtake log messages still queued, forced messages wait until the
+ *   queue is empty.
+ * - The ring buffer is replayed only after the queue is empty.
+ * - Network and offline logstorage egress are independent, a message may
+ *   be stored before or after it is sent.
+ *
+ * The lock protects the client list. It is not held while sending, a
+ * client is marked busy instead. The event loop waits for the busy flag
+ * before it writes to a client itself or closes it, so only one thread
+ * writes to a connection and a connection is never closed during a send.
+ * A slow client delays the egress thread, the event loop only when it
+ * writes to that client itself.
+ *
+ * Routing stays on the event loop, because the handlers update the
+ * application and context tables without locking. Reading from the
+ * applications is moved to the ingestion threads, see DltDaemonIngress.
+ */
+typedef struct
+{
+    pthread_t thread;                   /**< egress thread */
+    pthread_mutex_t lock;               /**< protects the client list */
+    pthread_cond_t cond;                /**< signalled when a client is released or messages are sent */
+    sem_t items;                        /**< number of queued messages */
+    sem_t slots;                        /**< number of free queue entries */
+    DltDaemonEgressMsg **queue;         /**< queued messages */
+    unsigned int size;                  /**< number of queue entries */
+    atomic_uint head;                   /**< total number of queued messages */
+    atomic_uint tail;                   /**< total number of sent messages */
+    atomic_uint max_depth;              /**< highest queue depth seen */
+    atomic_uint dropped;                /**< messages dropped because the queue was full */
+    atomic_int failed;                  /**< set when a client has to be closed */
+    atomic_int running;                 /**< cleared to stop the thread */
+    DltDaemonEgressClient *clients;     /**< TCP and serial clients */
+    int num_clients;                    /**< number of clients */
+    int max_clients;                    /**< allocated client entries */
+    unsigned int batch;                 /**< number of the batch being sent */
+    int serialheader;                   /**< 1: send the serial header in front of each message */
+} DltDaemonEgress;
+
+/**
+ * Initialise the egress stage and start its thread.
+ *
+ * @param egress egress to initialise
+ * @param size number of queue entries
+ * @param serialheader 1 to send the serial header in front of each message
+ * @return 0 on success, -1 on error
+ */
+int dlt_daemon_egress_init(DltDaemonEgress *egress, unsigned int size, int serialheader);
+
+/**
+ * Send all queued messages, stop the egress thread and free the egress.
+ *
+ * @param egress egress to free
+ */
+void dlt_daemon_egress_free(DltDaemonEgress *egress);
+
+/**
+ * Check if the egress thread is running.
+ *
+ * @param egress egress
+ * @return 1 if messages are sent by the egress thread, 0 otherwise
+ */
+int dlt_daemon_egress_is_active(DltDaemonEgress *egress);
+
+/**
+ * Serve a TCP or serial client connection.
+ *
+ * @param egress egress
+ * @param con client connection
+ * @return 0 on success, -1 on error
+ */
+int dlt_daemon_egress_add_client(DltDaemonEgress *egress, DltConnection *con);
+
+/**
+ * Stop serving a client connection. When this function returns, the
+ * egress thread does not use the connection anymore.
+ *
+ * @param egress egress
+ * @param con client connection
+ */
+void dlt_daemon_egress_remove_client(DltDaemonEgress *egress, DltConnection *con);
+
+/**
+ * Take exclusive use of a client before the event loop writes to it.
+ * Waits while the egress thread sends to the client.
+ *
+ * @param egress egress
+ * @param fd file descriptor of the client
+ * @return 1 if the client has to be released with
+ *         dlt_daemon_egress_release_client(), 0 if it is not served by
+ *         the egress thread
+ */
+int dlt_daemon_egress_acquire_client(DltDaemonEgress *egress, int fd);
+
+/**
+ * Release a client taken with dlt_daemon_egress_acquire_client().
+ *
+ * @param egress egress
+ * @param fd file descriptor of the client
+ */
+void dlt_daemon_egress_release_client(DltDaemonEgress *egress, int fd);
+
+/**
+ * Copy a message to the queue.
+ *
+ * @param egress egress
+ * @param data1 message header
+ * @param size1 size of message header
+ * @param data2 payload
+ * @param size2 size of payload
+ * @return 0 on success, -1 if the message was dropped
+ */
+int dlt_daemon_egress_enqueue(DltDaemonEgress *egress,
+                              void *data1,
+                              int size1,
+                              void *data2,
+                              int size2);
+
+/**
+ * Wait until all queued messages are sent.
+ *
+ * @param egress egress
+ */
+void dlt_daemon_egress_drain(DltDaemonEgress *egress);
+
+/**
+ * Get a client the egress thread failed to send to. The client is not
+ * served anymore, its connection has to be closed by the caller.
+ *
+ * @param egress egress
+ * @return file descriptor of the client, -1 if there is none
+ */
+int dlt_daemon_egress_get_failed(DltDaemonEgress *egress);
+
+/**
+ * Log queue depth and drop counter.
+ *
+ * @param egress egress
+ */
+void dlt_daemon_egress_log_stats(DltDaemonEgress *egress);
+
+#endif /* DLT_DAEMON_EGRESS_H */
@@ -42,6 +42,8 @@
 #include "dlt_daemon_connection_types.h"
 #include "dlt_daemon_event_handler.h"
 #include "dlt_daemon_event_handler_types.h"
+#include "dlt_daemon_metrics.h"
+#include "dlt_daemon_serial.h"
 
 /**
  * \def DLT_EV_TIMEOUT_MSEC
@@ -167,6 +169,42 @@ static void dlt_event_handler_disable_fd(DltEventHandler *ev, int fd)
     }
 }
 
+/** @brief Watch a serial connection for writability while data is queued.
+ *
+ * POLLOUT is only added to the descriptor list while the output queue of
+ * the connection holds data, the list is only searched when that changes.
+ *
+ * @param ev The event handler structure containing the list
+ * @param con The connection, nothing is done if it has no output queue
+ */
+void dlt_event_handler_update_output(DltEventHandler *ev, DltConnection *con)
+{
+    unsigned int i = 0;
+    int pending = 0;
+
+    if ((ev == NULL) || (con == NULL) || (con->receiver == NULL) ||
+        (con->serial_queue == NULL))
+        return;
+
+    pending = dlt_daemon_serial_queue_pending(con->serial_queue);
+
+    if (pending == con->serial_queue->output)
+        return;
+
+    for (i = 0; i < ev->nfds; i++) {
+        if (ev->pfd[i].fd != con->receiver->fd)
+            continue;
+
+        if (pending)
+            ev->pfd[i].events |= POLLOUT;
+        else
+            ev->pfd[i].events &= ~POLLOUT;
+
+        con->serial_queue->output = pending;
+        break;
+    }
+}
+
 /** @brief Catch and process incoming events.
  *
  * This function waits for events on all connections. Once an event raise,
@@ -184,13 +222,18 @@ int dlt_daemon_handle_event(DltEventHandler *pEvent,
                             DltDaemonLocal *daemon_local)
 {
     int ret = 0;
+    int timeout = DLT_EV_TIMEOUT_MSEC;
     unsigned int i = 0;
     int (*callback)(DltDaemon *, DltDaemonLocal *, DltReceiver *, int) = NULL;
 
     if ((pEvent == NULL) || (daemon == NULL) || (daemon_local == NULL))
         return DLT_RETURN_ERROR;
 
-    ret = poll(pEvent->pfd, pEvent->nfds, DLT_EV_TIMEOUT_MSEC);
+    /* do not wait while the ring buffer is replayed between the events */
+    if (daemon->state == DLT_DAEMON_STATE_SEND_BUFFER)
+        timeout = 0;
+
+    ret = poll(pEvent->pfd, pEvent->nfds, timeout);
 
     if (ret <= 0) {
         /* We are not interested in EINTR has it comes
@@ -205,6 +248,8 @@ int dlt_daemon_handle_event(DltEventHandler *pEvent,
         return ret;
     }
 
+    dlt_daemon_metrics_loop_begin(&daemon_local->metrics);
+
     for (i = 0; i < pEvent->nfds; i++) {
         int fd = 0;
         DltConnection *con = NULL;
@@ -242,6 +287,24 @@ int dlt_daemon_handle_event(DltEventHandler *pEvent,
             continue;
         }
 
+        /* Then write what is queued for a serial device */
+        if ((pEvent->pfd[i].revents & POLLOUT) && (con->serial_queue != NULL)) {
+            /* the egress thread may be writing the queue */
+            int acquired = dlt_daemon_egress_acquire_client(&daemon_local->egress, fd);
+
+            if (dlt_connection_flush(con) != DLT_DAEMON_ERROR_OK)
+                dlt_vlog(LOG_WARNING, "Writing queued messages to %u handle type failed\n",
+                         type);
+
+            dlt_event_handler_update_output(pEvent, con);
+
+            if (acquired)
+                dlt_daemon_egress_release_client(&daemon_local->egress, fd);
+
+            if (!(pEvent->pfd[i].revents & ~POLLOUT))
+                continue;
+        }
+
         /* Get the function to be used to handle the event */
         callback = dlt_connection_get_callback(con);
 
@@ -252,10 +315,14 @@ int dlt_daemon_handle_event(DltEventHandler *pEvent,
         }
 
         /* From now on, callback is correct */
-        if (callback(daemon,
-                     daemon_local,
-                     con->receiver,
-                     daemon_local->flags.vflag) == -1) {
+        daemon_local->metrics.current = con;
+        ret = callback(daemon,
+                       daemon_local,
+                       con->receiver,
+                       daemon_local->flags.vflag);
+        daemon_local->metrics.current = NULL;
+
+        if (ret == -1) {
             dlt_vlog(LOG_CRIT, "Processing from %u handle type failed!\n",
                      type);
             return -1;
@@ -423,6 +490,11 @@ int dlt_connection_check_activate(DltEventHandler *evhdl,
                                         con->ev_mask);
 
             con->status = ACTIVE;
+
+            if (con->serial_queue != NULL) {
+                con->serial_queue->output = 0;
+                dlt_event_handler_update_output(evhdl, con);
+            }
         }
 
         break;
@@ -462,10 +534,24 @@ int dlt_event_handler_register_connection(DltEventHandler *evhdl,
 
     dlt_daemon_add_connection(evhdl, connection);
 
+    /* the ingestion threads read from the applications instead of poll */
+    if ((connection->type == DLT_CONNECTION_APP_MSG) &&
+        dlt_daemon_ingress_is_active(&daemon_local->ingress)) {
+        connection->status = ACTIVE;
+        connection->next = NULL;
+        connection->ev_mask = mask;
+
+        return dlt_daemon_ingress_add(&daemon_local->ingress, connection);
+    }
+
     if ((connection->type == DLT_CONNECTION_CLIENT_MSG_TCP) ||
-        (connection->type == DLT_CONNECTION_CLIENT_MSG_SERIAL))
+        (connection->type == DLT_CONNECTION_CLIENT_MSG_SERIAL)) {
         daemon_local->client_connections++;
 
+        if (dlt_daemon_egress_is_active(&daemon_local->egress))
+            (void)dlt_daemon_egress_add_client(&daemon_local->egress, connection);
+    }
+
     /* On creation the connection is not active by default */
     connection->status = INACTIVE;
 
@@ -510,6 +596,9 @@ int dlt_event_handler_unregister_connection(DltEventHandler *evhdl,
 
     if ((temp->type == DLT_CONNECTION_CLIENT_MSG_TCP) ||
         (temp->type == DLT_CONNECTION_CLIENT_MSG_SERIAL)) {
+        /* wait for the egress thread to stop using the connection */
+        dlt_daemon_egress_remove_client(&daemon_local->egress, temp);
+
         daemon_local->client_connections--;
 
         if (daemon_local->client_connections < 0) {
@@ -518,6 +607,14 @@ int dlt_event_handler_unregister_connection(DltEventHandler *evhdl,
         }
     }
 
+    /* wait for the ingestion thread to stop reading the connection */
+    if (temp->type == DLT_CONNECTION_APP_MSG)
+        dlt_daemon_ingress_remove(&daemon_local->ingress, temp);
+
+    /* the connection is not counted anymore while its event is handled */
+    if (daemon_local->metrics.current == temp)
+        daemon_local->metrics.current = NULL;
+
     if (dlt_connection_check_activate(evhdl,
                                       temp,
                                       DEACTIVATE) < 0)
@@ -44,6 +44,8 @@ DltConnection *dlt_event_handler_find_connection(DltEventHandler *,
 
 void dlt_event_handler_cleanup_connections(DltEventHandler *);
 
+void dlt_event_handler_update_output(DltEventHandler *, DltConnection *);
+
 int dlt_event_handler_register_connection(DltEventHandler *,
                                           DltDaemonLocal *,
                                           DltConnection *,
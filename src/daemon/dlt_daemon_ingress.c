@@ -0,0 +1,496 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_ingress.c
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "dlt_common.h"
+#include "dlt-daemon.h"
+#include "dlt_daemon_ingress.h"
+#include "dlt_daemon_latency.h"
+
+/* Sources are added in steps of this many entries */
+#define DLT_DAEMON_INGRESS_SOURCE_STEP 4
+
+static void dlt_daemon_ingress_wake(int fd)
+{
+    uint64_t value = 1;
+
+    if ((write(fd, &value, sizeof(value)) < 0) && (errno != EAGAIN))
+        dlt_vlog(LOG_WARNING, "%s: write failed: %s\n", __func__, strerror(errno));
+}
+
+/* Queue a chunk and wake the event loop. Blocks while the queue is full. */
+static void dlt_daemon_ingress_push(DltDaemonIngressShard *shard, DltDaemonIngressChunk *chunk)
+{
+    DltDaemonIngress *ingress = shard->ingress;
+    unsigned int head;
+    unsigned int depth;
+
+    while (sem_wait(&shard->slots) != 0)
+        if (errno != EINTR) {
+            free(chunk);
+            return;
+        }
+
+    /* woken up to stop */
+    if (!atomic_load(&ingress->running)) {
+        free(chunk);
+        return;
+    }
+
+    head = atomic_load(&shard->head);
+    shard->queue[head % DLT_DAEMON_INGRESS_QUEUE_SIZE] = chunk;
+    atomic_store(&shard->head, head + 1);
+
+    depth = head + 1 - atomic_load(&shard->tail);
+
+    if (depth > atomic_load(&shard->max_depth))
+        atomic_store(&shard->max_depth, depth);
+
+    if (atomic_exchange(&ingress->signalled, 1) == 0)
+        dlt_daemon_ingress_wake(ingress->event_fd);
+}
+
+/* Read from a source and take the complete messages out of its buffer.
+ * Called with the lock held. */
+static DltDaemonIngressChunk *dlt_daemon_ingress_read(DltDaemonIngressSource *source)
+{
+    DltReceiver *receiver = &source->receiver;
+    DltDaemonIngressChunk *chunk;
+    int messages = 0;
+    int offset = 0;
+    int end = 0;
+    int size;
+    int recv;
+
+    recv = dlt_receiver_receive(receiver);
+
+    if (((recv <= 0) && (receiver->type == DLT_RECEIVE_SOCKET)) || (recv < 0)) {
+        source->closed = 1;
+        chunk = calloc(1, sizeof(DltDaemonIngressChunk));
+
+        if (chunk != NULL)
+            chunk->closed = 1;
+
+        return chunk;
+    }
+
+    /* the event loop resyncs over bytes between messages as before */
+    while (offset + (int)sizeof(DltUserHeader) <= receiver->bytesRcvd) {
+        size = dlt_daemon_user_message_size(receiver->buf + offset,
+                                            receiver->bytesRcvd - offset);
+
+        if (size == 0)
+            break;
+
+        if (size < 0) {
+            offset++;
+            end = offset;
+            continue;
+        }
+
+        offset += size;
+        end = offset;
+        messages++;
+    }
+
+    chunk = NULL;
+
+    if (messages > 0) {
+        chunk = malloc(sizeof(DltDaemonIngressChunk) + (size_t)end);
+
+        if (chunk != NULL) {
+            memset(chunk, 0, sizeof(DltDaemonIngressChunk));
+            chunk->bytes = recv;
+            chunk->received = dlt_daemon_latency_now();
+            chunk->size = end;
+            memcpy(chunk->data, receiver->buf, (size_t)end);
+        }
+        else {
+            dlt_vlog(LOG_ERR, "%s: Cannot allocate chunk of %d bytes\n", __func__, end);
+        }
+    }
+
+    if (end > 0)
+        dlt_receiver_remove(receiver, end);
+
+    dlt_receiver_move_to_begin(receiver);
+
+    return chunk;
+}
+
+static void *dlt_daemon_ingress_run(void *arg)
+{
+    DltDaemonIngressShard *shard = (DltDaemonIngressShard *)arg;
+    DltDaemonIngress *ingress = shard->ingress;
+    DltDaemonIngressChunk *chunk;
+    struct pollfd *pfd = NULL;
+    struct pollfd *tmp;
+    unsigned int generation;
+    uint64_t value;
+    int max_nfds = 0;
+    int nfds;
+    int i;
+
+    for (;;) {
+        pthread_mutex_lock(&shard->lock);
+
+        if (!atomic_load(&ingress->running)) {
+            pthread_mutex_unlock(&shard->lock);
+            break;
+        }
+
+        nfds = shard->num_sources + 1;
+
+        if (nfds > max_nfds) {
+            tmp = realloc(pfd, sizeof(struct pollfd) * (size_t)nfds);
+
+            if (tmp == NULL) {
+                pthread_mutex_unlock(&shard->lock);
+                dlt_vlog(LOG_CRIT, "%s: Cannot allocate poll list\n", __func__);
+                break;
+            }
+
+            pfd = tmp;
+            max_nfds = nfds;
+        }
+
+        pfd[0].fd = shard->wake_fd;
+        pfd[0].events = POLLIN;
+
+        /* a closed source is not polled until it is removed */
+        for (i = 1; i < nfds; i++) {
+            pfd[i].fd = shard->sources[i - 1].closed ? -1 : shard->sources[i - 1].receiver.fd;
+            pfd[i].events = POLLIN;
+        }
+
+        generation = shard->generation;
+        pthread_mutex_unlock(&shard->lock);
+
+        if (poll(pfd, (nfds_t)nfds, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+
+            dlt_vlog(LOG_CRIT, "%s: poll() failed: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        if ((pfd[0].revents & POLLIN) && (read(shard->wake_fd, &value, sizeof(value)) < 0))
+            dlt_vlog(LOG_WARNING, "%s: read failed: %s\n", __func__, strerror(errno));
+
+        for (i = 1; i < nfds; i++) {
+            if (pfd[i].revents == 0)
+                continue;
+
+            pthread_mutex_lock(&shard->lock);
+
+            /* the index is only valid for the polled sources */
+            if (shard->generation != generation) {
+                pthread_mutex_unlock(&shard->lock);
+                break;
+            }
+
+            chunk = dlt_daemon_ingress_read(&shard->sources[i - 1]);
+
+            if (chunk != NULL) {
+                chunk->id = shard->sources[i - 1].id;
+                chunk->fd = shard->sources[i - 1].receiver.fd;
+            }
+
+            pthread_mutex_unlock(&shard->lock);
+
+            if (chunk != NULL)
+                dlt_daemon_ingress_push(shard, chunk);
+        }
+    }
+
+    free(pfd);
+
+    return NULL;
+}
+
+static void dlt_daemon_ingress_free_shard(DltDaemonIngressShard *shard)
+{
+    unsigned int i;
+    int j;
+
+    for (i = atomic_load(&shard->tail); i != atomic_load(&shard->head); i++)
+        free(shard->queue[i % DLT_DAEMON_INGRESS_QUEUE_SIZE]);
+
+    for (j = 0; j < shard->num_sources; j++)
+        dlt_receiver_free(&shard->sources[j].receiver);
+
+    free(shard->sources);
+    free(shard->queue);
+    sem_destroy(&shard->slots);
+    pthread_mutex_destroy(&shard->lock);
+    close(shard->wake_fd);
+}
+
+int dlt_daemon_ingress_init(DltDaemonIngress *ingress, int threads)
+{
+    DltDaemonIngressShard *shard;
+    int i;
+
+    if ((ingress == NULL) || (threads <= 0) || (threads > DLT_DAEMON_INGRESS_MAX_THREADS))
+        return -1;
+
+    memset(ingress, 0, sizeof(DltDaemonIngress));
+    atomic_init(&ingress->signalled, 0);
+    atomic_init(&ingress->running, 1);
+
+    ingress->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (ingress->event_fd < 0) {
+        dlt_vlog(LOG_ERR, "%s: eventfd failed: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+
+    ingress->shards = calloc((size_t)threads, sizeof(DltDaemonIngressShard));
+
+    if (ingress->shards == NULL) {
+        dlt_vlog(LOG_ERR, "%s: Cannot allocate %d ingestion threads\n", __func__, threads);
+        close(ingress->event_fd);
+        return -1;
+    }
+
+    for (i = 0; i < threads; i++) {
+        shard = &ingress->shards[i];
+        shard->ingress = ingress;
+        atomic_init(&shard->head, 0);
+        atomic_init(&shard->tail, 0);
+        atomic_init(&shard->max_depth, 0);
+        shard->queue = calloc(DLT_DAEMON_INGRESS_QUEUE_SIZE, sizeof(DltDaemonIngressChunk *));
+        shard->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if ((shard->queue == NULL) || (shard->wake_fd < 0) ||
+            (pthread_mutex_init(&shard->lock, NULL) != 0) ||
+            (sem_init(&shard->slots, 0, DLT_DAEMON_INGRESS_QUEUE_SIZE) != 0) ||
+            (pthread_create(&shard->thread, NULL, dlt_daemon_ingress_run, shard) != 0)) {
+            dlt_vlog(LOG_ERR, "%s: Cannot create ingestion thread %d\n", __func__, i);
+            /* the threads already running are stopped and freed */
+            free(shard->queue);
+
+            if (shard->wake_fd >= 0)
+                close(shard->wake_fd);
+
+            dlt_daemon_ingress_free(ingress);
+            close(ingress->event_fd);
+            return -1;
+        }
+
+        ingress->num_shards++;
+    }
+
+    return 0;
+}
+
+void dlt_daemon_ingress_free(DltDaemonIngress *ingress)
+{
+    int i;
+
+    if ((ingress == NULL) || (ingress->shards == NULL))
+        return;
+
+    /* a thread waiting for a free entry is released as well */
+    atomic_store(&ingress->running, 0);
+
+    for (i = 0; i < ingress->num_shards; i++) {
+        dlt_daemon_ingress_wake(ingress->shards[i].wake_fd);
+        sem_post(&ingress->shards[i].slots);
+    }
+
+    for (i = 0; i < ingress->num_shards; i++) {
+        pthread_join(ingress->shards[i].thread, NULL);
+        dlt_daemon_ingress_free_shard(&ingress->shards[i]);
+    }
+
+    free(ingress->shards);
+    ingress->shards = NULL;
+    ingress->num_shards = 0;
+}
+
+int dlt_daemon_ingress_is_active(DltDaemonIngress *ingress)
+{
+    return (ingress != NULL) && (ingress->shards != NULL);
+}
+
+int dlt_daemon_ingress_add(DltDaemonIngress *ingress, DltConnection *con)
+{
+    DltDaemonIngressShard *shard;
+    DltDaemonIngressSource *sources;
+    DltDaemonIngressSource *source;
+
+    if ((ingress == NULL) || (ingress->shards == NULL) || (con == NULL) || (con->receiver == NULL))
+        return -1;
+
+    shard = &ingress->shards[con->id % (DltConnectionId)ingress->num_shards];
+
+    pthread_mutex_lock(&shard->lock);
+
+    if (shard->num_sources == shard->max_sources) {
+        sources = realloc(shard->sources,
+                          sizeof(DltDaemonIngressSource) *
+                          (size_t)(shard->max_sources + DLT_DAEMON_INGRESS_SOURCE_STEP));
+
+        if (sources == NULL) {
+            pthread_mutex_unlock(&shard->lock);
+            dlt_vlog(LOG_ERR, "%s: Cannot allocate source entry\n", __func__);
+            return -1;
+        }
+
+        shard->sources = sources;
+        shard->max_sources += DLT_DAEMON_INGRESS_SOURCE_STEP;
+    }
+
+    source = &shard->sources[shard->num_sources];
+    memset(source, 0, sizeof(DltDaemonIngressSource));
+    source->id = con->id;
+
+    /* each source keeps its partial messages in its own buffer */
+    if (dlt_receiver_init(&source->receiver,
+                          con->receiver->fd,
+                          con->receiver->type,
+                          DLT_RECEIVE_BUFSIZE) != DLT_RETURN_OK) {
+        pthread_mutex_unlock(&shard->lock);
+        return -1;
+    }
+
+    shard->num_sources++;
+    shard->generation++;
+
+    pthread_mutex_unlock(&shard->lock);
+
+    dlt_daemon_ingress_wake(shard->wake_fd);
+
+    return 0;
+}
+
+void dlt_daemon_ingress_remove(DltDaemonIngress *ingress, DltConnection *con)
+{
+    DltDaemonIngressShard *shard;
+    int i;
+
+    if ((ingress == NULL) || (ingress->shards == NULL) || (con == NULL))
+        return;
+
+    shard = &ingress->shards[con->id % (DltConnectionId)ingress->num_shards];
+
+    /* the lock is held while the thread reads */
+    pthread_mutex_lock(&shard->lock);
+
+    for (i = 0; i < shard->num_sources; i++) {
+        if (shard->sources[i].id != con->id)
+            continue;
+
+        dlt_receiver_free(&shard->sources[i].receiver);
+        shard->num_sources--;
+        memmove(&shard->sources[i],
+                &shard->sources[i + 1],
+                sizeof(DltDaemonIngressSource) * (size_t)(shard->num_sources - i));
+        shard->generation++;
+        break;
+    }
+
+    pthread_mutex_unlock(&shard->lock);
+
+    dlt_daemon_ingress_wake(shard->wake_fd);
+}
+
+void dlt_daemon_ingress_clear(DltDaemonIngress *ingress)
+{
+    uint64_t value;
+
+    if ((ingress == NULL) || (ingress->shards == NULL))
+        return;
+
+    if ((read(ingress->event_fd, &value, sizeof(value)) < 0) && (errno != EAGAIN))
+        dlt_vlog(LOG_WARNING, "%s: read failed: %s\n", __func__, strerror(errno));
+
+    atomic_store(&ingress->signalled, 0);
+}
+
+DltDaemonIngressChunk *dlt_daemon_ingress_pop(DltDaemonIngress *ingress)
+{
+    DltDaemonIngressShard *shard;
+    DltDaemonIngressChunk *chunk;
+    unsigned int tail;
+    int i;
+
+    if ((ingress == NULL) || (ingress->shards == NULL))
+        return NULL;
+
+    for (i = 0; i < ingress->num_shards; i++) {
+        shard = &ingress->shards[(ingress->next + i) % ingress->num_shards];
+        tail = atomic_load(&shard->tail);
+
+        if (tail == atomic_load(&shard->head))
+            continue;
+
+        chunk = shard->queue[tail % DLT_DAEMON_INGRESS_QUEUE_SIZE];
+        atomic_store(&shard->tail, tail + 1);
+        sem_post(&shard->slots);
+
+        ingress->next = (ingress->next + i + 1) % ingress->num_shards;
+
+        return chunk;
+    }
+
+    return NULL;
+}
+
+void dlt_daemon_ingress_rearm(DltDaemonIngress *ingress)
+{
+    int i;
+
+    if ((ingress == NULL) || (ingress->shards == NULL))
+        return;
+
+    for (i = 0; i < ingress->num_shards; i++)
+        if (atomic_load(&ingress->shards[i].tail) != atomic_load(&ingress->shards[i].head)) {
+            if (atomic_exchange(&ingress->signalled, 1) == 0)
+                dlt_daemon_ingress_wake(ingress->event_fd);
+
+            return;
+        }
+}
+
+void dlt_daemon_ingress_log_stats(DltDaemonIngress *ingress)
+{
+    int i;
+
+    if ((ingress == NULL) || (ingress->shards == NULL))
+        return;
+
+    for (i = 0; i < ingress->num_shards; i++)
+        dlt_vlog(LOG_INFO,
+                 "Ingestion thread %d: %d connections, queue depth %u (max %u of %u)\n",
+                 i,
+                 ingress->shards[i].num_sources,
+                 atomic_load(&ingress->shards[i].head) - atomic_load(&ingress->shards[i].tail),
+                 atomic_load(&ingress->shards[i].max_depth),
+                 DLT_DAEMON_INGRESS_QUEUE_SIZE);
+}
@@ -0,0 +1,203 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_ingress.h
+ */
+
+#ifndef DLT_DAEMON_INGRESS_H
+#define DLT_DAEMON_INGRESS_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "dlt_common.h"
+#include "dlt_daemon_connection_types.h"
+
+#define DLT_DAEMON_INGRESS_THREADS     1  /* Default number of ingestion threads */
+#define DLT_DAEMON_INGRESS_MAX_THREADS 16 /* Max number of ingestion threads */
+#define DLT_DAEMON_INGRESS_QUEUE_SIZE  64 /* Chunks queued per ingestion thread */
+#define DLT_DAEMON_INGRESS_BATCH_SIZE  64 /* Max chunks routed per event */
+
+/**
+ * Complete user messages read from one application connection.
+ */
+typedef struct
+{
+    DltConnectionId id;     /**< connection the messages were read from */
+    int fd;                 /**< file descriptor of the connection */
+    int closed;             /**< 1: the connection was closed or reading failed */
+    int bytes;              /**< bytes read from the connection */
+    uint64_t received;      /**< time the messages were read */
+    int size;               /**< size of data */
+    unsigned char data[];   /**< user messages */
+} DltDaemonIngressChunk;
+
+/**
+ * An application connection read by an ingestion thread.
+ */
+typedef struct
+{
+    DltConnectionId id;     /**< connection owned by the event handler */
+    int closed;             /**< reading stopped, the event loop closes it */
+    DltReceiver receiver;   /**< private receive buffer of the connection */
+} DltDaemonIngressSource;
+
+struct DltDaemonIngress;
+
+/**
+ * One ingestion thread and the queue it feeds.
+ */
+typedef struct
+{
+    pthread_t thread;                   /**< ingestion thread */
+    struct DltDaemonIngress *ingress;   /**< ingress the thread belongs to */
+    pthread_mutex_t lock;               /**< protects the sources, held while reading */
+    int wake_fd;                        /**< eventfd written when the sources change */
+    DltDaemonIngressSource *sources;    /**< connections read by the thread */
+    int num_sources;                    /**< number of sources */
+    int max_sources;                    /**< allocated source entries */
+    unsigned int generation;            /**< changed when a source is added or removed */
+    sem_t slots;                        /**< number of free queue entries */
+    DltDaemonIngressChunk **queue;      /**< queued chunks */
+    atomic_uint head;                   /**< total number of queued chunks */
+    atomic_uint tail;                   /**< total number of routed chunks */
+    atomic_uint max_depth;              /**< highest queue depth seen */
+} DltDaemonIngressShard;
+
+/**
+ * Ingestion stage of the pipelined mode.
+ *
+ * Each application connection is read by one of the ingestion threads,
+ * chosen by its connection id. The thread receives from the connection,
+ * cuts the received data after the last complete user message and queues
+ * these messages. Each thread is the only producer of its queue, the event
+ * loop, which routes the messages, the only consumer. Head and tail are
+ * updated without lock; a full queue blocks the thread, so nothing is
+ * dropped and a slow event loop slows down the applications as before.
+ *
+ * The threads wake the event loop through an eventfd it polls like any
+ * other connection. It is only written when the flag signalled was not
+ * set yet, so a burst of chunks costs one write. The event loop clears the
+ * flag before it takes chunks, and raises it again when it leaves chunks
+ * for the next event.
+ *
+ * Ordering guarantees:
+ * - A connection is read by one thread only and its chunks are queued and
+ *   routed in the order they were read, so the messages of one application
+ *   keep their order. Messages of different threads are interleaved.
+ * - The close of a connection is queued after its last chunk.
+ * - The egress stage keeps the order of the event loop, see
+ *   DltDaemonEgress.
+ *
+ * Only reading and framing run on the ingestion threads. Parsing and
+ * routing stay on the event loop, because the handlers update the
+ * application and context tables without locking. With FIFO IPC all
+ * applications share one connection and thus one ingestion thread; more
+ * threads only help with UNIX socket IPC.
+ *
+ * The lock of a thread is held while it reads, not while it waits for a
+ * free queue entry. When dlt_daemon_ingress_remove() returns, the thread
+ * does not read the connection anymore. Chunks of a removed connection
+ * still queued are recognised by the connection id and dropped.
+ */
+typedef struct DltDaemonIngress
+{
+    DltDaemonIngressShard *shards;      /**< ingestion threads */
+    int num_shards;                     /**< number of ingestion threads */
+    int next;                           /**< thread the next chunk is taken from */
+    int event_fd;                       /**< eventfd polled by the event loop */
+    atomic_int signalled;               /**< event_fd was written and not handled yet */
+    atomic_int running;                 /**< cleared to stop the threads */
+} DltDaemonIngress;
+
+/**
+ * Initialise the ingestion stage and start its threads. The event loop has
+ * to poll event_fd, the connection created for it closes the descriptor.
+ *
+ * @param ingress ingress to initialise
+ * @param threads number of ingestion threads
+ * @return 0 on success, -1 on error
+ */
+int dlt_daemon_ingress_init(DltDaemonIngress *ingress, int threads);
+
+/**
+ * Stop the ingestion threads and free the ingress. Chunks not routed yet
+ * are dropped.
+ *
+ * @param ingress ingress to free
+ */
+void dlt_daemon_ingress_free(DltDaemonIngress *ingress);
+
+/**
+ * Check if the ingestion threads are running.
+ *
+ * @param ingress ingress
+ * @return 1 if the applications are read by the ingestion threads, 0 otherwise
+ */
+int dlt_daemon_ingress_is_active(DltDaemonIngress *ingress);
+
+/**
+ * Read an application connection on an ingestion thread.
+ *
+ * @param ingress ingress
+ * @param con application connection
+ * @return 0 on success, -1 on error
+ */
+int dlt_daemon_ingress_add(DltDaemonIngress *ingress, DltConnection *con);
+
+/**
+ * Stop reading an application connection. When this function returns, no
+ * ingestion thread uses the connection anymore.
+ *
+ * @param ingress ingress
+ * @param con application connection
+ */
+void dlt_daemon_ingress_remove(DltDaemonIngress *ingress, DltConnection *con);
+
+/**
+ * Acknowledge the wake up of the event loop, before taking chunks.
+ *
+ * @param ingress ingress
+ */
+void dlt_daemon_ingress_clear(DltDaemonIngress *ingress);
+
+/**
+ * Take the next chunk, taking from the threads in turn. The caller frees
+ * the chunk.
+ *
+ * @param ingress ingress
+ * @return chunk, NULL if all queues are empty
+ */
+DltDaemonIngressChunk *dlt_daemon_ingress_pop(DltDaemonIngress *ingress);
+
+/**
+ * Wake the event loop again if chunks are left in the queues.
+ *
+ * @param ingress ingress
+ */
+void dlt_daemon_ingress_rearm(DltDaemonIngress *ingress);
+
+/**
+ * Log the queue depths of the ingestion threads.
+ *
+ * @param ingress ingress
+ */
+void dlt_daemon_ingress_log_stats(DltDaemonIngress *ingress);
+
+#endif /* DLT_DAEMON_INGRESS_H */
@@ -0,0 +1,216 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_latency.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+
+#include "dlt_common.h"
+#include "dlt_daemon_latency.h"
+
+/* Applications are added in steps of this many entries */
+#define DLT_DAEMON_LATENCY_APP_STEP 8
+
+/* Index of the bucket counting value */
+static int dlt_daemon_latency_bucket(uint64_t value)
+{
+    int msb;
+
+    if (value >= (1ULL << DLT_DAEMON_LATENCY_MAX_BITS))
+        value = (1ULL << DLT_DAEMON_LATENCY_MAX_BITS) - 1;
+
+    if (value < (1ULL << DLT_DAEMON_LATENCY_SUB_BITS))
+        return (int)value;
+
+    msb = 63 - __builtin_clzll(value);
+
+    return ((msb - DLT_DAEMON_LATENCY_SUB_BITS + 1) << DLT_DAEMON_LATENCY_SUB_BITS) |
+           (int)((value >> (msb - DLT_DAEMON_LATENCY_SUB_BITS)) & ((1 << DLT_DAEMON_LATENCY_SUB_BITS) - 1));
+}
+
+/* Highest value counted in bucket index */
+static uint64_t dlt_daemon_latency_bucket_value(int index)
+{
+    int msb;
+    uint64_t sub;
+
+    if (index < (1 << DLT_DAEMON_LATENCY_SUB_BITS))
+        return (uint64_t)index;
+
+    msb = (index >> DLT_DAEMON_LATENCY_SUB_BITS) + DLT_DAEMON_LATENCY_SUB_BITS - 1;
+    sub = (uint64_t)(index & ((1 << DLT_DAEMON_LATENCY_SUB_BITS) - 1));
+
+    return ((((1ULL << DLT_DAEMON_LATENCY_SUB_BITS) | sub) + 1) << (msb - DLT_DAEMON_LATENCY_SUB_BITS)) - 1;
+}
+
+/* Value below which percent of the counted latencies are */
+static uint64_t dlt_daemon_latency_percentile(const DltDaemonLatencyHistogram *hist, uint32_t percent)
+{
+    uint64_t target;
+    uint64_t sum = 0;
+    uint64_t value;
+    int i;
+
+    if (hist->count == 0)
+        return 0;
+
+    target = ((uint64_t)hist->count * percent + 99) / 100;
+
+    for (i = 0; i < DLT_DAEMON_LATENCY_BUCKETS; i++) {
+        sum += hist->buckets[i];
+
+        if (sum >= target) {
+            value = dlt_daemon_latency_bucket_value(i);
+            return (value < hist->max) ? value : hist->max;
+        }
+    }
+
+    return hist->max;
+}
+
+static void dlt_daemon_latency_add(DltDaemonLatencyHistogram *hist, uint64_t value)
+{
+    hist->buckets[dlt_daemon_latency_bucket(value)]++;
+    hist->count++;
+
+    if (value > hist->max)
+        hist->max = value;
+}
+
+static DltDaemonLatencyApp *dlt_daemon_latency_find_app(DltDaemonLatency *latency, const char *apid)
+{
+    DltDaemonLatencyApp *apps;
+    char id[DLT_ID_SIZE] = { 0 };
+    int i;
+
+    if (apid != NULL)
+        memcpy(id, apid, DLT_ID_SIZE);
+
+    if ((latency->last_app < latency->num_apps) &&
+        (memcmp(latency->apps[latency->last_app].apid, id, DLT_ID_SIZE) == 0))
+        return &(latency->apps[latency->last_app]);
+
+    for (i = 0; i < latency->num_apps; i++)
+        if (memcmp(latency->apps[i].apid, id, DLT_ID_SIZE) == 0) {
+            latency->last_app = i;
+            return &(latency->apps[i]);
+        }
+
+    if (latency->num_apps >= DLT_DAEMON_LATENCY_MAX_APPS)
+        return NULL;
+
+    if ((latency->num_apps % DLT_DAEMON_LATENCY_APP_STEP) == 0) {
+        apps = realloc(latency->apps,
+                       sizeof(DltDaemonLatencyApp) * (size_t)(latency->num_apps + DLT_DAEMON_LATENCY_APP_STEP));
+
+        if (apps == NULL) {
+            dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+            return NULL;
+        }
+
+        latency->apps = apps;
+    }
+
+    memset(&(latency->apps[latency->num_apps]), 0, sizeof(DltDaemonLatencyApp));
+    memcpy(latency->apps[latency->num_apps].apid, id, DLT_ID_SIZE);
+    latency->last_app = latency->num_apps;
+
+    return &(latency->apps[latency->num_apps++]);
+}
+
+uint64_t dlt_daemon_latency_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void dlt_daemon_latency_free(DltDaemonLatency *latency)
+{
+    if (latency == NULL)
+        return;
+
+    free(latency->apps);
+    memset(latency, 0, sizeof(DltDaemonLatency));
+}
+
+void dlt_daemon_latency_begin(DltDaemonLatency *latency, uint64_t logged, uint64_t received)
+{
+    if (latency == NULL)
+        return;
+
+    memset(latency->stamps, 0, sizeof(latency->stamps));
+    latency->logged = logged;
+    latency->stamps[DLT_LATENCY_STAGE_RECEIVE] = received;
+    latency->active = 1;
+}
+
+void dlt_daemon_latency_stamp(DltDaemonLatency *latency, DltLatencyStage stage)
+{
+    if ((latency == NULL) || !latency->active || (stage >= DLT_LATENCY_STAGE_COUNT))
+        return;
+
+    if (latency->stamps[stage] == 0)
+        latency->stamps[stage] = dlt_daemon_latency_now();
+}
+
+void dlt_daemon_latency_end(DltDaemonLatency *latency, const char *apid)
+{
+    DltDaemonLatencyApp *app;
+    uint64_t prev, end;
+    int stage;
+
+    if ((latency == NULL) || !latency->active)
+        return;
+
+    latency->active = 0;
+    latency->stamps[DLT_LATENCY_STAGE_SEND] = dlt_daemon_latency_now();
+
+    app = dlt_daemon_latency_find_app(latency, apid);
+
+    if (app == NULL)
+        return;
+
+    /* a stage without stamp took no time, the clocks of application and
+     * daemon are the same, but guard against stamps from the future */
+    prev = latency->logged;
+
+    for (stage = DLT_LATENCY_STAGE_RECEIVE; stage < DLT_LATENCY_STAGE_TOTAL; stage++) {
+        end = (latency->stamps[stage] > prev) ? latency->stamps[stage] : prev;
+        dlt_daemon_latency_add(&(app->stages[stage]), end - prev);
+        prev = end;
+    }
+
+    dlt_daemon_latency_add(&(app->stages[DLT_LATENCY_STAGE_TOTAL]), prev - latency->logged);
+}
+
+void dlt_daemon_latency_get_stage(const DltDaemonLatencyHistogram *hist, DltServiceLatencyStage *stage)
+{
+    if ((hist == NULL) || (stage == NULL))
+        return;
+
+    stage->count = hist->count;
+    stage->p50 = dlt_daemon_latency_percentile(hist, 50);
+    stage->p99 = dlt_daemon_latency_percentile(hist, 99);
+    stage->max = hist->max;
+}
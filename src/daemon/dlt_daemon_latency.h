@@ -0,0 +1,133 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_latency.h
+ */
+
+#ifndef DLT_DAEMON_LATENCY_H
+#define DLT_DAEMON_LATENCY_H
+
+#include <stdint.h>
+
+#include "dlt_common.h"
+
+/* Each power of two is split in 2^DLT_DAEMON_LATENCY_SUB_BITS buckets,
+ * so a bucket is at most 12.5% wide. */
+#define DLT_DAEMON_LATENCY_SUB_BITS 3
+/* Latencies of 2^DLT_DAEMON_LATENCY_MAX_BITS ns (about 68 s) and more are
+ * counted in the last bucket. */
+#define DLT_DAEMON_LATENCY_MAX_BITS 36
+#define DLT_DAEMON_LATENCY_BUCKETS \
+    ((DLT_DAEMON_LATENCY_MAX_BITS - DLT_DAEMON_LATENCY_SUB_BITS + 1) << DLT_DAEMON_LATENCY_SUB_BITS)
+
+/* Max number of applications with latency histograms */
+#define DLT_DAEMON_LATENCY_MAX_APPS 256
+
+/**
+ * Log-linear latency histogram of one stage, in ns.
+ */
+typedef struct
+{
+    uint32_t buckets[DLT_DAEMON_LATENCY_BUCKETS];
+    uint32_t count;                     /**< number of messages */
+    uint64_t max;                       /**< highest latency */
+} DltDaemonLatencyHistogram;
+
+/**
+ * Latency histograms of the messages of one application.
+ */
+typedef struct
+{
+    char apid[DLT_ID_SIZE];                                     /**< application id */
+    DltDaemonLatencyHistogram stages[DLT_LATENCY_STAGE_COUNT];  /**< histogram per stage */
+} DltDaemonLatencyApp;
+
+/**
+ * Latency trace of the log messages stamped by libdlt.
+ *
+ * The application stamps each message with the monotonic time it was
+ * finished. The daemon takes the time when the message was received from
+ * the FIFO or socket, when it was parsed, when it was routed to offline
+ * trace and logstorage and when it was sent. The histograms are only
+ * allocated once the first stamped message arrives.
+ *
+ * In pipelined mode the send stage ends when the message is queued for the
+ * egress thread.
+ */
+typedef struct
+{
+    DltDaemonLatencyApp *apps;          /**< histograms per application */
+    int num_apps;                       /**< number of applications */
+    int last_app;                       /**< application of the last message */
+    uint64_t received;                  /**< time the last data was received */
+    int active;                         /**< 1 while a stamped message is processed */
+    uint64_t stamps[DLT_LATENCY_STAGE_COUNT]; /**< end time of each stage of the message */
+    uint64_t logged;                    /**< time the message was finished in the application */
+} DltDaemonLatency;
+
+/**
+ * Get the monotonic time in ns, comparable with the stamps of libdlt.
+ *
+ * @return time in ns
+ */
+uint64_t dlt_daemon_latency_now(void);
+
+/**
+ * Free all histograms.
+ *
+ * @param latency latency trace
+ */
+void dlt_daemon_latency_free(DltDaemonLatency *latency);
+
+/**
+ * Start the trace of a stamped message.
+ *
+ * @param latency latency trace
+ * @param logged time the message was finished in the application
+ * @param received time the message was received
+ */
+void dlt_daemon_latency_begin(DltDaemonLatency *latency, uint64_t logged, uint64_t received);
+
+/**
+ * Take the end time of a stage of the traced message.
+ * Only the first call per stage counts, nothing is done if no message is
+ * traced.
+ *
+ * @param latency latency trace
+ * @param stage stage which ends now
+ */
+void dlt_daemon_latency_stamp(DltDaemonLatency *latency, DltLatencyStage stage);
+
+/**
+ * End the trace of a message and add its stage latencies to the
+ * histograms of its application.
+ *
+ * @param latency latency trace
+ * @param apid application id of the message, NULL if it has none
+ */
+void dlt_daemon_latency_end(DltDaemonLatency *latency, const char *apid);
+
+/**
+ * Fill the latency of one stage of an application for the Get Latency
+ * Stats response.
+ *
+ * @param hist histogram of the stage
+ * @param stage response entry to fill
+ */
+void dlt_daemon_latency_get_stage(const DltDaemonLatencyHistogram *hist, DltServiceLatencyStage *stage);
+
+#endif /* DLT_DAEMON_LATENCY_H */
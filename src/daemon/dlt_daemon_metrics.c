@@ -0,0 +1,734 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_metrics.c
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "dlt_common.h"
+#include "dlt-daemon.h"
+#include "dlt_daemon_connection.h"
+#include "dlt_daemon_latency.h"
+#include "dlt_daemon_metrics.h"
+#include "dlt_daemon_offline_logstorage_worker.h"
+#include "dlt_daemon_ringbuffer.h"
+#include "dlt_daemon_unix_socket.h"
+#include "dlt_offline_logstorage_behavior.h"
+
+/* Initial size of the snapshot text */
+#define DLT_DAEMON_METRICS_TEXT_SIZE 16384
+/* Time a client of the metrics socket may take to read the snapshot */
+#define DLT_DAEMON_METRICS_SEND_TIMEOUT_US 100000
+
+/* Connections whose traffic is reported */
+#define DLT_DAEMON_METRICS_CON_MASK \
+    (DLT_CON_MASK_CLIENT_MSG_TCP | DLT_CON_MASK_CLIENT_MSG_SERIAL | DLT_CON_MASK_APP_MSG | \
+     DLT_CON_MASK_CONTROL_MSG | DLT_CON_MASK_GATEWAY)
+
+static const char *const dlt_daemon_metrics_reason[DLT_DAEMON_DROP_REASON_MAX] = {
+    [DLT_DAEMON_DROP_BUFFER_FULL] = "buffer_full",
+    [DLT_DAEMON_DROP_RATE_LIMIT] = "rate_limit",
+    [DLT_DAEMON_DROP_RATE_LIMIT_USER] = "rate_limit_user",
+    [DLT_DAEMON_DROP_CLIENT_SLOW] = "client_slow",
+    [DLT_DAEMON_DROP_LOGSTORAGE] = "logstorage"
+};
+
+static const char *const dlt_daemon_metrics_class[DLT_DAEMON_RINGBUFFER_CLASS_MAX] = {
+    [DLT_DAEMON_RINGBUFFER_CLASS_HIGH] = "high",
+    [DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM] = "medium",
+    [DLT_DAEMON_RINGBUFFER_CLASS_LOW] = "low"
+};
+
+static const char *const dlt_daemon_metrics_con_type[DLT_CONNECTION_TYPE_MAX] = {
+    [DLT_CONNECTION_CLIENT_MSG_TCP] = "client_tcp",
+    [DLT_CONNECTION_CLIENT_MSG_SERIAL] = "client_serial",
+    [DLT_CONNECTION_APP_MSG] = "application",
+    [DLT_CONNECTION_CONTROL_MSG] = "control",
+    [DLT_CONNECTION_GATEWAY] = "gateway"
+};
+
+/**
+ * Counters of one application summed over all threads.
+ */
+typedef struct
+{
+    char apid[DLT_ID_SIZE];
+    uint64_t messages;
+    uint64_t bytes;
+    uint64_t drops[DLT_DAEMON_DROP_REASON_MAX];
+    uint32_t rate;
+} DltDaemonMetricsAppSum;
+
+/**
+ * Growing text buffer of a snapshot, buf is NULL after an allocation error.
+ */
+typedef struct
+{
+    char *buf;
+    int size;
+    int len;
+} DltDaemonMetricsText;
+
+static unsigned int dlt_daemon_metrics_hash(const char *apid)
+{
+    uint32_t id;
+
+    memcpy(&id, apid, DLT_ID_SIZE);
+
+    return ((id * 2654435761U) >> 16) & (DLT_DAEMON_METRICS_MAX_APPS - 1);
+}
+
+/* Get the counters of an application, only called by the owning thread */
+static DltDaemonMetricsApp *dlt_daemon_metrics_find_app(DltDaemonMetricsThread *thread, const char *apid)
+{
+    DltDaemonMetricsApp *app;
+    unsigned int index;
+    unsigned int i;
+
+    if ((apid == NULL) || (apid[0] == '\0'))
+        return &(thread->other);
+
+    if ((thread->last != NULL) && (memcmp(thread->last->apid, apid, DLT_ID_SIZE) == 0))
+        return thread->last;
+
+    index = dlt_daemon_metrics_hash(apid);
+
+    for (i = 0; i < DLT_DAEMON_METRICS_MAX_APPS; i++) {
+        app = &(thread->apps[(index + i) & (DLT_DAEMON_METRICS_MAX_APPS - 1)]);
+
+        if (!atomic_load_explicit(&app->used, memory_order_relaxed)) {
+            /* readers only look at the apid once used is set */
+            memcpy(app->apid, apid, DLT_ID_SIZE);
+            atomic_store_explicit(&app->used, 1, memory_order_release);
+        }
+        else if (memcmp(app->apid, apid, DLT_ID_SIZE) != 0) {
+            continue;
+        }
+
+        thread->last = app;
+
+        return app;
+    }
+
+    return &(thread->other);
+}
+
+void dlt_daemon_metrics_init(DltDaemonMetrics *metrics)
+{
+    if (metrics == NULL)
+        return;
+
+    memset(metrics, 0, sizeof(DltDaemonMetrics));
+    metrics->rate_time = dlt_daemon_latency_now();
+}
+
+const char *dlt_daemon_metrics_get_apid(const uint8_t *header, int size)
+{
+    const DltStandardHeader *standard = (const DltStandardHeader *)header;
+    int offset;
+
+    if ((header == NULL) || (size < (int)sizeof(DltStandardHeader)) ||
+        !DLT_IS_HTYP_UEH(standard->htyp))
+        return NULL;
+
+    offset = (int)(sizeof(DltStandardHeader) + DLT_STANDARD_HEADER_EXTRA_SIZE(standard->htyp));
+
+    if (size < offset + (int)sizeof(DltExtendedHeader))
+        return NULL;
+
+    return ((const DltExtendedHeader *)(header + offset))->apid;
+}
+
+void dlt_daemon_metrics_received(DltDaemonMetrics *metrics, int bytes)
+{
+    if ((metrics == NULL) || (metrics->current == NULL) || (bytes <= 0))
+        return;
+
+    atomic_fetch_add_explicit(&metrics->current->bytes_in, (uint64_t)bytes, memory_order_relaxed);
+}
+
+void dlt_daemon_metrics_message_received(DltDaemonMetrics *metrics)
+{
+    if ((metrics == NULL) || (metrics->current == NULL))
+        return;
+
+    atomic_fetch_add_explicit(&metrics->current->messages_in, 1, memory_order_relaxed);
+}
+
+void dlt_daemon_metrics_log(DltDaemonMetrics *metrics, DltMessage *msg)
+{
+    DltDaemonMetricsApp *app;
+
+    if ((metrics == NULL) || (msg == NULL) || (msg->standardheader == NULL))
+        return;
+
+    app = dlt_daemon_metrics_find_app(&(metrics->main),
+                                      DLT_IS_HTYP_UEH(msg->standardheader->htyp) ?
+                                      msg->extendedheader->apid : NULL);
+
+    DLT_DAEMON_METRICS_ADD(app->messages, 1);
+    DLT_DAEMON_METRICS_ADD(app->bytes,
+                           (uint64_t)(msg->headersize - sizeof(DltStorageHeader) + msg->datasize));
+}
+
+void dlt_daemon_metrics_drop(DltDaemonMetricsThread *thread, const char *apid, DltDaemonDropReason reason)
+{
+    DltDaemonMetricsApp *app;
+
+    if ((thread == NULL) || (reason >= DLT_DAEMON_DROP_REASON_MAX))
+        return;
+
+    app = dlt_daemon_metrics_find_app(thread, apid);
+
+    DLT_DAEMON_METRICS_ADD(app->drops[reason], 1);
+}
+
+void dlt_daemon_metrics_drop_count(DltDaemonMetricsThread *thread,
+                                   const char *apid,
+                                   DltDaemonDropReason reason,
+                                   uint32_t count)
+{
+    DltDaemonMetricsApp *app;
+
+    if ((thread == NULL) || (reason >= DLT_DAEMON_DROP_REASON_MAX) || (count == 0))
+        return;
+
+    app = dlt_daemon_metrics_find_app(thread, apid);
+
+    DLT_DAEMON_METRICS_ADD(app->drops[reason], count);
+}
+
+void dlt_daemon_metrics_loop_begin(DltDaemonMetrics *metrics)
+{
+    if (metrics != NULL)
+        metrics->loop_start = dlt_daemon_latency_now();
+}
+
+void dlt_daemon_metrics_loop_end(DltDaemonMetrics *metrics)
+{
+    uint64_t duration;
+
+    if ((metrics == NULL) || (metrics->loop_start == 0))
+        return;
+
+    duration = dlt_daemon_latency_now() - metrics->loop_start;
+    metrics->loop_start = 0;
+    metrics->loop_count++;
+    metrics->loop_sum += duration;
+
+    if (duration > metrics->loop_max)
+        metrics->loop_max = duration;
+}
+
+static void dlt_daemon_metrics_update_rate(DltDaemonMetricsApp *app, uint64_t elapsed)
+{
+    uint64_t messages = DLT_DAEMON_METRICS_GET(app->messages);
+
+    app->rate = (uint32_t)((messages - app->last_messages) * 1000000000ULL / elapsed);
+    app->last_messages = messages;
+}
+
+void dlt_daemon_metrics_update_rates(DltDaemonMetrics *metrics)
+{
+    uint64_t now;
+    int i;
+
+    if (metrics == NULL)
+        return;
+
+    now = dlt_daemon_latency_now();
+
+    if (now <= metrics->rate_time)
+        return;
+
+    for (i = 0; i < DLT_DAEMON_METRICS_MAX_APPS; i++)
+        if (atomic_load_explicit(&metrics->main.apps[i].used, memory_order_relaxed))
+            dlt_daemon_metrics_update_rate(&(metrics->main.apps[i]), now - metrics->rate_time);
+
+    dlt_daemon_metrics_update_rate(&(metrics->main.other), now - metrics->rate_time);
+    metrics->rate_time = now;
+}
+
+static void dlt_daemon_metrics_printf(DltDaemonMetricsText *text, const char *format, ...)
+{
+    va_list args;
+    char *buf;
+    int len;
+
+    while (text->buf != NULL) {
+        va_start(args, format);
+        len = vsnprintf(text->buf + text->len, (size_t)(text->size - text->len), format, args);
+        va_end(args);
+
+        if (len < 0)
+            return;
+
+        if (text->len + len < text->size) {
+            text->len += len;
+            return;
+        }
+
+        buf = realloc(text->buf, (size_t)(text->size * 2 + len));
+
+        if (buf == NULL) {
+            dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+            free(text->buf);
+            text->buf = NULL;
+            return;
+        }
+
+        text->buf = buf;
+        text->size = text->size * 2 + len;
+    }
+}
+
+static void dlt_daemon_metrics_family(DltDaemonMetricsText *text,
+                                      const char *name,
+                                      const char *type,
+                                      const char *help)
+{
+    dlt_daemon_metrics_printf(text, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* Application id as label value, escaped as the text format requires */
+static void dlt_daemon_metrics_apid_label(const char *apid, char *label)
+{
+    int i;
+
+    for (i = 0; (i < DLT_ID_SIZE) && (apid[i] != '\0'); i++) {
+        if ((apid[i] == '"') || (apid[i] == '\\'))
+            *label++ = '\\';
+
+        *label++ = ((apid[i] >= ' ') && (apid[i] <= '~')) ? apid[i] : '?';
+    }
+
+    *label = '\0';
+}
+
+/* Add the counters of one thread to the sums per application */
+static void dlt_daemon_metrics_sum_app(DltDaemonMetricsAppSum *sums,
+                                       int *num_sums,
+                                       int max_sums,
+                                       DltDaemonMetricsApp *app)
+{
+    DltDaemonMetricsAppSum *sum = NULL;
+    int i;
+
+    for (i = 0; i < *num_sums; i++)
+        if (memcmp(sums[i].apid, app->apid, DLT_ID_SIZE) == 0) {
+            sum = &sums[i];
+            break;
+        }
+
+    if (sum == NULL) {
+        if (*num_sums >= max_sums)
+            return;
+
+        sum = &sums[(*num_sums)++];
+        memset(sum, 0, sizeof(DltDaemonMetricsAppSum));
+        memcpy(sum->apid, app->apid, DLT_ID_SIZE);
+    }
+
+    sum->messages += DLT_DAEMON_METRICS_GET(app->messages);
+    sum->bytes += DLT_DAEMON_METRICS_GET(app->bytes);
+    sum->rate += app->rate;
+
+    for (i = 0; i < DLT_DAEMON_DROP_REASON_MAX; i++)
+        sum->drops[i] += DLT_DAEMON_METRICS_GET(app->drops[i]);
+}
+
+static void dlt_daemon_metrics_sum_thread(DltDaemonMetricsAppSum *sums,
+                                          int *num_sums,
+                                          int max_sums,
+                                          DltDaemonMetricsThread *thread)
+{
+    int i;
+
+    for (i = 0; i < DLT_DAEMON_METRICS_MAX_APPS; i++)
+        if (atomic_load_explicit(&thread->apps[i].used, memory_order_acquire))
+            dlt_daemon_metrics_sum_app(sums, num_sums, max_sums, &(thread->apps[i]));
+
+    /* messages without application are rare, only report them if there are any */
+    for (i = 0; i < DLT_DAEMON_DROP_REASON_MAX; i++)
+        if (DLT_DAEMON_METRICS_GET(thread->other.drops[i]) > 0)
+            break;
+
+    if ((DLT_DAEMON_METRICS_GET(thread->other.messages) > 0) || (i < DLT_DAEMON_DROP_REASON_MAX))
+        dlt_daemon_metrics_sum_app(sums, num_sums, max_sums, &(thread->other));
+}
+
+static void dlt_daemon_metrics_print_apps(DltDaemonMetricsText *text,
+                                          DltDaemon *daemon,
+                                          DltDaemonLocal *daemon_local)
+{
+    DltDaemonMetricsAppSum *sums;
+    char label[DLT_ID_SIZE * 2 + 1];
+    int num_threads = 1;
+    int num_sums = 0;
+    int max_sums;
+    int i, j;
+
+    if (daemon->storage_worker != NULL)
+        num_threads += daemon_local->flags.offlineLogstorageMaxDevices;
+
+    max_sums = num_threads * (DLT_DAEMON_METRICS_MAX_APPS + 1);
+    sums = malloc(sizeof(DltDaemonMetricsAppSum) * (size_t)max_sums);
+
+    if (sums == NULL) {
+        dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+        return;
+    }
+
+    dlt_daemon_metrics_sum_thread(sums, &num_sums, max_sums, &(daemon_local->metrics.main));
+
+    for (i = 1; i < num_threads; i++)
+        dlt_daemon_metrics_sum_thread(sums, &num_sums, max_sums, &(daemon->storage_worker[i - 1].metrics));
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_messages_received_total", "counter",
+                              "Log messages received per application.");
+
+    for (i = 0; i < num_sums; i++) {
+        dlt_daemon_metrics_apid_label(sums[i].apid, label);
+        dlt_daemon_metrics_printf(text, "dlt_daemon_messages_received_total{apid=\"%s\"} %llu\n",
+                                  label, (unsigned long long)sums[i].messages);
+    }
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_message_bytes_received_total", "counter",
+                              "Bytes of the log messages received per application.");
+
+    for (i = 0; i < num_sums; i++) {
+        dlt_daemon_metrics_apid_label(sums[i].apid, label);
+        dlt_daemon_metrics_printf(text, "dlt_daemon_message_bytes_received_total{apid=\"%s\"} %llu\n",
+                                  label, (unsigned long long)sums[i].bytes);
+    }
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_message_rate", "gauge",
+                              "Log messages received per second in the last second.");
+
+    for (i = 0; i < num_sums; i++) {
+        dlt_daemon_metrics_apid_label(sums[i].apid, label);
+        dlt_daemon_metrics_printf(text, "dlt_daemon_message_rate{apid=\"%s\"} %u\n", label, sums[i].rate);
+    }
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_messages_dropped_total", "counter",
+                              "Log messages dropped per application and reason.");
+
+    for (i = 0; i < num_sums; i++) {
+        dlt_daemon_metrics_apid_label(sums[i].apid, label);
+
+        for (j = 0; j < DLT_DAEMON_DROP_REASON_MAX; j++)
+            dlt_daemon_metrics_printf(text,
+                                      "dlt_daemon_messages_dropped_total{apid=\"%s\",reason=\"%s\"} %llu\n",
+                                      label, dlt_daemon_metrics_reason[j],
+                                      (unsigned long long)sums[i].drops[j]);
+    }
+
+    free(sums);
+}
+
+static void dlt_daemon_metrics_print_connections(DltDaemonMetricsText *text, DltDaemonLocal *daemon_local)
+{
+    static const struct
+    {
+        const char *name;
+        const char *help;
+        size_t offset;
+    } counters[] = {
+        { "dlt_daemon_connection_bytes_received_total", "Bytes received per connection.",
+          offsetof(DltConnection, bytes_in) },
+        { "dlt_daemon_connection_bytes_sent_total", "Bytes sent per connection.",
+          offsetof(DltConnection, bytes_out) },
+        { "dlt_daemon_connection_messages_received_total", "Messages received per connection.",
+          offsetof(DltConnection, messages_in) },
+        { "dlt_daemon_connection_messages_sent_total", "Messages sent per connection.",
+          offsetof(DltConnection, messages_out) }
+    };
+    DltConnection *con;
+    size_t i;
+
+    for (i = 0; i < sizeof(counters) / sizeof(counters[0]); i++) {
+        dlt_daemon_metrics_family(text, counters[i].name, "counter", counters[i].help);
+
+        for (con = dlt_connection_get_next(daemon_local->pEvent.connections, DLT_DAEMON_METRICS_CON_MASK);
+             con != NULL;
+             con = dlt_connection_get_next(con->next, DLT_DAEMON_METRICS_CON_MASK))
+            dlt_daemon_metrics_printf(text, "%s{type=\"%s\",fd=\"%d\"} %llu\n",
+                                      counters[i].name,
+                                      dlt_daemon_metrics_con_type[con->type],
+                                      con->receiver->fd,
+                                      (unsigned long long)DLT_DAEMON_METRICS_GET(
+                                          *(_Atomic uint64_t *)((uint8_t *)con + counters[i].offset)));
+    }
+}
+
+static void dlt_daemon_metrics_print_ringbuffer(DltDaemonMetricsText *text, DltDaemon *daemon)
+{
+    DltDaemonRingbuffer *rb = &(daemon->client_ringbuffer);
+    int i;
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_ringbuffer_bytes", "gauge",
+                              "Bytes stored in the client ring buffer per class.");
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_ringbuffer_bytes{class=\"%s\"} %d\n",
+                                  dlt_daemon_metrics_class[i],
+                                  dlt_buffer_get_used_size(&(rb->buffer[i])));
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_ringbuffer_limit_bytes", "gauge",
+                              "Bytes each class of the client ring buffer may use.");
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_ringbuffer_limit_bytes{class=\"%s\"} %u\n",
+                                  dlt_daemon_metrics_class[i], rb->limit[i]);
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_ringbuffer_messages", "gauge",
+                              "Messages stored in the client ring buffer per class.");
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_ringbuffer_messages{class=\"%s\"} %d\n",
+                                  dlt_daemon_metrics_class[i],
+                                  dlt_buffer_get_message_count(&(rb->buffer[i])));
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_ringbuffer_evicted_total", "counter",
+                              "Buffered messages removed for a message of a higher class.");
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_ringbuffer_evicted_total{class=\"%s\"} %u\n",
+                                  dlt_daemon_metrics_class[i], rb->stats[i].evicted);
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_ringbuffer_max_bytes", "gauge",
+                              "Bytes all classes of the client ring buffer may use.");
+    dlt_daemon_metrics_printf(text, "dlt_daemon_ringbuffer_max_bytes %u\n", rb->max_size);
+}
+
+static void dlt_daemon_metrics_print_queues(DltDaemonMetricsText *text,
+                                            DltDaemon *daemon,
+                                            DltDaemonLocal *daemon_local)
+{
+    DltDaemonEgress *egress = &(daemon_local->egress);
+    DltDaemonIngress *ingress = &(daemon_local->ingress);
+    DltDaemonLogstorageWorker *worker;
+    int i;
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_queue_depth", "gauge",
+                              "Entries waiting in the queue of a pipeline thread.");
+
+    for (i = 0; i < ingress->num_shards; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_queue_depth{queue=\"ingress%d\"} %u\n",
+                                  i, atomic_load(&ingress->shards[i].head) -
+                                  atomic_load(&ingress->shards[i].tail));
+
+    if (egress->queue != NULL)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_queue_depth{queue=\"egress\"} %u\n",
+                                  atomic_load(&egress->head) - atomic_load(&egress->tail));
+
+    if (daemon->storage_worker != NULL)
+        for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+            worker = &(daemon->storage_worker[i]);
+
+            if (worker->queue != NULL)
+                dlt_daemon_metrics_printf(text, "dlt_daemon_queue_depth{queue=\"logstorage%d\"} %u\n",
+                                          i, dlt_daemon_logstorage_worker_get_depth(worker));
+        }
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_queue_max_depth", "gauge",
+                              "Highest depth of the queue of a pipeline thread.");
+
+    for (i = 0; i < ingress->num_shards; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_queue_max_depth{queue=\"ingress%d\"} %u\n",
+                                  i, atomic_load(&ingress->shards[i].max_depth));
+
+    if (egress->queue != NULL)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_queue_max_depth{queue=\"egress\"} %u\n",
+                                  atomic_load(&egress->max_depth));
+
+    if (daemon->storage_worker != NULL)
+        for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+            worker = &(daemon->storage_worker[i]);
+
+            if (worker->queue != NULL)
+                dlt_daemon_metrics_printf(text, "dlt_daemon_queue_max_depth{queue=\"logstorage%d\"} %u\n",
+                                          i, atomic_load(&worker->max_depth));
+        }
+
+    dlt_daemon_metrics_family(text, "dlt_daemon_queue_size", "gauge",
+                              "Entries of the queue of a pipeline thread.");
+
+    for (i = 0; i < ingress->num_shards; i++)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_queue_size{queue=\"ingress%d\"} %u\n",
+                                  i, DLT_DAEMON_INGRESS_QUEUE_SIZE);
+
+    if (egress->queue != NULL)
+        dlt_daemon_metrics_printf(text, "dlt_daemon_queue_size{queue=\"egress\"} %u\n", egress->size);
+
+    if (daemon->storage_worker != NULL)
+        for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++) {
+            worker = &(daemon->storage_worker[i]);
+
+            if (worker->queue != NULL)
+                dlt_daemon_metrics_printf(text, "dlt_daemon_queue_size{queue=\"logstorage%d\"} %u\n",
+                                          i, worker->size);
+        }
+}
+
+/* Summary of durations in ns, printed in seconds */
+static void dlt_daemon_metrics_print_duration(DltDaemonMetricsText *text,
+                                              const char *name,
+                                              const char *help,
+                                              uint64_t count,
+                                              uint64_t sum,
+                                              uint64_t max)
+{
+    dlt_daemon_metrics_family(text, name, "summary", help);
+    dlt_daemon_metrics_printf(text, "%s_count %llu\n%s_sum %.9f\n",
+                              name, (unsigned long long)count, name, (double)sum / 1e9);
+    dlt_daemon_metrics_printf(text, "# HELP %s_max Longest duration.\n# TYPE %s_max gauge\n%s_max %.9f\n",
+                              name, name, name, (double)max / 1e9);
+}
+
+char *dlt_daemon_metrics_print(DltDaemon *daemon, DltDaemonLocal *daemon_local, int *size)
+{
+    DltDaemonMetricsText text;
+    uint64_t count, sum, max;
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (size == NULL))
+        return NULL;
+
+    text.size = DLT_DAEMON_METRICS_TEXT_SIZE;
+    text.len = 0;
+    text.buf = malloc((size_t)text.size);
+
+    if (text.buf == NULL) {
+        dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+        return NULL;
+    }
+
+    dlt_daemon_metrics_print_apps(&text, daemon, daemon_local);
+    dlt_daemon_metrics_print_connections(&text, daemon_local);
+    dlt_daemon_metrics_print_ringbuffer(&text, daemon);
+    dlt_daemon_metrics_print_queues(&text, daemon, daemon_local);
+
+    dlt_daemon_metrics_print_duration(&text, "dlt_daemon_event_loop_seconds",
+                                      "Time spent handling the events of one event loop iteration.",
+                                      daemon_local->metrics.loop_count,
+                                      daemon_local->metrics.loop_sum,
+                                      daemon_local->metrics.loop_max);
+
+    dlt_logstorage_get_sync_stats(&count, &sum, &max);
+    dlt_daemon_metrics_print_duration(&text, "dlt_daemon_logstorage_sync_seconds",
+                                      "Time spent syncing logstorage files.",
+                                      count, sum, max);
+
+    *size = text.len;
+
+    return text.buf;
+}
+
+int dlt_daemon_metrics_init_socket(DltDaemonLocal *daemon_local)
+{
+    /* socket access permission set to srw-rw---- (660)  */
+    int mask = S_IXUSR | S_IXGRP | S_IROTH | S_IWOTH | S_IXOTH;
+    int fd = -1;
+
+    if (daemon_local == NULL)
+        return -1;
+
+    if (daemon_local->flags.metricsSockPath[0] == '\0')
+        return 0;
+
+    if (dlt_daemon_unix_socket_open(&fd,
+                                    daemon_local->flags.metricsSockPath,
+                                    SOCK_STREAM,
+                                    mask) != DLT_RETURN_OK) {
+        dlt_vlog(LOG_ERR, "%s: cannot open %s\n", __func__, daemon_local->flags.metricsSockPath);
+        return -1;
+    }
+
+    if (dlt_connection_create(daemon_local,
+                              &daemon_local->pEvent,
+                              fd,
+                              POLLIN,
+                              DLT_CONNECTION_METRICS_CONNECT) < DLT_RETURN_OK) {
+        dlt_log(LOG_ERR, "Could not initialize metrics socket.\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+int dlt_daemon_process_metrics_connect(DltDaemon *daemon,
+                                       DltDaemonLocal *daemon_local,
+                                       DltReceiver *receiver,
+                                       int verbose)
+{
+    struct timeval timeout = { 0, DLT_DAEMON_METRICS_SEND_TIMEOUT_US };
+    char *text;
+    ssize_t ret;
+    int size = 0;
+    int sent = 0;
+    int fd;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((daemon == NULL) || (daemon_local == NULL) || (receiver == NULL)) {
+        dlt_vlog(LOG_ERR, "%s: Invalid function parameters\n", __func__);
+        return -1;
+    }
+
+    fd = accept(receiver->fd, NULL, NULL);
+
+    if (fd < 0) {
+        dlt_vlog(LOG_ERR, "accept() on metrics socket %d failed: %s\n", receiver->fd, strerror(errno));
+        return -1;
+    }
+
+    /* a client which does not read must not stall the event loop */
+    if (setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0)
+        dlt_vlog(LOG_WARNING, "%s: setsockopt SO_SNDTIMEO failed: %s\n", __func__, strerror(errno));
+
+    text = dlt_daemon_metrics_print(daemon, daemon_local, &size);
+
+    while ((text != NULL) && (sent < size)) {
+        ret = send(fd, text + sent, (size_t)(size - sent), MSG_NOSIGNAL);
+
+        if (ret <= 0) {
+            if ((ret < 0) && (errno == EINTR))
+                continue;
+
+            dlt_vlog(LOG_WARNING, "%s: metrics snapshot not sent completely\n", __func__);
+            break;
+        }
+
+        sent += (int)ret;
+    }
+
+    free(text);
+    close(fd);
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_metrics.h
+ */
+
+#ifndef DLT_DAEMON_METRICS_H
+#define DLT_DAEMON_METRICS_H
+
+#include "dlt-daemon.h"
+#include "dlt_daemon_metrics_types.h"
+
+/* Max length of the text sent in a get metrics response, leaving room for
+ * the headers of the DLT message */
+#define DLT_DAEMON_METRICS_CONTROL_SIZE (UINT16_MAX - 256)
+
+/**
+ * Initialise the metrics of the daemon.
+ *
+ * @param metrics metrics
+ */
+void dlt_daemon_metrics_init(DltDaemonMetrics *metrics);
+
+/**
+ * Get the application id of a message.
+ *
+ * @param header message starting with the standard header
+ * @param size size of the header
+ * @return application id, NULL if the message has no extended header
+ */
+const char *dlt_daemon_metrics_get_apid(const uint8_t *header, int size);
+
+/**
+ * Count bytes received on the connection whose event is handled.
+ *
+ * @param metrics metrics
+ * @param bytes number of bytes received
+ */
+void dlt_daemon_metrics_received(DltDaemonMetrics *metrics, int bytes);
+
+/**
+ * Count a message received on the connection whose event is handled.
+ *
+ * @param metrics metrics
+ */
+void dlt_daemon_metrics_message_received(DltDaemonMetrics *metrics);
+
+/**
+ * Count a log message of an application read by the event loop.
+ *
+ * @param metrics metrics
+ * @param msg log message
+ */
+void dlt_daemon_metrics_log(DltDaemonMetrics *metrics, DltMessage *msg);
+
+/**
+ * Count a dropped message. Only the thread owning the counters may call it.
+ *
+ * @param thread counters of the calling thread
+ * @param apid application id, NULL if unknown
+ * @param reason reason of the drop
+ */
+void dlt_daemon_metrics_drop(DltDaemonMetricsThread *thread, const char *apid, DltDaemonDropReason reason);
+
+/**
+ * Count messages dropped elsewhere and reported to the daemon. Only the
+ * thread owning the counters may call it.
+ *
+ * @param thread counters of the calling thread
+ * @param apid application id, NULL if unknown
+ * @param reason reason of the drop
+ * @param count number of dropped messages
+ */
+void dlt_daemon_metrics_drop_count(DltDaemonMetricsThread *thread,
+                                   const char *apid,
+                                   DltDaemonDropReason reason,
+                                   uint32_t count);
+
+/**
+ * Take the time the events of an event loop iteration were polled.
+ *
+ * @param metrics metrics
+ */
+void dlt_daemon_metrics_loop_begin(DltDaemonMetrics *metrics);
+
+/**
+ * Count the time the event loop iteration took since it polled the events.
+ *
+ * @param metrics metrics
+ */
+void dlt_daemon_metrics_loop_end(DltDaemonMetrics *metrics);
+
+/**
+ * Update the message rate of each application, called once per second.
+ *
+ * @param metrics metrics
+ */
+void dlt_daemon_metrics_update_rates(DltDaemonMetrics *metrics);
+
+/**
+ * Print a snapshot of all metrics in the Prometheus text format.
+ *
+ * @param daemon pointer to dlt daemon structure
+ * @param daemon_local pointer to dlt daemon local structure
+ * @param size set to the length of the text
+ * @return text to be freed by the caller, NULL on error
+ */
+char *dlt_daemon_metrics_print(DltDaemon *daemon, DltDaemonLocal *daemon_local, int *size);
+
+/**
+ * Open the metrics socket configured by MetricsSocketPath.
+ *
+ * @param daemon_local pointer to dlt daemon local structure
+ * @return 0 on success or if no socket is configured, -1 on error
+ */
+int dlt_daemon_metrics_init_socket(DltDaemonLocal *daemon_local);
+
+/**
+ * Send a snapshot to a client connecting to the metrics socket, then close
+ * the connection.
+ *
+ * @param daemon pointer to dlt daemon structure
+ * @param daemon_local pointer to dlt daemon local structure
+ * @param receiver receiver of the metrics socket
+ * @param verbose if set to true verbose information is printed out.
+ * @return 0 on success, -1 on error
+ */
+int dlt_daemon_process_metrics_connect(DltDaemon *daemon,
+                                       DltDaemonLocal *daemon_local,
+                                       DltReceiver *receiver,
+                                       int verbose);
+
+#endif /* DLT_DAEMON_METRICS_H */
@@ -0,0 +1,106 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_metrics_types.h
+ */
+
+#ifndef DLT_DAEMON_METRICS_TYPES_H
+#define DLT_DAEMON_METRICS_TYPES_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "dlt_common.h"
+#include "dlt_daemon_connection_types.h"
+
+/*
+ * These types are needed by DltDaemonLocal and the logstorage workers,
+ * the functions using them are declared in dlt_daemon_metrics.h.
+ */
+
+/* Applications counted per thread, a power of two */
+#define DLT_DAEMON_METRICS_MAX_APPS 256
+
+/**
+ * Reasons a log message is dropped.
+ */
+typedef enum
+{
+    DLT_DAEMON_DROP_BUFFER_FULL = 0,    /**< no client and the client ring buffer is full */
+    DLT_DAEMON_DROP_RATE_LIMIT,         /**< the rate limit of the context is exceeded */
+    DLT_DAEMON_DROP_RATE_LIMIT_USER,    /**< the rate limit is exceeded, dropped in the application */
+    DLT_DAEMON_DROP_CLIENT_SLOW,        /**< egress queue full or sending to a client failed */
+    DLT_DAEMON_DROP_LOGSTORAGE,         /**< logstorage queue full or writing failed */
+    DLT_DAEMON_DROP_REASON_MAX
+} DltDaemonDropReason;
+
+/**
+ * Counters of one application in one thread.
+ *
+ * Only the owning thread writes them, other threads read them with relaxed
+ * loads. An entry is used once apid is set, used is set after apid.
+ */
+typedef struct
+{
+    atomic_int used;                                /**< 1 once apid is set */
+    char apid[DLT_ID_SIZE];                         /**< application id */
+    _Atomic uint64_t messages;                      /**< log messages received */
+    _Atomic uint64_t bytes;                         /**< bytes of the log messages received */
+    _Atomic uint64_t drops[DLT_DAEMON_DROP_REASON_MAX]; /**< messages dropped per reason */
+    uint64_t last_messages;                         /**< messages at the last rate update */
+    uint32_t rate;                                  /**< messages per second */
+} DltDaemonMetricsApp;
+
+/**
+ * Counters written by one thread, so no lock is needed to update them.
+ */
+typedef struct
+{
+    DltDaemonMetricsApp apps[DLT_DAEMON_METRICS_MAX_APPS]; /**< open addressing table by apid */
+    DltDaemonMetricsApp other;          /**< messages without apid or when the table is full */
+    DltDaemonMetricsApp *last;          /**< application of the last update */
+} DltDaemonMetricsThread;
+
+/**
+ * Runtime metrics of the daemon.
+ *
+ * The event loop counts in main, each logstorage worker in its own
+ * DltDaemonMetricsThread and the connections count the bytes and messages
+ * they send and receive. The snapshot sums them up.
+ */
+typedef struct
+{
+    DltDaemonMetricsThread main;        /**< counters of the event loop */
+    DltConnection *current;             /**< connection whose event is handled */
+    uint64_t loop_start;                /**< time the events of this iteration were polled */
+    uint64_t loop_count;                /**< event loop iterations with events */
+    uint64_t loop_sum;                  /**< time spent handling events, in ns */
+    uint64_t loop_max;                  /**< longest iteration, in ns */
+    uint64_t rate_time;                 /**< time the message rates were updated */
+} DltDaemonMetrics;
+
+/* Add to a counter only written by the calling thread */
+#define DLT_DAEMON_METRICS_ADD(counter, value) \
+    atomic_store_explicit(&(counter), \
+                          atomic_load_explicit(&(counter), memory_order_relaxed) + (value), \
+                          memory_order_relaxed)
+
+/* Read a counter of any thread */
+#define DLT_DAEMON_METRICS_GET(counter) \
+    atomic_load_explicit(&(counter), memory_order_relaxed)
+
+#endif /* DLT_DAEMON_METRICS_TYPES_H */
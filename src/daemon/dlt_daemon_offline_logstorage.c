@@ -989,6 +989,82 @@ int dlt_daemon_logstorage_get_loglevel(DltDaemon *daemon,
     return storage_loglevel;
 }
 
+/**
+ * dlt_daemon_logstorage_enqueue
+ *
+ * Queue a log message for the worker of each attached storage device. The
+ * message is copied once and shared by all queues. Devices whose worker
+ * reported too many write errors are disconnected here.
+ *
+ * @param daemon        Pointer to Dlt Daemon structure
+ * @param user_config   DltDaemon configuration
+ * @param data1         message header buffer
+ * @param size1         message header buffer size
+ * @param data2         message extended header buffer
+ * @param size2         message extended header size
+ * @param data3         message data buffer
+ * @param size3         message data size
+ * @return number of devices the message was dropped for
+ */
+DLT_STATIC int dlt_daemon_logstorage_enqueue(DltDaemon *daemon,
+                                             DltDaemonFlags *user_config,
+                                             unsigned char *data1,
+                                             int size1,
+                                             unsigned char *data2,
+                                             int size2,
+                                             unsigned char *data3,
+                                             int size3)
+{
+    int i = 0;
+    int dropped = 0;
+    DltLogStorageMsg *msg = NULL;
+    DltDaemonLogstorageWorker *worker = NULL;
+
+    for (i = 0; i < user_config->offlineLogstorageMaxDevices; i++) {
+        worker = &daemon->storage_worker[i];
+
+        if (atomic_load(&worker->failed)) {
+            dlt_log(LOG_ERR,
+                    "dlt_daemon_logstorage_write: failed. "
+                    "Disable storage device\n");
+            /* DLT_OFFLINE_LOGSTORAGE_MAX_WRITE_ERRORS happened,
+             * therefore remove logstorage device */
+            dlt_daemon_logstorage_worker_lock(worker);
+            dlt_logstorage_device_disconnected(
+                &(daemon->storage_handle[i]),
+                DLT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+            atomic_store(&worker->failed, 0);
+            dlt_daemon_logstorage_worker_unlock(worker);
+            dlt_daemon_logstorage_worker_log_stats(worker, i);
+        }
+
+        if (daemon->storage_handle[i].config_status !=
+            DLT_OFFLINE_LOGSTORAGE_CONFIG_DONE)
+            continue;
+
+        if (msg == NULL) {
+            msg = dlt_daemon_logstorage_msg_create(data1,
+                                                   size1,
+                                                   data2,
+                                                   size2,
+                                                   data3,
+                                                   size3);
+
+            if (msg == NULL) {
+                dlt_vlog(LOG_ERR, "%s: Cannot allocate message\n", __func__);
+                return user_config->offlineLogstorageMaxDevices - i;
+            }
+        }
+
+        if (dlt_daemon_logstorage_worker_enqueue(worker, msg) != 0)
+            dropped++;
+    }
+
+    dlt_daemon_logstorage_msg_release(msg);
+
+    return dropped;
+}
+
 /**
  * dlt_daemon_logstorage_write
  *
@@ -1004,17 +1080,19 @@ int dlt_daemon_logstorage_get_loglevel(DltDaemon *daemon,
  * @param size2         message extended header size
  * @param data3         message data buffer
  * @param size3         message data size
+ * @return number of devices the message was dropped for
  */
-void dlt_daemon_logstorage_write(DltDaemon *daemon,
-                                 DltDaemonFlags *user_config,
-                                 unsigned char *data1,
-                                 int size1,
-                                 unsigned char *data2,
-                                 int size2,
-                                 unsigned char *data3,
-                                 int size3)
+int dlt_daemon_logstorage_write(DltDaemon *daemon,
+                                DltDaemonFlags *user_config,
+                                unsigned char *data1,
+                                int size1,
+                                unsigned char *data2,
+                                int size2,
+                                unsigned char *data3,
+                                int size3)
 {
     int i = 0;
+    int dropped = 0;
     DltLogStorageUserConfig file_config;
 
     if ((daemon == NULL) || (user_config == NULL) ||
@@ -1023,7 +1101,7 @@ void dlt_daemon_logstorage_write(DltDaemon *daemon,
         dlt_vlog(LOG_DEBUG,
                  "%s: message type is not LOG. Skip storing.\n",
                  __func__);
-        return;
+        return 0;
         /* Log Level changed callback */
     }
 
@@ -1034,6 +1112,16 @@ void dlt_daemon_logstorage_write(DltDaemon *daemon,
     file_config.logfile_counteridxlen =
         user_config->offlineLogstorageMaxCounterIdx;
 
+    if (daemon->storage_worker != NULL)
+        return dlt_daemon_logstorage_enqueue(daemon,
+                                             user_config,
+                                             data1,
+                                             size1,
+                                             data2,
+                                             size2,
+                                             data3,
+                                             size3);
+
     for (i = 0; i < user_config->offlineLogstorageMaxDevices; i++)
         if (daemon->storage_handle[i].config_status ==
             DLT_OFFLINE_LOGSTORAGE_CONFIG_DONE) {
@@ -1053,8 +1141,11 @@ void dlt_daemon_logstorage_write(DltDaemon *daemon,
                 dlt_logstorage_device_disconnected(
                     &(daemon->storage_handle[i]),
                     DLT_LOGSTORAGE_SYNC_ON_DEVICE_DISCONNECT);
+                dropped++;
             }
         }
+
+    return dropped;
 }
 
 /**
@@ -1082,7 +1173,9 @@ int dlt_daemon_logstorage_setup_internal_storage(DltDaemon *daemon,
 
     /* connect internal storage device */
     /* Device index always used as 0 as it is setup on DLT daemon startup */
+    dlt_daemon_logstorage_lock(daemon, 0);
     ret = dlt_logstorage_device_connected(&(daemon->storage_handle[0]), path);
+    dlt_daemon_logstorage_unlock(daemon, 0);
 
     if (ret != 0) {
         dlt_vlog(LOG_ERR, "%s: Device connect failed\n", __func__);
@@ -1114,6 +1207,53 @@ void dlt_daemon_logstorage_set_logstorage_cache_size(unsigned int size)
     g_logstorage_cache_max = size * 1024;
 }
 
+void dlt_daemon_logstorage_lock(DltDaemon *daemon, int index)
+{
+    if ((daemon != NULL) && (daemon->storage_worker != NULL))
+        dlt_daemon_logstorage_worker_lock(&daemon->storage_worker[index]);
+}
+
+void dlt_daemon_logstorage_unlock(DltDaemon *daemon, int index)
+{
+    if ((daemon != NULL) && (daemon->storage_worker != NULL))
+        dlt_daemon_logstorage_worker_unlock(&daemon->storage_worker[index]);
+}
+
+/**
+ * dlt_daemon_logstorage_sync_request
+ *
+ * With worker threads, hand the cache sync of a logstorage device to its
+ * worker, to be run once the messages queued so far are written. Several
+ * devices can be requested before waiting for them.
+ *
+ * @param daemon       Pointer to Dlt Daemon structure
+ * @param index        Index of the logstorage device
+ */
+DLT_STATIC void dlt_daemon_logstorage_sync_request(DltDaemon *daemon, int index)
+{
+    if (daemon->storage_worker != NULL)
+        dlt_daemon_logstorage_worker_sync(&daemon->storage_worker[index]);
+}
+
+/**
+ * dlt_daemon_logstorage_sync_device
+ *
+ * Sync the caches of a logstorage device. With worker threads, wait until
+ * the sync requested by dlt_daemon_logstorage_sync_request is done, so the
+ * control response reports the flushed data and its result.
+ *
+ * @param daemon       Pointer to Dlt Daemon structure
+ * @param index        Index of the logstorage device
+ * @return 0 on success, -1 otherwise
+ */
+DLT_STATIC int dlt_daemon_logstorage_sync_device(DltDaemon *daemon, int index)
+{
+    if (daemon->storage_worker != NULL)
+        return dlt_daemon_logstorage_worker_sync_wait(&daemon->storage_worker[index]);
+
+    return dlt_logstorage_sync_caches(&daemon->storage_handle[index]);
+}
+
 int dlt_daemon_logstorage_cleanup(DltDaemon *daemon,
                                   DltDaemonLocal *daemon_local,
                                   int verbose)
@@ -1139,9 +1279,11 @@ int dlt_daemon_logstorage_cleanup(DltDaemon *daemon,
             (&daemon->storage_handle[i])->uconfig.logfile_timestamp =
                                         daemon_local->flags.offlineLogstorageTimestamp;
 
+            dlt_daemon_logstorage_lock(daemon, i);
             dlt_logstorage_device_disconnected(
                 &daemon->storage_handle[i],
                 DLT_LOGSTORAGE_SYNC_ON_DAEMON_EXIT);
+            dlt_daemon_logstorage_unlock(daemon, i);
         }
 
     return 0;
@@ -1153,6 +1295,7 @@ int dlt_daemon_logstorage_sync_cache(DltDaemon *daemon,
                                      int verbose)
 {
     int i = 0;
+    int ret = 0;
     DltLogStorage *handle = NULL;
 
     PRINT_FUNCTION_VERBOSE(verbose);
@@ -1179,7 +1322,11 @@ int dlt_daemon_logstorage_sync_cache(DltDaemon *daemon,
             handle->uconfig.logfile_timestamp =
                 daemon_local->flags.offlineLogstorageTimestamp;
 
-            if (dlt_logstorage_sync_caches(handle) != 0)
+            i = (int)(handle - daemon->storage_handle);
+            dlt_daemon_logstorage_sync_request(daemon, i);
+            ret = dlt_daemon_logstorage_sync_device(daemon, i);
+
+            if (ret != 0)
                 return DLT_RETURN_ERROR;
         }
     }
@@ -1197,9 +1344,18 @@ int dlt_daemon_logstorage_sync_cache(DltDaemon *daemon,
                 daemon->storage_handle[i].uconfig.logfile_timestamp =
                     daemon_local->flags.offlineLogstorageTimestamp;
 
-                if (dlt_logstorage_sync_caches(&daemon->storage_handle[i]) != 0)
-                    return DLT_RETURN_ERROR;
+                dlt_daemon_logstorage_sync_request(daemon, i);
             }
+
+        /* the workers flush their devices in parallel */
+        for (i = 0; i < daemon_local->flags.offlineLogstorageMaxDevices; i++)
+            if ((daemon->storage_handle[i].connection_type ==
+                 DLT_OFFLINE_LOGSTORAGE_DEVICE_CONNECTED) &&
+                (dlt_daemon_logstorage_sync_device(daemon, i) != 0))
+                ret = -1;
+
+        if (ret != 0)
+            return DLT_RETURN_ERROR;
     }
 
     return 0;
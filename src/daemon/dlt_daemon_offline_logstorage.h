@@ -120,7 +120,9 @@ void dlt_daemon_logstorage_update_application_loglevel(DltDaemon *daemon,
  *
  * Write log message to all attached storage device. If the called
  * dlt_logstorage_write function is not able to write to the device,
- * DltDaemon will disconnect this device.
+ * DltDaemon will disconnect this device. If logstorage worker threads are
+ * enabled, the message is only queued and written by the worker of each
+ * device.
  *
  * @param daemon        Pointer to Dlt Daemon structure
  * @param user_config   DltDaemon configuration
@@ -130,15 +132,16 @@ void dlt_daemon_logstorage_update_application_loglevel(DltDaemon *daemon,
  * @param size2         message extended data size
  * @param data3         message data buffer
  * @param size3         message data size
+ * @return number of devices the message was dropped for
  */
-void dlt_daemon_logstorage_write(DltDaemon *daemon,
-                                 DltDaemonFlags *user_config,
-                                 unsigned char *data1,
-                                 int size1,
-                                 unsigned char *data2,
-                                 int size2,
-                                 unsigned char *data3,
-                                 int size3);
+int dlt_daemon_logstorage_write(DltDaemon *daemon,
+                                DltDaemonFlags *user_config,
+                                unsigned char *data1,
+                                int size1,
+                                unsigned char *data2,
+                                int size2,
+                                unsigned char *data3,
+                                int size3);
 
 /**
  * dlt_daemon_logstorage_setup_internal_storage
@@ -162,6 +165,24 @@ int dlt_daemon_logstorage_setup_internal_storage(DltDaemon *daemon,
  */
 void dlt_daemon_logstorage_set_logstorage_cache_size(unsigned int size);
 
+/**
+ * Wait until the worker of a logstorage device has written all queued
+ * messages and keep it from writing until dlt_daemon_logstorage_unlock() is
+ * called. Does nothing if logstorage worker threads are disabled.
+ *
+ * @param daemon       Pointer to Dlt Daemon structure
+ * @param index        Index of the logstorage device
+ */
+void dlt_daemon_logstorage_lock(DltDaemon *daemon, int index);
+
+/**
+ * Allow the worker of a logstorage device to write again.
+ *
+ * @param daemon       Pointer to Dlt Daemon structure
+ * @param index        Index of the logstorage device
+ */
+void dlt_daemon_logstorage_unlock(DltDaemon *daemon, int index);
+
 /**
  * Cleanup dlt logstorage
  *
@@ -174,7 +195,8 @@ int dlt_daemon_logstorage_cleanup(DltDaemon *daemon,
                                   int verbose);
 
 /**
- * Sync logstorage caches
+ * Sync logstorage caches. With logstorage worker threads, the sync is run by
+ * the worker of each device and the call returns without waiting for it.
  *
  * @param daemon        Pointer to Dlt Daemon structure
  * @param daemon_local  Pointer to Dlt Daemon Local structure
@@ -0,0 +1,321 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_offline_logstorage_worker.c
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+
+#include "dlt_common.h"
+#include "dlt_daemon_offline_logstorage_worker.h"
+#include "dlt_daemon_metrics.h"
+
+static void *dlt_daemon_logstorage_worker_run(void *arg)
+{
+    DltDaemonLogstorageWorker *worker = (DltDaemonLogstorageWorker *)arg;
+    DltLogStorageMsg *msg;
+    unsigned int tail;
+
+    for (;;) {
+        if (sem_wait(&worker->items) != 0) {
+            if (errno == EINTR)
+                continue;
+
+            dlt_vlog(LOG_ERR, "%s: sem_wait failed: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        pthread_mutex_lock(&worker->lock);
+
+        tail = atomic_load(&worker->tail);
+        msg = NULL;
+
+        /* woken up without message: sync or stop request */
+        if (tail != atomic_load(&worker->head)) {
+            msg = worker->queue[tail % worker->size];
+
+            /* After too many errors, the event loop disconnects the device.
+             * Until then, queued messages are discarded. */
+            if (atomic_load(&worker->failed) ||
+                (dlt_logstorage_write(worker->handle,
+                                      &worker->uconfig,
+                                      msg->data,
+                                      msg->size1,
+                                      msg->data + msg->size1,
+                                      msg->size2,
+                                      msg->data + msg->size1 + msg->size2,
+                                      msg->size3) != 0)) {
+                atomic_store(&worker->failed, 1);
+                dlt_daemon_metrics_drop(&worker->metrics,
+                                        dlt_daemon_metrics_get_apid(msg->data + msg->size1, msg->size2),
+                                        DLT_DAEMON_DROP_LOGSTORAGE);
+            }
+
+            tail++;
+            atomic_store(&worker->tail, tail);
+        }
+
+        /* all messages queued before the sync request are written */
+        if (worker->sync_pending && ((int)(tail - worker->sync_at) >= 0)) {
+            if (atomic_load(&worker->failed))
+                worker->sync_result = -1;
+            else
+                worker->sync_result = dlt_logstorage_sync_caches(worker->handle);
+
+            worker->sync_pending = 0;
+            pthread_cond_broadcast(&worker->idle);
+        }
+        else if (!worker->sync_pending && (tail == atomic_load(&worker->head))) {
+            pthread_cond_broadcast(&worker->idle);
+        }
+
+        pthread_mutex_unlock(&worker->lock);
+
+        if (msg != NULL) {
+            dlt_daemon_logstorage_msg_release(msg);
+            sem_post(&worker->slots);
+        }
+        else if (!atomic_load(&worker->running)) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+DltLogStorageMsg *dlt_daemon_logstorage_msg_create(unsigned char *data1,
+                                                   int size1,
+                                                   unsigned char *data2,
+                                                   int size2,
+                                                   unsigned char *data3,
+                                                   int size3)
+{
+    DltLogStorageMsg *msg;
+
+    if ((data1 == NULL) || (data2 == NULL) || (data3 == NULL) ||
+        (size1 < 0) || (size2 < 0) || (size3 < 0))
+        return NULL;
+
+    msg = malloc(sizeof(DltLogStorageMsg) + (size_t)size1 + (size_t)size2 + (size_t)size3);
+
+    if (msg == NULL)
+        return NULL;
+
+    atomic_init(&msg->refs, 1);
+    msg->size1 = size1;
+    msg->size2 = size2;
+    msg->size3 = size3;
+    memcpy(msg->data, data1, (size_t)size1);
+    memcpy(msg->data + size1, data2, (size_t)size2);
+    memcpy(msg->data + size1 + size2, data3, (size_t)size3);
+
+    return msg;
+}
+
+void dlt_daemon_logstorage_msg_release(DltLogStorageMsg *msg)
+{
+    if ((msg != NULL) && (atomic_fetch_sub(&msg->refs, 1) == 1))
+        free(msg);
+}
+
+int dlt_daemon_logstorage_worker_init(DltDaemonLogstorageWorker *worker,
+                                      DltLogStorage *handle,
+                                      DltLogStorageUserConfig *uconfig,
+                                      unsigned int size,
+                                      int blocking)
+{
+    if ((worker == NULL) || (handle == NULL) || (uconfig == NULL) || (size == 0))
+        return -1;
+
+    memset(worker, 0, sizeof(DltDaemonLogstorageWorker));
+
+    worker->queue = calloc(size, sizeof(DltLogStorageMsg *));
+
+    if (worker->queue == NULL) {
+        dlt_vlog(LOG_ERR, "%s: Cannot allocate queue of %u entries\n", __func__, size);
+        return -1;
+    }
+
+    worker->handle = handle;
+    worker->uconfig = *uconfig;
+    worker->size = size;
+    worker->blocking = blocking;
+    atomic_init(&worker->head, 0);
+    atomic_init(&worker->tail, 0);
+    atomic_init(&worker->max_depth, 0);
+    atomic_init(&worker->dropped, 0);
+    atomic_init(&worker->failed, 0);
+    atomic_init(&worker->running, 1);
+
+    if ((pthread_mutex_init(&worker->lock, NULL) != 0) ||
+        (pthread_cond_init(&worker->idle, NULL) != 0) ||
+        (sem_init(&worker->items, 0, 0) != 0) ||
+        (sem_init(&worker->slots, 0, size) != 0)) {
+        dlt_vlog(LOG_ERR, "%s: Cannot initialize synchronization\n", __func__);
+        free(worker->queue);
+        worker->queue = NULL;
+        return -1;
+    }
+
+    if (pthread_create(&worker->thread, NULL, dlt_daemon_logstorage_worker_run, worker) != 0) {
+        dlt_vlog(LOG_ERR, "%s: Cannot create worker thread\n", __func__);
+        sem_destroy(&worker->slots);
+        sem_destroy(&worker->items);
+        pthread_cond_destroy(&worker->idle);
+        pthread_mutex_destroy(&worker->lock);
+        free(worker->queue);
+        worker->queue = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+void dlt_daemon_logstorage_worker_free(DltDaemonLogstorageWorker *worker)
+{
+    if ((worker == NULL) || (worker->queue == NULL))
+        return;
+
+    /* the worker writes what is queued before it sees the stop request */
+    atomic_store(&worker->running, 0);
+    sem_post(&worker->items);
+    pthread_join(worker->thread, NULL);
+
+    sem_destroy(&worker->slots);
+    sem_destroy(&worker->items);
+    pthread_cond_destroy(&worker->idle);
+    pthread_mutex_destroy(&worker->lock);
+    free(worker->queue);
+    worker->queue = NULL;
+}
+
+int dlt_daemon_logstorage_worker_enqueue(DltDaemonLogstorageWorker *worker,
+                                         DltLogStorageMsg *msg)
+{
+    unsigned int head;
+    unsigned int depth;
+
+    if ((worker == NULL) || (worker->queue == NULL) || (msg == NULL))
+        return -1;
+
+    if (worker->blocking) {
+        while ((sem_wait(&worker->slots) != 0) && (errno == EINTR))
+            ;
+    }
+    else if (sem_trywait(&worker->slots) != 0) {
+        if (atomic_fetch_add(&worker->dropped, 1) == 0)
+            dlt_vlog(LOG_WARNING, "%s: Logstorage queue is full! Messages will be discarded.\n",
+                     __func__);
+
+        return -1;
+    }
+
+    atomic_fetch_add(&msg->refs, 1);
+
+    head = atomic_load(&worker->head);
+    worker->queue[head % worker->size] = msg;
+    atomic_store(&worker->head, head + 1);
+
+    depth = head + 1 - atomic_load(&worker->tail);
+
+    if (depth > atomic_load(&worker->max_depth))
+        atomic_store(&worker->max_depth, depth);
+
+    sem_post(&worker->items);
+
+    return 0;
+}
+
+void dlt_daemon_logstorage_worker_lock(DltDaemonLogstorageWorker *worker)
+{
+    if ((worker == NULL) || (worker->queue == NULL))
+        return;
+
+    pthread_mutex_lock(&worker->lock);
+
+    /* head is only advanced by the caller, so the queue cannot grow here */
+    while (worker->sync_pending || (atomic_load(&worker->tail) != atomic_load(&worker->head)))
+        pthread_cond_wait(&worker->idle, &worker->lock);
+}
+
+void dlt_daemon_logstorage_worker_sync(DltDaemonLogstorageWorker *worker)
+{
+    if ((worker == NULL) || (worker->queue == NULL))
+        return;
+
+    pthread_mutex_lock(&worker->lock);
+
+    /* a pending sync is moved behind the messages queued since */
+    worker->sync_pending = 1;
+    worker->sync_at = atomic_load(&worker->head);
+
+    pthread_mutex_unlock(&worker->lock);
+
+    sem_post(&worker->items);
+}
+
+int dlt_daemon_logstorage_worker_sync_wait(DltDaemonLogstorageWorker *worker)
+{
+    int ret;
+
+    if ((worker == NULL) || (worker->queue == NULL))
+        return -1;
+
+    pthread_mutex_lock(&worker->lock);
+
+    while (worker->sync_pending)
+        pthread_cond_wait(&worker->idle, &worker->lock);
+
+    ret = worker->sync_result;
+
+    pthread_mutex_unlock(&worker->lock);
+
+    return ret;
+}
+
+void dlt_daemon_logstorage_worker_unlock(DltDaemonLogstorageWorker *worker)
+{
+    if ((worker == NULL) || (worker->queue == NULL))
+        return;
+
+    pthread_mutex_unlock(&worker->lock);
+}
+
+unsigned int dlt_daemon_logstorage_worker_get_depth(DltDaemonLogstorageWorker *worker)
+{
+    if ((worker == NULL) || (worker->queue == NULL))
+        return 0;
+
+    return atomic_load(&worker->head) - atomic_load(&worker->tail);
+}
+
+void dlt_daemon_logstorage_worker_log_stats(DltDaemonLogstorageWorker *worker, int index)
+{
+    if ((worker == NULL) || (worker->queue == NULL))
+        return;
+
+    dlt_vlog(LOG_INFO,
+             "Logstorage device %d: queue depth %u (max %u of %u), %u messages dropped\n",
+             index,
+             dlt_daemon_logstorage_worker_get_depth(worker),
+             atomic_load(&worker->max_depth),
+             worker->size,
+             atomic_load(&worker->dropped));
+}
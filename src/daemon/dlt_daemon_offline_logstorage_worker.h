@@ -0,0 +1,185 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_offline_logstorage_worker.h
+ */
+
+#ifndef DLT_DAEMON_OFFLINE_LOGSTORAGE_WORKER_H
+#define DLT_DAEMON_OFFLINE_LOGSTORAGE_WORKER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#include "dlt_offline_logstorage.h"
+#include "dlt_daemon_metrics_types.h"
+
+#define DLT_DAEMON_LOGSTORAGE_QUEUE_SIZE 1024 /* Default number of queued messages per device */
+
+/**
+ * A message queued for offline logstorage. The same message is referenced
+ * by the queue of every device, it is freed when the last reference is
+ * released.
+ */
+typedef struct
+{
+    atomic_int refs;        /**< number of references */
+    int size1;              /**< size of the storage header */
+    int size2;              /**< size of the message header */
+    int size3;              /**< size of the payload */
+    unsigned char data[];   /**< storage header, message header and payload */
+} DltLogStorageMsg;
+
+/**
+ * I/O worker thread of one logstorage device.
+ *
+ * The event loop is the only producer and the worker the only consumer of
+ * the queue, so head is updated without lock. The lock is held by the worker
+ * while it writes to or syncs the device and by the event loop while it
+ * connects or disconnects the device. Cache syncs requested by the event loop
+ * are run by the worker once the messages queued before the request are
+ * written.
+ */
+typedef struct
+{
+    DltLogStorage *handle;              /**< device served by the worker */
+    DltLogStorageUserConfig uconfig;    /**< user configuration of the log file names */
+    pthread_t thread;                   /**< worker thread */
+    pthread_mutex_t lock;               /**< serializes the access to the device */
+    pthread_cond_t idle;                /**< signalled when the queue is empty or a sync is done */
+    sem_t items;                        /**< number of queued messages */
+    sem_t slots;                        /**< number of free queue entries */
+    DltLogStorageMsg **queue;           /**< queued messages */
+    unsigned int size;                  /**< number of queue entries */
+    atomic_uint head;                   /**< total number of queued messages */
+    atomic_uint tail;                   /**< total number of written messages, updated under lock */
+    int sync_pending;                   /**< cache sync requested, protected by lock */
+    unsigned int sync_at;               /**< value of head when the sync was requested */
+    int sync_result;                    /**< result of the last sync, protected by lock */
+    atomic_uint max_depth;              /**< highest queue depth seen */
+    atomic_uint dropped;                /**< messages dropped because the queue was full */
+    atomic_int failed;                  /**< set by the worker after too many write errors */
+    atomic_int running;                 /**< cleared to stop the worker */
+    int blocking;                       /**< 1: wait for a free entry when full, 0: drop */
+    DltDaemonMetricsThread metrics;     /**< messages the worker failed to write */
+} DltDaemonLogstorageWorker;
+
+/**
+ * Create a message referenced by the device queues.
+ *
+ * @param data1 storage header
+ * @param size1 size of storage header
+ * @param data2 message header
+ * @param size2 size of message header
+ * @param data3 payload
+ * @param size3 size of payload
+ * @return message with one reference, NULL on error
+ */
+DltLogStorageMsg *dlt_daemon_logstorage_msg_create(unsigned char *data1,
+                                                   int size1,
+                                                   unsigned char *data2,
+                                                   int size2,
+                                                   unsigned char *data3,
+                                                   int size3);
+
+/**
+ * Release a reference to a message, the message is freed with the last one.
+ *
+ * @param msg message
+ */
+void dlt_daemon_logstorage_msg_release(DltLogStorageMsg *msg);
+
+/**
+ * Initialise a worker and start its thread.
+ *
+ * @param worker worker to initialise
+ * @param handle logstorage device
+ * @param uconfig user configuration of the log file names
+ * @param size number of queue entries
+ * @param blocking 1 to block the caller when the queue is full, 0 to drop
+ * @return 0 on success, -1 on error
+ */
+int dlt_daemon_logstorage_worker_init(DltDaemonLogstorageWorker *worker,
+                                      DltLogStorage *handle,
+                                      DltLogStorageUserConfig *uconfig,
+                                      unsigned int size,
+                                      int blocking);
+
+/**
+ * Write all queued messages, stop the worker thread and free the worker.
+ *
+ * @param worker worker to free
+ */
+void dlt_daemon_logstorage_worker_free(DltDaemonLogstorageWorker *worker);
+
+/**
+ * Queue a message for the device, a reference is taken on success.
+ *
+ * @param worker worker of the device
+ * @param msg message
+ * @return 0 on success, -1 if the message was dropped
+ */
+int dlt_daemon_logstorage_worker_enqueue(DltDaemonLogstorageWorker *worker,
+                                         DltLogStorageMsg *msg);
+
+/**
+ * Wait until all queued messages are written, then take the device lock.
+ *
+ * @param worker worker of the device
+ */
+void dlt_daemon_logstorage_worker_lock(DltDaemonLogstorageWorker *worker);
+
+/**
+ * Request a cache sync of the device. The sync is run by the worker after
+ * the messages queued so far are written, the call does not wait for it.
+ *
+ * @param worker worker of the device
+ */
+void dlt_daemon_logstorage_worker_sync(DltDaemonLogstorageWorker *worker);
+
+/**
+ * Wait until the requested cache sync of the device is done.
+ *
+ * @param worker worker of the device
+ * @return result of the sync, 0 on success, -1 otherwise
+ */
+int dlt_daemon_logstorage_worker_sync_wait(DltDaemonLogstorageWorker *worker);
+
+/**
+ * Release the device lock.
+ *
+ * @param worker worker of the device
+ */
+void dlt_daemon_logstorage_worker_unlock(DltDaemonLogstorageWorker *worker);
+
+/**
+ * Get the number of messages waiting in the queue.
+ *
+ * @param worker worker of the device
+ * @return queue depth
+ */
+unsigned int dlt_daemon_logstorage_worker_get_depth(DltDaemonLogstorageWorker *worker);
+
+/**
+ * Log queue depth and drop counter of a worker.
+ *
+ * @param worker worker of the device
+ * @param index device index
+ */
+void dlt_daemon_logstorage_worker_log_stats(DltDaemonLogstorageWorker *worker, int index);
+
+#endif /* DLT_DAEMON_OFFLINE_LOGSTORAGE_WORKER_H */
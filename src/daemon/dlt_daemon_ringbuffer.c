@@ -0,0 +1,408 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_ringbuffer.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+
+#include "dlt_common.h"
+#include "dlt_protocol.h"
+#include "dlt_daemon_ringbuffer.h"
+
+static const char *const dlt_daemon_ringbuffer_class_names[DLT_DAEMON_RINGBUFFER_CLASS_MAX] = {
+    "high", "medium", "low"
+};
+
+/* bytes allocated by a class buffer */
+static uint32_t dlt_daemon_ringbuffer_allocated(DltBuffer *buf)
+{
+    return (uint32_t)(buf->size + sizeof(DltBufferHead));
+}
+
+/**
+ * Limit the growth of a class to its own limit and to the memory not yet
+ * allocated by the other classes.
+ */
+static void dlt_daemon_ringbuffer_update_max_size(DltDaemonRingbuffer *rb, int cls)
+{
+    uint32_t allocated = 0;
+    uint32_t own = dlt_daemon_ringbuffer_allocated(&(rb->buffer[cls]));
+    uint32_t max_size;
+    int i;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        allocated += dlt_daemon_ringbuffer_allocated(&(rb->buffer[i]));
+
+    if (allocated < rb->max_size)
+        max_size = own + (rb->max_size - allocated);
+    else
+        max_size = own;
+
+    if (max_size > rb->limit[cls])
+        max_size = (rb->limit[cls] > own) ? rb->limit[cls] : own;
+
+    rb->buffer[cls].max_size = max_size;
+}
+
+/**
+ * Move the stored messages into a buffer of the smallest size holding them.
+ */
+static int dlt_daemon_ringbuffer_compact(DltBuffer *buf)
+{
+    DltBufferHead *head = (DltBufferHead *)buf->shm;
+    DltBufferHead *new_head;
+    unsigned char *new_ptr;
+    unsigned char *new_mem;
+    uint32_t used = (uint32_t)dlt_buffer_get_used_size(buf);
+    uint32_t new_size = buf->min_size;
+    uint32_t first;
+
+    while ((new_size - sizeof(DltBufferHead)) < used)
+        new_size += buf->step_size;
+
+    if (new_size >= dlt_daemon_ringbuffer_allocated(buf))
+        return DLT_RETURN_OK;
+
+    new_ptr = malloc(new_size);
+
+    if (new_ptr == NULL) {
+        dlt_vlog(LOG_WARNING, "%s: Cannot allocate %u bytes\n", __func__, new_size);
+        return DLT_RETURN_ERROR;
+    }
+
+    new_mem = new_ptr + sizeof(DltBufferHead);
+
+    /* copy the stored messages to the beginning of the new memory */
+    if (head->read < head->write) {
+        memcpy(new_mem, buf->mem + head->read, used);
+    }
+    else if (used > 0) {
+        first = buf->size - (uint32_t)head->read;
+        memcpy(new_mem, buf->mem + head->read, first);
+        memcpy(new_mem + first, buf->mem, used - first);
+    }
+
+    new_head = (DltBufferHead *)new_ptr;
+    new_head->write = (int)used;
+    new_head->read = 0;
+    new_head->count = head->count;
+
+    free(buf->shm);
+    buf->shm = new_ptr;
+    buf->mem = new_mem;
+    buf->size = (uint32_t)(new_size - sizeof(DltBufferHead));
+
+    return DLT_RETURN_OK;
+}
+
+/**
+ * Evict the oldest messages of the lowest class below cls which can release
+ * memory, until at least one step is released.
+ */
+static int dlt_daemon_ringbuffer_evict(DltDaemonRingbuffer *rb, int cls)
+{
+    DltBuffer *buf;
+    int victim;
+
+    for (victim = DLT_DAEMON_RINGBUFFER_CLASS_MAX - 1; victim > cls; victim--) {
+        buf = &(rb->buffer[victim]);
+
+        if (dlt_daemon_ringbuffer_allocated(buf) <= buf->min_size)
+            continue;
+
+        while ((dlt_buffer_get_message_count(buf) > 0) &&
+               ((uint32_t)dlt_buffer_get_used_size(buf) + buf->step_size > buf->size)) {
+            dlt_buffer_remove(buf);
+            rb->stats[victim].evicted++;
+        }
+
+        return dlt_daemon_ringbuffer_compact(buf);
+    }
+
+    return DLT_RETURN_ERROR;
+}
+
+int dlt_daemon_ringbuffer_init(DltDaemonRingbuffer *rb,
+                               uint32_t min_size,
+                               uint32_t max_size,
+                               uint32_t step_size)
+{
+    int i;
+
+    if (rb == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    memset(rb, 0, sizeof(DltDaemonRingbuffer));
+    rb->max_size = max_size;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++) {
+        if (dlt_buffer_init_dynamic(&(rb->buffer[i]), min_size, max_size, step_size) < DLT_RETURN_OK) {
+            while (--i >= 0)
+                dlt_buffer_free_dynamic(&(rb->buffer[i]));
+
+            return DLT_RETURN_ERROR;
+        }
+
+        rb->limit[i] = max_size;
+    }
+
+    return DLT_RETURN_OK;
+}
+
+void dlt_daemon_ringbuffer_free(DltDaemonRingbuffer *rb)
+{
+    int i;
+
+    if (rb == NULL)
+        return;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        dlt_buffer_free_dynamic(&(rb->buffer[i]));
+}
+
+void dlt_daemon_ringbuffer_set_limits(DltDaemonRingbuffer *rb,
+                                      const unsigned int limits[DLT_DAEMON_RINGBUFFER_CLASS_MAX])
+{
+    uint64_t limit;
+    int i;
+
+    if ((rb == NULL) || (limits == NULL))
+        return;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++) {
+        limit = (uint64_t)rb->max_size * limits[i] / 100;
+
+        if (limit > rb->max_size)
+            limit = rb->max_size;
+
+        /* a class always keeps its minimum size allocated */
+        if (limit < rb->buffer[i].min_size)
+            limit = rb->buffer[i].min_size;
+
+        rb->limit[i] = (uint32_t)limit;
+    }
+
+    dlt_vlog(LOG_INFO, "Ringbuffer class limits: %u/%u/%u\n",
+             rb->limit[DLT_DAEMON_RINGBUFFER_CLASS_HIGH],
+             rb->limit[DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM],
+             rb->limit[DLT_DAEMON_RINGBUFFER_CLASS_LOW]);
+}
+
+DltDaemonRingbufferClass dlt_daemon_ringbuffer_get_class(const uint8_t *data, int size)
+{
+    const DltStandardHeader *standardheader;
+    const DltExtendedHeader *extendedheader;
+    int offset;
+
+    if ((data == NULL) || (size < (int)sizeof(DltStandardHeader)))
+        return DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM;
+
+    standardheader = (const DltStandardHeader *)data;
+
+    if (!DLT_IS_HTYP_UEH(standardheader->htyp))
+        return DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM;
+
+    offset = (int)(sizeof(DltStandardHeader) + DLT_STANDARD_HEADER_EXTRA_SIZE(standardheader->htyp));
+
+    if (size < offset + (int)sizeof(DltExtendedHeader))
+        return DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM;
+
+    extendedheader = (const DltExtendedHeader *)(data + offset);
+
+    switch (DLT_GET_MSIN_MSTP(extendedheader->msin)) {
+    case DLT_TYPE_LOG:
+
+        switch (DLT_GET_MSIN_MTIN(extendedheader->msin)) {
+        case DLT_LOG_FATAL:
+        case DLT_LOG_ERROR:
+            return DLT_DAEMON_RINGBUFFER_CLASS_HIGH;
+        case DLT_LOG_DEBUG:
+        case DLT_LOG_VERBOSE:
+            return DLT_DAEMON_RINGBUFFER_CLASS_LOW;
+        default:
+            return DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM;
+        }
+
+    case DLT_TYPE_CONTROL:
+        return DLT_DAEMON_RINGBUFFER_CLASS_HIGH;
+    default:
+        return DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM;
+    }
+}
+
+int dlt_daemon_ringbuffer_push(DltDaemonRingbuffer *rb,
+                               const uint8_t *data1,
+                               int size1,
+                               const uint8_t *data2,
+                               int size2)
+{
+    DltDaemonRingbufferClass cls;
+    DltBuffer *buf;
+
+    if (rb == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    cls = dlt_daemon_ringbuffer_get_class(data1, size1);
+    buf = &(rb->buffer[cls]);
+
+    for (;;) {
+        dlt_daemon_ringbuffer_update_max_size(rb, cls);
+
+        if (dlt_buffer_push3(buf, data1, (unsigned int)size1, data2, (unsigned int)size2, 0, 0) == DLT_RETURN_OK) {
+            rb->stats[cls].stored++;
+            return DLT_RETURN_OK;
+        }
+
+        /* the class reached its own limit, evicting other classes does not help */
+        if (dlt_daemon_ringbuffer_allocated(buf) + buf->step_size > rb->limit[cls])
+            break;
+
+        if (dlt_daemon_ringbuffer_evict(rb, cls) != DLT_RETURN_OK)
+            break;
+    }
+
+    rb->stats[cls].discarded++;
+
+    return DLT_RETURN_ERROR;
+}
+
+int dlt_daemon_ringbuffer_get_message_count(DltDaemonRingbuffer *rb)
+{
+    int count = 0;
+    int i;
+
+    if (rb == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        count += dlt_buffer_get_message_count(&(rb->buffer[i]));
+
+    return count;
+}
+
+DltBuffer *dlt_daemon_ringbuffer_next(DltDaemonRingbuffer *rb)
+{
+    int i;
+
+    if (rb == NULL)
+        return NULL;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        if (dlt_buffer_get_message_count(&(rb->buffer[i])) > 0)
+            return &(rb->buffer[i]);
+
+    return NULL;
+}
+
+int dlt_daemon_ringbuffer_map(DltBuffer *buf,
+                              struct iovec *iov,
+                              int iov_max,
+                              int serialheader,
+                              size_t max_bytes,
+                              int *messages)
+{
+    DltBufferHead *head;
+    DltBufferBlockHead block;
+    uint32_t read;
+    uint32_t first;
+    size_t bytes = 0;
+    int needed;
+    int count;
+    int iovcnt = 0;
+
+    if ((buf == NULL) || (buf->shm == NULL) || (iov == NULL) || (messages == NULL))
+        return 0;
+
+    *messages = 0;
+    head = (DltBufferHead *)buf->shm;
+    read = (uint32_t)head->read;
+    count = head->count;
+
+    while ((*messages < count) && (bytes < max_bytes)) {
+        /* the block head may wrap around the end of the buffer */
+        first = buf->size - read;
+
+        if (first >= sizeof(DltBufferBlockHead)) {
+            memcpy(&block, buf->mem + read, sizeof(DltBufferBlockHead));
+        }
+        else {
+            memcpy(&block, buf->mem + read, first);
+            memcpy((uint8_t *)&block + first, buf->mem, sizeof(DltBufferBlockHead) - first);
+        }
+
+        if ((memcmp(block.head, DLT_BUFFER_HEAD, sizeof(DLT_BUFFER_HEAD)) != 0) ||
+            (block.status != 2) || (block.size <= 0) || ((uint32_t)block.size > buf->size)) {
+            dlt_vlog(LOG_ERR, "%s: Buffer: Invalid block head\n", __func__);
+            break;
+        }
+
+        read = (read + sizeof(DltBufferBlockHead)) % buf->size;
+        first = buf->size - read;
+        needed = ((uint32_t)block.size > first) ? 2 : 1;
+
+        if (serialheader)
+            needed++;
+
+        if (iovcnt + needed > iov_max)
+            break;
+
+        if (serialheader) {
+            iov[iovcnt].iov_base = (void *)dltSerialHeader;
+            iov[iovcnt].iov_len = sizeof(dltSerialHeader);
+            iovcnt++;
+        }
+
+        iov[iovcnt].iov_base = buf->mem + read;
+
+        if ((uint32_t)block.size > first) {
+            iov[iovcnt].iov_len = first;
+            iovcnt++;
+            iov[iovcnt].iov_base = buf->mem;
+            iov[iovcnt].iov_len = (size_t)block.size - first;
+        }
+        else {
+            iov[iovcnt].iov_len = (size_t)block.size;
+        }
+
+        iovcnt++;
+        read = (read + (uint32_t)block.size) % buf->size;
+        bytes += (size_t)block.size;
+        (*messages)++;
+    }
+
+    return iovcnt;
+}
+
+void dlt_daemon_ringbuffer_log_stats(DltDaemonRingbuffer *rb)
+{
+    int i;
+
+    if (rb == NULL)
+        return;
+
+    for (i = 0; i < DLT_DAEMON_RINGBUFFER_CLASS_MAX; i++)
+        dlt_vlog(LOG_INFO,
+                 "Ringbuffer class %s: %d buffered, %u stored, %u evicted, %u discarded\n",
+                 dlt_daemon_ringbuffer_class_names[i],
+                 dlt_buffer_get_message_count(&(rb->buffer[i])),
+                 rb->stats[i].stored,
+                 rb->stats[i].evicted,
+                 rb->stats[i].discarded);
+}
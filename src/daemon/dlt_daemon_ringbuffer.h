@@ -0,0 +1,169 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_daemon_ringbuffer.h
+ */
+
+#ifndef DLT_DAEMON_RINGBUFFER_H
+#define DLT_DAEMON_RINGBUFFER_H
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "dlt_common.h"
+
+/* Default share of the ring buffer max size each class may use, in percent */
+#define DLT_DAEMON_RINGBUFFER_HIGH_LIMIT      100
+#define DLT_DAEMON_RINGBUFFER_MEDIUM_LIMIT     80
+#define DLT_DAEMON_RINGBUFFER_LOW_LIMIT        50
+
+/**
+ * Priority classes of the client ring buffer, highest priority first.
+ */
+typedef enum
+{
+    DLT_DAEMON_RINGBUFFER_CLASS_HIGH = 0,   /**< fatal and error logs, control messages */
+    DLT_DAEMON_RINGBUFFER_CLASS_MEDIUM,     /**< warning and info logs, all other messages */
+    DLT_DAEMON_RINGBUFFER_CLASS_LOW,        /**< debug and verbose logs */
+    DLT_DAEMON_RINGBUFFER_CLASS_MAX
+} DltDaemonRingbufferClass;
+
+/**
+ * Statistics of one ring buffer class.
+ */
+typedef struct
+{
+    uint32_t stored;    /**< number of messages stored */
+    uint32_t evicted;   /**< stored messages removed to make room for a higher class */
+    uint32_t discarded; /**< new messages discarded because there was no room */
+} DltDaemonRingbufferStats;
+
+/**
+ * Ring buffer storing messages while no client is connected.
+ *
+ * Each class has its own DltBuffer which grows on demand. All classes
+ * together never allocate more than max_size bytes. When the memory is
+ * exhausted, the oldest messages of lower classes are evicted to make room
+ * for a message of a higher class.
+ */
+typedef struct
+{
+    DltBuffer buffer[DLT_DAEMON_RINGBUFFER_CLASS_MAX]; /**< buffer of each class */
+    uint32_t limit[DLT_DAEMON_RINGBUFFER_CLASS_MAX];   /**< max bytes each class may allocate */
+    DltDaemonRingbufferStats stats[DLT_DAEMON_RINGBUFFER_CLASS_MAX]; /**< statistics of each class */
+    uint32_t max_size;                                 /**< max bytes all classes may allocate */
+} DltDaemonRingbuffer;
+
+/**
+ * Initialise the ring buffer, each class may use the whole max size.
+ *
+ * @param rb pointer to ring buffer
+ * @param min_size initial size of each class
+ * @param max_size maximum size of all classes together
+ * @param step_size size a class is grown by
+ * @return negative value if there was an error
+ */
+int dlt_daemon_ringbuffer_init(DltDaemonRingbuffer *rb,
+                               uint32_t min_size,
+                               uint32_t max_size,
+                               uint32_t step_size);
+
+/**
+ * Free the ring buffer.
+ *
+ * @param rb pointer to ring buffer
+ */
+void dlt_daemon_ringbuffer_free(DltDaemonRingbuffer *rb);
+
+/**
+ * Set the share of the max size each class may use.
+ *
+ * @param rb pointer to ring buffer
+ * @param limits percentage of the max size, one per class
+ */
+void dlt_daemon_ringbuffer_set_limits(DltDaemonRingbuffer *rb,
+                                      const unsigned int limits[DLT_DAEMON_RINGBUFFER_CLASS_MAX]);
+
+/**
+ * Get the class of a message from its headers.
+ *
+ * @param data message starting with the standard header
+ * @param size size of data
+ * @return class of the message
+ */
+DltDaemonRingbufferClass dlt_daemon_ringbuffer_get_class(const uint8_t *data, int size);
+
+/**
+ * Store a message, evicting messages of lower classes if needed.
+ *
+ * @param rb pointer to ring buffer
+ * @param data1 first part of the message, starting with the standard header
+ * @param size1 size of data1
+ * @param data2 second part of the message
+ * @param size2 size of data2
+ * @return DLT_RETURN_OK on success, DLT_RETURN_ERROR if the message was discarded
+ */
+int dlt_daemon_ringbuffer_push(DltDaemonRingbuffer *rb,
+                               const uint8_t *data1,
+                               int size1,
+                               const uint8_t *data2,
+                               int size2);
+
+/**
+ * Get the number of messages stored in all classes.
+ *
+ * @param rb pointer to ring buffer
+ * @return number of messages
+ */
+int dlt_daemon_ringbuffer_get_message_count(DltDaemonRingbuffer *rb);
+
+/**
+ * Get the buffer of the highest class which holds messages.
+ *
+ * @param rb pointer to ring buffer
+ * @return buffer to be drained next, NULL if all classes are empty
+ */
+DltBuffer *dlt_daemon_ringbuffer_next(DltDaemonRingbuffer *rb);
+
+/**
+ * Map consecutive messages of a class buffer into iovecs without copying
+ * them. The messages stay in the buffer until dlt_buffer_remove() is called
+ * for each of them.
+ *
+ * @param buf class buffer returned by dlt_daemon_ringbuffer_next()
+ * @param iov array of iovecs to fill
+ * @param iov_max size of the iov array
+ * @param serialheader 1 to put the serial header in front of each message
+ * @param max_bytes stop mapping when this many bytes are mapped
+ * @param messages returns the number of mapped messages
+ * @return number of used iovecs
+ */
+int dlt_daemon_ringbuffer_map(DltBuffer *buf,
+                              struct iovec *iov,
+                              int iov_max,
+                              int serialheader,
+                              size_t max_bytes,
+                              int *messages);
+
+/**
+ * Log the statistics of all classes.
+ *
+ * @param rb pointer to ring buffer
+ */
+void dlt_daemon_ringbuffer_log_stats(DltDaemonRingbuffer *rb);
+
+#endif /* DLT_DAEMON_RINGBUFFER_H */
@@ -57,8 +57,11 @@
 #include <syslog.h>
 #include <errno.h>
 #include <unistd.h>
+#include <inttypes.h>
+#include <poll.h>
 
 #include <sys/socket.h> /* send() */
+#include <sys/uio.h>
 
 #include "dlt-daemon.h"
 
@@ -73,26 +76,328 @@ int dlt_daemon_serial_send(int sock,
                            int size2,
                            char serialheader)
 {
+    struct iovec iov[3];
+    struct iovec *next = iov;
+    struct pollfd pfd;
+    int iovcnt = 0;
+    ssize_t ret;
+
     /* Optional: Send serial header, if requested */
     if (serialheader) {
-        if (0 > write(sock, dltSerialHeader, sizeof(dltSerialHeader))) {
+        iov[iovcnt].iov_base = (void *)dltSerialHeader;
+        iov[iovcnt++].iov_len = sizeof(dltSerialHeader);
+    }
+
+    if (data1 && (size1 > 0)) {
+        iov[iovcnt].iov_base = data1;
+        iov[iovcnt++].iov_len = (size_t)size1;
+    }
+
+    if (data2 && (size2 > 0)) {
+        iov[iovcnt].iov_base = data2;
+        iov[iovcnt++].iov_len = (size_t)size2;
+    }
+
+    while (iovcnt > 0) {
+        ret = writev(sock, next, iovcnt);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                /* the device is non-blocking, wait until the UART drained */
+                pfd.fd = sock;
+                pfd.events = POLLOUT;
+
+                if ((poll(&pfd, 1, -1) < 0) && (errno != EINTR))
+                    return DLT_DAEMON_ERROR_SEND_FAILED;
+
+                continue;
+            }
+
             return DLT_DAEMON_ERROR_SEND_FAILED;
         }
+
+        /* skip what was sent, a partial write may stop within a buffer */
+        while ((iovcnt > 0) && ((size_t)ret >= next->iov_len)) {
+            ret -= (ssize_t)next->iov_len;
+            next++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            next->iov_base = (uint8_t *)next->iov_base + ret;
+            next->iov_len -= (size_t)ret;
+        }
     }
 
-    /* Send data */
+    return DLT_DAEMON_ERROR_OK;
+}
 
-    if (data1 && (size1 > 0)) {
-        if (0 > write(sock, data1, size1)) {
-            return DLT_DAEMON_ERROR_SEND_FAILED;
+DltDaemonSerialQueue *dlt_daemon_serial_queue_create(uint32_t size)
+{
+    DltDaemonSerialQueue *queue = NULL;
+
+    if (size == 0)
+        return NULL;
+
+    queue = calloc(1, sizeof(DltDaemonSerialQueue));
+
+    if (queue == NULL)
+        return NULL;
+
+    /* no message is smaller than a standard header */
+    queue->max_entries = size / sizeof(DltStandardHeader) + 1;
+    queue->buffer = malloc(size);
+    queue->entries = calloc(queue->max_entries, sizeof(DltDaemonSerialQueueEntry));
+
+    if ((queue->buffer == NULL) || (queue->entries == NULL)) {
+        dlt_daemon_serial_queue_free(queue);
+        return NULL;
+    }
+
+    queue->size = size;
+
+    return queue;
+}
+
+void dlt_daemon_serial_queue_free(DltDaemonSerialQueue *queue)
+{
+    if (queue == NULL)
+        return;
+
+    if (queue->dropped > 0)
+        dlt_vlog(LOG_INFO, "Serial queue dropped %" PRIu64 " messages\n", queue->dropped);
+
+    free(queue->buffer);
+    free(queue->entries);
+    free(queue);
+}
+
+uint8_t dlt_daemon_serial_get_level(const uint8_t *header, int size)
+{
+    const DltStandardHeader *standard = (const DltStandardHeader *)header;
+    const DltExtendedHeader *extended = NULL;
+    int offset;
+
+    if ((header == NULL) || (size < (int)sizeof(DltStandardHeader)) ||
+        !DLT_IS_HTYP_UEH(standard->htyp))
+        return DLT_LOG_INFO;
+
+    offset = (int)(sizeof(DltStandardHeader) + DLT_STANDARD_HEADER_EXTRA_SIZE(standard->htyp));
+
+    if (size < offset + (int)sizeof(DltExtendedHeader))
+        return DLT_LOG_INFO;
+
+    extended = (const DltExtendedHeader *)(header + offset);
+
+    switch (DLT_GET_MSIN_MSTP(extended->msin)) {
+    case DLT_TYPE_LOG:
+        return (uint8_t)DLT_GET_MSIN_MTIN(extended->msin);
+    case DLT_TYPE_CONTROL:
+        return DLT_DAEMON_SERIAL_LEVEL_CONTROL;
+    default:
+        return DLT_LOG_VERBOSE;
+    }
+}
+
+/* Entry of the k-th queued message */
+static DltDaemonSerialQueueEntry *dlt_daemon_serial_queue_entry(DltDaemonSerialQueue *queue, uint32_t k)
+{
+    return &(queue->entries[(queue->first + k) % queue->max_entries]);
+}
+
+/* Move the queued bytes to the start of the buffer */
+static void dlt_daemon_serial_queue_compact(DltDaemonSerialQueue *queue)
+{
+    if (queue->begin == 0)
+        return;
+
+    memmove(queue->buffer, queue->buffer + queue->begin, queue->end - queue->begin);
+    queue->end -= queue->begin;
+    queue->begin = 0;
+}
+
+/* Remove the k-th queued message, which starts at offset in the buffer */
+static void dlt_daemon_serial_queue_remove(DltDaemonSerialQueue *queue, uint32_t k, uint32_t offset)
+{
+    uint32_t size = dlt_daemon_serial_queue_entry(queue, k)->size;
+
+    memmove(queue->buffer + offset, queue->buffer + offset + size, queue->end - offset - size);
+    queue->end -= size;
+
+    for (; k + 1 < queue->count; k++)
+        *dlt_daemon_serial_queue_entry(queue, k) = *dlt_daemon_serial_queue_entry(queue, k + 1);
+
+    queue->count--;
+    queue->dropped++;
+}
+
+/* Drop queued messages of a less important level than level until size
+ * bytes are free. Nothing is dropped if that is not possible. */
+static int dlt_daemon_serial_queue_make_room(DltDaemonSerialQueue *queue, uint32_t size, uint8_t level)
+{
+    DltDaemonSerialQueueEntry *entry = NULL;
+    uint32_t skip = (queue->written > 0) ? 1 : 0;
+    uint32_t free_size = queue->size - (queue->end - queue->begin);
+    uint32_t offset, victim_offset, victim;
+    uint32_t k;
+
+    /* a partly written message cannot be dropped without breaking the stream */
+    for (k = skip; k < queue->count; k++) {
+        entry = dlt_daemon_serial_queue_entry(queue, k);
+
+        if (entry->level > level)
+            free_size += entry->size;
+    }
+
+    if ((free_size < size) || ((queue->count - skip) == 0))
+        return -1;
+
+    dlt_daemon_serial_queue_compact(queue);
+
+    while ((queue->size - queue->end < size) || (queue->count >= queue->max_entries)) {
+        /* the oldest message of the least important level goes first */
+        victim = queue->count;
+        victim_offset = 0;
+        offset = (skip > 0) ? (dlt_daemon_serial_queue_entry(queue, 0)->size - queue->written) : 0;
+
+        for (k = skip; k < queue->count; k++) {
+            entry = dlt_daemon_serial_queue_entry(queue, k);
+
+            if ((entry->level > level) &&
+                ((victim == queue->count) ||
+                 (entry->level > dlt_daemon_serial_queue_entry(queue, victim)->level))) {
+                victim = k;
+                victim_offset = offset;
+            }
+
+            offset += entry->size;
         }
+
+        if (victim == queue->count)
+            return -1;
+
+        dlt_daemon_serial_queue_remove(queue, victim, victim_offset);
+    }
+
+    return 0;
+}
+
+int dlt_daemon_serial_queue_add(DltDaemonSerialQueue *queue,
+                                void *data1,
+                                int size1,
+                                void *data2,
+                                int size2,
+                                char serialheader,
+                                uint8_t level)
+{
+    DltDaemonSerialQueueEntry *entry = NULL;
+    uint32_t size = 0;
+
+    if (queue == NULL)
+        return DLT_DAEMON_ERROR_UNKNOWN;
+
+    if (serialheader)
+        size += sizeof(dltSerialHeader);
+
+    if (data1 && (size1 > 0))
+        size += (uint32_t)size1;
+
+    if (data2 && (size2 > 0))
+        size += (uint32_t)size2;
+
+    if (size == 0)
+        return DLT_DAEMON_ERROR_OK;
+
+    if (size > queue->size) {
+        queue->dropped++;
+        return DLT_DAEMON_ERROR_BUFFER_FULL;
+    }
+
+    if (queue->size - queue->end < size)
+        dlt_daemon_serial_queue_compact(queue);
+
+    if (((queue->size - queue->end < size) || (queue->count >= queue->max_entries)) &&
+        (dlt_daemon_serial_queue_make_room(queue, size, level) != 0)) {
+        queue->dropped++;
+        return DLT_DAEMON_ERROR_BUFFER_FULL;
+    }
+
+    if (serialheader) {
+        memcpy(queue->buffer + queue->end, dltSerialHeader, sizeof(dltSerialHeader));
+        queue->end += sizeof(dltSerialHeader);
+    }
+
+    if (data1 && (size1 > 0)) {
+        memcpy(queue->buffer + queue->end, data1, (size_t)size1);
+        queue->end += (uint32_t)size1;
     }
 
     if (data2 && (size2 > 0)) {
-        if (0 > write(sock, data2, size2)) {
-            return DLT_DAEMON_ERROR_SEND_FAILED;
-        }
+        memcpy(queue->buffer + queue->end, data2, (size_t)size2);
+        queue->end += (uint32_t)size2;
     }
 
+    entry = dlt_daemon_serial_queue_entry(queue, queue->count);
+    entry->size = size;
+    entry->level = level;
+    queue->count++;
+
     return DLT_DAEMON_ERROR_OK;
 }
+
+int dlt_daemon_serial_queue_flush(DltDaemonSerialQueue *queue, int fd, int *messages)
+{
+    DltDaemonSerialQueueEntry *entry = NULL;
+    ssize_t ret;
+    uint32_t done;
+
+    if (messages != NULL)
+        *messages = 0;
+
+    if (queue == NULL)
+        return -1;
+
+    if (queue->begin == queue->end)
+        return 0;
+
+    do
+        ret = write(fd, queue->buffer + queue->begin, queue->end - queue->begin);
+    while ((ret < 0) && (errno == EINTR));
+
+    if (ret < 0)
+        return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1;
+
+    queue->begin += (uint32_t)ret;
+    done = queue->written + (uint32_t)ret;
+
+    while (queue->count > 0) {
+        entry = dlt_daemon_serial_queue_entry(queue, 0);
+
+        if (done < entry->size)
+            break;
+
+        done -= entry->size;
+        queue->first = (queue->first + 1) % queue->max_entries;
+        queue->count--;
+
+        if (messages != NULL)
+            (*messages)++;
+    }
+
+    queue->written = done;
+
+    if (queue->begin == queue->end) {
+        queue->begin = 0;
+        queue->end = 0;
+    }
+
+    return (int)ret;
+}
+
+int dlt_daemon_serial_queue_pending(const DltDaemonSerialQueue *queue)
+{
+    return (queue != NULL) && (queue->begin != queue->end);
+}
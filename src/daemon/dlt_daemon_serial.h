@@ -60,6 +60,59 @@
 #include "dlt_common.h"
 #include "dlt_user.h"
 
+/* Level of queued messages which are not log messages, never dropped
+ * for a log message */
+#define DLT_DAEMON_SERIAL_LEVEL_CONTROL 0
+
+/**
+ * A message in the serial queue.
+ */
+typedef struct
+{
+    uint32_t size;      /**< size of the message with its serial header */
+    uint8_t level;      /**< log level, DLT_DAEMON_SERIAL_LEVEL_CONTROL if no log message */
+} DltDaemonSerialQueueEntry;
+
+/**
+ * Output queue of a serial connection.
+ *
+ * Messages are copied behind each other with their serial header, so
+ * everything queued is written with a single non-blocking write(). A
+ * message which is partly written stays at the head until it is complete,
+ * the stream is never cut within a message. When the UART cannot keep up
+ * and the queue is full, the queued log messages of the least important
+ * level are dropped first to make room.
+ */
+typedef struct DltDaemonSerialQueue
+{
+    uint8_t *buffer;                        /**< queued messages */
+    uint32_t size;                          /**< size of the buffer */
+    uint32_t begin;                         /**< offset of the first byte not written */
+    uint32_t end;                           /**< offset after the last queued byte */
+    DltDaemonSerialQueueEntry *entries;     /**< ring of the queued messages */
+    uint32_t max_entries;                   /**< size of the ring */
+    uint32_t first;                         /**< index of the head message */
+    uint32_t count;                         /**< number of queued messages */
+    uint32_t written;                       /**< bytes of the head message already written */
+    int output;                             /**< 1 while the fd is polled for POLLOUT */
+    int dropping;                           /**< 1 from the first drop until the queue is written */
+    uint64_t dropped;                       /**< messages dropped because the queue was full */
+} DltDaemonSerialQueue;
+
+/**
+ * Send a message to a serial device.
+ *
+ * The serial header and both parts are written with writev(), partial
+ * writes are continued, a non-blocking device is waited for.
+ *
+ * @param sock file descriptor of the device
+ * @param data1 first part of the message
+ * @param size1 size of the first part
+ * @param data2 second part of the message
+ * @param size2 size of the second part
+ * @param serialheader 1 to send the serial header first
+ * @return DLT_DAEMON_ERROR_OK on success, DLT_DAEMON_ERROR_SEND_FAILED otherwise
+ */
 int dlt_daemon_serial_send(int sock,
                            void *data1,
                            int size1,
@@ -67,4 +120,71 @@ int dlt_daemon_serial_send(int sock,
                            int size2,
                            char serialheader);
 
+/**
+ * Allocate a serial queue.
+ *
+ * @param size size of the queue in bytes
+ * @return the queue, NULL on error
+ */
+DltDaemonSerialQueue *dlt_daemon_serial_queue_create(uint32_t size);
+
+/**
+ * Free a serial queue and the messages still queued.
+ *
+ * @param queue queue, may be NULL
+ */
+void dlt_daemon_serial_queue_free(DltDaemonSerialQueue *queue);
+
+/**
+ * Get the level used to choose which messages are dropped first.
+ *
+ * @param header message starting with the standard header
+ * @param size size of the header
+ * @return log level of a log message, DLT_LOG_INFO if the message has no
+ *         extended header, DLT_DAEMON_SERIAL_LEVEL_CONTROL for control
+ *         messages and DLT_LOG_VERBOSE for traces
+ */
+uint8_t dlt_daemon_serial_get_level(const uint8_t *header, int size);
+
+/**
+ * Copy a message behind the queued ones.
+ *
+ * If the queue is full, queued messages of a less important level than the
+ * new one are dropped, otherwise the new message is dropped.
+ *
+ * @param queue queue
+ * @param data1 first part of the message
+ * @param size1 size of the first part
+ * @param data2 second part of the message
+ * @param size2 size of the second part
+ * @param serialheader 1 to queue the serial header first
+ * @param level level of the message
+ * @return DLT_DAEMON_ERROR_OK if queued, DLT_DAEMON_ERROR_BUFFER_FULL if dropped
+ */
+int dlt_daemon_serial_queue_add(DltDaemonSerialQueue *queue,
+                                void *data1,
+                                int size1,
+                                void *data2,
+                                int size2,
+                                char serialheader,
+                                uint8_t level);
+
+/**
+ * Write as much of the queue as the device accepts without blocking.
+ *
+ * @param queue queue
+ * @param fd file descriptor of the device, opened with O_NONBLOCK
+ * @param messages set to the number of messages completely written
+ * @return bytes written, -1 on error
+ */
+int dlt_daemon_serial_queue_flush(DltDaemonSerialQueue *queue, int fd, int *messages);
+
+/**
+ * Check whether data is waiting to be written.
+ *
+ * @param queue queue
+ * @return 1 if data is queued, 0 otherwise
+ */
+int dlt_daemon_serial_queue_pending(const DltDaemonSerialQueue *queue);
+
 #endif /* DLT_DAEMON_SERIAL_H */
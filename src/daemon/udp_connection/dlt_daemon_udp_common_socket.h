@@ -33,6 +33,7 @@
 #include <string.h>     /* for memset() */
 #include <syslog.h>
 #include <sys/socket.h> /* for socket(), connect(), (), and recv() */
+#include <sys/uio.h>    /* for struct iovec */
 #include <unistd.h>     /* for close() */
 
 #include "dlt_common.h"
@@ -47,6 +48,7 @@
 #define SYSTEM_CALL_ERROR -1
 #define ZERO_BYTE_RECIEVED 0
 #define ONE_BYTE_RECIEVED 0
+#define UDP_BATCH_SIZE 32 /* datagrams sent with one sendmmsg() */
 
 typedef struct sockaddr_storage CLIENT_ADDR_STRUCT;
 typedef socklen_t CLIENT_ADDR_STRUCT_SIZE;
@@ -59,6 +61,16 @@ typedef struct
     int isvalidflag;
 } DltDaemonClientSockInfo;
 
+/* multicast datagrams waiting to be sent */
+typedef struct
+{
+    unsigned char *buffer;                 /* UDP_BATCH_SIZE datagrams of mtu bytes */
+    struct iovec iov[UDP_BATCH_SIZE];      /* used part of each datagram */
+    struct mmsghdr msgs[UDP_BATCH_SIZE];   /* headers passed to sendmmsg() */
+    int count;                             /* number of datagrams in use */
+    unsigned int mtu;                      /* max datagram size, 0 if packing is disabled */
+} DltDaemonUdpBatch;
+
 /* Function prototype declaration */
 void dlt_daemon_udp_init_clientstruct(DltDaemonClientSockInfo *clientinfo_struct);
 DltReturnValue dlt_daemon_udp_socket_open(int *sock, unsigned int servPort);
@@ -27,6 +27,40 @@ static void dlt_daemon_udp_clientmsg_send(DltDaemonClientSockInfo *clientinfo,
                                           void *data1, int size1, void *data2, int size2, int verbose);
 static int g_udp_sock_fd = -1;
 static DltDaemonClientSockInfo g_udpmulticast_addr;
+static DltDaemonUdpBatch g_udp_batch;
+
+/* ************************************************************************** */
+/* Function   : dlt_daemon_udp_batch_init */
+/* In Param   : max datagram size, 0 disables packing */
+/* Out Param  : NIL */
+/* Description: allocate the datagrams multicast messages are packed into */
+/* ************************************************************************** */
+static void dlt_daemon_udp_batch_init(int mtu)
+{
+    int i = 0;
+
+    memset(&g_udp_batch, 0, sizeof(g_udp_batch));
+
+    if (mtu <= 0)
+        return;
+
+    g_udp_batch.buffer = calloc(UDP_BATCH_SIZE, (size_t)mtu);
+
+    if (g_udp_batch.buffer == NULL) {
+        dlt_vlog(LOG_WARNING, "%s: calloc failure, messages are sent unpacked\n", __func__);
+        return;
+    }
+
+    g_udp_batch.mtu = (unsigned int)mtu;
+
+    for (i = 0; i < UDP_BATCH_SIZE; i++) {
+        g_udp_batch.iov[i].iov_base = g_udp_batch.buffer + (size_t)i * g_udp_batch.mtu;
+        g_udp_batch.msgs[i].msg_hdr.msg_name = &g_udpmulticast_addr.clientaddr;
+        g_udp_batch.msgs[i].msg_hdr.msg_namelen = g_udpmulticast_addr.clientaddr_size;
+        g_udp_batch.msgs[i].msg_hdr.msg_iov = &g_udp_batch.iov[i];
+        g_udp_batch.msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
 
 /* ************************************************************************** */
 /* Function   : dlt_daemon_udp_init_clientstruct */
@@ -94,6 +128,7 @@ DltReturnValue dlt_daemon_udp_connection_setup(DltDaemonLocal *daemon_local)
         g_udp_sock_fd = fd;
         /* set global multicast addr */
         dlt_daemon_udp_setmulticast_addr(daemon_local);
+        dlt_daemon_udp_batch_init(daemon_local->UDPMulticastMTU);
         dlt_log(LOG_DEBUG, "initialize udp socket success\n");
     }
 
@@ -224,23 +259,51 @@ void dlt_daemon_udp_clientmsg_send(DltDaemonClientSockInfo *clientinfo,
 
     if ((clientinfo->isvalidflag == ADDRESS_VALID) &&
         (size1 > 0) && (size2 > 0)) {
-        void *data = (void *)calloc(size1 + size2, sizeof(char));
+        unsigned int size = (unsigned int)size1 + (unsigned int)size2;
+        struct iovec *datagram = NULL;
+
+        /* Messages larger than a datagram are sent on their own */
+        if ((g_udp_batch.buffer == NULL) || (size > g_udp_batch.mtu)) {
+            struct iovec iov[2];
+            struct msghdr msg;
+
+            /* keep the order of the packed messages */
+            dlt_daemon_udp_flush();
+
+            iov[0].iov_base = data1;
+            iov[0].iov_len = (size_t)size1;
+            iov[1].iov_base = data2;
+            iov[1].iov_len = (size_t)size2;
+
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &clientinfo->clientaddr;
+            msg.msg_namelen = clientinfo->clientaddr_size;
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 2;
+
+            if (sendmsg(g_udp_sock_fd, &msg, 0) < 0)
+                dlt_vlog(LOG_ERR, "%s: Send UDP Packet Data failed\n", __func__);
 
-        if (data == NULL) {
-            dlt_vlog(LOG_ERR, "%s: calloc failure\n", __func__);
             return;
         }
 
-        memcpy(data, data1, size1);
-        memcpy(data + size1, data2, size2);
+        /* Pack the message into the current datagram if it fits, otherwise
+         * start a new one. The datagrams are sent by dlt_daemon_udp_flush()
+         * at the end of the event loop iteration or when all are used. */
+        if (g_udp_batch.count > 0)
+            datagram = &g_udp_batch.iov[g_udp_batch.count - 1];
 
-        if (sendto(g_udp_sock_fd, data, size1 + size2, 0, (struct sockaddr *)&clientinfo->clientaddr,
-                   clientinfo->clientaddr_size) < 0)
-            dlt_vlog(LOG_ERR, "%s: Send UDP Packet Data failed\n", __func__);
+        if ((datagram == NULL) || (datagram->iov_len + size > g_udp_batch.mtu)) {
+            if (g_udp_batch.count == UDP_BATCH_SIZE)
+                dlt_daemon_udp_flush();
 
-        free(data);
-        data = NULL;
+            datagram = &g_udp_batch.iov[g_udp_batch.count++];
+            datagram->iov_len = 0;
+        }
 
+        memcpy((unsigned char *)datagram->iov_base + datagram->iov_len, data1, (size_t)size1);
+        memcpy((unsigned char *)datagram->iov_base + datagram->iov_len + size1, data2, (size_t)size2);
+        datagram->iov_len += size;
     }
     else {
         if (clientinfo->isvalidflag != ADDRESS_VALID)
@@ -254,6 +317,34 @@ void dlt_daemon_udp_clientmsg_send(DltDaemonClientSockInfo *clientinfo,
     }
 }
 
+/* ************************************************************************** */
+/* Function   : dlt_daemon_udp_flush */
+/* In Param   : NIL */
+/* Out Param  : NIL */
+/* Description: send all packed multicast datagrams with one system call */
+/* ************************************************************************** */
+void dlt_daemon_udp_flush(void)
+{
+    int sent = 0;
+    int ret = 0;
+
+    while (sent < g_udp_batch.count) {
+        ret = sendmmsg(g_udp_sock_fd, &g_udp_batch.msgs[sent], (unsigned int)(g_udp_batch.count - sent), 0);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            dlt_vlog(LOG_ERR, "%s: Send UDP Packet Data failed: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        sent += ret;
+    }
+
+    g_udp_batch.count = 0;
+}
+
 /* ************************************************************************** */
 /* Function   : dlt_daemon_udp_close_connection */
 /* In Param   : NIL */
@@ -262,6 +353,10 @@ void dlt_daemon_udp_clientmsg_send(DltDaemonClientSockInfo *clientinfo,
 /* ************************************************************************** */
 void dlt_daemon_udp_close_connection(void)
 {
+    dlt_daemon_udp_flush();
+    free(g_udp_batch.buffer);
+    memset(&g_udp_batch, 0, sizeof(g_udp_batch));
+
     if (close(g_udp_sock_fd) == SYSTEM_CALL_ERROR)
         dlt_vlog(LOG_WARNING, "[%s:%d] close error %s\n", __func__, __LINE__,
                  strerror(errno));
@@ -862,6 +862,39 @@ DltReturnValue dlt_client_get_software_version(DltClient *client)
     return ret;
 }
 
+DltReturnValue dlt_client_get_latency_stats(DltClient *client)
+{
+    uint32_t service_id = DLT_SERVICE_ID_GET_LATENCY_STATS;
+
+    if (client == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    /* send control message to daemon*/
+    return dlt_client_send_ctrl_msg(client, "", "", (uint8_t *)&service_id, sizeof(uint32_t));
+}
+
+DltReturnValue dlt_client_get_metrics(DltClient *client)
+{
+    uint32_t service_id = DLT_SERVICE_ID_GET_METRICS;
+
+    if (client == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    /* send control message to daemon*/
+    return dlt_client_send_ctrl_msg(client, "", "", (uint8_t *)&service_id, sizeof(uint32_t));
+}
+
+DltReturnValue dlt_client_get_rate_limit_status(DltClient *client)
+{
+    uint32_t service_id = DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS;
+
+    if (client == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    /* send control message to daemon*/
+    return dlt_client_send_ctrl_msg(client, "", "", (uint8_t *)&service_id, sizeof(uint32_t));
+}
+
 DltReturnValue dlt_client_send_trace_status(DltClient *client, char *apid, char *ctid, uint8_t traceStatus)
 {
     DltServiceSetLogLevel *req;
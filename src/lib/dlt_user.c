@@ -55,6 +55,7 @@
 #include <unistd.h>
 
 #include <stdbool.h>
+#include <stddef.h> /* for ptrdiff_t */
 
 #include <stdatomic.h>
 
@@ -112,6 +113,86 @@ static int atexit_registered = 0;
 
 /* used to disallow DLT usage in fork() child */
 static int g_dlt_is_child = 0;
+
+/* signalled whenever messages were resent from the user buffer */
+static pthread_mutex_t dlt_user_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dlt_user_buffer_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t dlt_user_buffer_generation = 0;
+
+/* number of contexts with a rate limit, the check is skipped if there is none */
+static atomic_int dlt_user_rate_limits = 0;
+
+/* Token bucket of a context, updated without lock by the logging threads.
+ * Tokens are counted in 1/1000, rate 0 means unlimited. */
+typedef struct
+{
+    _Atomic uint32_t rate;          /**< tokens per second */
+    _Atomic uint32_t burst;         /**< maximum number of tokens */
+    _Atomic uint64_t tokens;        /**< available tokens * 1000 */
+    _Atomic uint64_t last;          /**< time of the last refill in us */
+    _Atomic uint32_t dropped;       /**< messages dropped and not reported yet */
+} DltUserRateLimit;
+
+/* The buckets are kept by log_level_pos in chunks, which are never moved
+ * while the library is initialised, so no lock is needed to find them */
+#define DLT_USER_RATE_LIMIT_CHUNK_SIZE 256
+#define DLT_USER_RATE_LIMIT_CHUNKS 256
+static DltUserRateLimit *_Atomic dlt_user_rate_limit_chunks[DLT_USER_RATE_LIMIT_CHUNKS];
+
+/* messages dropped by the rate limits and not reported yet, the counts
+ * per context are only looked at if it is not 0 */
+static atomic_uint dlt_user_rate_limit_dropped = 0;
+
+/* Index of the injection callbacks by context and service id, an open
+ * addressing table with linear probing, locked by the DLT semaphore */
+typedef struct
+{
+    int32_t log_level_pos;  /* context of the callback, -1 if the slot is free */
+    uint32_t service_id;    /* service id of the callback */
+    uint32_t index;         /* entry in the injection table of the context */
+} DltUserInjectionSlot;
+
+static DltUserInjectionSlot *dlt_user_injection_index = NULL;
+static uint32_t dlt_user_injection_index_size = 0;
+static uint32_t dlt_user_injection_index_used = 0;
+
+/* An injection waiting for its callback */
+typedef struct DltUserInjectionJob
+{
+    struct DltUserInjectionJob *next;
+    int32_t log_level_pos;      /* context of the callback */
+    DltUserInjectionCallback callback;
+    uint32_t length;
+    unsigned char data[];
+} DltUserInjectionJob;
+
+/* A thread calling the injection callbacks dispatched to it */
+typedef struct
+{
+    pthread_t handle;
+    bool started;
+    pthread_cond_t cond;
+    DltUserInjectionJob *head;
+    DltUserInjectionJob *tail;
+    int32_t running;            /* context of the running callback, -1 if none */
+} DltUserInjectionWorker;
+
+/* The receiver only queues injections, so a slow callback neither blocks
+ * log level updates nor the injections of services on other workers */
+static pthread_mutex_t dlt_user_injection_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t dlt_user_injection_done = PTHREAD_COND_INITIALIZER;
+static DltUserInjectionWorker dlt_user_injection_workers[DLT_USER_INJECTION_WORKERS_MAX];
+static uint32_t dlt_user_injection_num_workers = DLT_USER_INJECTION_WORKERS;
+static bool dlt_user_injection_stopping = false;
+
+/* Startup ring in shared memory, used as startup buffer until the application
+ * is registered at the daemon. The daemon drains it on registration. */
+static DltUserStartupShm dlt_user_startup_shm;
+static bool dlt_user_startup_shm_handed_over = false;
+/* Sizes of the dynamic startup buffer used after the hand over */
+static uint32_t dlt_user_startup_buffer_min = DLT_USER_RINGBUFFER_MIN_SIZE;
+static uint32_t dlt_user_startup_buffer_max = DLT_USER_RINGBUFFER_MAX_SIZE;
+static uint32_t dlt_user_startup_buffer_step = DLT_USER_RINGBUFFER_STEP_SIZE;
 /* String truncate message */
 static const char STR_TRUNCATED_MESSAGE[] = "... <<Message truncated, too long>>";
 
@@ -196,6 +277,24 @@ static DltReturnValue dlt_user_log_send_marker();
 static DltReturnValue dlt_user_print_msg(DltMessage *msg, DltContextData *log);
 static DltReturnValue dlt_user_log_check_user_message(void);
 static void dlt_user_log_reattach_to_daemon(void);
+static DltReturnValue dlt_user_startup_buffer_init(void);
+static bool dlt_user_startup_shm_handover_begin(void);
+static void dlt_user_startup_shm_handover_end(bool done);
+static void dlt_user_startup_buffer_free(void);
+static bool dlt_user_rate_limit_exceeded(DltContext *handle);
+static void dlt_user_rate_limit_set(int32_t log_level_pos, uint32_t rate, uint32_t burst);
+static void dlt_user_rate_limit_free(int32_t log_level_pos);
+static void dlt_user_rate_limit_free_all(void);
+static void dlt_user_rate_limit_report(void);
+static DltUserInjectionSlot *dlt_user_injection_find(int32_t log_level_pos, uint32_t service_id);
+static DltReturnValue dlt_user_injection_add(int32_t log_level_pos, uint32_t service_id, uint32_t index);
+static void dlt_user_injection_remove_context(int32_t log_level_pos);
+static void dlt_user_injection_free_index(void);
+static DltReturnValue dlt_user_injection_dispatch(DltUserInjectionJob *job);
+static void dlt_user_injection_call(DltUserInjectionJob *job);
+static void dlt_user_injection_cancel_context(int32_t log_level_pos);
+static void dlt_user_injection_wait_context(int32_t log_level_pos);
+static void dlt_user_injection_stop_workers(void);
 static DltReturnValue dlt_user_log_send_overflow(void);
 static DltReturnValue dlt_user_log_out_error_handling(void *ptr1,
                                                       size_t len1,
@@ -886,10 +985,31 @@ DltReturnValue dlt_init_common(void)
         dlt_user.disable_injection_msg = 1;
     }
 
-    if (dlt_buffer_init_dynamic(&(dlt_user.startup_buffer),
-                                buffer_min,
-                                buffer_max,
-                                buffer_step) == DLT_RETURN_ERROR) {
+    dlt_user_injection_num_workers = DLT_USER_INJECTION_WORKERS;
+    if (getenv(DLT_USER_ENV_INJECTION_WORKERS)) {
+        int workers = atoi(getenv(DLT_USER_ENV_INJECTION_WORKERS));
+
+        if ((workers > 0) && (workers <= DLT_USER_INJECTION_WORKERS_MAX))
+            dlt_user_injection_num_workers = (uint32_t)workers;
+        else
+            dlt_vlog(LOG_WARNING, "Invalid %s, using %u injection threads\n",
+                     DLT_USER_ENV_INJECTION_WORKERS, dlt_user_injection_num_workers);
+    }
+
+    dlt_user.latency_trace = 0;
+#ifndef DLT_SHM_ENABLE
+    /* with shared memory the user header is sent apart from the message */
+    if (getenv(DLT_USER_ENV_LATENCY_TRACE)) {
+        dlt_log(LOG_INFO, "Latency trace is enabled\n");
+        dlt_user.latency_trace = 1;
+    }
+#endif
+
+    dlt_user_startup_buffer_min = buffer_min;
+    dlt_user_startup_buffer_max = buffer_max;
+    dlt_user_startup_buffer_step = buffer_step;
+
+    if (dlt_user_startup_buffer_init() == DLT_RETURN_ERROR) {
         dlt_user_initialised = false;
         DLT_SEM_FREE();
         return DLT_RETURN_ERROR;
@@ -1128,7 +1248,7 @@ DltReturnValue dlt_free(void)
     DLT_SEM_LOCK();
 
     dlt_user_free_buffer(&(dlt_user.resend_buffer));
-    dlt_buffer_free_dynamic(&(dlt_user.startup_buffer));
+    dlt_user_startup_buffer_free();
 
     /* Clear and free local stored application information */
     if (dlt_user.application_description != NULL)
@@ -1161,12 +1281,16 @@ DltReturnValue dlt_free(void)
             dlt_user.dlt_ll_ts[i].log_level_changed_callback = 0;
         }
 
+        dlt_user_rate_limit_free_all();
+
         free(dlt_user.dlt_ll_ts);
         dlt_user.dlt_ll_ts = NULL;
         dlt_user.dlt_ll_ts_max_num_entries = 0;
         dlt_user.dlt_ll_ts_num_entries = 0;
     }
 
+    dlt_user_injection_free_index();
+
     dlt_env_free_ll_set(&dlt_user.initial_ll_set);
     DLT_SEM_FREE();
 
@@ -1258,6 +1382,10 @@ DltReturnValue dlt_register_app(const char *apid, const char *description)
     /* Store locally application id and application description */
     dlt_set_id(dlt_user.appID, apid);
 
+    /* the daemon uses it, if the application ends before it is registered */
+    if ((dlt_user_startup_shm.head != NULL) && !dlt_user_startup_shm_handed_over)
+        dlt_set_id(dlt_user_startup_shm.head->apid, apid);
+
     if (dlt_user.application_description != NULL)
         free(dlt_user.application_description);
 
@@ -1666,17 +1794,26 @@ DltReturnValue dlt_unregister_context(DltContext *handle)
 
         dlt_user.dlt_ll_ts[handle->log_level_pos].context_description = NULL;
 
+        dlt_user_injection_remove_context(handle->log_level_pos);
+        dlt_user_injection_cancel_context(handle->log_level_pos);
+
         if (dlt_user.dlt_ll_ts[handle->log_level_pos].injection_table != NULL) {
             free(dlt_user.dlt_ll_ts[handle->log_level_pos].injection_table);
             dlt_user.dlt_ll_ts[handle->log_level_pos].injection_table = NULL;
         }
 
+        dlt_user_rate_limit_free(handle->log_level_pos);
+
         dlt_user.dlt_ll_ts[handle->log_level_pos].nrcallbacks = 0;
         dlt_user.dlt_ll_ts[handle->log_level_pos].log_level_changed_callback = 0;
     }
 
     DLT_SEM_FREE();
 
+    /* the private data of the callbacks may be freed once this returns */
+    if (handle->log_level_pos >= 0)
+        dlt_user_injection_wait_context(handle->log_level_pos);
+
     /* Inform daemon to unregister context */
     ret = dlt_user_log_send_unregister_context(&log);
 
@@ -1842,6 +1979,12 @@ DltReturnValue dlt_user_log_write_start_internal(DltContext *handle,
         return DLT_RETURN_OK;
     }
 
+    /* excess messages are dropped like disabled ones, before they are serialized */
+    if (dlt_user_rate_limit_exceeded(handle)) {
+        log->handle = NULL;
+        return DLT_RETURN_OK;
+    }
+
     ret = dlt_user_log_write_start_init(handle, log, loglevel, is_verbose);
     if (ret == DLT_RETURN_TRUE) {
         /* initialize values */
@@ -2789,14 +2932,266 @@ static DltReturnValue dlt_user_log_write_string_utils_attr(DltContextData *log,
     return dlt_user_log_write_sized_string_utils_attr(log, text, length, type, name, with_var_info);
 }
 
+DltReturnValue dlt_user_log_write_vprintf(DltContextData *log, const char *format, va_list args)
+{
+    if ((log == NULL) || (format == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    if (!dlt_user_initialised) {
+        dlt_vlog(LOG_WARNING, "%s dlt_user_initialised false\n", __FUNCTION__);
+        return DLT_RETURN_ERROR;
+    }
+
+    size_t header_size = sizeof(uint16_t);
+
+    if (is_verbose_mode(dlt_user.verbose_mode, log))
+        header_size += sizeof(uint32_t);
+
+    /* at least the terminating null character has to fit */
+    if ((log->size + header_size + 1) > dlt_user.log_buf_len)
+        return DLT_RETURN_USER_BUFFER_FULL;
+
+    unsigned char *header = log->buffer + log->size;
+    char *text = (char *)(header + header_size);
+    size_t text_max = dlt_user.log_buf_len - log->size - header_size;
+    DltReturnValue ret = DLT_RETURN_OK;
+
+    /* format straight into the payload buffer */
+    int written = vsnprintf(text, text_max, format, args);
+
+    if (written < 0)
+        return DLT_RETURN_ERROR;
+
+    size_t arg_size = (size_t)written + 1;
+
+    if (arg_size > text_max) {
+        size_t str_truncate_message_length = strlen(STR_TRUNCATED_MESSAGE) + 1;
+
+        ret = DLT_RETURN_USER_BUFFER_FULL;
+        arg_size = text_max;
+
+        if (text_max >= str_truncate_message_length) {
+            /* do not leave a partial utf8 sequence in front of the marker */
+            size_t keep = text_max - str_truncate_message_length;
+
+            while ((keep > 0) && (((unsigned char)text[keep] & 0xc0) == 0x80))
+                keep--;
+
+            memcpy(text + keep, STR_TRUNCATED_MESSAGE, str_truncate_message_length);
+            arg_size = keep + str_truncate_message_length;
+        }
+    }
+
+    if (is_verbose_mode(dlt_user.verbose_mode, log)) {
+        uint32_t type_info = DLT_TYPE_INFO_STRG | DLT_SCOD_UTF8;
+        memcpy(header, &type_info, sizeof(uint32_t));
+        header += sizeof(uint32_t);
+    }
+
+    uint16_t length = (uint16_t) arg_size;
+    memcpy(header, &length, sizeof(uint16_t));
+
+    log->size += (int32_t)(header_size + arg_size);
+    log->args_num++;
+
+    return ret;
+}
+
+DltReturnValue dlt_user_log_write_vprintf_args(DltContextData *log, const char *format, va_list args)
+{
+    DltReturnValue ret = DLT_RETURN_OK;
+    const char *p = NULL;
+    va_list ap;
+
+    if ((log == NULL) || (format == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    va_copy(ap, args);
+
+    for (p = format; (*p != '\0') && (ret >= DLT_RETURN_OK); p++) {
+        int length = 0; /* 'H' hh, 'h', 'l', 'q' ll, 'j', 'z', 't', 'L' */
+
+        if (*p != '%')
+            continue;
+
+        p++;
+
+        if (*p == '%')
+            continue;
+
+        /* flags */
+        while ((*p != '\0') && (strchr("-+ #0'", *p) != NULL))
+            p++;
+
+        /* width */
+        if (*p == '*') {
+            ret = dlt_user_log_write_int32(log, (int32_t)va_arg(ap, int));
+            p++;
+        }
+        else {
+            while ((*p >= '0') && (*p <= '9'))
+                p++;
+        }
+
+        /* precision */
+        if (*p == '.') {
+            p++;
+
+            if (*p == '*') {
+                ret = dlt_user_log_write_int32(log, (int32_t)va_arg(ap, int));
+                p++;
+            }
+            else {
+                while ((*p >= '0') && (*p <= '9'))
+                    p++;
+            }
+        }
+
+        /* length modifier */
+        if (*p == 'h') {
+            length = 'h';
+
+            if (*(++p) == 'h') {
+                length = 'H';
+                p++;
+            }
+        }
+        else if (*p == 'l') {
+            length = 'l';
+
+            if (*(++p) == 'l') {
+                length = 'q';
+                p++;
+            }
+        }
+        else if ((*p == 'q') || (*p == 'j') || (*p == 'z') || (*p == 't') || (*p == 'L')) {
+            length = *p++;
+        }
+
+        if (ret < DLT_RETURN_OK)
+            break;
+
+        switch (*p) {
+        case 'd':
+        case 'i':
+        {
+            switch (length) {
+            case 'H':
+                ret = dlt_user_log_write_int8(log, (int8_t)va_arg(ap, int));
+                break;
+            case 'h':
+                ret = dlt_user_log_write_int16(log, (int16_t)va_arg(ap, int));
+                break;
+            case 'l':
+                ret = dlt_user_log_write_int64(log, (int64_t)va_arg(ap, long));
+                break;
+            case 'q':
+                ret = dlt_user_log_write_int64(log, (int64_t)va_arg(ap, long long));
+                break;
+            case 'j':
+                ret = dlt_user_log_write_int64(log, (int64_t)va_arg(ap, intmax_t));
+                break;
+            case 'z':
+                ret = dlt_user_log_write_int64(log, (int64_t)va_arg(ap, ssize_t));
+                break;
+            case 't':
+                ret = dlt_user_log_write_int64(log, (int64_t)va_arg(ap, ptrdiff_t));
+                break;
+            default:
+                ret = dlt_user_log_write_int32(log, (int32_t)va_arg(ap, int));
+                break;
+            }
+
+            break;
+        }
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        {
+            switch (length) {
+            case 'H':
+                ret = dlt_user_log_write_uint8(log, (uint8_t)va_arg(ap, unsigned int));
+                break;
+            case 'h':
+                ret = dlt_user_log_write_uint16(log, (uint16_t)va_arg(ap, unsigned int));
+                break;
+            case 'l':
+                ret = dlt_user_log_write_uint64(log, (uint64_t)va_arg(ap, unsigned long));
+                break;
+            case 'q':
+                ret = dlt_user_log_write_uint64(log, (uint64_t)va_arg(ap, unsigned long long));
+                break;
+            case 'j':
+                ret = dlt_user_log_write_uint64(log, (uint64_t)va_arg(ap, uintmax_t));
+                break;
+            case 'z':
+                ret = dlt_user_log_write_uint64(log, (uint64_t)va_arg(ap, size_t));
+                break;
+            case 't':
+                ret = dlt_user_log_write_uint64(log, (uint64_t)va_arg(ap, ptrdiff_t));
+                break;
+            default:
+                ret = dlt_user_log_write_uint32(log, (uint32_t)va_arg(ap, unsigned int));
+                break;
+            }
+
+            break;
+        }
+        case 'c':
+            ret = dlt_user_log_write_int8(log, (int8_t)va_arg(ap, int));
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+        {
+            if (length == 'L')
+                ret = dlt_user_log_write_float64(log, (float64_t)va_arg(ap, long double));
+            else
+                ret = dlt_user_log_write_float64(log, (float64_t)va_arg(ap, double));
+
+            break;
+        }
+        case 's':
+        {
+            const char *text = va_arg(ap, const char *);
+            ret = dlt_user_log_write_utf8_string(log, (text != NULL) ? text : "(null)");
+            break;
+        }
+        case 'p':
+            ret = dlt_user_log_write_ptr(log, va_arg(ap, void *));
+            break;
+        case 'n':
+            /* nothing is printed, only consume the argument */
+            (void)va_arg(ap, void *);
+            break;
+        case '\0':
+            p--;
+            break;
+        default:
+            dlt_vlog(LOG_WARNING, "%s: unsupported conversion '%c'\n", __func__, *p);
+            ret = DLT_RETURN_WRONG_PARAMETER;
+            break;
+        }
+    }
+
+    va_end(ap);
+
+    return ret;
+}
+
 DltReturnValue dlt_register_injection_callback_with_id(DltContext *handle, uint32_t service_id,
                                                        dlt_injection_callback_id dlt_injection_cbk, void *priv)
 {
     DltContextData log;
-    uint32_t i, j, k;
-    int found = 0;
-
-    DltUserInjectionCallback *old;
+    uint32_t i, j;
+    DltUserInjectionSlot *slot;
+    DltUserInjectionCallback *table;
 
     if (dlt_user_log_init(handle, &log) < DLT_RETURN_OK)
         return DLT_RETURN_ERROR;
@@ -2824,42 +3219,31 @@ DltReturnValue dlt_register_injection_callback_with_id(DltContext *handle, uint3
     i = (uint32_t) handle->log_level_pos;
 
     /* Insert each service_id only once */
-    for (k = 0; k < dlt_user.dlt_ll_ts[i].nrcallbacks; k++)
-        if ((dlt_user.dlt_ll_ts[i].injection_table) &&
-            (dlt_user.dlt_ll_ts[i].injection_table[k].service_id == service_id)) {
-            found = 1;
-            break;
-        }
+    slot = dlt_user_injection_find(handle->log_level_pos, service_id);
 
-    if (found) {
-        j = k;
+    if (slot != NULL) {
+        j = slot->index;
     }
     else {
         j = dlt_user.dlt_ll_ts[i].nrcallbacks;
 
-        /* Allocate or expand injection table */
-        if (dlt_user.dlt_ll_ts[i].injection_table == NULL) {
-            dlt_user.dlt_ll_ts[i].injection_table =
-                (DltUserInjectionCallback *)malloc(sizeof(DltUserInjectionCallback));
+        /* Allocate or expand injection table, its size doubles whenever
+         * the number of callbacks reaches a power of two */
+        if ((j & (j - 1)) == 0) {
+            table = (DltUserInjectionCallback *)realloc(dlt_user.dlt_ll_ts[i].injection_table,
+                                                        sizeof(DltUserInjectionCallback) * (j ? (2 * j) : 1));
 
-            if (dlt_user.dlt_ll_ts[i].injection_table == NULL) {
+            if (table == NULL) {
                 DLT_SEM_FREE();
                 return DLT_RETURN_ERROR;
             }
-        }
-        else {
-            old = dlt_user.dlt_ll_ts[i].injection_table;
-            dlt_user.dlt_ll_ts[i].injection_table = (DltUserInjectionCallback *)malloc(
-                sizeof(DltUserInjectionCallback) * (j + 1));
 
-            if (dlt_user.dlt_ll_ts[i].injection_table == NULL) {
-                dlt_user.dlt_ll_ts[i].injection_table = old;
-                DLT_SEM_FREE();
-                return DLT_RETURN_ERROR;
-            }
+            dlt_user.dlt_ll_ts[i].injection_table = table;
+        }
 
-            memcpy(dlt_user.dlt_ll_ts[i].injection_table, old, sizeof(DltUserInjectionCallback) * j);
-            free(old);
+        if (dlt_user_injection_add(handle->log_level_pos, service_id, j) < DLT_RETURN_OK) {
+            DLT_SEM_FREE();
+            return DLT_RETURN_ERROR;
         }
 
         dlt_user.dlt_ll_ts[i].nrcallbacks++;
@@ -3861,7 +4245,13 @@ DltReturnValue dlt_user_log_init(DltContext *handle, DltContextData *log)
 DltReturnValue dlt_user_log_send_log(DltContextData *log, int mtype)
 {
     DltMessage msg;
-    DltUserHeader userheader;
+    struct
+    {
+        DltUserHeader userheader;
+        DltUserControlMsgLogTrace trace;
+    } DLT_PACKED head;
+    size_t head_size = sizeof(DltUserHeader);
+    struct timespec ts;
     int32_t len;
 
     DltReturnValue ret = DLT_RETURN_OK;
@@ -3879,9 +4269,18 @@ DltReturnValue dlt_user_log_send_log(DltContextData *log, int mtype)
         return DLT_RETURN_WRONG_PARAMETER;
 
     /* also for Trace messages */
-    if (dlt_user_set_userheader(&userheader, DLT_USER_MESSAGE_LOG) < DLT_RETURN_OK)
+    if (dlt_user_set_userheader(&(head.userheader),
+                                dlt_user.latency_trace ? DLT_USER_MESSAGE_LOG_TRACE : DLT_USER_MESSAGE_LOG) <
+        DLT_RETURN_OK)
         return DLT_RETURN_ERROR;
 
+    /* the latency of the message is measured from here */
+    if (dlt_user.latency_trace) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        head.trace.timestamp = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+        head_size += sizeof(DltUserControlMsgLogTrace);
+    }
+
     if (dlt_message_init(&msg, 0) == DLT_RETURN_ERROR)
         return DLT_RETURN_ERROR;
 
@@ -4003,6 +4402,9 @@ DltReturnValue dlt_user_log_send_log(DltContextData *log, int mtype)
     
     if(dlt_user.dlt_is_daemon) {
         dlt_user_log_reattach_to_daemon();
+
+        dlt_user_rate_limit_report();
+
         if (dlt_user.overflow_counter) {
             if (dlt_user_log_send_overflow() == DLT_RETURN_OK) {
                 dlt_vnlog(LOG_WARNING, DLT_USER_BUFFER_LENGTH, "%u messages discarded!\n", dlt_user.overflow_counter);
@@ -4026,17 +4428,17 @@ DltReturnValue dlt_user_log_send_log(DltContextData *log, int mtype)
                              log->buffer, log->size, 0, 0);
 
             ret = dlt_user_log_out3(dlt_user.dlt_log_handle,
-                                    &(userheader), sizeof(DltUserHeader),
+                                    &(head.userheader), sizeof(DltUserHeader),
                                     0, 0,
                                     0, 0);
 #else
 #   ifdef DLT_TEST_ENABLE
 
             if (dlt_user.corrupt_user_header) {
-                userheader.pattern[0] = (char) 0xff;
-                userheader.pattern[1] = (char) 0xff;
-                userheader.pattern[2] = (char) 0xff;
-                userheader.pattern[3] = (char) 0xff;
+                head.userheader.pattern[0] = (char) 0xff;
+                head.userheader.pattern[1] = (char) 0xff;
+                head.userheader.pattern[2] = (char) 0xff;
+                head.userheader.pattern[3] = (char) 0xff;
             }
 
             if (dlt_user.corrupt_message_size)
@@ -4045,7 +4447,7 @@ DltReturnValue dlt_user_log_send_log(DltContextData *log, int mtype)
 #   endif
 
             ret = dlt_user_log_out3(dlt_user.dlt_log_handle,
-                                    &(userheader), sizeof(DltUserHeader),
+                                    &head, head_size,
                                     msg.headerbuffer + sizeof(DltStorageHeader),
                                     msg.headersize - sizeof(DltStorageHeader),
                                     log->buffer, log->size);
@@ -4055,8 +4457,8 @@ DltReturnValue dlt_user_log_send_log(DltContextData *log, int mtype)
         DltReturnValue process_error_ret = DLT_RETURN_OK;
         /* store message in ringbuffer, if an error has occured */
         if ((ret != DLT_RETURN_OK) || (dlt_user.appID[0] == '\0'))
-            process_error_ret = dlt_user_log_out_error_handling(&(userheader),
-                                                  sizeof(DltUserHeader),
+            process_error_ret = dlt_user_log_out_error_handling(&head,
+                                                  head_size,
                                                   msg.headerbuffer + sizeof(DltStorageHeader),
                                                   msg.headersize - sizeof(DltStorageHeader),
                                                   log->buffer,
@@ -4120,6 +4522,7 @@ DltReturnValue dlt_user_log_send_register_application(void)
 {
     DltUserHeader userheader;
     DltUserControlMsgRegisterApplication usercontext;
+    bool handover = false;
 
     DltReturnValue ret;
 
@@ -4146,11 +4549,19 @@ DltReturnValue dlt_user_log_send_register_application(void)
         return DLT_RETURN_OK;
     }
 
+    DLT_SEM_LOCK();
+    handover = dlt_user_startup_shm_handover_begin();
+
     ret = dlt_user_log_out3(dlt_user.dlt_log_handle,
                             &(userheader), sizeof(DltUserHeader),
                             &(usercontext), sizeof(DltUserControlMsgRegisterApplication),
                             dlt_user.application_description, usercontext.description_length);
 
+    if (handover)
+        dlt_user_startup_shm_handover_end(ret == DLT_RETURN_OK);
+
+    DLT_SEM_FREE();
+
     /* store message in ringbuffer, if an error has occured */
     if (ret < DLT_RETURN_OK)
         return dlt_user_log_out_error_handling(&(userheader),
@@ -4482,7 +4893,6 @@ DltReturnValue dlt_user_log_check_user_message(void)
     int leave_while = 0;
     int ret = 0;
 
-    uint32_t i;
     int fd;
     struct pollfd nfd[1];
 
@@ -4495,17 +4905,13 @@ DltReturnValue dlt_user_log_check_user_message(void)
     unsigned char *userbuffer;
 
     /* For delayed calling of injection callback, to avoid deadlock */
-    DltUserInjectionCallback delayed_injection_callback;
+    DltUserInjectionJob *injection_job;
+    DltReturnValue injection_queued;
+    DltUserInjectionSlot *slot;
     DltUserLogLevelChangedCallback delayed_log_level_changed_callback;
-    unsigned char *delayed_inject_buffer = 0;
-    uint32_t delayed_inject_data_length = 0;
 
     /* Ensure that callback is null before searching for it */
-    delayed_injection_callback.injection_callback = 0;
-    delayed_injection_callback.injection_callback_with_id = 0;
-    delayed_injection_callback.service_id = 0;
     delayed_log_level_changed_callback.log_level_changed_callback = 0;
-    delayed_injection_callback.data = 0;
 
 #if defined DLT_LIB_USE_UNIX_SOCKET_IPC || defined DLT_LIB_USE_VSOCK_IPC
     fd = dlt_user.dlt_log_handle;
@@ -4612,6 +5018,28 @@ DltReturnValue dlt_user_log_check_user_message(void)
                         return DLT_RETURN_ERROR;
                 }
                 break;
+                case DLT_USER_MESSAGE_RATE_LIMIT:
+                {
+                    DltUserControlMsgRateLimit *usercontextrl;
+
+                    if (receiver->bytesRcvd < (int32_t) (sizeof(DltUserHeader) + sizeof(DltUserControlMsgRateLimit))) {
+                        leave_while = 1;
+                        break;
+                    }
+
+                    usercontextrl = (DltUserControlMsgRateLimit *)(receiver->buf + sizeof(DltUserHeader));
+
+                    dlt_user_rate_limit_set(usercontextrl->log_level_pos,
+                                            usercontextrl->rate,
+                                            usercontextrl->burst);
+
+                    /* keep not read data in buffer */
+                    if (dlt_receiver_remove(receiver,
+                                            sizeof(DltUserHeader) + sizeof(DltUserControlMsgRateLimit)) ==
+                        DLT_RETURN_ERROR)
+                        return DLT_RETURN_ERROR;
+                }
+                break;
                 case DLT_USER_MESSAGE_INJECTION:
                 {
                     /* At least, user header, user context, and service id and data_length of injected message is available */
@@ -4633,69 +5061,44 @@ DltReturnValue dlt_user_log_check_user_message(void)
                             break;
                         }
 
+                        injection_job = malloc(sizeof(DltUserInjectionJob) + usercontextinj->data_length_inject);
+
+                        if (injection_job == NULL) {
+                            dlt_log(LOG_WARNING, "malloc failed!\n");
+                            return DLT_RETURN_ERROR;
+                        }
+
+                        memset(&(injection_job->callback), 0, sizeof(DltUserInjectionCallback));
+                        injection_job->log_level_pos = usercontextinj->log_level_pos;
+                        injection_job->length = usercontextinj->data_length_inject;
+                        memcpy(injection_job->data, userbuffer, usercontextinj->data_length_inject);
+                        injection_queued = DLT_RETURN_OK;
+
                         DLT_SEM_LOCK();
 
-                        if ((usercontextinj->data_length_inject > 0) && (dlt_user.dlt_ll_ts))
-                            /* Check if injection callback is registered for this context */
-                            for (i = 0; i < dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].nrcallbacks; i++)
-                                if ((dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table) &&
-                                    (dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[i].service_id ==
-                                     usercontextinj->service_id)) {
-                                    /* Prepare delayed injection callback call */
-                                    if (dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[i].
-                                        injection_callback != NULL) {
-                                        delayed_injection_callback.injection_callback =
-                                            dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[i].
-                                            injection_callback;
-                                    }
-                                    else if (dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[i].
-                                             injection_callback_with_id != NULL)
-                                    {
-                                        delayed_injection_callback.injection_callback_with_id =
-                                            dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[i].
-                                            injection_callback_with_id;
-                                        delayed_injection_callback.data =
-                                            dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[i].data;
-                                    }
-
-                                    delayed_injection_callback.service_id = usercontextinj->service_id;
-                                    delayed_inject_data_length = usercontextinj->data_length_inject;
-                                    delayed_inject_buffer = malloc(delayed_inject_data_length);
-
-                                    if (delayed_inject_buffer != NULL) {
-                                        memcpy(delayed_inject_buffer, userbuffer, delayed_inject_data_length);
-                                    }
-                                    else {
-                                        DLT_SEM_FREE();
-                                        dlt_log(LOG_WARNING, "malloc failed!\n");
-                                        return DLT_RETURN_ERROR;
-                                    }
-
-                                    break;
-                                }
+                        /* Check if injection callback is registered for this context */
+                        if ((usercontextinj->data_length_inject > 0) && (dlt_user.dlt_ll_ts) &&
+                            (usercontextinj->log_level_pos >= 0) &&
+                            (usercontextinj->log_level_pos < (int32_t)dlt_user.dlt_ll_ts_num_entries)) {
+                            slot = dlt_user_injection_find(usercontextinj->log_level_pos,
+                                                           usercontextinj->service_id);
 
-                        DLT_SEM_FREE();
+                            if (slot != NULL) {
+                                injection_job->callback =
+                                    dlt_user.dlt_ll_ts[usercontextinj->log_level_pos].injection_table[slot->index];
 
-                        /* Delayed injection callback call */
-                        if ((delayed_inject_buffer != NULL) &&
-                            (delayed_injection_callback.injection_callback != NULL)) {
-                            delayed_injection_callback.injection_callback(delayed_injection_callback.service_id,
-                                                                          delayed_inject_buffer,
-                                                                          delayed_inject_data_length);
-                            delayed_injection_callback.injection_callback = NULL;
-                        }
-                        else if ((delayed_inject_buffer != NULL) &&
-                                 (delayed_injection_callback.injection_callback_with_id != NULL))
-                        {
-                            delayed_injection_callback.injection_callback_with_id(delayed_injection_callback.service_id,
-                                                                                  delayed_inject_buffer,
-                                                                                  delayed_inject_data_length,
-                                                                                  delayed_injection_callback.data);
-                            delayed_injection_callback.injection_callback_with_id = NULL;
+                                /* The callback is called by an injection thread, to avoid
+                                 * deadlock and to keep receiving while it runs */
+                                injection_queued = dlt_user_injection_dispatch(injection_job);
+                            }
                         }
 
-                        free(delayed_inject_buffer);
-                        delayed_inject_buffer = NULL;
+                        DLT_SEM_FREE();
+
+                        if (injection_queued != DLT_RETURN_TRUE) {
+                            dlt_user_injection_call(injection_job);
+                            free(injection_job);
+                        }
 
                         /* keep not read data in buffer */
                         if (dlt_receiver_remove(receiver,
@@ -4749,6 +5152,664 @@ DltReturnValue dlt_user_log_check_user_message(void)
     return DLT_RETURN_OK;
 }
 
+static DltUserRateLimit *dlt_user_rate_limit_get(int32_t log_level_pos)
+{
+    DltUserRateLimit *chunk;
+
+    if ((log_level_pos < 0) ||
+        (log_level_pos >= DLT_USER_RATE_LIMIT_CHUNKS * DLT_USER_RATE_LIMIT_CHUNK_SIZE))
+        return NULL;
+
+    chunk = atomic_load(&dlt_user_rate_limit_chunks[log_level_pos / DLT_USER_RATE_LIMIT_CHUNK_SIZE]);
+
+    if (chunk == NULL)
+        return NULL;
+
+    return &chunk[log_level_pos % DLT_USER_RATE_LIMIT_CHUNK_SIZE];
+}
+
+static uint64_t dlt_user_rate_limit_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static bool dlt_user_rate_limit_exceeded(DltContext *handle)
+{
+    DltUserRateLimit *limit;
+    uint64_t max_tokens;
+    uint64_t tokens;
+    uint64_t last;
+    uint64_t now;
+    uint32_t rate;
+
+    if (atomic_load_explicit(&dlt_user_rate_limits, memory_order_relaxed) == 0)
+        return false;
+
+    limit = dlt_user_rate_limit_get(handle->log_level_pos);
+
+    if (limit == NULL)
+        return false;
+
+    rate = atomic_load_explicit(&limit->rate, memory_order_acquire);
+
+    if (rate == 0)
+        return false;
+
+    max_tokens = (uint64_t)atomic_load_explicit(&limit->burst, memory_order_relaxed) * 1000;
+
+    /* refill, only the thread which moves the time adds the tokens */
+    now = dlt_user_rate_limit_now();
+    last = atomic_load_explicit(&limit->last, memory_order_relaxed);
+
+    if (now > last) {
+        uint64_t elapsed_us = now - last;
+        uint64_t added;
+
+        if (elapsed_us > 1000000ULL * 1000)
+            elapsed_us = 1000000ULL * 1000;
+
+        /* rate per second in 1/1000 tokens per microsecond */
+        added = elapsed_us * rate / 1000;
+
+        if ((added > 0) && atomic_compare_exchange_strong(&limit->last, &last, now)) {
+            tokens = atomic_fetch_add(&limit->tokens, added) + added;
+
+            while ((tokens > max_tokens) &&
+                   !atomic_compare_exchange_weak(&limit->tokens, &tokens, max_tokens))
+                ;
+        }
+    }
+
+    tokens = atomic_load_explicit(&limit->tokens, memory_order_relaxed);
+
+    do {
+        if (tokens < 1000) {
+            atomic_fetch_add_explicit(&limit->dropped, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&dlt_user_rate_limit_dropped, 1, memory_order_relaxed);
+            return true;
+        }
+    } while (!atomic_compare_exchange_weak(&limit->tokens, &tokens, tokens - 1000));
+
+    return false;
+}
+
+static void dlt_user_rate_limit_set(int32_t log_level_pos, uint32_t rate, uint32_t burst)
+{
+    DltUserRateLimit *limit;
+    DltUserRateLimit *chunk;
+    int n;
+
+    if ((log_level_pos < 0) ||
+        (log_level_pos >= DLT_USER_RATE_LIMIT_CHUNKS * DLT_USER_RATE_LIMIT_CHUNK_SIZE)) {
+        if (rate > 0)
+            dlt_vlog(LOG_WARNING, "No rate limit for context %d, too many contexts\n", log_level_pos);
+
+        return;
+    }
+
+    if (rate == 0) {
+        dlt_user_rate_limit_free(log_level_pos);
+        return;
+    }
+
+    DLT_SEM_LOCK();
+
+    n = log_level_pos / DLT_USER_RATE_LIMIT_CHUNK_SIZE;
+
+    if (atomic_load(&dlt_user_rate_limit_chunks[n]) == NULL) {
+        chunk = calloc(DLT_USER_RATE_LIMIT_CHUNK_SIZE, sizeof(DltUserRateLimit));
+
+        if (chunk == NULL) {
+            DLT_SEM_FREE();
+            dlt_log(LOG_WARNING, "Cannot allocate rate limits\n");
+            return;
+        }
+
+        atomic_store(&dlt_user_rate_limit_chunks[n], chunk);
+    }
+
+    limit = dlt_user_rate_limit_get(log_level_pos);
+
+    /* the bucket starts full, rate is set last to enable it */
+    burst = (burst > 0) ? burst : 1;
+    atomic_store(&limit->burst, burst);
+    atomic_store(&limit->tokens, (uint64_t)burst * 1000);
+    atomic_store(&limit->last, dlt_user_rate_limit_now());
+
+    if (atomic_exchange(&limit->rate, rate) == 0)
+        atomic_fetch_add(&dlt_user_rate_limits, 1);
+
+    DLT_SEM_FREE();
+}
+
+static void dlt_user_rate_limit_free(int32_t log_level_pos)
+{
+    DltUserRateLimit *limit = dlt_user_rate_limit_get(log_level_pos);
+
+    if ((limit != NULL) && (atomic_exchange(&limit->rate, 0) != 0))
+        atomic_fetch_sub(&dlt_user_rate_limits, 1);
+}
+
+/* Send the number of messages dropped by the rate limit of each context to
+ * the daemon, counts which cannot be sent are kept for the next message */
+static void dlt_user_rate_limit_report(void)
+{
+    DltUserHeader userheader;
+    DltUserControlMsgRateLimitDropped userpayload;
+    DltUserRateLimit *chunk;
+    uint32_t dropped;
+    int32_t pos;
+    int n, i;
+
+    if ((atomic_load_explicit(&dlt_user_rate_limit_dropped, memory_order_relaxed) == 0) ||
+        (dlt_user.dlt_log_handle == -1))
+        return;
+
+    if (dlt_user_set_userheader(&userheader, DLT_USER_MESSAGE_RATE_LIMIT_DROPPED) < DLT_RETURN_OK)
+        return;
+
+    atomic_store(&dlt_user_rate_limit_dropped, 0);
+    dlt_set_id(userpayload.apid, dlt_user.appID);
+
+    for (n = 0; n < DLT_USER_RATE_LIMIT_CHUNKS; n++) {
+        chunk = atomic_load(&dlt_user_rate_limit_chunks[n]);
+
+        if (chunk == NULL)
+            continue;
+
+        for (i = 0; i < DLT_USER_RATE_LIMIT_CHUNK_SIZE; i++) {
+            if (atomic_load_explicit(&chunk[i].dropped, memory_order_relaxed) == 0)
+                continue;
+
+            dropped = atomic_exchange(&chunk[i].dropped, 0);
+            pos = n * DLT_USER_RATE_LIMIT_CHUNK_SIZE + i;
+
+            DLT_SEM_LOCK();
+
+            if ((dlt_user.dlt_ll_ts != NULL) && ((uint32_t)pos < dlt_user.dlt_ll_ts_num_entries))
+                dlt_set_id(userpayload.ctid, dlt_user.dlt_ll_ts[pos].contextID);
+            else
+                memset(userpayload.ctid, 0, DLT_ID_SIZE);
+
+            DLT_SEM_FREE();
+
+            userpayload.dropped = dropped;
+
+            if (dlt_user_log_out2(dlt_user.dlt_log_handle,
+                                  &(userheader), sizeof(DltUserHeader),
+                                  &(userpayload), sizeof(DltUserControlMsgRateLimitDropped)) != DLT_RETURN_OK) {
+                atomic_fetch_add(&chunk[i].dropped, dropped);
+                atomic_fetch_add(&dlt_user_rate_limit_dropped, dropped);
+                return;
+            }
+        }
+    }
+}
+
+static void dlt_user_rate_limit_free_all(void)
+{
+    int n;
+
+    atomic_store(&dlt_user_rate_limits, 0);
+
+    for (n = 0; n < DLT_USER_RATE_LIMIT_CHUNKS; n++)
+        free(atomic_exchange(&dlt_user_rate_limit_chunks[n], NULL));
+}
+
+static uint32_t dlt_user_injection_hash(int32_t log_level_pos, uint32_t service_id)
+{
+    uint32_t hash = ((uint32_t)log_level_pos * 0x9E3779B1u) ^ (service_id * 0x85EBCA77u);
+
+    hash ^= hash >> 16;
+    hash *= 0x7FEB352Du;
+    hash ^= hash >> 15;
+
+    return hash;
+}
+
+static DltUserInjectionSlot *dlt_user_injection_find(int32_t log_level_pos, uint32_t service_id)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    uint32_t mask = dlt_user_injection_index_size - 1;
+    uint32_t i;
+
+    if (dlt_user_injection_index == NULL)
+        return NULL;
+
+    for (i = dlt_user_injection_hash(log_level_pos, service_id) & mask;
+         dlt_user_injection_index[i].log_level_pos >= 0;
+         i = (i + 1) & mask)
+        if ((dlt_user_injection_index[i].log_level_pos == log_level_pos) &&
+            (dlt_user_injection_index[i].service_id == service_id))
+            return &(dlt_user_injection_index[i]);
+
+    return NULL;
+}
+
+/* Put an entry in a free slot, the index must have one */
+static void dlt_user_injection_put(DltUserInjectionSlot *index, uint32_t size, const DltUserInjectionSlot *slot)
+{
+    uint32_t i = dlt_user_injection_hash(slot->log_level_pos, slot->service_id) & (size - 1);
+
+    while (index[i].log_level_pos >= 0)
+        i = (i + 1) & (size - 1);
+
+    index[i] = *slot;
+}
+
+static DltReturnValue dlt_user_injection_add(int32_t log_level_pos, uint32_t service_id, uint32_t index)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    DltUserInjectionSlot *new_index;
+    DltUserInjectionSlot slot;
+    uint32_t new_size;
+    uint32_t i;
+
+    /* keep at most 3/4 of the slots used so probing stays short */
+    if ((dlt_user_injection_index_used + 1) * 4 > dlt_user_injection_index_size * 3) {
+        new_size = (dlt_user_injection_index_size == 0) ?
+            DLT_USER_INJECTION_INDEX_SIZE : (dlt_user_injection_index_size * 2);
+        new_index = malloc(sizeof(DltUserInjectionSlot) * new_size);
+
+        if (new_index == NULL)
+            return DLT_RETURN_ERROR;
+
+        for (i = 0; i < new_size; i++)
+            new_index[i].log_level_pos = -1;
+
+        for (i = 0; i < dlt_user_injection_index_size; i++)
+            if (dlt_user_injection_index[i].log_level_pos >= 0)
+                dlt_user_injection_put(new_index, new_size, &(dlt_user_injection_index[i]));
+
+        free(dlt_user_injection_index);
+        dlt_user_injection_index = new_index;
+        dlt_user_injection_index_size = new_size;
+    }
+
+    slot.log_level_pos = log_level_pos;
+    slot.service_id = service_id;
+    slot.index = index;
+    dlt_user_injection_put(dlt_user_injection_index, dlt_user_injection_index_size, &slot);
+    dlt_user_injection_index_used++;
+
+    return DLT_RETURN_OK;
+}
+
+/* Remove an entry, the following entries of its probe sequence are moved up
+ * so that no lookup stops at the freed slot */
+static void dlt_user_injection_remove(DltUserInjectionSlot *slot)
+{
+    uint32_t mask = dlt_user_injection_index_size - 1;
+    uint32_t i = (uint32_t)(slot - dlt_user_injection_index);
+    uint32_t j = i;
+    uint32_t home;
+
+    for (;;) {
+        j = (j + 1) & mask;
+
+        if (dlt_user_injection_index[j].log_level_pos < 0)
+            break;
+
+        home = dlt_user_injection_hash(dlt_user_injection_index[j].log_level_pos,
+                                       dlt_user_injection_index[j].service_id) & mask;
+
+        /* the entry can move to i if i lies between its home slot and j */
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            dlt_user_injection_index[i] = dlt_user_injection_index[j];
+            i = j;
+        }
+    }
+
+    dlt_user_injection_index[i].log_level_pos = -1;
+    dlt_user_injection_index_used--;
+}
+
+static void dlt_user_injection_remove_context(int32_t log_level_pos)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    dlt_ll_ts_type *ctx_entry = &(dlt_user.dlt_ll_ts[log_level_pos]);
+    DltUserInjectionSlot *slot;
+    uint32_t k;
+
+    if (ctx_entry->injection_table == NULL)
+        return;
+
+    for (k = 0; k < ctx_entry->nrcallbacks; k++) {
+        slot = dlt_user_injection_find(log_level_pos, ctx_entry->injection_table[k].service_id);
+
+        if (slot != NULL)
+            dlt_user_injection_remove(slot);
+    }
+}
+
+static void dlt_user_injection_free_index(void)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    free(dlt_user_injection_index);
+    dlt_user_injection_index = NULL;
+    dlt_user_injection_index_size = 0;
+    dlt_user_injection_index_used = 0;
+}
+
+static void *dlt_user_injection_worker_function(void *ptr)
+{
+    DltUserInjectionWorker *worker = (DltUserInjectionWorker *)ptr;
+    DltUserInjectionJob *job;
+
+#ifdef DLT_USE_PTHREAD_SETNAME_NP
+    if (pthread_setname_np(worker->handle, "dlt_injection"))
+        dlt_log(LOG_WARNING, "Failed to rename injection thread!\n");
+#elif linux
+    if (prctl(PR_SET_NAME, "dlt_injection", 0, 0, 0) < 0)
+        dlt_log(LOG_WARNING, "Failed to rename injection thread!\n");
+#endif
+
+    pthread_mutex_lock(&dlt_user_injection_mutex);
+
+    for (;;) {
+        while ((worker->head == NULL) && !dlt_user_injection_stopping)
+            pthread_cond_wait(&(worker->cond), &dlt_user_injection_mutex);
+
+        if (dlt_user_injection_stopping)
+            break;
+
+        job = worker->head;
+        worker->head = job->next;
+
+        if (worker->head == NULL)
+            worker->tail = NULL;
+
+        worker->running = job->log_level_pos;
+        pthread_mutex_unlock(&dlt_user_injection_mutex);
+
+        dlt_user_injection_call(job);
+        free(job);
+
+        pthread_mutex_lock(&dlt_user_injection_mutex);
+        worker->running = -1;
+        pthread_cond_broadcast(&dlt_user_injection_done);
+    }
+
+    pthread_mutex_unlock(&dlt_user_injection_mutex);
+
+    return NULL;
+}
+
+static void dlt_user_injection_call(DltUserInjectionJob *job)
+{
+    if (job->callback.injection_callback != NULL)
+        job->callback.injection_callback(job->callback.service_id,
+                                         job->data,
+                                         job->length);
+    else if (job->callback.injection_callback_with_id != NULL)
+        job->callback.injection_callback_with_id(job->callback.service_id,
+                                                 job->data,
+                                                 job->length,
+                                                 job->callback.data);
+}
+
+/* Queue an injection for its worker. Called with the DLT semaphore held, so
+ * no job is queued for a context after dlt_unregister_context() removed its
+ * callbacks. Returns DLT_RETURN_TRUE if the job was queued, else the caller
+ * calls the callback itself once it released the semaphore. */
+static DltReturnValue dlt_user_injection_dispatch(DltUserInjectionJob *job)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    DltUserInjectionWorker *worker;
+
+    /* injections of a service always go to the same worker to keep their order */
+    worker = &(dlt_user_injection_workers[dlt_user_injection_hash(job->log_level_pos, job->callback.service_id) %
+                                          dlt_user_injection_num_workers]);
+
+    pthread_mutex_lock(&dlt_user_injection_mutex);
+
+    if (dlt_user_injection_stopping) {
+        pthread_mutex_unlock(&dlt_user_injection_mutex);
+        free(job);
+        return DLT_RETURN_TRUE;
+    }
+
+    if (!worker->started) {
+        pthread_cond_init(&(worker->cond), NULL);
+        worker->head = NULL;
+        worker->tail = NULL;
+        worker->running = -1;
+
+        if (pthread_create(&(worker->handle), NULL, dlt_user_injection_worker_function, worker) != 0) {
+            pthread_cond_destroy(&(worker->cond));
+            pthread_mutex_unlock(&dlt_user_injection_mutex);
+            dlt_log(LOG_WARNING, "Can't create injection thread, calling the callback directly\n");
+            return DLT_RETURN_OK;
+        }
+
+        worker->started = true;
+    }
+
+    job->next = NULL;
+
+    if (worker->tail != NULL)
+        worker->tail->next = job;
+    else
+        worker->head = job;
+
+    worker->tail = job;
+    pthread_cond_signal(&(worker->cond));
+    pthread_mutex_unlock(&dlt_user_injection_mutex);
+
+    return DLT_RETURN_TRUE;
+}
+
+/* Drop the queued injections of a context, called with the DLT semaphore held */
+static void dlt_user_injection_cancel_context(int32_t log_level_pos)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    DltUserInjectionWorker *worker;
+    DltUserInjectionJob **link;
+    DltUserInjectionJob *job;
+    uint32_t i;
+
+    pthread_mutex_lock(&dlt_user_injection_mutex);
+
+    for (i = 0; i < DLT_USER_INJECTION_WORKERS_MAX; i++) {
+        worker = &(dlt_user_injection_workers[i]);
+
+        if (!worker->started)
+            continue;
+
+        worker->tail = NULL;
+        link = &(worker->head);
+
+        while (*link != NULL) {
+            job = *link;
+
+            if (job->log_level_pos == log_level_pos) {
+                *link = job->next;
+                free(job);
+            }
+            else {
+                worker->tail = job;
+                link = &(job->next);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&dlt_user_injection_mutex);
+}
+
+/* Wait until no callback of a context runs, except on the calling thread.
+ * Called without the DLT semaphore, a callback may log. */
+static void dlt_user_injection_wait_context(int32_t log_level_pos)
+{
+    uint32_t i;
+
+    pthread_mutex_lock(&dlt_user_injection_mutex);
+
+    for (i = 0; i < DLT_USER_INJECTION_WORKERS_MAX; i++)
+        while (dlt_user_injection_workers[i].started &&
+               (dlt_user_injection_workers[i].running == log_level_pos) &&
+               !pthread_equal(dlt_user_injection_workers[i].handle, pthread_self()))
+            pthread_cond_wait(&dlt_user_injection_done, &dlt_user_injection_mutex);
+
+    pthread_mutex_unlock(&dlt_user_injection_mutex);
+}
+
+static void dlt_user_injection_stop_workers(void)
+{
+    DltUserInjectionJob *job;
+    uint32_t i;
+    int joined;
+
+    /* dlt_start_threads() allows dispatching again */
+    pthread_mutex_lock(&dlt_user_injection_mutex);
+    dlt_user_injection_stopping = true;
+
+    for (i = 0; i < DLT_USER_INJECTION_WORKERS_MAX; i++)
+        if (dlt_user_injection_workers[i].started)
+            pthread_cond_signal(&(dlt_user_injection_workers[i].cond));
+
+    pthread_mutex_unlock(&dlt_user_injection_mutex);
+
+    /* a running callback is completed, the injections still queued are dropped */
+    for (i = 0; i < DLT_USER_INJECTION_WORKERS_MAX; i++) {
+        if (!dlt_user_injection_workers[i].started)
+            continue;
+
+        joined = -1;
+
+        /* a callback may call dlt_free() itself */
+        if (!pthread_equal(dlt_user_injection_workers[i].handle, pthread_self())) {
+            joined = pthread_join(dlt_user_injection_workers[i].handle, NULL);
+
+            if (joined != 0)
+                dlt_vlog(LOG_ERR,
+                         "ERROR pthread_join(dlt_injection): %s\n",
+                         strerror(joined));
+        }
+        else {
+            /* the thread ends once the callback returns */
+            pthread_detach(dlt_user_injection_workers[i].handle);
+        }
+
+        while (dlt_user_injection_workers[i].head != NULL) {
+            job = dlt_user_injection_workers[i].head;
+            dlt_user_injection_workers[i].head = job->next;
+            free(job);
+        }
+
+        dlt_user_injection_workers[i].tail = NULL;
+
+        if (joined == 0)
+            pthread_cond_destroy(&(dlt_user_injection_workers[i].cond));
+
+        dlt_user_injection_workers[i].started = false;
+    }
+}
+
+static DltReturnValue dlt_user_startup_buffer_init(void)
+{
+    char *env_startup_shm_size = getenv(DLT_USER_ENV_STARTUP_SHM_SIZE);
+    uint32_t startup_shm_size = 0;
+
+    /*Do not DLT_SEM_LOCK inside here! */
+    if (env_startup_shm_size != NULL)
+        startup_shm_size = (uint32_t)strtoul(env_startup_shm_size, NULL, 10);
+
+    if (startup_shm_size > 0) {
+        if (dlt_user_startup_shm_create(&dlt_user_startup_shm, getpid(), startup_shm_size) == DLT_RETURN_OK) {
+            dlt_user.startup_buffer = dlt_user_startup_shm.buffer;
+            return DLT_RETURN_OK;
+        }
+
+        dlt_vlog(LOG_WARNING,
+                 "Cannot create startup ring of %u bytes in shared memory, using heap\n",
+                 startup_shm_size);
+    }
+
+    return dlt_buffer_init_dynamic(&(dlt_user.startup_buffer),
+                                   dlt_user_startup_buffer_min,
+                                   dlt_user_startup_buffer_max,
+                                   dlt_user_startup_buffer_step);
+}
+
+static bool dlt_user_startup_shm_handover_begin(void)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    if ((dlt_user_startup_shm.head == NULL) || dlt_user_startup_shm_handed_over ||
+        (dlt_user.dlt_log_handle == -1))
+        return false;
+
+    /* The daemon looks at the ring when it processes the registration,
+     * so the state has to be set before the registration is sent. */
+    dlt_set_id(dlt_user_startup_shm.head->apid, dlt_user.appID);
+    dlt_user_startup_shm.head->state = DLT_USER_STARTUP_SHM_STATE_HANDOVER;
+
+    return true;
+}
+
+static void dlt_user_startup_shm_handover_end(bool done)
+{
+    /*Do not DLT_SEM_LOCK inside here! */
+    if (!done) {
+        /* daemon did not get the registration, keep writing into the ring */
+        dlt_user_startup_shm.head->state = DLT_USER_STARTUP_SHM_STATE_ACTIVE;
+        return;
+    }
+
+    /* The ring belongs to the daemon now. It stays mapped until dlt_free()
+     * to be able to remove it, if the daemon could not. */
+    dlt_user_startup_shm_handed_over = true;
+
+    if (dlt_buffer_init_dynamic(&(dlt_user.startup_buffer),
+                                dlt_user_startup_buffer_min,
+                                dlt_user_startup_buffer_max,
+                                dlt_user_startup_buffer_step) != DLT_RETURN_OK) {
+        dlt_log(LOG_ERR, "Cannot allocate startup buffer after hand over of startup ring\n");
+        memset(&(dlt_user.startup_buffer), 0, sizeof(DltBuffer));
+    }
+}
+
+static void dlt_user_startup_buffer_free(void)
+{
+    char path[DLT_PATH_MAX];
+    bool remove = false;
+
+    /*Do not DLT_SEM_LOCK inside here! */
+    if (dlt_user_startup_shm.head == NULL) {
+        dlt_buffer_free_dynamic(&(dlt_user.startup_buffer));
+        return;
+    }
+
+    if (dlt_user_startup_shm_handed_over) {
+        dlt_buffer_free_dynamic(&(dlt_user.startup_buffer));
+        /* otherwise the daemon still needs it or removes it on its own */
+        remove = (dlt_user_startup_shm.head->state == DLT_USER_STARTUP_SHM_STATE_DRAINED);
+    }
+    else {
+        /* Keep a filled ring, the daemon picks it up on its next start */
+        remove = (dlt_buffer_get_message_count(&(dlt_user.startup_buffer)) == 0);
+        memset(&(dlt_user.startup_buffer), 0, sizeof(DltBuffer));
+    }
+
+    dlt_user_startup_shm_close(&dlt_user_startup_shm);
+    dlt_user_startup_shm_handed_over = false;
+
+    if (remove && (dlt_user_startup_shm_path(path, sizeof(path), getpid()) == DLT_RETURN_OK))
+        unlink(path);
+}
+
+/* Wake up the threads waiting for free space in the user buffer */
+static void dlt_user_buffer_notify(void)
+{
+    pthread_mutex_lock(&dlt_user_buffer_mutex);
+    dlt_user_buffer_generation++;
+    pthread_cond_broadcast(&dlt_user_buffer_cond);
+    pthread_mutex_unlock(&dlt_user_buffer_mutex);
+}
+
 DltReturnValue dlt_user_log_resend_buffer(void)
 {
     int num, count;
@@ -4788,9 +5849,12 @@ DltReturnValue dlt_user_log_resend_buffer(void)
                     break;
                 }
                 case DLT_USER_MESSAGE_LOG:
+                case DLT_USER_MESSAGE_LOG_TRACE:
                 {
                     DltExtendedHeader *extendedHeader =
                         (DltExtendedHeader *)(dlt_user.resend_buffer + sizeof(DltUserHeader) +
+                                              ((userheader->message == DLT_USER_MESSAGE_LOG_TRACE) ?
+                                               sizeof(DltUserControlMsgLogTrace) : 0) +
                                               sizeof(DltStandardHeader) +
                                               sizeof(DltStandardHeaderExtra));
 
@@ -4833,6 +5897,10 @@ DltReturnValue dlt_user_log_resend_buffer(void)
 
                 /* keep message in ringbuffer */
                 DLT_SEM_FREE();
+
+                if (num > 0)
+                    dlt_user_buffer_notify();
+
                 return ret;
             }
         }
@@ -4840,6 +5908,9 @@ DltReturnValue dlt_user_log_resend_buffer(void)
         DLT_SEM_FREE();
     }
 
+    if (count > 0)
+        dlt_user_buffer_notify();
+
     return DLT_RETURN_OK;
 }
 
@@ -4971,6 +6042,73 @@ DltReturnValue dlt_user_check_buffer(int *total_size, int *used_size)
     return DLT_RETURN_OK; /* ok */
 }
 
+DltReturnValue dlt_user_wait_for_buffer(int free_percent, uint32_t timeout)
+{
+    int total_size, used_size;
+    uint32_t generation;
+    uint64_t start, waited;
+    uint32_t slice;
+    struct timespec ts;
+
+    if ((free_percent < 0) || (free_percent > 100))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    /* a wake up does not mean the slice is over, measure the time waited */
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    start = (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000;
+
+    for (;;) {
+        pthread_mutex_lock(&dlt_user_buffer_mutex);
+        generation = dlt_user_buffer_generation;
+        pthread_mutex_unlock(&dlt_user_buffer_mutex);
+
+        dlt_user_check_buffer(&total_size, &used_size);
+
+        if ((int64_t)(total_size - used_size) * 100 >= (int64_t)total_size * free_percent)
+            return DLT_RETURN_OK;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        waited = (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000 - start;
+
+        if (waited >= timeout)
+            return DLT_RETURN_ERROR;
+
+        slice = timeout - (uint32_t)waited;
+
+        if (slice > DLT_USER_BUFFER_WAIT_SLICE)
+            slice = DLT_USER_BUFFER_WAIT_SLICE;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += (long)slice * 1000000L;
+        ts.tv_sec += ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+
+        pthread_mutex_lock(&dlt_user_buffer_mutex);
+
+        while ((generation == dlt_user_buffer_generation) &&
+               (pthread_cond_timedwait(&dlt_user_buffer_cond, &dlt_user_buffer_mutex, &ts) == 0)) {
+        }
+
+        pthread_mutex_unlock(&dlt_user_buffer_mutex);
+    }
+}
+
+int dlt_user_is_startup_shm_active(void)
+{
+    int active;
+
+    if (!dlt_user_initialised) {
+        if (dlt_init() < DLT_RETURN_OK)
+            return 0;
+    }
+
+    DLT_SEM_LOCK();
+    active = (dlt_user_startup_shm.head != NULL) && !dlt_user_startup_shm_handed_over;
+    DLT_SEM_FREE();
+
+    return active;
+}
+
 #ifdef DLT_TEST_ENABLE
 void dlt_user_test_corrupt_user_header(int enable)
 {
@@ -4986,6 +6124,11 @@ void dlt_user_test_corrupt_message_size(int enable, int16_t size)
 
 int dlt_start_threads()
 {
+    /* Injection threads are started on demand */
+    pthread_mutex_lock(&dlt_user_injection_mutex);
+    dlt_user_injection_stopping = false;
+    pthread_mutex_unlock(&dlt_user_injection_mutex);
+
     /* Start housekeeper thread */
     if (pthread_create(&(dlt_housekeeperthread_handle),
                        0,
@@ -5076,10 +6219,21 @@ void dlt_stop_threads()
         dlt_user.dlt_segmented_nwt_handle = 0; /* set to invalid */
     }
 #endif /* DLT_NETWORK_TRACE_ENABLE */
+
+    /* the housekeeper does not dispatch injections anymore */
+    dlt_user_injection_stop_workers();
 }
 
 static void dlt_fork_child_fork_handler()
 {
+    uint32_t i;
+
+    /* the injection threads are not copied to the child */
+    for (i = 0; i < DLT_USER_INJECTION_WORKERS_MAX; i++)
+        dlt_user_injection_workers[i].started = false;
+
+    pthread_mutex_init(&dlt_user_injection_mutex, NULL);
+
     g_dlt_is_child = 1;
     dlt_user_initialised = false;
     dlt_user.dlt_log_handle = -1;
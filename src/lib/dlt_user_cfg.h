@@ -83,6 +83,15 @@
 #define DLT_USER_ENV_BUFFER_MAX_SIZE  "DLT_USER_BUFFER_MAX"
 #define DLT_USER_ENV_BUFFER_STEP_SIZE "DLT_USER_BUFFER_STEP"
 
+/* Name of environment variable to place the ringbuffer in shared memory until
+ * the application is registered at the daemon. The value is the size of the
+ * ring in bytes, the ring is not used if the variable is not set. */
+#define DLT_USER_ENV_STARTUP_SHM_SIZE "DLT_USER_STARTUP_SHM_SIZE"
+
+/* Name of environment variable to stamp each log message with the time it
+ * was finished, so the daemon can measure its latency per stage. */
+#define DLT_USER_ENV_LATENCY_TRACE "DLT_LATENCY_TRACE"
+
 /* Temporary buffer length */
 #define DLT_USER_BUFFER_LENGTH               255
 
@@ -148,6 +157,10 @@ typedef enum
     DLT_USER_USE_EXTENDED_HEADER_FOR_NONVERBOSE
 } DltExtHeaderNonVer;
 
+/* Longest wait in msec for a buffer state notification, the daemon empties
+ * the shared memory buffer without notifying the application */
+#define DLT_USER_BUFFER_WAIT_SLICE 50
+
 /* Retry interval for mq error in usec */
 #define DLT_USER_MQ_ERROR_RETRY_INTERVAL 100000
 
@@ -161,6 +174,21 @@ typedef enum
 /* Name of environment variable for disabling the injection message at libdlt */
 #define DLT_USER_ENV_DISABLE_INJECTION_MSG "DLT_DISABLE_INJECTION_MSG_AT_USER"
 
+/* Name of environment variable to set the number of threads calling the
+ * injection callbacks. With more than one thread, callbacks of different
+ * services can run at the same time. Injections of the same service always
+ * run on the same thread, in the order they were received. */
+#define DLT_USER_ENV_INJECTION_WORKERS "DLT_INJECTION_WORKERS"
+
+/* Default and maximum number of injection callback threads, a thread is only
+ * started once an injection is dispatched to it. One thread by default calls
+ * all callbacks one after another. */
+#define DLT_USER_INJECTION_WORKERS     1
+#define DLT_USER_INJECTION_WORKERS_MAX 16
+
+/* Initial number of slots of the injection callback index, a power of two */
+#define DLT_USER_INJECTION_INDEX_SIZE  64
+
 /************************/
 /* Don't change please! */
 /************************/
@@ -262,11 +262,6 @@ Logger::Logger(const std::string& ctxId, const std::string& ctxDescription, LogL
 
 Logger::~Logger()
 {
-    for (std::map<LogLevel, LogStream*>::iterator iter = m_logstreams.begin(); m_logstreams.end() != iter; ++iter)
-    {
-        delete (iter->second);
-    }
-
     unregisterBackends();
 }
 
@@ -346,26 +341,55 @@ void Logger::traceNetworkSegmented(DltNetworkTraceType nw_trace_type,
 
 void Logger::syslog(LogLevel loglv, const std::string& str)
 {
-    syslog(loglv, str.c_str());
+    syslog(loglv, "%s", str.c_str());
 }
 
 void Logger::syslog(LogLevel loglv, const char* fmt,...)
 {
-    char str[1390] = {0};
     va_list ap;
+
+    DltContextData log{};
+    if (dlt_user_log_write_start(static_cast<DltContext*>(getContext()), &log,
+                                 static_cast<DltLogLevelType>(loglv)) <= DLT_RETURN_OK)
+    {
+        return;
+    }
+
     va_start(ap, fmt);
-    vsnprintf(str, 1390, fmt, ap);
+    (void)dlt_user_log_write_vprintf(&log, fmt, ap);
     va_end(ap);
 
-    LogStream *out = m_logstreams[loglv];
-    if (nullptr == out)
+    std::unique_lock<std::mutex> lock(g_LogBufferMutex);
+    if (!g_LoggingInit && !dlt_user_is_startup_shm_active())
     {
-        out = new LogStream(loglv, (*this));
-        m_logstreams.insert(std::pair<LogLevel, LogStream*>(loglv, out));
+        // Keep the message like LogStream::Flush() until the LogManager is up,
+        // g_LogBuffer is shared with the LogStreams of all threads
+        if (!g_LogBuffer.empty() && ((size_t)g_BufferSize <= g_LogBuffer.size()))
+        {
+            delete static_cast<DltContextData*>(g_LogBuffer.front());
+            g_LogBuffer.pop_front();
+        }
+
+        g_LogBuffer.push_back(static_cast<void*>(new DltContextData(log)));
+        return;
     }
+    lock.unlock();
+
+    (void)dlt_user_log_write_finish(&log);
+}
 
-    (*out) << (const char* const)str;
-    out->Flush();
+void Logger::syslogId(LogLevel loglv, uint32_t msgId, const char* fmt,...)
+{
+    DltContextData log{};
+    if (dlt_user_log_write_start_id(static_cast<DltContext*>(getContext()), &log,
+                                    static_cast<DltLogLevelType>(loglv), msgId) > DLT_RETURN_OK)
+    {
+        va_list ap;
+        va_start(ap, fmt);
+        (void)dlt_user_log_write_vprintf_args(&log, fmt, ap);
+        va_end(ap);
+        (void)dlt_user_log_write_finish(&log);
+    }
 }
 
 
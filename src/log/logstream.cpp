@@ -19,6 +19,8 @@
 #include "ara/log/common.h"
 #include <dlt/dlt.h>
 #include <string.h>
+#include <unistd.h>
+#include <atomic>
 
 #include "ara/log/logger.h"
 
@@ -32,14 +34,25 @@ namespace log {
 	 *  @var g_LoggingInit  the gloabl variable.
      *  @var logBuffer      the buffer for save the logData.
 	 *  @var g_BufferSize   the buffer size.get it from the configura file by  logmanager.
+     *  @var g_LogBufferMutex guards logBuffer, messages are buffered from any thread.
 */
 bool g_LoggingInit = false;
 int g_BufferSize = -1;
 std::deque<void*> g_LogBuffer;
+std::mutex g_LogBufferMutex;
 
 /*! @brief length of dlt log message  */    
 size_t g_LogLength = DLT_USER_BUF_MAX_SIZE;
 
+/*! @brief sequence id of the values split over several messages */
+static std::atomic<uint32_t> g_SegmentSeq(0);
+
+/*! @brief messages are kept in g_LogBuffer until logging is initialised */
+static bool IsLogBuffered() noexcept
+{
+    return !g_LoggingInit && !dlt_user_is_startup_shm_active();
+}
+
 LogStream::LogStream()
     : logLocalData_(0), logRet_(internal::LogReturnValue::kReturnOk)
 {
@@ -146,7 +159,8 @@ LogStream::~LogStream()
 
 void LogStream::Flush() noexcept
 {
-    if(!g_LoggingInit){
+    std::unique_lock<std::mutex> lock(g_LogBufferMutex);
+    if(IsLogBuffered()){
         if((size_t)g_BufferSize > g_LogBuffer.size()){
             DltContextData* tempBuffer = new DltContextData;
             *tempBuffer = *(static_cast<DltContextData*>(logLocalData_));
@@ -154,6 +168,7 @@ void LogStream::Flush() noexcept
             return ;
         }
         else{
+            delete static_cast<DltContextData*>(g_LogBuffer.front());
             g_LogBuffer.pop_front();
              DltContextData* tempBuffer = new DltContextData;
             *tempBuffer = *(static_cast<DltContextData*>(logLocalData_));
@@ -167,9 +182,12 @@ void LogStream::Flush() noexcept
                 delete static_cast<DltContextData*>(it);
             } 
         }
+        g_LogBuffer.clear();
         return ;
     }
     else{
+        lock.unlock();
+        /* with the startup ring libdlt keeps the messages until the application is registered */
         if (logLocalData_ && static_cast<DltContextData*>(logLocalData_)->size > 0) 
         {
             (void) dlt_user_log_write_finish(static_cast<DltContextData*>(logLocalData_));
@@ -188,80 +206,119 @@ LogStream& LogStream::WithLocation (core::StringView file, int line) noexcept
     return *this;
 }
 
-LogStream& LogStream::operator<<(const ara::core::StringView value) noexcept
+void LogStream::WriteSegmented(const char* data, size_t size, bool isString) noexcept
 {
-    char* buffer = (char*)const_cast<void *>((const void*)value.data());
-    
-    if (logRet_ > internal::LogReturnValue::kReturnOk) 
+    DltContextData* plogdata = static_cast<DltContextData*>(logLocalData_);
+    /* type info, length and the terminating zero of strings */
+    const size_t argSize = sizeof(uint32_t) + sizeof(uint16_t) + (isString ? 1 : 0);
+    const size_t markerSize = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(DltSegmentMarker);
+    DltSegmentMarker marker;
+    DltReturnValue ret;
+    size_t sizeHaveSent = 0;
+
+    if (plogdata->size + argSize + size <= g_LogLength)
     {
-        DltContextData* plogdata = static_cast<DltContextData*>(logLocalData_);
-        int32_t sizeToSend = value.length();
-        int32_t sizeHaveSent = 0;
+        if (isString)
+        {
+            (void) dlt_user_log_write_sized_utf8_string(plogdata, data, static_cast<uint16_t>(size));
+        }
+        else
+        {
+            (void) dlt_user_log_write_raw_formatted(
+                plogdata, const_cast<char*>(data), static_cast<uint16_t>(size), DLT_FORMAT_DEFAULT);
+        }
+        return;
+    }
+
+    if (g_LogLength <= argSize + markerSize)
+    {
+        return;
+    }
+
+    /* each message holds a part of the value and ends with a marker linking it */
+    memcpy(marker.magic, DLT_SEGMENT_MAGIC, sizeof(marker.magic));
+    marker.pid = static_cast<uint32_t>(getpid());
+    marker.seq = g_SegmentSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+    marker.index = 0;
+    marker.flags = 0;
+
+    while (sizeHaveSent < size && logRet_ > internal::LogReturnValue::kReturnOk)
+    {
+        size_t currSize = plogdata->size + argSize + markerSize;
 
-        while (sizeHaveSent < sizeToSend)
+        if (currSize < g_LogLength)
         {
-            int32_t currSize = plogdata->size + 1 + sizeof(uint16_t) + sizeof(uint32_t);
-            int32_t leftSize = g_LogLength - currSize;
-            if (leftSize <= 0) // left spaces but not enough
+            size_t partSize = g_LogLength - currSize;
+            if (partSize > size - sizeHaveSent)
             {
-                Flush();
-                continue;
+                partSize = size - sizeHaveSent;
             }
-            char tmp[DLT_USER_BUF_MAX_SIZE] = {0};
-            strncpy(tmp, buffer + sizeHaveSent, leftSize);
-            DltReturnValue ret = dlt_user_log_write_utf8_string(plogdata, tmp);
-            currSize += strlen(tmp);
-            sizeHaveSent += strlen(tmp);
-            if ((size_t)currSize == g_LogLength )
+            /* do not split an utf8 character */
+            while (isString && partSize > 1 && sizeHaveSent + partSize < size &&
+                   (static_cast<unsigned char>(data[sizeHaveSent + partSize]) & 0xC0) == 0x80)
             {
-                Flush();
+                partSize--;
+            }
+
+            if (isString)
+            {
+                ret = dlt_user_log_write_sized_utf8_string(
+                    plogdata, data + sizeHaveSent, static_cast<uint16_t>(partSize));
+            }
+            else
+            {
+                ret = dlt_user_log_write_raw_formatted(
+                    plogdata, const_cast<char*>(data + sizeHaveSent), static_cast<uint16_t>(partSize),
+                    DLT_FORMAT_DEFAULT);
             }
             if (ret < DLT_RETURN_OK)
             {
                 break;
             }
-        }
-    }
-    return *this;
-}
 
-LogStream& LogStream::operator<<(core::Span< const core::Byte > value) noexcept
-{
-    void* buffer = const_cast<void *>((const void*)value.data());
-    
-    if (logRet_ > internal::LogReturnValue::kReturnOk) 
-    {
-        DltContextData* plogdata = static_cast<DltContextData*>(logLocalData_);
-        int32_t sizeToSend = value.size_bytes();
-        int32_t sizeHaveSent = 0;
-        while (sizeHaveSent < sizeToSend)
-        {
-            int32_t currSize = plogdata->size + sizeof(size_t) + sizeof(uint32_t);
-            int32_t leftSize = g_LogLength - currSize;
-            if (leftSize <= 0) // left spaces but not enough
+            sizeHaveSent += partSize;
+            if (sizeHaveSent == size)
             {
-                Flush();
-                continue;
+                marker.flags = DLT_SEGMENT_FLAG_LAST;
             }
-            char tmp[DLT_USER_BUF_MAX_SIZE] = {0};
-            int tmpsize = sizeToSend - sizeHaveSent;
-            tmpsize = (tmpsize < leftSize ? tmpsize : leftSize);
-            char *ptr = (char*)buffer + sizeHaveSent;
-            memcpy(tmp, ptr, tmpsize);
-            DltReturnValue ret = dlt_user_log_write_raw_formatted(
-            plogdata, (void*)tmp, tmpsize, DLT_FORMAT_DEFAULT);
-            currSize += tmpsize;
-            sizeHaveSent += tmpsize;
-            if ((size_t)currSize == g_LogLength )
+            else if (IsLogBuffered())
             {
-                Flush();
+                /* a kept message is not sent yet, so the rest cannot follow it */
+                marker.flags = DLT_SEGMENT_FLAG_LAST | DLT_SEGMENT_FLAG_TRUNCATED;
             }
-            if (ret < DLT_RETURN_OK)
+            if (dlt_user_log_write_raw(plogdata, &marker, sizeof(marker)) < DLT_RETURN_OK)
             {
                 break;
             }
+            marker.index++;
+        }
+
+        /* the next part and the arguments after the value go into a new message,
+         * unless the message is kept until logging is initialised */
+        bool buffered = IsLogBuffered();
+        Flush();
+        if (buffered)
+        {
+            break;
         }
     }
+}
+
+LogStream& LogStream::operator<<(const ara::core::StringView value) noexcept
+{
+    if (logRet_ > internal::LogReturnValue::kReturnOk) 
+    {
+        WriteSegmented(value.data(), value.size(), true);
+    }
+    return *this;
+}
+
+LogStream& LogStream::operator<<(core::Span< const core::Byte > value) noexcept
+{
+    if (logRet_ > internal::LogReturnValue::kReturnOk) 
+    {
+        WriteSegmented(reinterpret_cast<const char*>(value.data()), value.size_bytes(), false);
+    }
     return *this;
 }
 
@@ -478,33 +535,7 @@ LogStream& LogStream::operator<<(const char* const value) noexcept
 {
     if (logRet_ > internal::LogReturnValue::kReturnOk) 
     {
-        DltContextData* plogdata = static_cast<DltContextData*>(logLocalData_);
-        int32_t sizeToSend = strlen(value);
-        int32_t sizeHaveSent = 0;
-
-        while (sizeHaveSent < sizeToSend)
-        {
-            int32_t currSize = plogdata->size + 1 + sizeof(uint16_t) + sizeof(uint32_t);
-            int32_t leftSize = g_LogLength - currSize;
-            if (leftSize <= 0) // left spaces but not enough
-            {
-                Flush();
-                continue;
-            }
-            char tmp[DLT_USER_BUF_MAX_SIZE] = {0};
-            strncpy(tmp, value + sizeHaveSent, leftSize);
-            DltReturnValue ret = dlt_user_log_write_utf8_string(plogdata, tmp);
-            currSize += strlen(tmp);
-            sizeHaveSent += strlen(tmp);
-            if ((size_t)currSize == g_LogLength )
-            {
-                Flush();
-            }
-            if (ret < DLT_RETURN_OK)
-            {
-                break;
-            }
-        }
+        WriteSegmented(value, strlen(value), true);
     }
     return *this;
 }
@@ -514,36 +545,7 @@ LogStream& LogStream::operator<<(const LogRawBuffer& value) noexcept
 {
     if (logRet_ > internal::LogReturnValue::kReturnOk) 
     {
-        DltContextData* plogdata = static_cast<DltContextData*>(logLocalData_);
-        int32_t sizeToSend = value.size;
-        int32_t sizeHaveSent = 0;
-        while (sizeHaveSent < sizeToSend)
-        {
-            int32_t currSize = plogdata->size + sizeof(uint16_t) + sizeof(uint32_t);
-            int32_t leftSize = g_LogLength - currSize;
-            if (leftSize <= 0) // left spaces but not enough
-            {
-                Flush();
-                continue;
-            }
-            char tmp[DLT_USER_BUF_MAX_SIZE] = {0};
-            int tmpsize = sizeToSend - sizeHaveSent;
-            tmpsize = (tmpsize < leftSize ? tmpsize : leftSize);
-            char *ptr = (char*)value.buffer + sizeHaveSent;
-            memcpy(tmp, ptr, tmpsize);
-            DltReturnValue ret = dlt_user_log_write_raw_formatted(
-            plogdata, (void*)tmp, tmpsize, DLT_FORMAT_DEFAULT);
-            currSize += tmpsize;
-            sizeHaveSent += tmpsize;
-            if ((size_t)currSize == g_LogLength )
-            {
-                Flush();
-            }
-            if (ret < DLT_RETURN_OK)
-            {
-                break;
-            }
-        }
+        WriteSegmented(static_cast<const char*>(value.buffer), value.size, false);
     }
     return *this;
 }
@@ -687,7 +689,7 @@ LogStream& operator<<(LogStream& out, LogLevel value) noexcept
             return (out << "Debug");
         case LogLevel::kVerbose:
             return (out << "Verbose");
-        case default:
+        default:
             return (out << static_cast<typename std::underlying_type<LogLevel>::type>(value));
     }
 }
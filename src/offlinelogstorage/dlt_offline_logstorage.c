@@ -73,10 +73,8 @@ DLT_STATIC void dlt_logstorage_filter_config_free(DltLogStorageFilterConfig *dat
     if (data->log != NULL)
         fclose(data->log);
 
-    if (data->cache != NULL) {
-        free(data->cache);
-        data->cache = NULL;
-    }
+    if (data->cache != NULL)
+        dlt_logstorage_free_msg_cache(data);
 
     n = data->records;
 
@@ -1061,6 +1059,15 @@ DLT_STATIC int dlt_logstorage_check_specificsize(DltLogStorageFilterConfig *conf
     return dlt_logstorage_read_number(&config->specific_size, value);
 }
 
+DLT_STATIC int dlt_logstorage_check_cachereservation(DltLogStorageFilterConfig *config,
+                                                     char *value)
+{
+    if ((config == NULL) || (value == NULL))
+        return -1;
+
+    return dlt_logstorage_read_number(&config->cache_reservation, value);
+}
+
 /**
  * dlt_logstorage_check_sync_strategy
  *
@@ -1195,6 +1202,11 @@ DLT_STATIC DltLogstorageFilterConf
         .key = "SpecificSize",
         .func = dlt_logstorage_check_specificsize,
         .is_opt = 1
+    },
+    [DLT_LOGSTORAGE_FILTER_CONF_CACHE_RESERVATION] = {
+        .key = "CacheReservation",
+        .func = dlt_logstorage_check_cachereservation,
+        .is_opt = 1
     }
 };
 
@@ -1250,6 +1262,11 @@ DLT_STATIC DltLogstorageFilterConf
         .key = NULL,
         .func = dlt_logstorage_check_specificsize,
         .is_opt = 1
+    },
+    [DLT_LOGSTORAGE_FILTER_CONF_CACHE_RESERVATION] = {
+        .key = NULL,
+        .func = dlt_logstorage_check_cachereservation,
+        .is_opt = 1
     }
 };
 
@@ -1304,6 +1321,11 @@ DLT_STATIC DltLogstorageFilterConf
         .key = NULL,
         .func = dlt_logstorage_check_specificsize,
         .is_opt = 1
+    },
+    [DLT_LOGSTORAGE_FILTER_CONF_CACHE_RESERVATION] = {
+        .key = NULL,
+        .func = dlt_logstorage_check_cachereservation,
+        .is_opt = 1
     }
 };
 /**
@@ -2136,6 +2158,10 @@ int dlt_logstorage_write(DltLogStorage *handle,
     unsigned int header_len = 0;
     DltNewestFileName *tmp = NULL;
     int found = 0;
+    /* log files the message was already stored to */
+    DltNewestFileName *stored[DLT_CONFIG_FILE_SECTIONS_MAX] = { 0 };
+    int num_stored = 0;
+    int j = 0;
 
     int log_level = -1;
 
@@ -2217,6 +2243,7 @@ int dlt_logstorage_write(DltLogStorage *handle,
         if (config[i]->file_name == NULL)
             continue;
 
+        found = 0;
         tmp = handle->newest_file_list;
         while (tmp) {
             if (strcmp(tmp->file_name, config[i]->file_name) == 0) {
@@ -2233,6 +2260,15 @@ int dlt_logstorage_write(DltLogStorage *handle,
             return -1;
         }
 
+        /* Several filters may store to the same log file. The message is
+         * only written once to each of them. */
+        for (j = 0; j < num_stored; j++)
+            if (stored[j] == tmp)
+                break;
+
+        if (j < num_stored)
+            continue;
+
         /* prepare log file (create and/or open)*/
         if (config[i]->ecuid == NULL)
             dlt_vlog(LOG_DEBUG, "%s: ApId-CtId-EcuId [%s]-[%s]-[]\n", __func__,
@@ -2241,6 +2277,8 @@ int dlt_logstorage_write(DltLogStorage *handle,
             dlt_vlog(LOG_DEBUG, "%s: ApId-CtId-EcuId [%s]-[%s]-[%s]\n", __func__,
                      config[i]->apids, config[i]->ctids, config[i]->ecuid);
 
+        config[i]->newest_file_info = tmp;
+
         ret = config[i]->dlt_logstorage_prepare(config[i],
                                                 uconfig,
                                                 handle->device_mount_point,
@@ -2280,6 +2318,8 @@ int dlt_logstorage_write(DltLogStorage *handle,
                                                   size3);
 
             if (ret == 0) {
+                stored[num_stored++] = tmp;
+
                 /* In case of behavior CACHED_BASED, the newest file info
                  * must be updated right after writing phase.
                  * That is because in writing phase, it could also perform
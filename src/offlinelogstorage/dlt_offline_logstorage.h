@@ -113,6 +113,11 @@
 
 #define DLT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(S, s) ((S)&(s))
 
+/* Filter caches are drawn from a shared pool in segments of this size */
+#define DLT_OFFLINE_LOGSTORAGE_CACHE_SEGMENT_SIZE     (64 * 1024)
+/* Default cache size reserved in the pool for each filter */
+#define DLT_OFFLINE_LOGSTORAGE_CACHE_RESERVATION      (64 * 1024)
+
 /* logstorage max cache */
 extern unsigned int g_logstorage_cache_max;
 /* current logstorage cache size */
@@ -150,6 +155,7 @@ struct DltNewestFileName
     char *file_name;    /* The unique name of file in whole a dlt_logstorage.conf */
     char *newest_file;  /* The real newest name of file which is associated with filename.*/
     unsigned int wrap_id;   /* Identifier of wrap around happened for this file_name */
+    unsigned int file_list_id; /* Changed whenever a log file of file_name is created or removed */
     DltNewestFileName *next; /* Pointer to next */
 };
 
@@ -194,7 +200,11 @@ struct DltLogStorageFilterConfig
     void *cache;                    /* log data cache */
     unsigned int specific_size;     /* cache size used for specific_size sync strategy */
     unsigned int current_write_file_offset;    /* file offset for specific_size sync strategy */
+    unsigned int cache_reservation; /* cache size always available to the filter */
+    unsigned int cache_committed;   /* cache size currently drawn from the shared pool */
     DltLogStorageFileList *records; /* File name list */
+    DltNewestFileName *newest_file_info; /* Newest file info shared by all filters of file_name */
+    unsigned int file_list_id;      /* file_list_id of newest_file_info the records are valid for */
 };
 
 typedef struct DltLogStorageFilterList DltLogStorageFilterList;
@@ -248,6 +258,7 @@ typedef enum {
     DLT_LOGSTORAGE_FILTER_CONF_SYNCBEHAVIOR,
     DLT_LOGSTORAGE_FILTER_CONF_ECUID,
     DLT_LOGSTORAGE_FILTER_CONF_SPECIFIC_SIZE,
+    DLT_LOGSTORAGE_FILTER_CONF_CACHE_RESERVATION,
     DLT_LOGSTORAGE_FILTER_CONF_COUNT
 } DltLogstorageFilterConfType;
 
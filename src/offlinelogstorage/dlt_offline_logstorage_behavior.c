@@ -24,15 +24,176 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
 
 #include "dlt_offline_logstorage.h"
 #include "dlt_offline_logstorage_behavior.h"
 #include "dlt_offline_logstorage_behavior_internal.h"
 
 unsigned int g_logstorage_cache_size;
+
+/* Caches of different devices may be created by their worker threads */
+static pthread_mutex_t g_logstorage_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Syncs of all devices, the workers of the devices sync concurrently */
+static _Atomic uint64_t g_logstorage_sync_count;
+static _Atomic uint64_t g_logstorage_sync_sum;
+static _Atomic uint64_t g_logstorage_sync_max;
+
+static uint64_t dlt_logstorage_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Count a sync which started at start */
+static void dlt_logstorage_sync_done(uint64_t start)
+{
+    uint64_t duration = dlt_logstorage_now() - start;
+    uint64_t max = atomic_load_explicit(&g_logstorage_sync_max, memory_order_relaxed);
+
+    atomic_fetch_add_explicit(&g_logstorage_sync_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_logstorage_sync_sum, duration, memory_order_relaxed);
+
+    while ((duration > max) &&
+           !atomic_compare_exchange_weak_explicit(&g_logstorage_sync_max, &max, duration,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+void dlt_logstorage_get_sync_stats(uint64_t *count, uint64_t *sum, uint64_t *max)
+{
+    if ((count == NULL) || (sum == NULL) || (max == NULL))
+        return;
+
+    *count = atomic_load_explicit(&g_logstorage_sync_count, memory_order_relaxed);
+    *sum = atomic_load_explicit(&g_logstorage_sync_sum, memory_order_relaxed);
+    *max = atomic_load_explicit(&g_logstorage_sync_max, memory_order_relaxed);
+}
+
+/**
+ * dlt_logstorage_get_cache_size
+ *
+ * Get the configured cache size of a filter.
+ *
+ * @param config        DltLogStorageFilterConfig
+ * @return cache size without footer
+ */
+DLT_STATIC unsigned int dlt_logstorage_get_cache_size(DltLogStorageFilterConfig *config)
+{
+    if (DLT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(config->sync,
+                                               DLT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE) > 0)
+        return config->specific_size;
+
+    return config->file_size;
+}
+
+/**
+ * dlt_logstorage_commit_msg_cache
+ *
+ * Draw segments from the shared cache pool until size bytes of the cache of
+ * a filter are backed by the pool, or the pool is exhausted.
+ *
+ * @param config        DltLogStorageFilterConfig
+ * @param size          Cache size needed
+ * @param cache_size    Configured cache size of the filter
+ * @return cache size backed by the pool
+ */
+DLT_STATIC unsigned int dlt_logstorage_commit_msg_cache(DltLogStorageFilterConfig *config,
+                                                        unsigned int size,
+                                                        unsigned int cache_size)
+{
+    unsigned int segment = 0;
+
+    pthread_mutex_lock(&g_logstorage_cache_lock);
+
+    while ((config->cache_committed < size) && (config->cache_committed < cache_size)) {
+        segment = DLT_OFFLINE_LOGSTORAGE_MIN(DLT_OFFLINE_LOGSTORAGE_CACHE_SEGMENT_SIZE,
+                                             cache_size - config->cache_committed);
+
+        if (g_logstorage_cache_size + segment > g_logstorage_cache_max)
+            break;
+
+        g_logstorage_cache_size += segment;
+        config->cache_committed += segment;
+    }
+
+    pthread_mutex_unlock(&g_logstorage_cache_lock);
+
+    return config->cache_committed;
+}
+
+/**
+ * dlt_logstorage_reset_msg_cache
+ *
+ * Clear the cache of a filter after it was synchronized. Segments beyond the
+ * reservation of the filter are given back to the shared cache pool.
+ *
+ * @param config        DltLogStorageFilterConfig
+ * @param cache_size    Configured cache size of the filter
+ */
+DLT_STATIC void dlt_logstorage_reset_msg_cache(DltLogStorageFilterConfig *config,
+                                               unsigned int cache_size)
+{
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = 0;
+    size_t end = 0;
+    unsigned int reservation = DLT_OFFLINE_LOGSTORAGE_MIN(config->cache_reservation,
+                                                          config->cache_committed);
+
+    /* The kernel drops the pages and gives zeroed pages on the next access.
+     * The page of the footer is kept. */
+    start = (reservation + page_size - 1) & ~(page_size - 1);
+    end = DLT_OFFLINE_LOGSTORAGE_MIN((config->cache_committed + page_size - 1) & ~(page_size - 1),
+                                     cache_size & ~(page_size - 1));
+
+    if (start < end)
+        madvise((uint8_t *)config->cache + start, end - start, MADV_DONTNEED);
+    else
+        end = start;
+
+    memset(config->cache, 0, DLT_OFFLINE_LOGSTORAGE_MIN(start, config->cache_committed));
+
+    if (config->cache_committed > end)
+        memset((uint8_t *)config->cache + end, 0, config->cache_committed - end);
+
+    memset((uint8_t *)config->cache + cache_size, 0, sizeof(DltLogStorageCacheFooter));
+
+    pthread_mutex_lock(&g_logstorage_cache_lock);
+    g_logstorage_cache_size -= config->cache_committed - reservation;
+    pthread_mutex_unlock(&g_logstorage_cache_lock);
+
+    config->cache_committed = reservation;
+}
+
+void dlt_logstorage_free_msg_cache(DltLogStorageFilterConfig *config)
+{
+    unsigned int cache_size = 0;
+
+    if ((config == NULL) || (config->cache == NULL))
+        return;
+
+    cache_size = dlt_logstorage_get_cache_size(config);
+
+    munmap(config->cache, cache_size + sizeof(DltLogStorageCacheFooter));
+    config->cache = NULL;
+
+    pthread_mutex_lock(&g_logstorage_cache_lock);
+    g_logstorage_cache_size -= config->cache_committed + sizeof(DltLogStorageCacheFooter);
+    pthread_mutex_unlock(&g_logstorage_cache_lock);
+
+    config->cache_committed = 0;
+}
 /**
  * dlt_logstorage_log_file_name
  *
@@ -391,6 +552,24 @@ int dlt_logstorage_storage_dir_info(DltLogStorageUserConfig *file_config,
     return ret;
 }
 
+/**
+ * dlt_logstorage_file_list_changed
+ *
+ * Tell the other filters of the same file name that a log file was created or
+ * removed, so they read the storage directory again before their next
+ * rotation. The file list of the given filter is already up to date.
+ *
+ * @param  config    DltLogStorageFilterConfig
+ */
+DLT_STATIC void dlt_logstorage_file_list_changed(DltLogStorageFilterConfig *config)
+{
+    if (config->newest_file_info == NULL)
+        return;
+
+    config->newest_file_info->file_list_id += 1;
+    config->file_list_id = config->newest_file_info->file_list_id;
+}
+
 /**
  * dlt_logstorage_open_log_file
  *
@@ -419,7 +598,9 @@ int dlt_logstorage_open_log_file(DltLogStorageFilterConfig *config,
     struct stat s;
     DltLogStorageFileList **tmp = NULL;
     DltLogStorageFileList **newest = NULL;
+    DltLogStorageFileList *n = NULL;
     char file_name[DLT_MOUNT_PATH_MAX + 1] = { '\0' };
+    bool is_file_list_changed = false;
 
     if (config == NULL)
         return -1;
@@ -431,10 +612,18 @@ int dlt_logstorage_open_log_file(DltLogStorageFilterConfig *config,
 
     snprintf(storage_path, DLT_OFFLINE_LOGSTORAGE_CONFIG_DIR_PATH_LEN, "%s/", dev_path);
 
-    /* check if there are already files stored */
-    if (config->records == NULL || is_update_required) {
+    /* check if there are already files stored. An update of the file list
+     * is only needed if another filter with the same file name created or
+     * removed a log file since the directory was read. */
+    if ((config->records == NULL) ||
+        (is_update_required &&
+         ((config->newest_file_info == NULL) ||
+          (config->file_list_id != config->newest_file_info->file_list_id)))) {
         if (dlt_logstorage_storage_dir_info(file_config, storage_path, config) != 0)
             return -1;
+
+        if (config->newest_file_info != NULL)
+            config->file_list_id = config->newest_file_info->file_list_id;
     }
 
     /* obtain locations of newest, current file names, file count */
@@ -473,6 +662,7 @@ int dlt_logstorage_open_log_file(DltLogStorageFilterConfig *config,
         (*tmp)->name = strdup(file_name);
         (*tmp)->idx = 1;
         (*tmp)->next = NULL;
+        is_file_list_changed = true;
     }
     else {
         strcat(absolute_file_path, storage_path);
@@ -544,6 +734,26 @@ int dlt_logstorage_open_log_file(DltLogStorageFilterConfig *config,
                 dlt_vlog(LOG_DEBUG,
                          "%s: Remove '%s' (num_log_files: %u, config->num_files:%u)\n",
                          __func__, absolute_file_path, num_log_files, config->num_files);
+
+                /* the file list is kept across rotations, remove its entry */
+                tmp = &config->records;
+
+                while (*tmp != NULL) {
+                    if (strcmp((*tmp)->name, file_name) == 0) {
+                        n = *tmp;
+                        *tmp = n->next;
+                        free(n->name);
+                        free(n);
+                        break;
+                    }
+
+                    tmp = &(*tmp)->next;
+                }
+
+                tmp = &config->records;
+
+                while (*tmp != NULL)
+                    tmp = &(*tmp)->next;
             }
 
             config->log = fopen(absolute_file_path, "a+");
@@ -563,6 +773,7 @@ int dlt_logstorage_open_log_file(DltLogStorageFilterConfig *config,
             (*tmp)->name = strdup(file_name);
             (*tmp)->idx = idx;
             (*tmp)->next = NULL;
+            is_file_list_changed = true;
 
             num_log_files += 1;
 
@@ -609,6 +820,9 @@ int dlt_logstorage_open_log_file(DltLogStorageFilterConfig *config,
         return -1;
     }
 
+    if (is_file_list_changed)
+        dlt_logstorage_file_list_changed(config);
+
     return ret;
 }
 
@@ -721,6 +935,7 @@ DLT_STATIC int dlt_logstorage_sync_to_file(DltLogStorageFilterConfig *config,
     int end_index = 0;
     int count = 0;
     int remain_file_size = 0;
+    struct stat s;
 
     if ((config == NULL) || (file_config == NULL) || (dev_path == NULL) ||
         (footer == NULL))
@@ -732,16 +947,30 @@ DLT_STATIC int dlt_logstorage_sync_to_file(DltLogStorageFilterConfig *config,
     count = end_offset - start_offset;
 
     /* In case of cached-based strategy, the newest file information
-     * must be updated everytime of synchronization.
+     * must be updated everytime of synchronization. The open log file is
+     * kept as long as it is still the newest file and the data fits in.
      */
     if (config->log) {
-        fclose(config->log);
-        config->log = NULL;
-        config->current_write_file_offset = 0;
+        if ((config->newest_file_info == NULL) ||
+            (config->newest_file_info->newest_file == NULL) ||
+            (config->working_file_name == NULL) ||
+            (config->wrap_id != config->newest_file_info->wrap_id) ||
+            (strcmp(config->working_file_name,
+                    config->newest_file_info->newest_file) != 0) ||
+            (fstat(fileno(config->log), &s) != 0) ||
+            (s.st_size + count > (int)config->file_size)) {
+            fclose(config->log);
+            config->log = NULL;
+            config->current_write_file_offset = 0;
+        }
+        else {
+            config->current_write_file_offset = s.st_size;
+        }
     }
 
-    if (dlt_logstorage_open_log_file(config, file_config,
-            dev_path, count, true) != 0) {
+    if ((config->log == NULL) &&
+        (dlt_logstorage_open_log_file(config, file_config,
+                                      dev_path, count, true) != 0)) {
         dlt_vlog(LOG_ERR, "%s: failed to open log file\n", __func__);
         return -1;
     }
@@ -791,7 +1020,7 @@ DLT_STATIC int dlt_logstorage_sync_to_file(DltLogStorageFilterConfig *config,
         if (config->log == NULL)
         {
             if (dlt_logstorage_prepare_on_msg(config, file_config, dev_path,
-                                              count, NULL) != 0)
+                                              count, config->newest_file_info) != 0)
             {
                 dlt_vlog(LOG_ERR, "%s: failed to prepare log file\n", __func__);
                 return -1;
@@ -927,30 +1156,59 @@ int dlt_logstorage_write_on_msg(DltLogStorageFilterConfig *config,
                                 unsigned char *data3,
                                 int size3)
 {
-    int ret;
+    struct iovec iov[3];
+    ssize_t ret = 0;
+    size_t remain = 0;
+    int i = 0;
 
-    if ((config == NULL) || (data1 == NULL) || (data2 == NULL) || (data3 == NULL) ||
+    if ((config == NULL) || (data1 == NULL) || (size1 < 0) || (data2 == NULL) ||
+        (size2 < 0) || (data3 == NULL) || (size3 < 0) ||
         (file_config == NULL) || (dev_path == NULL))
     {
         return -1;
     }
 
-    ret = fwrite(data1, 1, size1, config->log);
+    iov[0].iov_base = data1;
+    iov[0].iov_len = (size_t)size1;
+    iov[1].iov_base = data2;
+    iov[1].iov_len = (size_t)size2;
+    iov[2].iov_base = data3;
+    iov[2].iov_len = (size_t)size3;
+    remain = (size_t)size1 + (size_t)size2 + (size_t)size3;
 
-    if (ret != size1)
-        dlt_log(LOG_WARNING, "Wrote less data than specified\n");
+    /* The log file is only written with writev, so stdio never buffers data
+     * for it and the whole message is stored with one system call. */
+    while (remain > 0) {
+        ret = writev(fileno(config->log), &iov[i], 3 - i);
 
-    ret = fwrite(data2, 1, size2, config->log);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
 
-    if (ret != size2)
-        dlt_log(LOG_WARNING, "Wrote less data than specified\n");
+            dlt_vlog(LOG_ERR, "%s: writev failed: %s\n", __func__, strerror(errno));
+            return -1;
+        }
+
+        if (ret == 0) {
+            dlt_log(LOG_WARNING, "Wrote less data than specified\n");
+            return -1;
+        }
 
-    ret = fwrite(data3, 1, size3, config->log);
+        remain -= (size_t)ret;
 
-    if (ret != size3)
-        dlt_log(LOG_WARNING, "Wrote less data than specified\n");
+        /* continue after a partial write */
+        while ((i < 3) && ((size_t)ret >= iov[i].iov_len)) {
+            ret -= (ssize_t)iov[i].iov_len;
+            i++;
+        }
+
+        if (i < 3) {
+            iov[i].iov_base = (uint8_t *)iov[i].iov_base + ret;
+            iov[i].iov_len -= (size_t)ret;
+        }
+    }
 
-    return ferror(config->log);
+    return 0;
 }
 
 /**
@@ -978,10 +1236,14 @@ int dlt_logstorage_sync_on_msg(DltLogStorageFilterConfig *config,
         return -1;
 
     if (status == DLT_LOGSTORAGE_SYNC_ON_MSG) { /* sync on every message */
+        uint64_t start = dlt_logstorage_now();
+
         ret = fflush(config->log);
 
         if (ret != 0)
             dlt_log(LOG_ERR, "fflush failed\n");
+
+        dlt_logstorage_sync_done(start);
     }
 
     return 0;
@@ -1056,40 +1318,53 @@ int dlt_logstorage_prepare_msg_cache(DltLogStorageFilterConfig *config,
 
     if (config->cache == NULL)
     {
-        unsigned int cache_size = 0;
+        unsigned int cache_size = dlt_logstorage_get_cache_size(config);
+        unsigned int reservation = 0;
+        void *cache = NULL;
 
-        /* check for sync_specific_size strategy */
-        if (DLT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(config->sync,
-               DLT_LOGSTORAGE_SYNC_ON_SPECIFIC_SIZE) > 0)
-        {
-            cache_size = config->specific_size;
-        }
-        else  /* other cache strategies */
-        {
-            cache_size = config->file_size;
-        }
+        /* Only the reservation is taken from the pool now. The rest of the
+         * cache is drawn in segments when it is needed. */
+        if (config->cache_reservation == 0)
+            config->cache_reservation = DLT_OFFLINE_LOGSTORAGE_CACHE_RESERVATION;
+
+        config->cache_reservation = DLT_OFFLINE_LOGSTORAGE_MIN(config->cache_reservation,
+                                                               cache_size);
+        reservation = config->cache_reservation;
+
+        pthread_mutex_lock(&g_logstorage_cache_lock);
 
         /* check total logstorage cache size */
-        if ((g_logstorage_cache_size + cache_size +
+        if ((g_logstorage_cache_size + reservation +
              sizeof(DltLogStorageCacheFooter)) >
              g_logstorage_cache_max)
         {
+            pthread_mutex_unlock(&g_logstorage_cache_lock);
             dlt_log(LOG_ERR, "Max size of Logstorage Cache already used.");
             return -1;
         }
 
-        /* create cache */
-        config->cache = calloc(1, cache_size + sizeof(DltLogStorageCacheFooter));
+        g_logstorage_cache_size += reservation + sizeof(DltLogStorageCacheFooter);
 
-        if (config->cache == NULL)
+        pthread_mutex_unlock(&g_logstorage_cache_lock);
+
+        /* create cache, the pages are only backed by memory when written */
+        cache = mmap(NULL, cache_size + sizeof(DltLogStorageCacheFooter),
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+        if (cache == MAP_FAILED)
         {
             dlt_log(LOG_CRIT,
                     "Cannot allocate memory for filter ring buffer\n");
+
+            pthread_mutex_lock(&g_logstorage_cache_lock);
+            g_logstorage_cache_size -= reservation + sizeof(DltLogStorageCacheFooter);
+            pthread_mutex_unlock(&g_logstorage_cache_lock);
         }
         else
         {
-            /* update current used cache size */
-            g_logstorage_cache_size = cache_size + sizeof(DltLogStorageCacheFooter);
+            config->cache = cache;
+            config->cache_committed = reservation;
         }
     }
 
@@ -1153,7 +1428,14 @@ int dlt_logstorage_write_msg_cache(DltLogStorageFilterConfig *config,
         return -1;
     }
     msg_size = size1 + size2 + size3;
-    remain_cache_size = cache_size - footer->offset;
+
+    /* draw more cache from the pool if the message does not fit into the
+     * part of the cache backed so far. If the pool is exhausted, the cache
+     * is handled as full at the end of that part. */
+    if (config->cache_committed < footer->offset + msg_size)
+        dlt_logstorage_commit_msg_cache(config, footer->offset + msg_size, cache_size);
+
+    remain_cache_size = config->cache_committed - footer->offset;
 
     if (msg_size <= remain_cache_size) /* add at current position */
     {
@@ -1223,6 +1505,13 @@ int dlt_logstorage_write_msg_cache(DltLogStorageFilterConfig *config,
 
          if (msg_size > remain_cache_size)
          {
+            if (dlt_logstorage_commit_msg_cache(config, msg_size, cache_size) <
+                (unsigned int) msg_size)
+            {
+                dlt_log(LOG_WARNING, "Logstorage cache pool exhausted. Discard.\n");
+                return -1;
+            }
+
             /* start writing from beginning */
             footer->end_sync_offset = footer->offset;
             curr_write_addr = config->cache;
@@ -1258,6 +1547,7 @@ int dlt_logstorage_sync_msg_cache(DltLogStorageFilterConfig *config,
                                   int status)
 {
     unsigned int cache_size;
+    uint64_t start;
 
     DltLogStorageCacheFooter *footer = NULL;
 
@@ -1269,6 +1559,8 @@ int dlt_logstorage_sync_msg_cache(DltLogStorageFilterConfig *config,
     /* sync only, if given strategy is set */
     if (DLT_OFFLINE_LOGSTORAGE_IS_STRATEGY_SET(config->sync, status) > 0)
     {
+        start = dlt_logstorage_now();
+
         if (config->cache == NULL)
         {
             dlt_log(LOG_ERR,
@@ -1328,8 +1620,7 @@ int dlt_logstorage_sync_msg_cache(DltLogStorageFilterConfig *config,
             (status == DLT_LOGSTORAGE_SYNC_ON_FILE_SIZE))
         {
             /* clean ring buffer and reset footer information */
-            memset(config->cache, 0,
-                   cache_size + sizeof(DltLogStorageCacheFooter));
+            dlt_logstorage_reset_msg_cache(config, cache_size);
         }
 
         if (status == DLT_LOGSTORAGE_SYNC_ON_FILE_SIZE)
@@ -1339,6 +1630,8 @@ int dlt_logstorage_sync_msg_cache(DltLogStorageFilterConfig *config,
             config->log = NULL;
             config->current_write_file_offset = 0;
         }
+
+        dlt_logstorage_sync_done(start);
     }
     return 0;
 }
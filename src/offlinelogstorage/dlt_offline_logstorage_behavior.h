@@ -95,4 +95,10 @@ int dlt_logstorage_sync_msg_cache(DltLogStorageFilterConfig *config,
                                   char *dev_path,
                                   int status);
 
+/* Return the cache of a filter to the shared cache pool */
+void dlt_logstorage_free_msg_cache(DltLogStorageFilterConfig *config);
+
+/* Number, total and longest duration in ns of the syncs to the log files */
+void dlt_logstorage_get_sync_stats(uint64_t *count, uint64_t *sum, uint64_t *max);
+
 #endif /* DLT_OFFLINELOGSTORAGE_DLT_OFFLINE_LOGSTORAGE_BEHAVIOR_H_ */
@@ -41,6 +41,7 @@
 #include "dlt_user_shared.h"
 #include "dlt_common.h"
 #include "dlt_common_cfg.h"
+#include "dlt_compressed_file.h"
 
 #include "dlt_version.h"
 
@@ -1450,6 +1451,8 @@ DltReturnValue dlt_file_read_data(DltFile *file, int verbose)
 
 DltReturnValue dlt_file_open(DltFile *file, const char *filename, int verbose)
 {
+    char magic[4];
+
     PRINT_FUNCTION_VERBOSE(verbose);
 
     if ((file == NULL) || (filename == NULL))
@@ -1474,6 +1477,24 @@ DltReturnValue dlt_file_open(DltFile *file, const char *filename, int verbose)
         return DLT_RETURN_ERROR;
     }
 
+    /* a block compressed file is read through a stream of its messages */
+    if ((fread(magic, sizeof(magic), 1, file->handle) == 1) &&
+        (memcmp(magic, DLT_COMPRESSED_FILE_MAGIC, sizeof(magic)) == 0)) {
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+        file->handle = dlt_compressed_file_open(file->handle, verbose);
+
+        if (file->handle == NULL) {
+            dlt_vlog(LOG_WARNING, "Compressed file %s cannot be opened!\n", filename);
+            return DLT_RETURN_ERROR;
+        }
+#else
+        dlt_vlog(LOG_WARNING, "File %s is compressed, which is not supported by this build!\n", filename);
+        fclose(file->handle);
+        file->handle = NULL;
+        return DLT_RETURN_ERROR;
+#endif
+    }
+
     if (0 != fseek(file->handle, 0, SEEK_END)) {
         dlt_vlog(LOG_WARNING, "dlt_file_open: Seek failed to 0,SEEK_END");
         return DLT_RETURN_ERROR;
@@ -1519,6 +1540,12 @@ DltReturnValue dlt_file_read(DltFile *file, int verbose)
         file->index = ptr;
     }
 
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    /* skip compressed blocks without message of the filtered applications */
+    if (file->filter)
+        dlt_compressed_file_skip(file, file->filter, 0, 0, verbose);
+#endif
+
     /* set to end of last succesful read message, because of conflicting calls to dlt_file_read and dlt_file_message */
     if (0 != fseek(file->handle, file->file_position, SEEK_SET)) {
         dlt_vlog(LOG_WARNING, "Seek failed to file_position %" PRIu64 "\n",
@@ -1756,6 +1783,600 @@ DltReturnValue dlt_file_free(DltFile *file, int verbose)
     return dlt_message_free(&(file->msg), verbose);
 }
 
+/* Size of the marker argument: type info, length and the marker */
+#define DLT_SEGMENT_ARG_SIZE (sizeof(uint32_t) + sizeof(uint16_t) + sizeof(DltSegmentMarker))
+
+DltReturnValue dlt_message_get_segment(DltMessage *msg, DltSegmentMarker *marker)
+{
+    DltSegmentMarker tmp;
+    uint32_t type_info = 0;
+    uint16_t length = 0;
+    uint8_t *ptr;
+
+    if ((msg == NULL) || (msg->standardheader == NULL) || (msg->databuffer == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    if (DLT_MSG_IS_NONVERBOSE(msg) || (msg->extendedheader->noar < 1) ||
+        (msg->datasize < (int32_t)DLT_SEGMENT_ARG_SIZE))
+        return DLT_RETURN_OK;
+
+    ptr = msg->databuffer + msg->datasize - DLT_SEGMENT_ARG_SIZE;
+
+    memcpy(&type_info, ptr, sizeof(uint32_t));
+    memcpy(&length, ptr + sizeof(uint32_t), sizeof(uint16_t));
+    memcpy(&tmp, ptr + sizeof(uint32_t) + sizeof(uint16_t), sizeof(DltSegmentMarker));
+
+    if ((DLT_ENDIAN_GET_32(msg->standardheader->htyp, type_info) != DLT_TYPE_INFO_RAWD) ||
+        (DLT_ENDIAN_GET_16(msg->standardheader->htyp, length) != sizeof(DltSegmentMarker)) ||
+        (memcmp(tmp.magic, DLT_SEGMENT_MAGIC, sizeof(tmp.magic)) != 0))
+        return DLT_RETURN_OK;
+
+    if (marker != NULL) {
+        memcpy(marker->magic, tmp.magic, sizeof(tmp.magic));
+        marker->pid = DLT_ENDIAN_GET_32(msg->standardheader->htyp, tmp.pid);
+        marker->seq = DLT_ENDIAN_GET_32(msg->standardheader->htyp, tmp.seq);
+        marker->index = DLT_ENDIAN_GET_16(msg->standardheader->htyp, tmp.index);
+        marker->flags = DLT_ENDIAN_GET_16(msg->standardheader->htyp, tmp.flags);
+    }
+
+    return DLT_RETURN_TRUE;
+}
+
+DltReturnValue dlt_segment_init(DltSegmentBuffer *segments)
+{
+    if (segments == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    memset(segments, 0, sizeof(DltSegmentBuffer));
+
+    return DLT_RETURN_OK;
+}
+
+/* Find the value a message belongs to, NULL if there is none */
+static DltSegment *dlt_segment_find(DltSegmentBuffer *segments, const char *ecu, DltMessage *msg,
+                                    const DltSegmentMarker *marker)
+{
+    int i;
+
+    for (i = 0; i < DLT_SEGMENT_MAX_PENDING; i++)
+        if (segments->segments[i].used && (segments->segments[i].seq == marker->seq) &&
+            (segments->segments[i].pid == marker->pid) &&
+            (memcmp(segments->segments[i].ecu, ecu, DLT_ID_SIZE) == 0) &&
+            (memcmp(segments->segments[i].apid, msg->extendedheader->apid, DLT_ID_SIZE) == 0) &&
+            (memcmp(segments->segments[i].ctid, msg->extendedheader->ctid, DLT_ID_SIZE) == 0))
+            return &(segments->segments[i]);
+
+    return NULL;
+}
+
+/* Append the payload text of a message to a value */
+static DltReturnValue dlt_segment_append(DltSegment *segment, const char *text, const char *separator)
+{
+    size_t length = strlen(text) + strlen(separator);
+    char *buf;
+
+    if (segment->length + length + 1 > segment->size) {
+        buf = realloc(segment->text, (segment->length + length + 1) * 2);
+
+        if (buf == NULL) {
+            dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+            return DLT_RETURN_ERROR;
+        }
+
+        segment->text = buf;
+        segment->size = (segment->length + length + 1) * 2;
+    }
+
+    snprintf(segment->text + segment->length, segment->size - segment->length, "%s%s", separator, text);
+    segment->length += length;
+
+    return DLT_RETURN_OK;
+}
+
+DltReturnValue dlt_segment_add(DltSegmentBuffer *segments, DltMessage *msg, DltSegment **complete, int verbose)
+{
+    DltSegmentMarker marker;
+    DltSegment *segment;
+    const char *ecu;
+    const char *separator = "";
+    uint32_t type_info = 0;
+    int32_t datasize;
+    size_t size;
+    char *buf;
+    DltReturnValue ret;
+    int i;
+
+    PRINT_FUNCTION_VERBOSE(verbose);
+
+    if ((segments == NULL) || (msg == NULL) || (complete == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    *complete = NULL;
+
+    /* release the value completed by the last call */
+    for (i = 0; i < DLT_SEGMENT_MAX_PENDING; i++)
+        if (segments->segments[i].used && (segments->segments[i].next == 0))
+            segments->segments[i].used = 0;
+
+    if (dlt_message_get_segment(msg, &marker) != DLT_RETURN_TRUE)
+        return DLT_RETURN_OK;
+
+    ecu = DLT_IS_HTYP_WEID(msg->standardheader->htyp) ? msg->headerextra.ecu : msg->storageheader->ecu;
+    segment = dlt_segment_find(segments, ecu, msg, &marker);
+
+    if (marker.index == 0) {
+        if (segment == NULL) {
+            for (i = 0; i < DLT_SEGMENT_MAX_PENDING; i++)
+                if (!segments->segments[i].used)
+                    break;
+
+            /* all values are pending, drop the oldest one */
+            if (i == DLT_SEGMENT_MAX_PENDING) {
+                i = segments->evict;
+                segments->evict = (segments->evict + 1) % DLT_SEGMENT_MAX_PENDING;
+            }
+
+            segment = &(segments->segments[i]);
+        }
+
+        segment->used = 1;
+        memcpy(segment->ecu, ecu, DLT_ID_SIZE);
+        memcpy(segment->apid, msg->extendedheader->apid, DLT_ID_SIZE);
+        memcpy(segment->ctid, msg->extendedheader->ctid, DLT_ID_SIZE);
+        segment->pid = marker.pid;
+        segment->seq = marker.seq;
+        segment->next = 0;
+        segment->truncated = 0;
+        segment->length = 0;
+    }
+    else if ((segment == NULL) || (segment->next != marker.index)) {
+        /* a message of the value is missing */
+        if (segment != NULL)
+            segment->used = 0;
+
+        return DLT_RETURN_OK;
+    }
+
+    /* the payload text can take three characters per byte */
+    size = (size_t)msg->datasize * 3 + 64;
+
+    if (segments->scratch_size < size) {
+        buf = realloc(segments->scratch, size);
+
+        if (buf == NULL) {
+            dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+            segment->used = 0;
+            return DLT_RETURN_ERROR;
+        }
+
+        segments->scratch = buf;
+        segments->scratch_size = size;
+    }
+
+    /* print the message without its marker */
+    datasize = msg->datasize;
+    msg->datasize -= (int32_t)DLT_SEGMENT_ARG_SIZE;
+    msg->extendedheader->noar--;
+
+    if (marker.index == 0) {
+        ret = dlt_message_header(msg, segment->header, sizeof(segment->header), verbose);
+    }
+    else {
+        ret = DLT_RETURN_OK;
+
+        /* hex dumps of raw data are separated by a space */
+        if (msg->datasize >= (int32_t)sizeof(uint32_t)) {
+            memcpy(&type_info, msg->databuffer, sizeof(uint32_t));
+
+            if (DLT_ENDIAN_GET_32(msg->standardheader->htyp, type_info) & DLT_TYPE_INFO_RAWD)
+                separator = " ";
+        }
+    }
+
+    if (ret == DLT_RETURN_OK)
+        ret = dlt_message_payload(msg, segments->scratch, segments->scratch_size, DLT_OUTPUT_ASCII, verbose);
+
+    msg->datasize = datasize;
+    msg->extendedheader->noar++;
+
+    if ((ret != DLT_RETURN_OK) ||
+        (dlt_segment_append(segment, segments->scratch, (segment->length > 0) ? separator : "") != DLT_RETURN_OK)) {
+        segment->used = 0;
+        return DLT_RETURN_ERROR;
+    }
+
+    if (marker.flags & DLT_SEGMENT_FLAG_LAST) {
+        /* released by the next call */
+        segment->next = 0;
+        segment->truncated = (marker.flags & DLT_SEGMENT_FLAG_TRUNCATED) ? 1 : 0;
+        *complete = segment;
+    }
+    else {
+        segment->next = (uint16_t)(marker.index + 1);
+    }
+
+    return DLT_RETURN_TRUE;
+}
+
+DltReturnValue dlt_segment_get_pending(DltSegmentBuffer *segments, DltSegment **pending)
+{
+    int i;
+
+    if ((segments == NULL) || (pending == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    *pending = NULL;
+
+    /* release the value returned by the last call */
+    for (i = 0; i < DLT_SEGMENT_MAX_PENDING; i++)
+        if (segments->segments[i].used && (segments->segments[i].next == 0))
+            segments->segments[i].used = 0;
+
+    for (i = 0; i < DLT_SEGMENT_MAX_PENDING; i++)
+        if (segments->segments[i].used) {
+            /* released by the next call */
+            segments->segments[i].next = 0;
+            segments->segments[i].truncated = 1;
+            *pending = &(segments->segments[i]);
+            return DLT_RETURN_TRUE;
+        }
+
+    return DLT_RETURN_OK;
+}
+
+DltReturnValue dlt_segment_free(DltSegmentBuffer *segments)
+{
+    int i;
+
+    if (segments == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    for (i = 0; i < DLT_SEGMENT_MAX_PENDING; i++)
+        free(segments->segments[i].text);
+
+    free(segments->scratch);
+
+    return dlt_segment_init(segments);
+}
+
+/* Value of count decimal digits, -1 if one is not a digit */
+static int dlt_syslog_digits(const char *p, int count)
+{
+    int value = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if ((p[i] < '0') || (p[i] > '9'))
+            return -1;
+
+        value = value * 10 + (p[i] - '0');
+    }
+
+    return value;
+}
+
+/* RFC 3164 timestamp "Mmm dd hh:mm:ss" in local time, without year */
+static int dlt_syslog_parse_time_3164(const char *p, DltSyslogMessage *msg)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    struct tm tm;
+    time_t now;
+    int month, day, hour, min, sec;
+
+    if ((p[3] != ' ') || (p[6] != ' ') || (p[9] != ':') || (p[12] != ':') || (p[15] != ' '))
+        return 0;
+
+    for (month = 0; month < 12; month++)
+        if (memcmp(months + 3 * month, p, 3) == 0)
+            break;
+
+    /* the day is padded with a space */
+    day = (p[4] == ' ') ? dlt_syslog_digits(p + 5, 1) : dlt_syslog_digits(p + 4, 2);
+    hour = dlt_syslog_digits(p + 7, 2);
+    min = dlt_syslog_digits(p + 10, 2);
+    sec = dlt_syslog_digits(p + 13, 2);
+
+    if ((month == 12) || (day < 1) || (hour < 0) || (min < 0) || (sec < 0))
+        return 0;
+
+    now = time(NULL);
+
+    if (localtime_r(&now, &tm) == NULL)
+        return 0;
+
+    tm.tm_mon = month;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = min;
+    tm.tm_sec = sec;
+    tm.tm_isdst = -1;
+    msg->time = mktime(&tm);
+
+    /* a message from more than a day in the future was sent last year */
+    if (msg->time > now + 86400) {
+        if (localtime_r(&now, &tm) == NULL)
+            return 0;
+
+        tm.tm_year--;
+        tm.tm_mon = month;
+        tm.tm_mday = day;
+        tm.tm_hour = hour;
+        tm.tm_min = min;
+        tm.tm_sec = sec;
+        tm.tm_isdst = -1;
+        msg->time = mktime(&tm);
+    }
+
+    msg->has_time = (msg->time != (time_t)-1);
+
+    return msg->has_time;
+}
+
+/* RFC 5424 timestamp "YYYY-MM-DDThh:mm:ss[.frac](Z|+hh:mm|-hh:mm)" */
+static void dlt_syslog_parse_time_5424(const char *p, size_t length, DltSyslogMessage *msg)
+{
+    const char *end = p + length;
+    struct tm tm;
+    int year, offset = 0, hours, minutes, digits = 0;
+    uint32_t usec = 0;
+
+    if ((length < 20) || (p[4] != '-') || (p[7] != '-') || (p[10] != 'T') || (p[13] != ':') ||
+        (p[16] != ':'))
+        return;
+
+    memset(&tm, 0, sizeof(tm));
+    year = dlt_syslog_digits(p, 4);
+    tm.tm_mon = dlt_syslog_digits(p + 5, 2) - 1;
+    tm.tm_mday = dlt_syslog_digits(p + 8, 2);
+    tm.tm_hour = dlt_syslog_digits(p + 11, 2);
+    tm.tm_min = dlt_syslog_digits(p + 14, 2);
+    tm.tm_sec = dlt_syslog_digits(p + 17, 2);
+
+    if ((year < 1970) || (tm.tm_mon < 0) || (tm.tm_mday < 1) || (tm.tm_hour < 0) || (tm.tm_min < 0) ||
+        (tm.tm_sec < 0))
+        return;
+
+    tm.tm_year = year - 1900;
+    p += 19;
+
+    if ((p < end) && (*p == '.'))
+        for (p++; (p < end) && (*p >= '0') && (*p <= '9'); p++)
+            if (digits < 6) {
+                usec = usec * 10 + (uint32_t)(*p - '0');
+                digits++;
+            }
+
+    for (; digits < 6; digits++)
+        usec *= 10;
+
+    if ((end - p == 1) && (*p == 'Z')) {
+        offset = 0;
+    }
+    else if ((end - p == 6) && ((*p == '+') || (*p == '-')) && (p[3] == ':')) {
+        hours = dlt_syslog_digits(p + 1, 2);
+        minutes = dlt_syslog_digits(p + 4, 2);
+
+        if ((hours < 0) || (minutes < 0))
+            return;
+
+        offset = (hours * 60 + minutes) * 60;
+
+        if (*p == '-')
+            offset = -offset;
+    }
+    else {
+        return;
+    }
+
+    msg->time = timegm(&tm) - offset;
+    msg->usec = usec;
+    msg->has_time = 1;
+}
+
+static uint16_t dlt_syslog_length(const char *begin, const char *end)
+{
+    return (end - begin > UINT16_MAX) ? UINT16_MAX : (uint16_t)(end - begin);
+}
+
+/* "[HOSTNAME ]TAG[[PID]]: MSG" after the timestamp of RFC 3164 */
+static void dlt_syslog_parse_3164(const char *p, const char *end, DltSyslogMessage *msg)
+{
+    const char *token;
+
+    if ((end - p > 16) && dlt_syslog_parse_time_3164(p, msg))
+        p += 16;
+
+    msg->text = p;
+
+    token = p;
+
+    while ((p < end) && (*p != ' ') && (*p != ':') && (*p != '['))
+        p++;
+
+    /* local senders leave out the hostname, which only follows a timestamp */
+    if (msg->has_time && (p < end) && (*p == ' ') && (p > token)) {
+        msg->hostname = token;
+        msg->hostname_length = dlt_syslog_length(token, p);
+        msg->text = ++p;
+        token = p;
+
+        while ((p < end) && (*p != ' ') && (*p != ':') && (*p != '['))
+            p++;
+    }
+
+    /* without ':' or '[' the rest is text */
+    if ((p == end) || (p == token) || (*p == ' '))
+        return;
+
+    msg->tag = token;
+    msg->tag_length = dlt_syslog_length(token, p);
+
+    if (*p == '[')
+        while ((p < end) && (*p++ != ']'))
+            ;
+
+    if ((p < end) && (*p == ':'))
+        p++;
+
+    if ((p < end) && (*p == ' '))
+        p++;
+
+    msg->text = p;
+}
+
+/* "TIMESTAMP HOSTNAME APP-NAME PROCID MSGID SD [MSG]" after the version of RFC 5424 */
+static void dlt_syslog_parse_5424(const char *p, const char *end, DltSyslogMessage *msg)
+{
+    const char *field[5];
+    size_t length[5];
+    int quoted;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        field[i] = p;
+
+        while ((p < end) && (*p != ' '))
+            p++;
+
+        length[i] = (size_t)(p - field[i]);
+
+        if (p < end)
+            p++;
+    }
+
+    dlt_syslog_parse_time_5424(field[0], length[0], msg);
+
+    /* '-' is the nil value */
+    if ((length[1] > 0) && !((length[1] == 1) && (field[1][0] == '-'))) {
+        msg->hostname = field[1];
+        msg->hostname_length = dlt_syslog_length(field[1], field[1] + length[1]);
+    }
+
+    if ((length[2] > 0) && !((length[2] == 1) && (field[2][0] == '-'))) {
+        msg->tag = field[2];
+        msg->tag_length = dlt_syslog_length(field[2], field[2] + length[2]);
+    }
+
+    /* structured data is '-' or elements "[id name="value" ...]" */
+    if ((p < end) && (*p == '-')) {
+        p++;
+    }
+    else {
+        while ((p < end) && (*p == '[')) {
+            for (quoted = 0, p++; (p < end) && (quoted || (*p != ']')); p++) {
+                if ((*p == '\\') && (p + 1 < end))
+                    p++;
+                else if (*p == '"')
+                    quoted = !quoted;
+            }
+
+            if (p < end)
+                p++;
+        }
+    }
+
+    if ((p < end) && (*p == ' '))
+        p++;
+
+    /* the text may start with a UTF-8 byte order mark */
+    if ((end - p >= 3) && (memcmp(p, "\xEF\xBB\xBF", 3) == 0))
+        p += 3;
+
+    msg->text = p;
+}
+
+DltReturnValue dlt_syslog_parse(const char *data, int size, DltSyslogMessage *msg)
+{
+    const char *p;
+    const char *end;
+    int pri = 0;
+    int digits = 0;
+
+    if ((data == NULL) || (size < 0) || (msg == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    memset(msg, 0, sizeof(DltSyslogMessage));
+    msg->severity = -1;
+    msg->facility = -1;
+
+    end = data + size;
+
+    while ((end > data) && ((end[-1] == '\n') || (end[-1] == '\r') || (end[-1] == '\0')))
+        end--;
+
+    msg->text = data;
+    msg->text_length = dlt_syslog_length(data, end);
+
+    /* "<PRI>" with up to three digits, the highest value is 191 */
+    p = data;
+
+    if ((p == end) || (*p != '<'))
+        return DLT_RETURN_OK;
+
+    for (p++; (p < end) && (digits < 3) && (*p >= '0') && (*p <= '9'); p++, digits++)
+        pri = pri * 10 + (*p - '0');
+
+    if ((digits == 0) || (p == end) || (*p != '>') || (pri > 191))
+        return DLT_RETURN_OK;
+
+    p++;
+    msg->severity = pri & 7;
+    msg->facility = pri >> 3;
+
+    if ((end - p >= 2) && (p[0] == '1') && (p[1] == ' '))
+        dlt_syslog_parse_5424(p + 2, end, msg);
+    else
+        dlt_syslog_parse_3164(p, end, msg);
+
+    msg->text_length = dlt_syslog_length(msg->text, end);
+
+    return DLT_RETURN_OK;
+}
+
+DltLogLevelType dlt_syslog_get_log_level(int severity)
+{
+    switch (severity) {
+    case 0:     /* Emergency */
+    case 1:     /* Alert */
+    case 2:     /* Critical */
+        return DLT_LOG_FATAL;
+    case 3:     /* Error */
+        return DLT_LOG_ERROR;
+    case 4:     /* Warning */
+        return DLT_LOG_WARN;
+    case 5:     /* Notice */
+    case 6:     /* Informational */
+        return DLT_LOG_INFO;
+    case 7:     /* Debug */
+        return DLT_LOG_DEBUG;
+    default:
+        return DLT_LOG_INFO;
+    }
+}
+
+uint32_t dlt_syslog_get_timestamp(const DltSyslogMessage *msg)
+{
+    struct timespec real, mono;
+    int64_t boot, now, stamp;
+
+    if ((msg == NULL) || !msg->has_time)
+        return 0;
+
+    if ((clock_gettime(CLOCK_REALTIME, &real) != 0) || (clock_gettime(CLOCK_MONOTONIC, &mono) != 0))
+        return 0;
+
+    /* wall clock time of the boot, all in 0.1 ms */
+    now = (int64_t)mono.tv_sec * 10000 + mono.tv_nsec / 100000;
+    boot = (int64_t)real.tv_sec * 10000 + real.tv_nsec / 100000 - now;
+    stamp = (int64_t)msg->time * 10000 + msg->usec / 100 - boot;
+
+    if ((stamp <= 0) || (stamp > (int64_t)UINT32_MAX))
+        return 0;
+
+    /* the clock of the sender may be ahead */
+    return (uint32_t)((stamp < now) ? stamp : now);
+}
+
 void dlt_log_set_level(int level)
 {
     if ((level < 0) || (level > LOG_DEBUG)) {
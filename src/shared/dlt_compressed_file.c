@@ -0,0 +1,836 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_compressed_file.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <zlib.h>
+
+#include "dlt_common.h"
+#include "dlt_compressed_file.h"
+
+/* Compression level of the blocks, logs compress well already at the
+ * fastest level */
+#define DLT_COMPRESSED_LEVEL Z_BEST_SPEED
+
+/* Index entries are added in steps of this many entries */
+#define DLT_COMPRESSED_INDEX_STEP 64
+
+/**
+ * Reader of a block compressed DLT file, the cookie of the stream returned
+ * by dlt_compressed_file_open(). The open readers are kept in a list to find
+ * the reader of a stream, DltFile has no room for it.
+ */
+typedef struct sDltCompressedFile
+{
+    FILE *stream;                       /**< stream of the uncompressed messages */
+    struct sDltCompressedFile *next;    /**< next open reader */
+    FILE *raw;                          /**< compressed file */
+    DltCompressedBlockIndex *index;     /**< index of all blocks */
+    uint64_t *positions;                /**< uncompressed position of each block, and the length at the end */
+    uint32_t blocks;                    /**< number of blocks */
+    uint64_t position;                  /**< position in the uncompressed messages */
+    int64_t cached;                     /**< block in data, -1 if none */
+    uint8_t *data;                      /**< uncompressed data of the cached block */
+    uint32_t data_size;                 /**< size allocated for data */
+    uint8_t *input;                     /**< compressed data of the cached block */
+    uint32_t input_size;                /**< size allocated for input */
+} DltCompressedFile;
+
+static DltCompressedFile *dlt_compressed_readers = NULL;
+static atomic_int dlt_compressed_reader_count = 0;
+static pthread_mutex_t dlt_compressed_readers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Bit of an id in the bitmaps of a block */
+static uint32_t dlt_compressed_id_bit(const char *id)
+{
+    uint32_t hash = 2166136261U;
+    int i;
+
+    for (i = 0; i < DLT_ID_SIZE; i++) {
+        hash ^= (uint8_t)id[i];
+        hash *= 16777619U;
+    }
+
+    return hash % DLT_COMPRESSED_BITMAP_BITS;
+}
+
+#define DLT_COMPRESSED_SET_BIT(bitmap, id) \
+    do { \
+        uint32_t bit_ = dlt_compressed_id_bit(id); \
+        (bitmap)[bit_ / 64] |= 1ULL << (bit_ % 64); \
+    } while (0)
+
+/* Index of a block which may contain any message */
+static void dlt_compressed_index_reset(DltCompressedBlockIndex *entry)
+{
+    memset(entry, 0, sizeof(DltCompressedBlockIndex));
+    entry->time_min = UINT64_MAX;
+}
+
+static void dlt_compressed_index_convert(DltCompressedBlockIndex *entry)
+{
+    int i;
+
+    entry->offset = DLT_LETOH_64(entry->offset);
+    entry->size = DLT_LETOH_32(entry->size);
+    entry->length = DLT_LETOH_32(entry->length);
+    entry->messages = DLT_LETOH_32(entry->messages);
+    entry->time_min = DLT_LETOH_64(entry->time_min);
+    entry->time_max = DLT_LETOH_64(entry->time_max);
+
+    for (i = 0; i < DLT_COMPRESSED_BITMAP_WORDS; i++)
+        entry->apid[i] = DLT_LETOH_64(entry->apid[i]);
+}
+
+static DltReturnValue dlt_compressed_pwrite(DltCompressedWriter *writer, const void *data, size_t size)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+    ssize_t ret;
+
+    while (size > 0) {
+        ret = pwrite(writer->fd, ptr, size, (off_t)writer->offset);
+
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+
+            dlt_vlog(LOG_ERR, "%s: write failed: %s\n", __func__, strerror(errno));
+            return DLT_RETURN_ERROR;
+        }
+
+        ptr += ret;
+        size -= (size_t)ret;
+        writer->offset += (uint64_t)ret;
+    }
+
+    return DLT_RETURN_OK;
+}
+
+/* Add a message copied into the current block to its index */
+static void dlt_compressed_writer_account(DltCompressedWriter *writer, const uint8_t *msg, uint32_t size)
+{
+    DltCompressedBlockIndex *entry = &(writer->current);
+    const DltStorageHeader *storageheader = (const DltStorageHeader *)msg;
+    const DltStandardHeader *standardheader =
+        (const DltStandardHeader *)(msg + sizeof(DltStorageHeader));
+    const DltExtendedHeader *extendedheader = NULL;
+    uint32_t extended;
+    uint64_t time;
+
+    entry->messages++;
+
+    if ((size < sizeof(DltStorageHeader) + sizeof(DltStandardHeader)) ||
+        (dlt_check_storageheader((DltStorageHeader *)storageheader) != DLT_RETURN_TRUE))
+        return;
+
+    time = (uint64_t)storageheader->seconds * 1000000ULL + (uint64_t)(uint32_t)storageheader->microseconds;
+
+    if (time < entry->time_min)
+        entry->time_min = time;
+
+    if (time > entry->time_max)
+        entry->time_max = time;
+
+    extended = (uint32_t)(sizeof(DltStorageHeader) + sizeof(DltStandardHeader) +
+                          DLT_STANDARD_HEADER_EXTRA_SIZE(standardheader->htyp));
+
+    if (DLT_IS_HTYP_UEH(standardheader->htyp) && (size >= extended + sizeof(DltExtendedHeader)))
+        extendedheader = (const DltExtendedHeader *)(msg + extended);
+
+    if (extendedheader != NULL)
+        DLT_COMPRESSED_SET_BIT(entry->apid, extendedheader->apid);
+    else
+        /* a message without extended header matches every filter */
+        memset(entry->apid, 0xff, sizeof(entry->apid));
+}
+
+/* Compress and write the current block */
+static DltReturnValue dlt_compressed_writer_flush(DltCompressedWriter *writer)
+{
+    DltCompressedBlockHeader header;
+    DltCompressedBlockIndex *index;
+    uLongf size = writer->output_size;
+
+    if (writer->used == 0)
+        return DLT_RETURN_OK;
+
+    if (compress2(writer->output, &size, writer->block, writer->used, DLT_COMPRESSED_LEVEL) != Z_OK) {
+        dlt_vlog(LOG_ERR, "%s: compressing block failed\n", __func__);
+        return DLT_RETURN_ERROR;
+    }
+
+    if (writer->blocks == writer->index_size) {
+        index = realloc(writer->index,
+                        sizeof(DltCompressedBlockIndex) * (writer->index_size + DLT_COMPRESSED_INDEX_STEP));
+
+        if (index == NULL) {
+            dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+            return DLT_RETURN_ERROR;
+        }
+
+        writer->index = index;
+        writer->index_size += DLT_COMPRESSED_INDEX_STEP;
+    }
+
+    writer->current.offset = writer->offset;
+    writer->current.size = (uint32_t)size;
+    writer->current.length = writer->used;
+
+    memcpy(header.magic, DLT_COMPRESSED_BLOCK_MAGIC, sizeof(header.magic));
+    header.size = DLT_HTOLE_32((uint32_t)size);
+    header.length = DLT_HTOLE_32(writer->used);
+
+    if ((dlt_compressed_pwrite(writer, &header, sizeof(header)) < DLT_RETURN_OK) ||
+        (dlt_compressed_pwrite(writer, writer->output, size) < DLT_RETURN_OK))
+        return DLT_RETURN_ERROR;
+
+    writer->index[writer->blocks++] = writer->current;
+    dlt_compressed_index_reset(&(writer->current));
+    writer->used = 0;
+
+    return DLT_RETURN_OK;
+}
+
+DltReturnValue dlt_compressed_writer_init(DltCompressedWriter *writer, int fd)
+{
+    DltCompressedFileHeader header;
+
+    if ((writer == NULL) || (fd < 0))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    memset(writer, 0, sizeof(DltCompressedWriter));
+    writer->fd = fd;
+    dlt_compressed_index_reset(&(writer->current));
+
+    writer->output_size = compressBound(DLT_COMPRESSED_BLOCK_SIZE);
+    writer->block = malloc(DLT_COMPRESSED_BLOCK_SIZE);
+    writer->output = malloc(writer->output_size);
+
+    if ((writer->block == NULL) || (writer->output == NULL)) {
+        dlt_vlog(LOG_ERR, "%s: cannot allocate memory\n", __func__);
+        free(writer->block);
+        free(writer->output);
+        writer->block = NULL;
+        writer->output = NULL;
+        return DLT_RETURN_ERROR;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DLT_COMPRESSED_FILE_MAGIC, sizeof(header.magic));
+    header.version = DLT_COMPRESSED_FILE_VERSION;
+    header.codec = DLT_COMPRESSED_CODEC_ZLIB;
+    header.block_size = DLT_HTOLE_32(DLT_COMPRESSED_BLOCK_SIZE);
+
+    return dlt_compressed_pwrite(writer, &header, sizeof(header));
+}
+
+DltReturnValue dlt_compressed_writer_add(DltCompressedWriter *writer,
+                                         const uint8_t *data1,
+                                         int size1,
+                                         const uint8_t *data2,
+                                         int size2,
+                                         const uint8_t *data3,
+                                         int size3)
+{
+    uint8_t *msg;
+    uint32_t size;
+
+    if ((writer == NULL) || (writer->block == NULL) || (data1 == NULL) || (size1 < 0) ||
+        ((data2 == NULL) && (size2 > 0)) || ((data3 == NULL) && (size3 > 0)) ||
+        (size2 < 0) || (size3 < 0))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    size = (uint32_t)size1 + (uint32_t)size2 + (uint32_t)size3;
+
+    if (size > DLT_COMPRESSED_BLOCK_SIZE)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    if ((writer->used + size > DLT_COMPRESSED_BLOCK_SIZE) &&
+        (dlt_compressed_writer_flush(writer) < DLT_RETURN_OK))
+        return DLT_RETURN_ERROR;
+
+    msg = writer->block + writer->used;
+    memcpy(msg, data1, (size_t)size1);
+
+    if (size2 > 0)
+        memcpy(msg + size1, data2, (size_t)size2);
+
+    if (size3 > 0)
+        memcpy(msg + size1 + size2, data3, (size_t)size3);
+
+    writer->used += size;
+    dlt_compressed_writer_account(writer, msg, size);
+
+    return DLT_RETURN_OK;
+}
+
+DltReturnValue dlt_compressed_writer_write(DltCompressedWriter *writer, const uint8_t *data, size_t size)
+{
+    const DltStandardHeader *standardheader;
+    size_t length;
+    DltReturnValue ret;
+
+    if ((writer == NULL) || ((data == NULL) && (size > 0)))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    while (size > 0) {
+        if ((size < sizeof(DltStorageHeader) + sizeof(DltStandardHeader)) ||
+            (dlt_check_storageheader((DltStorageHeader *)data) != DLT_RETURN_TRUE)) {
+            dlt_vlog(LOG_WARNING, "%s: data does not start with a storage header\n", __func__);
+            return DLT_RETURN_WRONG_PARAMETER;
+        }
+
+        standardheader = (const DltStandardHeader *)(data + sizeof(DltStorageHeader));
+        length = sizeof(DltStorageHeader) + DLT_BETOH_16(standardheader->len);
+
+        if (length > size) {
+            dlt_vlog(LOG_WARNING, "%s: incomplete message\n", __func__);
+            return DLT_RETURN_WRONG_PARAMETER;
+        }
+
+        ret = dlt_compressed_writer_add(writer, data, (int)length, NULL, 0, NULL, 0);
+
+        if (ret < DLT_RETURN_OK)
+            return ret;
+
+        data += length;
+        size -= length;
+    }
+
+    return DLT_RETURN_OK;
+}
+
+uint64_t dlt_compressed_writer_size(DltCompressedWriter *writer)
+{
+    if (writer == NULL)
+        return 0;
+
+    return writer->offset + writer->used;
+}
+
+DltReturnValue dlt_compressed_writer_close(DltCompressedWriter *writer)
+{
+    DltCompressedFileFooter footer;
+    DltReturnValue ret;
+    uint32_t i;
+    int j;
+
+    if ((writer == NULL) || (writer->block == NULL))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    ret = dlt_compressed_writer_flush(writer);
+
+    if (ret == DLT_RETURN_OK) {
+        footer.index = DLT_HTOLE_64(writer->offset);
+        footer.blocks = DLT_HTOLE_32(writer->blocks);
+        memcpy(footer.magic, DLT_COMPRESSED_INDEX_MAGIC, sizeof(footer.magic));
+
+        for (i = 0; i < writer->blocks; i++) {
+            writer->index[i].offset = DLT_HTOLE_64(writer->index[i].offset);
+            writer->index[i].size = DLT_HTOLE_32(writer->index[i].size);
+            writer->index[i].length = DLT_HTOLE_32(writer->index[i].length);
+            writer->index[i].messages = DLT_HTOLE_32(writer->index[i].messages);
+            writer->index[i].time_min = DLT_HTOLE_64(writer->index[i].time_min);
+            writer->index[i].time_max = DLT_HTOLE_64(writer->index[i].time_max);
+
+            for (j = 0; j < DLT_COMPRESSED_BITMAP_WORDS; j++)
+                writer->index[i].apid[j] = DLT_HTOLE_64(writer->index[i].apid[j]);
+        }
+
+        if ((dlt_compressed_pwrite(writer, writer->index,
+                                   sizeof(DltCompressedBlockIndex) * writer->blocks) < DLT_RETURN_OK) ||
+            (dlt_compressed_pwrite(writer, &footer, sizeof(footer)) < DLT_RETURN_OK))
+            ret = DLT_RETURN_ERROR;
+    }
+
+    /* the file may have been longer before */
+    if ((ret == DLT_RETURN_OK) && (ftruncate(writer->fd, (off_t)writer->offset) != 0))
+        dlt_vlog(LOG_WARNING, "%s: truncate failed: %s\n", __func__, strerror(errno));
+
+    free(writer->block);
+    free(writer->output);
+    free(writer->index);
+    writer->block = NULL;
+    writer->output = NULL;
+    writer->index = NULL;
+    writer->blocks = 0;
+    writer->index_size = 0;
+
+    return ret;
+}
+
+/* Read the index at the end of the file */
+static int dlt_compressed_file_read_index(DltCompressedFile *file, uint64_t size)
+{
+    DltCompressedFileFooter footer;
+    uint64_t index;
+    uint32_t blocks;
+    uint32_t i;
+
+    if (size < sizeof(DltCompressedFileHeader) + sizeof(DltCompressedFileFooter))
+        return -1;
+
+    if ((fseeko(file->raw, (off_t)(size - sizeof(footer)), SEEK_SET) != 0) ||
+        (fread(&footer, sizeof(footer), 1, file->raw) != 1) ||
+        (memcmp(footer.magic, DLT_COMPRESSED_INDEX_MAGIC, sizeof(footer.magic)) != 0))
+        return -1;
+
+    index = DLT_LETOH_64(footer.index);
+    blocks = DLT_LETOH_32(footer.blocks);
+
+    if ((index < sizeof(DltCompressedFileHeader)) ||
+        (index + (uint64_t)blocks * sizeof(DltCompressedBlockIndex) + sizeof(footer) != size))
+        return -1;
+
+    file->index = malloc(sizeof(DltCompressedBlockIndex) * (blocks + 1));
+
+    if (file->index == NULL)
+        return -1;
+
+    if ((fseeko(file->raw, (off_t)index, SEEK_SET) != 0) ||
+        ((blocks > 0) && (fread(file->index, sizeof(DltCompressedBlockIndex), blocks, file->raw) != blocks))) {
+        free(file->index);
+        file->index = NULL;
+        return -1;
+    }
+
+    for (i = 0; i < blocks; i++) {
+        dlt_compressed_index_convert(&(file->index[i]));
+
+        if (file->index[i].offset + sizeof(DltCompressedBlockHeader) + file->index[i].size > index) {
+            free(file->index);
+            file->index = NULL;
+            return -1;
+        }
+    }
+
+    file->blocks = blocks;
+
+    return 0;
+}
+
+/* Find the blocks of a file without index by their headers */
+static int dlt_compressed_file_scan(DltCompressedFile *file, uint64_t size)
+{
+    DltCompressedBlockHeader header;
+    DltCompressedBlockIndex *index;
+    uint64_t offset = sizeof(DltCompressedFileHeader);
+    uint32_t allocated = 0;
+
+    while (offset + sizeof(header) <= size) {
+        if ((fseeko(file->raw, (off_t)offset, SEEK_SET) != 0) ||
+            (fread(&header, sizeof(header), 1, file->raw) != 1) ||
+            (memcmp(header.magic, DLT_COMPRESSED_BLOCK_MAGIC, sizeof(header.magic)) != 0))
+            break;
+
+        header.size = DLT_LETOH_32(header.size);
+        header.length = DLT_LETOH_32(header.length);
+
+        /* the last block may be incomplete */
+        if (offset + sizeof(header) + header.size > size)
+            break;
+
+        if (file->blocks == allocated) {
+            index = realloc(file->index, sizeof(DltCompressedBlockIndex) * (allocated + DLT_COMPRESSED_INDEX_STEP + 1));
+
+            if (index == NULL)
+                return -1;
+
+            file->index = index;
+            allocated += DLT_COMPRESSED_INDEX_STEP;
+        }
+
+        /* nothing is known about the messages, so the block is never skipped */
+        index = &(file->index[file->blocks++]);
+        memset(index, 0, sizeof(DltCompressedBlockIndex));
+        index->offset = offset;
+        index->size = header.size;
+        index->length = header.length;
+        index->time_max = UINT64_MAX;
+        memset(index->apid, 0xff, sizeof(index->apid));
+
+        offset += sizeof(header) + header.size;
+    }
+
+    if (file->index == NULL)
+        file->index = malloc(sizeof(DltCompressedBlockIndex));
+
+    return (file->index == NULL) ? -1 : 0;
+}
+
+/* Block containing the uncompressed position */
+static int64_t dlt_compressed_file_find(DltCompressedFile *file, uint64_t position)
+{
+    uint32_t low = 0;
+    uint32_t high = file->blocks;
+    uint32_t mid;
+
+    if (position >= file->positions[file->blocks])
+        return -1;
+
+    if ((file->cached >= 0) && (position >= file->positions[file->cached]) &&
+        (position < file->positions[file->cached + 1]))
+        return file->cached;
+
+    while (high - low > 1) {
+        mid = low + (high - low) / 2;
+
+        if (file->positions[mid] <= position)
+            low = mid;
+        else
+            high = mid;
+    }
+
+    return (int64_t)low;
+}
+
+static int dlt_compressed_file_load(DltCompressedFile *file, int64_t block)
+{
+    DltCompressedBlockIndex *entry = &(file->index[block]);
+    uint8_t *buffer;
+    uLongf length = entry->length;
+
+    if (file->cached == block)
+        return 0;
+
+    file->cached = -1;
+
+    if (entry->size > file->input_size) {
+        buffer = realloc(file->input, entry->size);
+
+        if (buffer == NULL)
+            return -1;
+
+        file->input = buffer;
+        file->input_size = entry->size;
+    }
+
+    if (entry->length > file->data_size) {
+        buffer = realloc(file->data, entry->length);
+
+        if (buffer == NULL)
+            return -1;
+
+        file->data = buffer;
+        file->data_size = entry->length;
+    }
+
+    if ((fseeko(file->raw, (off_t)(entry->offset + sizeof(DltCompressedBlockHeader)), SEEK_SET) != 0) ||
+        (fread(file->input, 1, entry->size, file->raw) != entry->size)) {
+        dlt_vlog(LOG_WARNING, "%s: cannot read block %" PRId64 "\n", __func__, block);
+        return -1;
+    }
+
+    if ((uncompress(file->data, &length, file->input, entry->size) != Z_OK) ||
+        (length != entry->length)) {
+        dlt_vlog(LOG_WARNING, "%s: block %" PRId64 " is corrupted\n", __func__, block);
+        return -1;
+    }
+
+    file->cached = block;
+
+    return 0;
+}
+
+static ssize_t dlt_compressed_file_cookie_read(void *cookie, char *buf, size_t size)
+{
+    DltCompressedFile *file = (DltCompressedFile *)cookie;
+    size_t done = 0;
+    size_t count;
+    uint64_t offset;
+    int64_t block;
+
+    /* a read ends at the end of a block, messages are not split over
+     * blocks, so the next block is only inflated when it is needed */
+    while (done == 0) {
+        block = dlt_compressed_file_find(file, file->position);
+
+        if (block < 0)
+            break;
+
+        if (dlt_compressed_file_load(file, block) < 0) {
+            errno = EIO;
+            return (done > 0) ? (ssize_t)done : -1;
+        }
+
+        offset = file->position - file->positions[block];
+        count = file->index[block].length - offset;
+
+        if (count > size - done)
+            count = size - done;
+
+        memcpy(buf + done, file->data + offset, count);
+        done += count;
+        file->position += count;
+    }
+
+    return (ssize_t)done;
+}
+
+static int dlt_compressed_file_cookie_seek(void *cookie, off64_t *offset, int whence)
+{
+    DltCompressedFile *file = (DltCompressedFile *)cookie;
+    int64_t position;
+
+    switch (whence) {
+    case SEEK_SET:
+        position = *offset;
+        break;
+    case SEEK_CUR:
+        position = (int64_t)file->position + *offset;
+        break;
+    case SEEK_END:
+        position = (int64_t)file->positions[file->blocks] + *offset;
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (position < 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    file->position = (uint64_t)position;
+    *offset = position;
+
+    return 0;
+}
+
+static int dlt_compressed_file_cookie_close(void *cookie)
+{
+    DltCompressedFile *file = (DltCompressedFile *)cookie;
+    DltCompressedFile **link;
+
+    if (file->stream != NULL) {
+        pthread_mutex_lock(&dlt_compressed_readers_lock);
+
+        for (link = &dlt_compressed_readers; *link != NULL; link = &((*link)->next))
+            if (*link == file) {
+                *link = file->next;
+                atomic_fetch_sub(&dlt_compressed_reader_count, 1);
+                break;
+            }
+
+        pthread_mutex_unlock(&dlt_compressed_readers_lock);
+    }
+
+    if (file->raw != NULL)
+        fclose(file->raw);
+
+    free(file->index);
+    free(file->positions);
+    free(file->data);
+    free(file->input);
+    free(file);
+
+    return 0;
+}
+
+FILE *dlt_compressed_file_open(FILE *raw, int verbose)
+{
+    cookie_io_functions_t functions = {
+        .read = dlt_compressed_file_cookie_read,
+        .write = NULL,
+        .seek = dlt_compressed_file_cookie_seek,
+        .close = dlt_compressed_file_cookie_close
+    };
+    DltCompressedFileHeader header;
+    DltCompressedFile *file;
+    FILE *stream;
+    off_t size;
+    uint32_t i;
+
+    if (raw == NULL)
+        return NULL;
+
+    file = calloc(1, sizeof(DltCompressedFile));
+
+    if (file == NULL) {
+        fclose(raw);
+        return NULL;
+    }
+
+    file->raw = raw;
+    file->cached = -1;
+
+    if ((fseeko(raw, 0, SEEK_SET) != 0) ||
+        (fread(&header, sizeof(header), 1, raw) != 1) ||
+        (memcmp(header.magic, DLT_COMPRESSED_FILE_MAGIC, sizeof(header.magic)) != 0) ||
+        (header.version != DLT_COMPRESSED_FILE_VERSION) ||
+        (header.codec != DLT_COMPRESSED_CODEC_ZLIB)) {
+        dlt_log(LOG_WARNING, "Unsupported compressed DLT file\n");
+        dlt_compressed_file_cookie_close(file);
+        return NULL;
+    }
+
+    if ((fseeko(raw, 0, SEEK_END) != 0) || ((size = ftello(raw)) < 0)) {
+        dlt_compressed_file_cookie_close(file);
+        return NULL;
+    }
+
+    if (dlt_compressed_file_read_index(file, (uint64_t)size) < 0) {
+        if (verbose)
+            dlt_log(LOG_INFO, "Compressed DLT file has no index, searching blocks\n");
+
+        if (dlt_compressed_file_scan(file, (uint64_t)size) < 0) {
+            dlt_compressed_file_cookie_close(file);
+            return NULL;
+        }
+    }
+
+    file->positions = malloc(sizeof(uint64_t) * (file->blocks + 1));
+
+    if (file->positions == NULL) {
+        dlt_compressed_file_cookie_close(file);
+        return NULL;
+    }
+
+    file->positions[0] = 0;
+
+    for (i = 0; i < file->blocks; i++)
+        file->positions[i + 1] = file->positions[i] + file->index[i].length;
+
+    if (verbose)
+        dlt_vlog(LOG_DEBUG, "Compressed DLT file with %u blocks, %" PRIu64 " bytes uncompressed\n",
+                 file->blocks, file->positions[file->blocks]);
+
+    stream = fopencookie(file, "rb", functions);
+
+    if (stream == NULL) {
+        dlt_compressed_file_cookie_close(file);
+        return NULL;
+    }
+
+    /* the data is in memory already, and a buffered stream would seek to
+     * aligned positions in the previous block */
+    setvbuf(stream, NULL, _IONBF, 0);
+
+    pthread_mutex_lock(&dlt_compressed_readers_lock);
+    file->stream = stream;
+    file->next = dlt_compressed_readers;
+    dlt_compressed_readers = file;
+    atomic_fetch_add(&dlt_compressed_reader_count, 1);
+    pthread_mutex_unlock(&dlt_compressed_readers_lock);
+
+    return stream;
+}
+
+/* Reader of a stream, NULL for plain DLT files */
+static DltCompressedFile *dlt_compressed_file_get(FILE *stream)
+{
+    DltCompressedFile *file;
+
+    if (atomic_load(&dlt_compressed_reader_count) == 0)
+        return NULL;
+
+    pthread_mutex_lock(&dlt_compressed_readers_lock);
+
+    for (file = dlt_compressed_readers; file != NULL; file = file->next)
+        if (file->stream == stream)
+            break;
+
+    pthread_mutex_unlock(&dlt_compressed_readers_lock);
+
+    return file;
+}
+
+int dlt_compressed_file_skip(DltFile *file,
+                             const DltFilter *filter,
+                             uint64_t time_begin,
+                             uint64_t time_end,
+                             int verbose)
+{
+    DltCompressedFile *compressed;
+    DltCompressedBlockIndex *entry;
+    uint64_t apid[DLT_COMPRESSED_BITMAP_WORDS] = { 0 };
+    uint64_t match;
+    int use_apid = 0;
+    int64_t block;
+    int skipped = 0;
+    int i;
+
+    if (file == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    compressed = dlt_compressed_file_get(file->handle);
+
+    if (compressed == NULL)
+        return 0;
+
+    block = dlt_compressed_file_find(compressed, file->file_position);
+
+    /* only whole blocks are skipped */
+    if ((block < 0) || (compressed->positions[block] != file->file_position))
+        return 0;
+
+    if ((filter != NULL) && (filter->counter > 0)) {
+        use_apid = 1;
+
+        for (i = 0; i < filter->counter; i++) {
+            if (filter->apid[i][0] == 0) {
+                use_apid = 0;
+                break;
+            }
+
+            DLT_COMPRESSED_SET_BIT(apid, filter->apid[i]);
+        }
+    }
+
+    while (block < compressed->blocks) {
+        entry = &(compressed->index[block]);
+
+        if (((time_begin == 0) || (entry->time_max >= time_begin)) &&
+            ((time_end == 0) || (entry->time_min <= time_end))) {
+            if (!use_apid)
+                break;
+
+            match = 0;
+
+            for (i = 0; i < DLT_COMPRESSED_BITMAP_WORDS; i++)
+                match |= entry->apid[i] & apid[i];
+
+            if (match != 0)
+                break;
+        }
+
+        file->counter_total += (int32_t)entry->messages;
+        skipped++;
+        block++;
+    }
+
+    if (skipped > 0) {
+        file->file_position = compressed->positions[block];
+
+        if (verbose)
+            dlt_vlog(LOG_DEBUG, "%s: skipped %d blocks\n", __func__, skipped);
+    }
+
+    return skipped;
+}
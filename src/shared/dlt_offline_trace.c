@@ -239,6 +239,16 @@ DltReturnValue dlt_offline_trace_create_new_file(DltOfflineTrace *trace)
         return DLT_RETURN_ERROR;
     } /* if */
 
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    if (trace->compressed &&
+        (dlt_compressed_writer_init(&(trace->writer), trace->ohandle) < DLT_RETURN_OK)) {
+        printf("Offline trace file %s cannot be written\n", file_path);
+        close(trace->ohandle);
+        trace->ohandle = -1;
+        return DLT_RETURN_ERROR;
+    }
+#endif
+
     return DLT_RETURN_OK; /* OK */
 }
 
@@ -387,6 +397,30 @@ DltReturnValue dlt_offline_trace_init(DltOfflineTrace *trace,
     return dlt_offline_trace_create_new_file(trace);
 }
 
+/* Size of the current log file */
+static off_t dlt_offline_trace_file_size(DltOfflineTrace *trace)
+{
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    if (trace->compressed)
+        return (off_t)dlt_compressed_writer_size(&(trace->writer));
+#endif
+
+    return lseek(trace->ohandle, 0, SEEK_CUR);
+}
+
+/* Close the current log file */
+static void dlt_offline_trace_close_file(DltOfflineTrace *trace)
+{
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    /* write the last block and the index */
+    if (trace->compressed && (dlt_compressed_writer_close(&(trace->writer)) < DLT_RETURN_OK))
+        printf("Offline trace index cannot be written!\n");
+#endif
+
+    close(trace->ohandle);
+    trace->ohandle = -1;
+}
+
 DltReturnValue dlt_offline_trace_write(DltOfflineTrace *trace,
                                        unsigned char *data1,
                                        int size1,
@@ -400,10 +434,9 @@ DltReturnValue dlt_offline_trace_write(DltOfflineTrace *trace,
         return DLT_RETURN_ERROR;
 
     /* check file size here */
-    if ((lseek(trace->ohandle, 0, SEEK_CUR) + size1 + size2 + size3) >= trace->fileSize) {
+    if ((dlt_offline_trace_file_size(trace) + size1 + size2 + size3) >= trace->fileSize) {
         /* close old file */
-        close(trace->ohandle);
-        trace->ohandle = -1;
+        dlt_offline_trace_close_file(trace);
 
         /* check complete offline trace size, remove old logs if needed */
         dlt_offline_trace_check_size(trace);
@@ -412,6 +445,20 @@ DltReturnValue dlt_offline_trace_write(DltOfflineTrace *trace,
         dlt_offline_trace_create_new_file(trace);
     }
 
+#ifdef DLT_COMPRESSED_FILE_ENABLE
+    if (trace->compressed) {
+        if ((trace->ohandle < 0) || (data1 == NULL))
+            return DLT_RETURN_ERROR;
+
+        if (dlt_compressed_writer_add(&(trace->writer), data1, size1, data2, size2, data3, size3) < DLT_RETURN_OK) {
+            printf("Offline trace write failed!\n");
+            return DLT_RETURN_ERROR;
+        }
+
+        return DLT_RETURN_OK;
+    }
+#endif
+
     /* write data into log file */
     if (data1 && (trace->ohandle >= 0)) {
         if (write(trace->ohandle, data1, size1) != size1) {
@@ -444,7 +491,7 @@ DltReturnValue dlt_offline_trace_free(DltOfflineTrace *trace)
         return DLT_RETURN_ERROR;
 
     /* close last used log file */
-    close(trace->ohandle);
+    dlt_offline_trace_close_file(trace);
 
     return DLT_RETURN_OK; /* OK */
 }
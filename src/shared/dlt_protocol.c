@@ -65,7 +65,10 @@ const char *const dlt_user_service_names[] = {
     "DLT_SERVICE_ID_RESERVED",
     "DLT_SERVICE_ID_RESERVED",
     "DLT_SERVICE_ID_RESERVED",
-    "DLT_SERVICE_ID_RESERVED"
+    "DLT_SERVICE_ID_RESERVED",
+    "DLT_SERVICE_ID_GET_RATE_LIMIT_STATUS",
+    "DLT_SERVICE_ID_GET_LATENCY_STATS",
+    "DLT_SERVICE_ID_GET_METRICS"
 };
 
 const char *dlt_get_service_name(unsigned int id)
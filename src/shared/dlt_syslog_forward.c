@@ -0,0 +1,152 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * Copyright (C) 2011-2015, BMW AG
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright Copyright © 2011-2015 BMW AG. \n
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_syslog_forward.c
+ */
+
+/*******************************************************************************
+**                                                                            **
+**  SRC-MODULE: dlt_syslog_forward.c                                          **
+**                                                                            **
+**  TARGET    : linux                                                         **
+**                                                                            **
+**  PROJECT   : DLT                                                           **
+**                                                                            **
+**  PURPOSE   : Forwarding of received syslog messages to DLT, shared by      **
+**              dlt-system and dlt-adaptor-udp                                **
+**                                                                            **
+**  REMARKS   :                                                               **
+**                                                                            **
+**  PLATFORM DEPENDANT [yes/no]: yes                                          **
+**                                                                            **
+**  TO BE CHANGED BY USER [yes/no]: no                                        **
+**                                                                            **
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dlt_syslog_forward.h"
+
+void dlt_syslog_forward_init(DltSyslogForward *forward,
+                             DltContext *context,
+                             const char *description,
+                             DltLogLevelType level)
+{
+    memset(forward, 0, sizeof(DltSyslogForward));
+
+    forward->context = context;
+    forward->description = description;
+    forward->level = level;
+}
+
+DltContext *dlt_syslog_forward_get_context(DltSyslogForward *forward,
+                                           const char *tag,
+                                           uint16_t length)
+{
+    char ctid[DLT_ID_SIZE + 1] = { 0 };
+    char description[64];
+    DltSyslogTagContext *entry = NULL;
+    uint32_t hash = 0;
+    int i;
+
+    memcpy(ctid, tag, (length < DLT_ID_SIZE) ? length : DLT_ID_SIZE);
+
+    if (memcmp(ctid, forward->context->contextID, DLT_ID_SIZE) == 0)
+        return forward->context;
+
+    for (i = 0; i < DLT_ID_SIZE; i++)
+        hash = hash * 31 + (uint8_t)ctid[i];
+
+    for (i = 0; i < DLT_SYSLOG_FORWARD_TABLE_SIZE; i++) {
+        entry = &forward->table[(hash + i) & (DLT_SYSLOG_FORWARD_TABLE_SIZE - 1)];
+
+        if (!entry->used)
+            break;
+
+        if (memcmp(entry->ctid, ctid, DLT_ID_SIZE) == 0)
+            return &entry->context;
+    }
+
+    if ((entry == NULL) || entry->used || (forward->count >= forward->max_contexts))
+        return forward->context;
+
+    snprintf(description, sizeof(description), "%s %.*s", forward->description, (int)length, tag);
+
+    if (dlt_register_context(&entry->context, ctid, description) < DLT_RETURN_OK)
+        return forward->context;
+
+    memcpy(entry->ctid, ctid, DLT_ID_SIZE);
+    entry->used = 1;
+    forward->count++;
+
+    return &entry->context;
+}
+
+void dlt_syslog_forward_log(DltSyslogForward *forward, const char *data, int size)
+{
+    DltSyslogMessage msg;
+    DltContextData log;
+    DltContext *context = forward->context;
+    DltLogLevelType loglevel = forward->level;
+    uint32_t timestamp = 0;
+
+    dlt_syslog_parse(data, size, &msg);
+
+    if (msg.severity >= 0) {
+        if (forward->map_levels)
+            loglevel = dlt_syslog_get_log_level(msg.severity);
+
+        if (forward->use_timestamp)
+            timestamp = dlt_syslog_get_timestamp(&msg);
+
+        if ((forward->max_contexts > 0) && (msg.tag_length > 0))
+            context = dlt_syslog_forward_get_context(forward, msg.tag, msg.tag_length);
+    }
+
+    if (dlt_user_log_write_start(context, &log, loglevel) != DLT_RETURN_TRUE)
+        return;
+
+    if (timestamp != 0) {
+        log.use_timestamp = DLT_USER_TIMESTAMP;
+        log.user_timestamp = timestamp;
+    }
+
+    if (msg.hostname_length > 0)
+        dlt_user_log_write_sized_string(&log, msg.hostname, msg.hostname_length);
+
+    if (msg.tag_length > 0)
+        dlt_user_log_write_sized_string(&log, msg.tag, msg.tag_length);
+
+    dlt_user_log_write_sized_string(&log, msg.text, msg.text_length);
+    dlt_user_log_write_finish(&log);
+}
+
+void dlt_syslog_forward_free(DltSyslogForward *forward)
+{
+    int i;
+
+    for (i = 0; i < DLT_SYSLOG_FORWARD_TABLE_SIZE; i++)
+        if (forward->table[i].used) {
+            dlt_unregister_context(&forward->table[i].context);
+            forward->table[i].used = 0;
+        }
+
+    forward->count = 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * Copyright (C) 2011-2015, BMW AG
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright Copyright © 2011-2015 BMW AG. \n
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt_syslog_forward.h
+ */
+
+/*******************************************************************************
+**                                                                            **
+**  SRC-MODULE: dlt_syslog_forward.h                                          **
+**                                                                            **
+**  TARGET    : linux                                                         **
+**                                                                            **
+**  PROJECT   : DLT                                                           **
+**                                                                            **
+**  PURPOSE   : Forwarding of received syslog messages to DLT, shared by      **
+**              dlt-system and dlt-adaptor-udp                                **
+**                                                                            **
+**  REMARKS   :                                                               **
+**                                                                            **
+**  PLATFORM DEPENDANT [yes/no]: yes                                          **
+**                                                                            **
+**  TO BE CHANGED BY USER [yes/no]: no                                        **
+**                                                                            **
+*******************************************************************************/
+
+#ifndef _DLT_SYSLOG_FORWARD_H_
+#define _DLT_SYSLOG_FORWARD_H_
+
+#include "dlt_common.h"
+#include "dlt_user.h"
+
+/* definitions */
+#define DLT_SYSLOG_FORWARD_TABLE_SIZE   128 /* size of the tag context table, a power of two */
+#define DLT_SYSLOG_FORWARD_MAX_CONTEXTS (DLT_SYSLOG_FORWARD_TABLE_SIZE / 2) /* keeps the table half empty */
+
+/* Context of one syslog tag */
+typedef struct
+{
+    int used;                 /* entry is registered */
+    char ctid[DLT_ID_SIZE];   /* first four characters of the tag */
+    DltContext context;
+} DltSyslogTagContext;
+
+typedef struct
+{
+    DltContext *context;      /* context of messages without own context */
+    const char *description;  /* prefix of the descriptions of tag contexts */
+    int max_contexts;         /* max number of tag contexts, 0 to log all in context */
+    int map_levels;           /* take the log level from the severity */
+    int use_timestamp;        /* take the timestamp from the message */
+    DltLogLevelType level;    /* log level if not taken from the severity */
+    int count;                /* number of registered tag contexts */
+    DltSyslogTagContext table[DLT_SYSLOG_FORWARD_TABLE_SIZE];
+} DltSyslogForward;
+
+/**
+ * dlt_syslog_forward_init
+ *
+ * Initialize the forwarding of syslog messages. All messages are logged
+ * in context with level; set map_levels, use_timestamp and max_contexts
+ * to take level, timestamp and context from the message.
+ *
+ * @param forward     DltSyslogForward
+ * @param context     Registered context of messages without own context
+ * @param description Prefix of the descriptions of tag contexts
+ * @param level       Log level if not taken from the severity
+ */
+void dlt_syslog_forward_init(DltSyslogForward *forward,
+                             DltContext *context,
+                             const char *description,
+                             DltLogLevelType level);
+
+/**
+ * dlt_syslog_forward_get_context
+ *
+ * Get the context of a tag, registered on its first message. Falls back
+ * to the default context once max_contexts contexts are registered.
+ *
+ * @param forward     DltSyslogForward
+ * @param tag         Tag of the message
+ * @param length      Length of the tag
+ * @return            Context to log the message in
+ */
+DltContext *dlt_syslog_forward_get_context(DltSyslogForward *forward,
+                                           const char *tag,
+                                           uint16_t length);
+
+/**
+ * dlt_syslog_forward_log
+ *
+ * Log one received datagram, split into its syslog fields if it has a
+ * priority.
+ *
+ * @param forward     DltSyslogForward
+ * @param data        Received datagram
+ * @param size        Length of data
+ */
+void dlt_syslog_forward_log(DltSyslogForward *forward, const char *data, int size);
+
+/**
+ * dlt_syslog_forward_free
+ *
+ * Unregister all tag contexts.
+ *
+ * @param forward     DltSyslogForward
+ */
+void dlt_syslog_forward_free(DltSyslogForward *forward);
+
+#endif
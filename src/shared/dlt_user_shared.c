@@ -71,6 +71,11 @@
 #include <errno.h>
 
 #include <sys/uio.h> /* writev() */
+#include <sys/mman.h> /* mmap() */
+#include <syslog.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "dlt_user_shared.h"
 #include "dlt_user_shared_cfg.h"
@@ -175,4 +180,211 @@ DltReturnValue dlt_user_log_out3(int handle, void *ptr1, size_t len1, void *ptr2
     }
 
     return DLT_RETURN_OK;
-}
\ No newline at end of file
+}
+/* longest refill interval taken into account, keeps the calculation in range */
+#define DLT_TOKEN_BUCKET_MAX_REFILL_US (1000ULL * 1000000ULL)
+
+void dlt_token_bucket_init(DltTokenBucket *bucket, uint32_t rate, uint32_t burst)
+{
+    if (bucket == NULL)
+        return;
+
+    bucket->rate = rate;
+    bucket->burst = (burst > 0) ? burst : 1;
+    bucket->tokens = (uint64_t)bucket->burst * 1000;
+    bucket->dropped = 0;
+    clock_gettime(CLOCK_MONOTONIC, &(bucket->last));
+}
+
+int dlt_token_bucket_take(DltTokenBucket *bucket)
+{
+    struct timespec now;
+    uint64_t elapsed_us;
+    uint64_t added;
+    uint64_t max_tokens;
+
+    if ((bucket == NULL) || (bucket->rate == 0))
+        return 1;
+
+    max_tokens = (uint64_t)bucket->burst * 1000;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if ((now.tv_sec > bucket->last.tv_sec) ||
+        ((now.tv_sec == bucket->last.tv_sec) && (now.tv_nsec > bucket->last.tv_nsec))) {
+        elapsed_us = (uint64_t)(now.tv_sec - bucket->last.tv_sec) * 1000000ULL;
+        elapsed_us += (uint64_t)(now.tv_nsec / 1000);
+        elapsed_us -= (uint64_t)(bucket->last.tv_nsec / 1000);
+
+        if (elapsed_us > DLT_TOKEN_BUCKET_MAX_REFILL_US)
+            elapsed_us = DLT_TOKEN_BUCKET_MAX_REFILL_US;
+
+        /* rate per second in 1/1000 tokens per microsecond */
+        added = elapsed_us * bucket->rate / 1000;
+
+        /* keep the time if too little passed to get anything */
+        if (added > 0) {
+            bucket->tokens += added;
+
+            if (bucket->tokens > max_tokens)
+                bucket->tokens = max_tokens;
+
+            bucket->last = now;
+        }
+    }
+
+    if (bucket->tokens < 1000) {
+        bucket->dropped++;
+        return 0;
+    }
+
+    bucket->tokens -= 1000;
+
+    return 1;
+}
+
+DltReturnValue dlt_user_startup_shm_path(char *path, size_t len, pid_t pid)
+{
+    int n;
+
+    if ((path == NULL) || (len == 0))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    n = snprintf(path, len, "%s/%s%d",
+                 DLT_USER_STARTUP_SHM_DIR, DLT_USER_STARTUP_SHM_PREFIX, (int)pid);
+
+    if ((n < 0) || ((size_t)n >= len))
+        return DLT_RETURN_ERROR;
+
+    return DLT_RETURN_OK;
+}
+
+DltReturnValue dlt_user_startup_shm_create(DltUserStartupShm *shm, pid_t pid, uint32_t size)
+{
+    char path[DLT_PATH_MAX];
+    size_t length;
+    void *addr;
+    int fd;
+
+    if ((shm == NULL) || (size <= sizeof(DltBufferHead)))
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    memset(shm, 0, sizeof(DltUserStartupShm));
+
+    if (dlt_user_startup_shm_path(path, sizeof(path), pid) < DLT_RETURN_OK)
+        return DLT_RETURN_ERROR;
+
+    length = sizeof(DltUserStartupShmHead) + size;
+
+    fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, DLT_USER_STARTUP_SHM_PERMISSION);
+
+    if (fd < 0) {
+        dlt_vlog(LOG_WARNING, "%s: cannot open %s: %s\n", __func__, path, strerror(errno));
+        return DLT_RETURN_ERROR;
+    }
+
+    /* permissions shall not depend on the umask of the application */
+    if ((fchmod(fd, DLT_USER_STARTUP_SHM_PERMISSION) < 0) ||
+        (ftruncate(fd, (off_t)length) < 0)) {
+        dlt_vlog(LOG_WARNING, "%s: cannot prepare %s: %s\n", __func__, path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return DLT_RETURN_ERROR;
+    }
+
+    addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        dlt_vlog(LOG_WARNING, "%s: cannot map %s: %s\n", __func__, path, strerror(errno));
+        unlink(path);
+        return DLT_RETURN_ERROR;
+    }
+
+    shm->head = (DltUserStartupShmHead *)addr;
+    shm->length = length;
+
+    memcpy(shm->head->pattern, DLT_USER_STARTUP_SHM_PATTERN, DLT_ID_SIZE);
+    shm->head->pid = (int32_t)pid;
+    memset(shm->head->apid, 0, DLT_ID_SIZE);
+    shm->head->size = size;
+    shm->head->state = DLT_USER_STARTUP_SHM_STATE_ACTIVE;
+
+    return dlt_buffer_init_static_server(&(shm->buffer),
+                                         (unsigned char *)addr + sizeof(DltUserStartupShmHead),
+                                         size);
+}
+
+DltReturnValue dlt_user_startup_shm_open(DltUserStartupShm *shm, pid_t pid)
+{
+    char path[DLT_PATH_MAX];
+    struct stat st;
+    DltBufferHead *head;
+    void *addr;
+    int fd;
+
+    if (shm == NULL)
+        return DLT_RETURN_WRONG_PARAMETER;
+
+    memset(shm, 0, sizeof(DltUserStartupShm));
+
+    if (dlt_user_startup_shm_path(path, sizeof(path), pid) < DLT_RETURN_OK)
+        return DLT_RETURN_ERROR;
+
+    fd = open(path, O_RDWR | O_CLOEXEC);
+
+    if (fd < 0)
+        return DLT_RETURN_ERROR;
+
+    if ((fstat(fd, &st) < 0) ||
+        ((size_t)st.st_size < sizeof(DltUserStartupShmHead) + sizeof(DltBufferHead))) {
+        close(fd);
+        return DLT_RETURN_ERROR;
+    }
+
+    addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) {
+        dlt_vlog(LOG_WARNING, "%s: cannot map %s: %s\n", __func__, path, strerror(errno));
+        return DLT_RETURN_ERROR;
+    }
+
+    shm->head = (DltUserStartupShmHead *)addr;
+    shm->length = (size_t)st.st_size;
+
+    /* the content is written by the application, do not trust it */
+    if ((memcmp(shm->head->pattern, DLT_USER_STARTUP_SHM_PATTERN, DLT_ID_SIZE) != 0) ||
+        (shm->head->pid != (int32_t)pid) ||
+        (shm->head->size <= sizeof(DltBufferHead)) ||
+        (shm->head->size > shm->length - sizeof(DltUserStartupShmHead))) {
+        dlt_vlog(LOG_WARNING, "%s: %s is not a valid startup ring\n", __func__, path);
+        dlt_user_startup_shm_close(shm);
+        return DLT_RETURN_ERROR;
+    }
+
+    dlt_buffer_init_static_client(&(shm->buffer),
+                                  (unsigned char *)addr + sizeof(DltUserStartupShmHead),
+                                  shm->head->size);
+
+    head = (DltBufferHead *)shm->buffer.shm;
+
+    if ((head->read < 0) || (head->write < 0) || (head->count < 0) ||
+        ((unsigned int)head->read >= shm->buffer.size) ||
+        ((unsigned int)head->write >= shm->buffer.size)) {
+        dlt_vlog(LOG_WARNING, "%s: %s has inconsistent positions\n", __func__, path);
+        dlt_user_startup_shm_close(shm);
+        return DLT_RETURN_ERROR;
+    }
+
+    return DLT_RETURN_OK;
+}
+
+void dlt_user_startup_shm_close(DltUserStartupShm *shm)
+{
+    if ((shm == NULL) || (shm->head == NULL))
+        return;
+
+    munmap(shm->head, shm->length);
+    memset(shm, 0, sizeof(DltUserStartupShm));
+}
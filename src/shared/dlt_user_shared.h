@@ -69,9 +69,11 @@
 #define DLT_USER_SHARED_H
 
 #include "dlt_types.h"
+#include "dlt_common.h"
 #include "dlt_user.h"
 
 #include <sys/types.h>
+#include <time.h>
 
 /**
  * This is the header of each message to be exchanged between application and daemon.
@@ -181,6 +183,73 @@ typedef struct
     char apid[4];                        /**< application which lost messages */
 } DLT_PACKED DltUserControlMsgBufferOverflow;
 
+/**
+ * This is the internal message content to set the rate limit of a context.
+ */
+typedef struct
+{
+    int32_t log_level_pos;          /**< offset in user-application context field */
+    uint32_t rate;                  /**< messages per second, 0 = unlimited */
+    uint32_t burst;                 /**< maximum number of messages at once */
+} DLT_PACKED DltUserControlMsgRateLimit;
+
+/**
+ * This is the internal message content to report the messages of a context
+ * dropped by its rate limit in the application.
+ */
+typedef struct
+{
+    char apid[DLT_ID_SIZE];         /**< application id */
+    char ctid[DLT_ID_SIZE];         /**< context id */
+    uint32_t dropped;               /**< messages dropped since the last report */
+} DLT_PACKED DltUserControlMsgRateLimitDropped;
+
+/**
+ * This is the internal message content of a log message with latency trace.
+ * The log message follows like for DLT_USER_MESSAGE_LOG.
+ */
+typedef struct
+{
+    uint64_t timestamp;             /**< CLOCK_MONOTONIC time the message was finished in ns */
+} DLT_PACKED DltUserControlMsgLogTrace;
+
+/**
+ * This is a token bucket to limit the rate of messages.
+ * Each message takes one token, tokens are refilled with rate per second
+ * up to burst.
+ */
+typedef struct DltTokenBucket
+{
+    uint32_t rate;                  /**< tokens per second, 0 = unlimited */
+    uint32_t burst;                 /**< maximum number of tokens */
+    uint64_t tokens;                /**< available tokens in 1/1000 */
+    struct timespec last;           /**< time of last refill */
+    uint32_t dropped;               /**< number of messages without token */
+} DltTokenBucket;
+
+/**
+ * This is the head of a startup ring in shared memory.
+ * The ring (DltBufferHead and data) follows directly behind the head.
+ */
+typedef struct
+{
+    char pattern[DLT_ID_SIZE];  /**< DLT_USER_STARTUP_SHM_PATTERN */
+    int32_t pid;                /**< process id of the application owning the ring */
+    char apid[DLT_ID_SIZE];     /**< application id, empty until the application is registered */
+    uint32_t size;              /**< size of the ring behind this head */
+    volatile int32_t state;     /**< one of DLT_USER_STARTUP_SHM_STATE_* */
+} DltUserStartupShmHead;
+
+/**
+ * This is a mapped startup ring.
+ */
+typedef struct
+{
+    DltUserStartupShmHead *head; /**< head of the mapping, NULL if not mapped */
+    size_t length;               /**< length of the mapping */
+    DltBuffer buffer;            /**< ring inside the mapping */
+} DltUserStartupShm;
+
 /**************************************************************************************************
 * The folowing functions are used shared between the user lib and the daemon implementation
 **************************************************************************************************/
@@ -224,4 +293,54 @@ DltReturnValue dlt_user_log_out2(int handle, void *ptr1, size_t len1, void *ptr2
  */
 DltReturnValue dlt_user_log_out3(int handle, void *ptr1, size_t len1, void *ptr2, size_t len2, void *ptr3, size_t len3);
 
+/**
+ * Initialise a token bucket, the bucket starts full
+ * @param bucket pointer to the token bucket
+ * @param rate tokens per second, 0 = unlimited
+ * @param burst maximum number of tokens, at least one token is used
+ */
+void dlt_token_bucket_init(DltTokenBucket *bucket, uint32_t rate, uint32_t burst);
+
+/**
+ * Take a token from the bucket. If no token is available, the dropped
+ * counter of the bucket is incremented.
+ * @param bucket pointer to the token bucket
+ * @return 1 if a token was available, 0 otherwise
+ */
+int dlt_token_bucket_take(DltTokenBucket *bucket);
+
+/**
+ * Get the path of the startup ring of an application
+ * @param path buffer to store the path
+ * @param len size of the buffer
+ * @param pid process id of the application
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_user_startup_shm_path(char *path, size_t len, pid_t pid);
+
+/**
+ * Create the startup ring of an application in shared memory.
+ * An already existing ring of the same pid is overwritten.
+ * @param shm pointer to the startup ring structure to be initialised
+ * @param pid process id of the application
+ * @param size size of the ring in bytes
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_user_startup_shm_create(DltUserStartupShm *shm, pid_t pid, uint32_t size);
+
+/**
+ * Map the existing startup ring of an application.
+ * The head and the read/write positions of the ring are checked.
+ * @param shm pointer to the startup ring structure to be initialised
+ * @param pid process id of the application
+ * @return Value from DltReturnValue enum
+ */
+DltReturnValue dlt_user_startup_shm_open(DltUserStartupShm *shm, pid_t pid);
+
+/**
+ * Unmap a startup ring. The file in shared memory is not removed.
+ * @param shm pointer to the startup ring structure
+ */
+void dlt_user_startup_shm_close(DltUserStartupShm *shm);
+
 #endif /* DLT_USER_SHARED_H */
@@ -72,6 +72,14 @@
 /* Changable */
 /*************/
 
+/* Directory and file name prefix of the startup rings in shared memory.
+ * The pid of the application is appended to the prefix. */
+#define DLT_USER_STARTUP_SHM_DIR    "/dev/shm"
+#define DLT_USER_STARTUP_SHM_PREFIX "dlt-startup-"
+
+/* Permissions of a startup ring, the daemon has to be able to update it */
+#define DLT_USER_STARTUP_SHM_PERMISSION (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP)
+
 /************************/
 /* Don't change please! */
 /************************/
@@ -90,10 +98,21 @@
 #define DLT_USER_MESSAGE_LOG_MODE 11
 #define DLT_USER_MESSAGE_LOG_STATE 12
 #define DLT_USER_MESSAGE_MARKER 13
-#define DLT_USER_MESSAGE_NOT_SUPPORTED 16
+#define DLT_USER_MESSAGE_RATE_LIMIT 14
+#define DLT_USER_MESSAGE_LOG_TRACE 15
+#define DLT_USER_MESSAGE_RATE_LIMIT_DROPPED 16
+#define DLT_USER_MESSAGE_NOT_SUPPORTED 17
 
 /* Internal defined values */
 
+/* Pattern at the beginning of each startup ring */
+#define DLT_USER_STARTUP_SHM_PATTERN "DSR\1"
+
+/* States of a startup ring */
+#define DLT_USER_STARTUP_SHM_STATE_ACTIVE   1 /* application writes into the ring */
+#define DLT_USER_STARTUP_SHM_STATE_HANDOVER 2 /* application registered, daemon shall drain the ring */
+#define DLT_USER_STARTUP_SHM_STATE_DRAINED  3 /* daemon has forwarded the content of the ring */
+
 /* must be different from DltLogLevelType */
 #define DLT_USER_LOG_LEVEL_NOT_SET    -2
 /* must be different from DltTraceStatusType */
@@ -48,7 +48,10 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <errno.h>
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "dlt-system.h"
 
@@ -63,12 +66,44 @@
 #define DLT_SYSTEM_JOURNAL_ASCII_FIRST_VISIBLE_CHARACTER 31
 #define DLT_SYSTEM_JOURNAL_BOOT_ID_MAX_LENGTH 9 + 32 + 1
 
+/* Free space in percent of the user buffer to wait for when it is nearly full */
+#define DLT_SYSTEM_JOURNAL_FREE_PERCENT 50
+/* Maximum time to wait for free space in the user buffer in ms */
+#define DLT_SYSTEM_JOURNAL_WAIT_TIMEOUT 500
+/* Size of an entry in a batch without the strings: type info and value of
+ * the realtime, monotonic time, priority and pid, type info and length of
+ * the process name and message */
+#define DLT_SYSTEM_JOURNAL_ENTRY_SIZE (4 + 8 + 4 + 8 + 4 + 1 + 4 + 4 + 2 * (4 + 2 + 1))
+
 typedef struct
 {
     char real[DLT_SYSTEM_JOURNAL_BUFFER_SIZE];
     char monotonic[DLT_SYSTEM_JOURNAL_BUFFER_SIZE];
 } MessageTimestamp;
 
+/* Fields of a journal entry, read in one pass over its data */
+typedef struct
+{
+    uint64_t realtime;
+    uint64_t monotonic;
+    int priority;
+    uint32_t pid;
+    int kernel;
+    char comm[DLT_SYSTEM_JOURNAL_BUFFER_SIZE];
+    size_t comm_length;
+    char message[DLT_SYSTEM_JOURNAL_BUFFER_SIZE_BIG];
+    size_t message_length;
+} JournalEntry;
+
+/* Verbose message packing several journal entries of the same log level */
+typedef struct
+{
+    DltContextData log;
+    int active;
+    int loglevel;
+    int count;
+} JournalBatch;
+
 DLT_IMPORT_CONTEXT(dltsystem)
 DLT_DECLARE_CONTEXT(journalContext)
 
@@ -84,137 +119,330 @@ int journal_checkUserBufferForFreeSpace()
     return 1;
 }
 
-int dlt_system_journal_get(sd_journal *j, char *target, const char *field, size_t max_size)
+/* Wait until the daemon has taken messages from the nearly full user buffer */
+static void dlt_system_journal_wait_for_buffer(void)
 {
-    char *data;
-    size_t length;
-    int error_code;
-    size_t field_size;
+    if (journal_checkUserBufferForFreeSpace() == -1)
+        dlt_user_wait_for_buffer(DLT_SYSTEM_JOURNAL_FREE_PERCENT, DLT_SYSTEM_JOURNAL_WAIT_TIMEOUT);
+}
 
-    /* pre check parameters */
-    if ((max_size < 1) || (target == 0) || (field == 0) || (j == 0))
-        return -1;
+/* Copy a field value, which is not terminated, truncated to max_size */
+static size_t dlt_system_journal_copy(char *target, size_t max_size, const char *value, size_t length)
+{
+    if (length >= max_size)
+        length = max_size - 1;
 
-    /* intialise empty target */
-    target[0] = 0;
+    memcpy(target, value, length);
+    target[length] = 0;
 
-    /* get data from journal */
-    error_code = sd_journal_get_data(j, field, (const void **)&data, &length);
+    return length;
+}
 
-    /* check if an error */
-    if (error_code)
-        return error_code;
+/* Parse a decimal field value */
+static uint64_t dlt_system_journal_number(const char *value, size_t length)
+{
+    char number[32];
 
-    /* calculate field size */
-    field_size = strlen(field) + 1;
+    dlt_system_journal_copy(number, sizeof(number), value, length);
 
-    /*check length */
-    if (length < field_size)
-        return -1;
+    return strtoull(number, NULL, 10);
+}
 
-    /* copy string */
-    if (max_size <= (length - field_size)) {
-        /* truncate */
-        strncpy(target, data + field_size, max_size - 1);
-        target[max_size - 1] = 0;
+/* Read the fields of the current entry, enumerating its data only once */
+static void dlt_system_journal_read_entry(sd_journal *j, JournalEntry *entry)
+{
+    const void *data;
+    const char *field;
+    const char *value;
+    size_t length, name_length, value_length;
+    int ret;
+
+    entry->realtime = 0;
+    entry->monotonic = 0;
+    entry->priority = -1;
+    entry->pid = 0;
+    entry->kernel = 0;
+    entry->comm[0] = 0;
+    entry->comm_length = 0;
+    entry->message[0] = 0;
+    entry->message_length = 0;
+
+    sd_journal_restart_data(j);
+
+    while (sd_journal_enumerate_data(j, &data, &length) > 0) {
+        field = (const char *)data;
+        value = memchr(field, '=', length);
+
+        if (value == NULL)
+            continue;
+
+        name_length = (size_t)(value - field);
+        value++;
+        value_length = length - name_length - 1;
+
+#define DLT_SYSTEM_JOURNAL_IS_FIELD(name) \
+    ((name_length == sizeof(name) - 1) && (memcmp(field, name, sizeof(name) - 1) == 0))
+
+        if (DLT_SYSTEM_JOURNAL_IS_FIELD("MESSAGE"))
+            entry->message_length = dlt_system_journal_copy(entry->message, sizeof(entry->message),
+                                                            value, value_length);
+        else if (DLT_SYSTEM_JOURNAL_IS_FIELD("_COMM"))
+            entry->comm_length = dlt_system_journal_copy(entry->comm, sizeof(entry->comm),
+                                                         value, value_length);
+        else if (DLT_SYSTEM_JOURNAL_IS_FIELD("_PID"))
+            entry->pid = (uint32_t)dlt_system_journal_number(value, value_length);
+        else if (DLT_SYSTEM_JOURNAL_IS_FIELD("PRIORITY"))
+            entry->priority = (int)dlt_system_journal_number(value, value_length);
+        else if (DLT_SYSTEM_JOURNAL_IS_FIELD("_TRANSPORT"))
+            entry->kernel = (value_length == 6) && (memcmp(value, "kernel", 6) == 0);
+        else if (DLT_SYSTEM_JOURNAL_IS_FIELD("_SOURCE_REALTIME_TIMESTAMP"))
+            entry->realtime = dlt_system_journal_number(value, value_length);
+        else if (DLT_SYSTEM_JOURNAL_IS_FIELD("_SOURCE_MONOTONIC_TIMESTAMP"))
+            entry->monotonic = dlt_system_journal_number(value, value_length);
+
+#undef DLT_SYSTEM_JOURNAL_IS_FIELD
     }
-    else {
-        /* full copy */
-        strncpy(target, data + field_size, length - field_size);
-        target[length - field_size] = 0;
 
+    /* Take the time of the journal entry if the message source has none */
+    if ((entry->realtime == 0) && ((ret = sd_journal_get_realtime_usec(j, &entry->realtime)) < 0)) {
+        DLT_LOG(dltsystem, DLT_LOG_WARN,
+                DLT_STRING("dlt-system-journal failed to get realtime: "),
+                DLT_STRING(strerror(-ret)));
+
+        /* just to be sure to have a defined value */
+        entry->realtime = 0;
     }
 
-    /* debug messages */
-    /*printf("%s = %s\n",field,target); */
+    if ((entry->monotonic == 0) && ((ret = sd_journal_get_monotonic_usec(j, &entry->monotonic, NULL)) < 0)) {
+        DLT_LOG(dltsystem, DLT_LOG_WARN,
+                DLT_STRING("dlt-system-journal failed to get monotonic time: "),
+                DLT_STRING(strerror(-ret)));
 
-    /* Success */
-    return 0;
+        /* just to be sure to have a defined value */
+        entry->monotonic = 0;
+    }
 }
 
-void dlt_system_journal_get_timestamp(sd_journal *journal, MessageTimestamp *timestamp)
+void dlt_system_journal_get_timestamp(JournalEntry *entry, MessageTimestamp *timestamp)
 {
-    int ret = 0;
     time_t time_secs = 0;
-    uint64_t time_usecs = 0;
     struct tm timeinfo;
+    char buffer_realtime_formatted[DLT_SYSTEM_JOURNAL_BUFFER_SIZE];
+
+    time_secs = (time_t)(entry->realtime / 1000000);
+    tzset();
+    localtime_r(&time_secs, &timeinfo);
+    strftime(buffer_realtime_formatted, sizeof(buffer_realtime_formatted), "%Y/%m/%d %H:%M:%S", &timeinfo);
+
+    snprintf(timestamp->real, sizeof(timestamp->real), "%s.%06" PRIu64, buffer_realtime_formatted,
+             entry->realtime % 1000000);
+
+    snprintf(timestamp->monotonic,
+             sizeof(timestamp->monotonic),
+             "%" PRId64 ".%06" PRIu64,
+             entry->monotonic / 1000000,
+             entry->monotonic % 1000000);
+}
+
+/* Map the priority of a journal entry to a DLT log level */
+static int dlt_system_journal_loglevel(int systemd_loglevel, DltSystemConfiguration *config)
+{
+    if (!config->Journal.MapLogLevels)
+        return DLT_LOG_INFO;
 
-    char buffer_realtime[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 };
-    char buffer_realtime_formatted[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 };
-    char buffer_monotime[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 };
+    /* journal priorities are syslog severities */
+    return dlt_syslog_get_log_level(systemd_loglevel);
+}
 
-    /* Try to get realtime from message source and if not successful try to get realtime from journal entry */
-    ret = dlt_system_journal_get(journal, buffer_realtime, "_SOURCE_REALTIME_TIMESTAMP", sizeof(buffer_realtime));
+/* Log one journal entry as verbose message */
+static void dlt_system_journal_log_entry(JournalEntry *entry, int loglevel, DltSystemConfiguration *config)
+{
+    static const char *const systemd_log_levels[] =
+    { "Emergency", "Alert", "Critical", "Error", "Warning", "Notice", "Informational", "Debug" };
+    char buffer_process[DLT_SYSTEM_JOURNAL_BUFFER_SIZE];
+    char buffer_priority[DLT_SYSTEM_JOURNAL_BUFFER_SIZE];
+    MessageTimestamp timestamp;
+    uint32_t ts;
 
-    if ((ret == 0) && (strlen(buffer_realtime) > 0)) {
-        errno = 0;
-        time_usecs = strtoull(buffer_realtime, NULL, 10);
+    dlt_system_journal_get_timestamp(entry, &timestamp);
+
+    /* prepare process string */
+    if (entry->kernel)
+        snprintf(buffer_process, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "kernel:");
+    else if (entry->pid > 0)
+        snprintf(buffer_process, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "%s[%u]:", entry->comm, entry->pid);
+    else
+        snprintf(buffer_process, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "%s[]:", entry->comm);
+
+    if ((entry->priority >= 0) && (entry->priority <= 7))
+        snprintf(buffer_priority, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "%s:", systemd_log_levels[entry->priority]);
+    else
+        snprintf(buffer_priority, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "prio_unknown:");
+
+    /* write log entry */
+    if (config->Journal.UseOriginalTimestamp == 0) {
+        DLT_LOG(journalContext, loglevel,
+                DLT_STRING(timestamp.real),
+                DLT_STRING(timestamp.monotonic),
+                DLT_STRING(buffer_process),
+                DLT_STRING(buffer_priority),
+                DLT_SIZED_STRING(entry->message, (uint16_t)entry->message_length)
+                );
 
-        if (errno != 0)
-            time_usecs = 0;
     }
-    else if ((ret = sd_journal_get_realtime_usec(journal, &time_usecs)) < 0)
-    {
-        DLT_LOG(dltsystem, DLT_LOG_WARN,
-                DLT_STRING("dlt-system-journal failed to get realtime: "),
-                DLT_STRING(strerror(-ret)));
+    else {
+        /* since we are talking about points in time, I'd prefer truncating over arithmetic rounding */
+        ts = (uint32_t)(entry->monotonic / 100);
+        DLT_LOG_TS(journalContext, loglevel, ts,
+                    DLT_STRING(timestamp.real),
+                    DLT_STRING(buffer_process),
+                    DLT_STRING(buffer_priority),
+                    DLT_SIZED_STRING(entry->message, (uint16_t)entry->message_length)
+                    );
+    }
+}
 
-        /* just to be sure to have a defined value */
-        time_usecs = 0;
+/* Send the message packing the entries */
+static void dlt_system_journal_batch_flush(JournalBatch *batch)
+{
+    if (!batch->active)
+        return;
+
+    (void)dlt_user_log_write_finish(&(batch->log));
+    batch->active = 0;
+
+    dlt_system_journal_wait_for_buffer();
+}
+
+/* Add an entry to the message packing the entries */
+static void dlt_system_journal_batch_add(JournalBatch *batch, JournalEntry *entry, int loglevel,
+                                         DltSystemConfiguration *config)
+{
+    size_t size;
+
+    /* an entry always fits into an empty message */
+    if (DLT_SYSTEM_JOURNAL_ENTRY_SIZE + entry->comm_length + entry->message_length > DLT_USER_BUF_MAX_SIZE)
+        entry->message_length = DLT_USER_BUF_MAX_SIZE - DLT_SYSTEM_JOURNAL_ENTRY_SIZE - entry->comm_length;
+
+    size = DLT_SYSTEM_JOURNAL_ENTRY_SIZE + entry->comm_length + entry->message_length;
+
+    if (batch->active && ((batch->loglevel != loglevel) || (batch->log.size + size > DLT_USER_BUF_MAX_SIZE)))
+        dlt_system_journal_batch_flush(batch);
+
+    if (!batch->active) {
+        /* nothing to do if the log level is disabled */
+        if (dlt_user_log_write_start(&journalContext, &(batch->log), loglevel) != DLT_RETURN_TRUE)
+            return;
+
+        if (config->Journal.UseOriginalTimestamp) {
+            batch->log.use_timestamp = DLT_USER_TIMESTAMP;
+            batch->log.user_timestamp = (uint32_t)(entry->monotonic / 100);
+        }
+
+        batch->active = 1;
+        batch->loglevel = loglevel;
+        batch->count = 0;
     }
 
-    time_secs = (time_t)(time_usecs / 1000000);
-    tzset();
-    localtime_r(&time_secs, &timeinfo);
-    strftime(buffer_realtime_formatted, sizeof(buffer_realtime_formatted), "%Y/%m/%d %H:%M:%S", &timeinfo);
+    dlt_user_log_write_uint64(&(batch->log), entry->realtime);
+    dlt_user_log_write_uint64(&(batch->log), entry->monotonic);
+    dlt_user_log_write_uint8(&(batch->log), (uint8_t)entry->priority);
+    dlt_user_log_write_uint32(&(batch->log), entry->pid);
+    dlt_user_log_write_sized_string(&(batch->log), entry->kernel ? "kernel" : entry->comm,
+                                    entry->kernel ? 6 : (uint16_t)entry->comm_length);
+    dlt_user_log_write_sized_string(&(batch->log), entry->message, (uint16_t)entry->message_length);
+    batch->count++;
+}
 
-    snprintf(timestamp->real, sizeof(timestamp->real), "%s.%06" PRIu64, buffer_realtime_formatted,
-             time_usecs % 1000000);
+/* Store the cursor of the current entry, which is logged */
+static void dlt_system_journal_save_cursor(sd_journal *j, DltSystemConfiguration *config)
+{
+    char tmp_file[PATH_MAX];
+    char *cursor = NULL;
+    FILE *file;
+    int r;
+
+    if (config->Journal.CursorFile == NULL)
+        return;
 
-    /* Try to get monotonic time from message source and if not successful try to get monotonic time from journal entry */
-    ret = dlt_system_journal_get(journal, buffer_monotime, "_SOURCE_MONOTONIC_TIMESTAMP", sizeof(buffer_monotime));
+    r = sd_journal_get_cursor(j, &cursor);
 
-    if ((ret == 0) && (strlen(buffer_monotime) > 0)) {
-        errno = 0;
-        time_usecs = strtoull(buffer_monotime, NULL, 10);
+    if (r < 0)
+        return;
 
-        if (errno != 0)
-            time_usecs = 0;
+    /* replace the file at once, a crash leaves the old or the new cursor */
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", config->Journal.CursorFile);
+    file = fopen(tmp_file, "w");
+
+    if (file != NULL) {
+        r = fputs(cursor, file);
+
+        if ((fclose(file) == 0) && (r >= 0))
+            r = rename(tmp_file, config->Journal.CursorFile);
+        else
+            r = -1;
+
+        if (r < 0)
+            unlink(tmp_file);
     }
-    else if ((ret = sd_journal_get_monotonic_usec(journal, &time_usecs, NULL)) < 0)
-    {
+
+    if ((file == NULL) || (r < 0))
         DLT_LOG(dltsystem, DLT_LOG_WARN,
-                DLT_STRING("dlt-system-journal failed to get monotonic time: "),
-                DLT_STRING(strerror(-ret)));
+                DLT_STRING("dlt-system-journal failed to store cursor in"),
+                DLT_STRING(config->Journal.CursorFile));
 
-        /* just to be sure to have a defined value */
-        time_usecs = 0;
-    }
+    free(cursor);
+}
 
-    snprintf(timestamp->monotonic,
-             sizeof(timestamp->monotonic),
-             "%" PRId64 ".%06" PRIu64,
-             time_usecs / 1000000,
-             time_usecs % 1000000);
+/* Continue after the entry of the stored cursor, returns 1 on success */
+static int dlt_system_journal_restore_cursor(sd_journal *j, DltSystemConfiguration *config)
+{
+    char cursor[DLT_SYSTEM_JOURNAL_BUFFER_SIZE_BIG];
+    FILE *file;
+    size_t length;
+    int r;
+
+    if ((config->Journal.CursorFile == NULL) || (j == NULL))
+        return 0;
+
+    file = fopen(config->Journal.CursorFile, "r");
+
+    if (file == NULL)
+        return 0;
+
+    length = fread(cursor, 1, sizeof(cursor) - 1, file);
+    fclose(file);
+    cursor[length] = 0;
+
+    while ((length > 0) && ((cursor[length - 1] == '\n') || (cursor[length - 1] == ' ')))
+        cursor[--length] = 0;
+
+    if ((length == 0) || (sd_journal_seek_cursor(j, cursor) < 0))
+        return 0;
+
+    /* The entry of the cursor was logged, it is skipped by the next call of
+     * sd_journal_next(). If it was vacuumed, the journal is positioned before
+     * the next entry instead, so nothing is logged twice or lost. */
+    r = sd_journal_next(j);
+
+    if ((r > 0) && (sd_journal_test_cursor(j, cursor) <= 0))
+        sd_journal_previous(j);
+
+    DLT_LOG(dltsystem, DLT_LOG_INFO,
+            DLT_STRING("dlt-system-journal resumes after cursor of"),
+            DLT_STRING(config->Journal.CursorFile));
+
+    return 1;
 }
 
 void get_journal_msg(sd_journal *j, DltSystemConfiguration *config) 
 {   
-    uint32_t ts;
+    static JournalEntry entry;
+    JournalBatch batch;
     int r;
+    int loglevel;
 
-    char buffer_process[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 },
-         buffer_priority[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 },
-         buffer_pid[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 },
-         buffer_comm[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 },
-         buffer_message[DLT_SYSTEM_JOURNAL_BUFFER_SIZE_BIG] = { 0 },
-         buffer_transport[DLT_SYSTEM_JOURNAL_BUFFER_SIZE] = { 0 };
-
-    MessageTimestamp timestamp;
-
-    int loglevel, systemd_loglevel;
-    char *systemd_log_levels[] =
-    { "Emergency", "Alert", "Critical", "Error", "Warning", "Notice", "Informational", "Debug" };
+    batch.active = 0;
 
     for(;;)
     {
@@ -222,94 +450,39 @@ void get_journal_msg(sd_journal *j, DltSystemConfiguration *config)
         if (r < 0) {
             DLT_LOG(dltsystem, DLT_LOG_ERROR,
                     DLT_STRING("dlt-system-journal failed to get next entry:"), DLT_STRING(strerror(-r)));
+            dlt_system_journal_batch_flush(&batch);
             sd_journal_close(j);
             return;
         }
         else if (r == 0) {
+            /* the journal stays at the last entry, which is logged now */
+            dlt_system_journal_batch_flush(&batch);
+            dlt_system_journal_save_cursor(j, config);
             return;
         }
 
         /* get all data from current journal entry */
-        dlt_system_journal_get_timestamp(j, &timestamp);
-
-        /* get data from journal entry, empty string if invalid fields */
-        dlt_system_journal_get(j, buffer_comm, "_COMM", sizeof(buffer_comm));
-        dlt_system_journal_get(j, buffer_pid, "_PID", sizeof(buffer_pid));
-        dlt_system_journal_get(j, buffer_priority, "PRIORITY", sizeof(buffer_priority));
-        dlt_system_journal_get(j, buffer_message, "MESSAGE", sizeof(buffer_message));
-        dlt_system_journal_get(j, buffer_transport, "_TRANSPORT", sizeof(buffer_transport));
-
-        /* prepare process string */
-        if (strcmp(buffer_transport, "kernel") == 0)
-            snprintf(buffer_process, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "kernel:");
-        else
-            snprintf(buffer_process, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "%s[%s]:", buffer_comm, buffer_pid);
+        dlt_system_journal_read_entry(j, &entry);
 
         /* map log level on demand */
-        loglevel = DLT_LOG_INFO;
-        systemd_loglevel = atoi(buffer_priority);
-
-        if (config->Journal.MapLogLevels) {
-            /* Map log levels from journal to DLT */
-            switch (systemd_loglevel) {
-            case 0:     /* Emergency */
-            case 1:     /* Alert */
-            case 2:     /* Critical */
-                loglevel = DLT_LOG_FATAL;
-                break;
-            case 3:     /* Error */
-                loglevel = DLT_LOG_ERROR;
-                break;
-            case 4:     /* Warning */
-                loglevel = DLT_LOG_WARN;
-                break;
-            case 5:     /* Notice */
-            case 6:     /* Informational */
-                loglevel = DLT_LOG_INFO;
-                break;
-            case 7:     /* Debug */
-                loglevel = DLT_LOG_DEBUG;
-                break;
-            default:
-                loglevel = DLT_LOG_INFO;
-                break;
-            }
-        }
+        loglevel = dlt_system_journal_loglevel(entry.priority, config);
 
-        if ((systemd_loglevel >= 0) && (systemd_loglevel <= 7))
-            snprintf(buffer_priority, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "%s:", systemd_log_levels[systemd_loglevel]);
-        else
-            snprintf(buffer_priority, DLT_SYSTEM_JOURNAL_BUFFER_SIZE, "prio_unknown:");
-
-        /* write log entry */
-        if (config->Journal.UseOriginalTimestamp == 0) {
-            DLT_LOG(journalContext, loglevel,
-                    DLT_STRING(timestamp.real),
-                    DLT_STRING(timestamp.monotonic),
-                    DLT_STRING(buffer_process),
-                    DLT_STRING(buffer_priority),
-                    DLT_STRING(buffer_message)
-                    );
+        if (config->Journal.BatchSize > 0) {
+            dlt_system_journal_batch_add(&batch, &entry, loglevel, config);
 
+            if (batch.active && (batch.count >= config->Journal.BatchSize)) {
+                dlt_system_journal_batch_flush(&batch);
+                dlt_system_journal_save_cursor(j, config);
+            }
         }
         else {
-            /* since we are talking about points in time, I'd prefer truncating over arithmetic rounding */
-            ts = (uint32_t)(atof(timestamp.monotonic) * 10000);
-            DLT_LOG_TS(journalContext, loglevel, ts,
-                        DLT_STRING(timestamp.real),
-                        DLT_STRING(buffer_process),
-                        DLT_STRING(buffer_priority),
-                        DLT_STRING(buffer_message)
-                        );
-        }
+            dlt_system_journal_log_entry(&entry, loglevel, config);
 
-        if (journal_checkUserBufferForFreeSpace() == -1) {
-            /* buffer is nearly full */
-            /* wait 500ms for writing next entry */
-            struct timespec t;
-            t.tv_sec = 0;
-            t.tv_nsec = 1000000ul * 500;
-            nanosleep(&t, NULL);
+            if (journal_checkUserBufferForFreeSpace() == -1) {
+                /* buffer is nearly full */
+                dlt_system_journal_save_cursor(j, config);
+                dlt_system_journal_wait_for_buffer();
+            }
         }
     }
 }
@@ -351,7 +524,10 @@ void register_journal_fd(sd_journal **j, struct pollfd *pollfd, int i,  DltSyste
         }
     }
 
-    if (config->Journal.Follow) {
+    if (dlt_system_journal_restore_cursor(j_tmp, config)) {
+        /* continue after the last logged entry */
+    }
+    else if (config->Journal.Follow) {
         /* show only last 10 entries and follow */
         r = sd_journal_seek_tail(j_tmp);
         if (r < 0) {
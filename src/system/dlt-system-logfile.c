@@ -45,18 +45,55 @@
 
 
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
 #include "dlt-system.h"
 
 /* Modes of sending */
 #define SEND_MODE_OFF  0
 #define SEND_MODE_ONCE 1
 #define SEND_MODE_ON   2
+#define SEND_MODE_TAIL 3
+
+/* Lines longer than this are sent in several messages. Shorter lines are
+ * sent together, as many as fit into one message. */
+#define TAIL_LINE_MAX 1024
+/* Size of a line argument without the line: type info, length, terminating zero */
+#define TAIL_LINE_ARG_SIZE (sizeof(uint32_t) + sizeof(uint16_t) + 1)
+/* Size of the reads of appended data and of inotify events */
+#define TAIL_READ_SIZE 4096
+/* Free space in percent of the user buffer to wait for when it is nearly full */
+#define TAIL_FREE_PERCENT 50
+/* Maximum time to wait for free space in the user buffer in ms */
+#define TAIL_WAIT_TIMEOUT 500
+
+/* State of a file followed in tail mode */
+typedef struct {
+    int fd;                     /* open file, -1 if none */
+    int wd;                     /* inotify watch of the file, -1 if none */
+    dev_t dev;                  /* device of the open file */
+    ino_t inode;                /* inode of the open file */
+    off_t offset;               /* offset of the next read */
+    char line[TAIL_LINE_MAX];   /* start of a line not yet terminated */
+    size_t line_length;         /* length of line */
+    DltContextData log;         /* message collecting the sent lines */
+    int batched;                /* log is started and holds lines */
+    int restored;               /* offset was read from the state file */
+} LogFileTail;
 
 DLT_IMPORT_CONTEXT(dltsystem)
 
 DltContext logfileContext[DLT_SYSTEM_LOG_FILE_MAX];
 int logfile_delays[DLT_SYSTEM_LOG_FILE_MAX];
 
+static LogFileTail logfileTails[DLT_SYSTEM_LOG_FILE_MAX];
+static int logfileInotify = -1;
+static int logfileTailDirty = 0;
+
 void send_file(LogFileOptions const *fileopt, int n)
 {
     DLT_LOG(dltsystem, DLT_LOG_DEBUG,
@@ -96,6 +133,300 @@ void send_file(LogFileOptions const *fileopt, int n)
     }
 }
 
+/* Wait until the daemon has taken messages from the nearly full user buffer */
+static void logfile_tail_wait_for_buffer(void)
+{
+    int total_size, used_size;
+
+    dlt_user_check_buffer(&total_size, &used_size);
+
+    if ((total_size - used_size) < (total_size / 2))
+        dlt_user_wait_for_buffer(TAIL_FREE_PERCENT, TAIL_WAIT_TIMEOUT);
+}
+
+/* Send the message collecting the lines of a tailed file */
+static void logfile_tail_flush(int n)
+{
+    LogFileTail *tail = &logfileTails[n];
+
+    if (!tail->batched)
+        return;
+
+    dlt_user_log_write_finish(&tail->log);
+    tail->batched = 0;
+}
+
+/* Add the collected line of a tailed file to the message being built.
+ * A line which does not fit any more goes into a new message. */
+static void logfile_tail_send_line(int n)
+{
+    LogFileTail *tail = &logfileTails[n];
+    int32_t size;
+    int32_t args_num;
+
+    if ((tail->line_length > 0) && (tail->line[tail->line_length - 1] == '\r'))
+        tail->line_length--;
+
+    if (tail->line_length == 0)
+        return;
+
+    if (tail->batched &&
+        ((size_t)tail->log.size + TAIL_LINE_ARG_SIZE + tail->line_length > DLT_USER_BUF_MAX_SIZE))
+        logfile_tail_flush(n);
+
+    if (tail->batched) {
+        size = tail->log.size;
+        args_num = tail->log.args_num;
+
+        if (dlt_user_log_write_sized_string(&tail->log, tail->line, (uint16_t)tail->line_length) !=
+            DLT_RETURN_USER_BUFFER_FULL) {
+            tail->line_length = 0;
+            return;
+        }
+
+        /* the user buffer is configured smaller, drop the truncated copy */
+        tail->log.size = size;
+        tail->log.args_num = args_num;
+        logfile_tail_flush(n);
+    }
+
+    logfile_tail_wait_for_buffer();
+
+    if (dlt_user_log_write_start(&logfileContext[n], &tail->log, DLT_LOG_INFO) == DLT_RETURN_TRUE) {
+        dlt_user_log_write_sized_string(&tail->log, tail->line, (uint16_t)tail->line_length);
+        tail->batched = 1;
+    }
+
+    tail->line_length = 0;
+}
+
+/* Read the data appended to a tailed file and send its lines, several per
+ * message. A line which is not terminated yet is kept until the rest arrives. */
+static void logfile_tail_read(int n)
+{
+    LogFileTail *tail = &logfileTails[n];
+    char buffer[TAIL_READ_SIZE];
+    const char *p, *end, *newline;
+    size_t length;
+    ssize_t bytes;
+
+    if (tail->fd < 0)
+        return;
+
+    while ((bytes = pread(tail->fd, buffer, sizeof(buffer), tail->offset)) > 0) {
+        tail->offset += bytes;
+        logfileTailDirty = 1;
+
+        for (p = buffer, end = buffer + bytes; p < end; p += length) {
+            newline = memchr(p, '\n', (size_t)(end - p));
+            length = (size_t)(((newline != NULL) ? newline : end) - p);
+
+            if (length > TAIL_LINE_MAX - tail->line_length)
+                length = TAIL_LINE_MAX - tail->line_length;
+
+            memcpy(tail->line + tail->line_length, p, length);
+            tail->line_length += length;
+
+            if ((newline != NULL) && (p + length == newline)) {
+                logfile_tail_send_line(n);
+                length++;
+            }
+            else if (tail->line_length == TAIL_LINE_MAX) {
+                logfile_tail_send_line(n);
+            }
+        }
+    }
+
+    logfile_tail_flush(n);
+
+    if ((bytes < 0) && (errno != EINTR))
+        DLT_LOG(dltsystem, DLT_LOG_WARN,
+                DLT_STRING("dlt-system-logfile, failed to read file."),
+                DLT_STRING(strerror(errno)));
+}
+
+static void logfile_tail_close(int n)
+{
+    LogFileTail *tail = &logfileTails[n];
+    int i;
+
+    logfile_tail_flush(n);
+
+    if (tail->wd >= 0) {
+        /* the watch is shared if the same file is configured twice */
+        for (i = 0; i < DLT_SYSTEM_LOG_FILE_MAX; i++)
+            if ((i != n) && (logfileTails[i].wd == tail->wd))
+                break;
+
+        if (i == DLT_SYSTEM_LOG_FILE_MAX)
+            inotify_rm_watch(logfileInotify, tail->wd);
+    }
+
+    if (tail->fd >= 0)
+        close(tail->fd);
+
+    tail->fd = -1;
+    tail->wd = -1;
+}
+
+/* Open a file to tail. A file seen for the first time is followed from its
+ * end, a file reopened after rotation from its start. */
+static void logfile_tail_open(LogFileOptions const *fileopts, int n, int from_start)
+{
+    LogFileTail *tail = &logfileTails[n];
+    struct stat st;
+
+    tail->fd = open(fileopts->Filename[n], O_RDONLY | O_CLOEXEC);
+
+    if (tail->fd < 0)
+        return;
+
+    if (fstat(tail->fd, &st) < 0) {
+        close(tail->fd);
+        tail->fd = -1;
+        return;
+    }
+
+    if (tail->restored && (tail->inode == st.st_ino) && (tail->dev == st.st_dev) &&
+        (tail->offset <= st.st_size))
+        ; /* resume after the data sent before the restart */
+    else if (tail->restored || from_start)
+        tail->offset = 0;
+    else
+        tail->offset = st.st_size;
+
+    tail->restored = 0;
+    tail->dev = st.st_dev;
+    tail->inode = st.st_ino;
+    tail->line_length = 0;
+    logfileTailDirty = 1;
+
+    if (logfileInotify >= 0)
+        tail->wd = inotify_add_watch(logfileInotify, fileopts->Filename[n],
+                                     IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF | IN_ATTRIB);
+}
+
+/* Send what was appended to a tailed file and follow it if it was
+ * rotated: a new inode behind the name or a size below the read offset. */
+static void logfile_tail_check(LogFileOptions const *fileopts, int n)
+{
+    LogFileTail *tail = &logfileTails[n];
+    struct stat st;
+
+    if (tail->fd >= 0) {
+        if ((fstat(tail->fd, &st) == 0) && (st.st_size < tail->offset)) {
+            /* truncated in place */
+            logfile_tail_send_line(n);
+            tail->offset = 0;
+            logfileTailDirty = 1;
+        }
+
+        logfile_tail_read(n);
+    }
+
+    /* a moved or deleted file stays open until its name is used again */
+    if (stat(fileopts->Filename[n], &st) < 0)
+        return;
+
+    if ((tail->fd < 0) || (st.st_ino != tail->inode) || (st.st_dev != tail->dev)) {
+        if (tail->fd >= 0) {
+            logfile_tail_send_line(n);
+            logfile_tail_close(n);
+            logfile_tail_open(fileopts, n, 1);
+        }
+        else {
+            logfile_tail_open(fileopts, n, 0);
+        }
+
+        logfile_tail_read(n);
+    }
+}
+
+/* Read the offsets stored by logfile_tail_save(), one line per file:
+ * device, inode, offset, file name */
+static void logfile_tail_restore(LogFileOptions const *fileopts)
+{
+    char line[PATH_MAX + 64];
+    char *name;
+    unsigned long long dev, inode;
+    long long offset;
+    int chars, i;
+    FILE *file;
+
+    if (fileopts->TailStateFile == NULL)
+        return;
+
+    file = fopen(fileopts->TailStateFile, "r");
+
+    if (file == NULL)
+        return;
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\n")] = 0;
+
+        if (sscanf(line, "%llu %llu %lld %n", &dev, &inode, &offset, &chars) < 3)
+            continue;
+
+        name = line + chars;
+
+        for (i = 0; i < fileopts->Count; i++)
+            if ((fileopts->Mode[i] == SEND_MODE_TAIL) && (strcmp(fileopts->Filename[i], name) == 0)) {
+                logfileTails[i].dev = (dev_t)dev;
+                logfileTails[i].inode = (ino_t)inode;
+                logfileTails[i].offset = (off_t)offset;
+                logfileTails[i].restored = 1;
+            }
+    }
+
+    fclose(file);
+}
+
+/* Store the offset up to which each tailed file was sent */
+static void logfile_tail_save(LogFileOptions const *fileopts)
+{
+    char tmp_file[PATH_MAX];
+    FILE *file;
+    int i, r = 0;
+
+    if ((fileopts->TailStateFile == NULL) || !logfileTailDirty)
+        return;
+
+    /* replace the file at once, a crash leaves the old or the new offsets */
+    snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", fileopts->TailStateFile);
+    file = fopen(tmp_file, "w");
+
+    if (file == NULL) {
+        DLT_LOG(dltsystem, DLT_LOG_WARN,
+                DLT_STRING("dlt-system-logfile, failed to store offsets in"),
+                DLT_STRING(fileopts->TailStateFile));
+        return;
+    }
+
+    /* an unterminated line is sent again after a restart */
+    for (i = 0; i < fileopts->Count; i++)
+        if ((fileopts->Mode[i] == SEND_MODE_TAIL) && (logfileTails[i].fd >= 0) && (r >= 0))
+            r = fprintf(file, "%llu %llu %lld %s\n",
+                        (unsigned long long)logfileTails[i].dev,
+                        (unsigned long long)logfileTails[i].inode,
+                        (long long)(logfileTails[i].offset - (off_t)logfileTails[i].line_length),
+                        fileopts->Filename[i]);
+
+    if ((fclose(file) == 0) && (r >= 0))
+        r = rename(tmp_file, fileopts->TailStateFile);
+    else
+        r = -1;
+
+    if (r < 0) {
+        unlink(tmp_file);
+        DLT_LOG(dltsystem, DLT_LOG_WARN,
+                DLT_STRING("dlt-system-logfile, failed to store offsets in"),
+                DLT_STRING(fileopts->TailStateFile));
+        return;
+    }
+
+    logfileTailDirty = 0;
+}
+
 void register_contexts(LogFileOptions const *fileopts)
 {
     DLT_LOG(dltsystem, DLT_LOG_DEBUG,
@@ -115,10 +446,47 @@ void logfile_init(void *v_conf)
 
     register_contexts(&(conf->LogFile));
 
+    for (int i = 0; i < DLT_SYSTEM_LOG_FILE_MAX; i++) {
+        logfileTails[i].fd = -1;
+        logfileTails[i].wd = -1;
+    }
+
     for (int i = 0; i < conf->LogFile.Count; i++)
         logfile_delays[i] = conf->LogFile.TimeDelay[i];
 }
 
+int register_logfile_fd(struct pollfd *pollfd, int i, DltSystemConfiguration *config)
+{
+    int n, tail_count = 0;
+
+    for (n = 0; n < config->LogFile.Count; n++)
+        if (config->LogFile.Mode[n] == SEND_MODE_TAIL)
+            tail_count++;
+
+    if (tail_count == 0)
+        return -1;
+
+    logfileInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (logfileInotify < 0) {
+        DLT_LOG(dltsystem, DLT_LOG_ERROR,
+                DLT_STRING("dlt-system-logfile, failed to init inotify, files are tailed once per second."));
+    }
+
+    logfile_tail_restore(&(config->LogFile));
+
+    for (n = 0; n < config->LogFile.Count; n++)
+        if (config->LogFile.Mode[n] == SEND_MODE_TAIL)
+            logfile_tail_check(&(config->LogFile), n);
+
+    if (logfileInotify < 0)
+        return -1;
+
+    pollfd[i].fd = logfileInotify;
+    pollfd[i].events = POLLIN;
+    return logfileInotify;
+}
+
 void logfile_fd_handler(void *v_conf)
 {
     DltSystemConfiguration *conf = (DltSystemConfiguration *)v_conf;
@@ -126,6 +494,12 @@ void logfile_fd_handler(void *v_conf)
         if (conf->LogFile.Mode[i] == SEND_MODE_OFF)
             continue;
 
+        /* catches files which were created again after a rotation */
+        if (conf->LogFile.Mode[i] == SEND_MODE_TAIL) {
+            logfile_tail_check(&(conf->LogFile), i);
+            continue;
+        }
+
         if (logfile_delays[i] <= 0) {
             send_file(&(conf->LogFile), i);
             logfile_delays[i] = conf->LogFile.TimeDelay[i];
@@ -137,5 +511,58 @@ void logfile_fd_handler(void *v_conf)
             logfile_delays[i]--;
         }
     }
+
+    logfile_tail_save(&(conf->LogFile));
+}
+
+void logfile_tail_fd_handler(void *v_conf)
+{
+    DltSystemConfiguration *conf = (DltSystemConfiguration *)v_conf;
+    char buffer[TAIL_READ_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct inotify_event *event;
+    int changed[DLT_SYSTEM_LOG_FILE_MAX] = { 0 };
+    ssize_t bytes;
+    char *p;
+    int i;
+
+    while ((bytes = read(logfileInotify, buffer, sizeof(buffer))) > 0) {
+        for (p = buffer; p < buffer + bytes; p += sizeof(struct inotify_event) + event->len) {
+            event = (struct inotify_event *)p;
+
+            for (i = 0; i < conf->LogFile.Count; i++) {
+                if (event->mask & IN_Q_OVERFLOW)
+                    changed[i] = 1;
+                else if (logfileTails[i].wd == event->wd)
+                    changed[i] = 1;
+
+                /* the file was deleted, its watch is gone */
+                if ((event->mask & IN_IGNORED) && (logfileTails[i].wd == event->wd))
+                    logfileTails[i].wd = -1;
+            }
+        }
+    }
+
+    for (i = 0; i < conf->LogFile.Count; i++)
+        if (changed[i] && (conf->LogFile.Mode[i] == SEND_MODE_TAIL))
+            logfile_tail_check(&(conf->LogFile), i);
 }
 
+void logfile_cleanup(void *v_conf)
+{
+    DltSystemConfiguration *conf = (DltSystemConfiguration *)v_conf;
+
+    for (int i = 0; i < conf->LogFile.Count; i++)
+        if ((conf->LogFile.Mode[i] == SEND_MODE_TAIL) && (logfileTails[i].fd >= 0))
+            logfile_tail_read(i);
+
+    logfile_tail_save(&(conf->LogFile));
+
+    for (int i = 0; i < conf->LogFile.Count; i++)
+        if (logfileTails[i].fd >= 0) {
+            close(logfileTails[i].fd);
+            logfileTails[i].fd = -1;
+        }
+
+    /* the inotify descriptor is closed with the other polled descriptors */
+    logfileInotify = -1;
+}
@@ -141,6 +141,10 @@ void init_configuration(DltSystemConfiguration *config)
     config->Syslog.Enable = 0;
     strncpy(config->Syslog.ContextId, "SYSL", DLT_ID_SIZE);
     config->Syslog.Port = 47111;
+    config->Syslog.BatchSize = 32;
+    config->Syslog.MapLogLevels = 1;
+    config->Syslog.UseOriginalTimestamp = 1;
+    config->Syslog.TagContexts = 0;
 
     /* Journal */
     config->Journal.Enable = 0;
@@ -149,6 +153,8 @@ void init_configuration(DltSystemConfiguration *config)
     config->Journal.Follow = 0;
     config->Journal.MapLogLevels = 1;
     config->Journal.UseOriginalTimestamp = 1;
+    config->Journal.BatchSize = 0;
+    config->Journal.CursorFile = NULL;
 
     /* File transfer */
     config->Filetransfer.Enable = 0;
@@ -174,6 +180,8 @@ void init_configuration(DltSystemConfiguration *config)
         config->LogFile.TimeDelay[i] = 0;
     }
 
+    config->LogFile.TailStateFile = NULL;
+
     /* Log process */
     config->LogProcesses.Enable = 0;
     strncpy(config->LogProcesses.ContextId, "PROC", DLT_ID_SIZE);
@@ -261,6 +269,22 @@ int read_configuration_file(DltSystemConfiguration *config, char *file_name)
             {
                 config->Syslog.Port = atoi(value);
             }
+            else if (strcmp(token, "SyslogBatchSize") == 0)
+            {
+                config->Syslog.BatchSize = atoi(value);
+            }
+            else if (strcmp(token, "SyslogMapLogLevels") == 0)
+            {
+                config->Syslog.MapLogLevels = atoi(value);
+            }
+            else if (strcmp(token, "SyslogUseOriginalTimestamp") == 0)
+            {
+                config->Syslog.UseOriginalTimestamp = atoi(value);
+            }
+            else if (strcmp(token, "SyslogTagContexts") == 0)
+            {
+                config->Syslog.TagContexts = atoi(value);
+            }
 
             /* Journal */
             else if (strcmp(token, "JournalEnable") == 0)
@@ -287,6 +311,17 @@ int read_configuration_file(DltSystemConfiguration *config, char *file_name)
             {
                 config->Journal.UseOriginalTimestamp = atoi(value);
             }
+            else if (strcmp(token, "JournalBatchSize") == 0)
+            {
+                config->Journal.BatchSize = atoi(value);
+            }
+            else if (strcmp(token, "JournalCursorFile") == 0)
+            {
+                free(config->Journal.CursorFile);
+                config->Journal.CursorFile = malloc(strlen(value) + 1);
+                MALLOC_ASSERT(config->Journal.CursorFile);
+                strcpy(config->Journal.CursorFile, value); /* strcpy unritical here, because size matches exactly the size to be copied */
+            }
 
             /* File transfer */
             else if (strcmp(token, "FiletransferEnable") == 0)
@@ -350,6 +385,13 @@ int read_configuration_file(DltSystemConfiguration *config, char *file_name)
             {
                 config->LogFile.TimeDelay[config->LogFile.Count] = atoi(value);
             }
+            else if (strcmp(token, "LogFileTailStateFile") == 0)
+            {
+                free(config->LogFile.TailStateFile);
+                config->LogFile.TailStateFile = malloc(strlen(value) + 1);
+                MALLOC_ASSERT(config->LogFile.TailStateFile);
+                strcpy(config->LogFile.TailStateFile, value); /* strcpy unritical here, because size matches exactly the size to be copied */
+            }
             else if (strcmp(token, "LogFileContextId") == 0)
             {
                 strncpy(config->LogFile.ContextId[config->LogFile.Count], value, DLT_ID_SIZE);
@@ -425,6 +467,13 @@ void cleanup_config(DltSystemConfiguration *config, DltSystemCliOptions *options
         options->ConfigurationFileName = NULL;
     }
 
+    /* Journal */
+    if ((config->Journal.CursorFile) != NULL)
+    {
+        free(config->Journal.CursorFile);
+        config->Journal.CursorFile = NULL;
+    }
+
     /* File transfer */
     for(int i = 0 ; i < DLT_SYSTEM_LOG_DIRS_MAX ; i++)
     {
@@ -445,6 +494,12 @@ void cleanup_config(DltSystemConfiguration *config, DltSystemCliOptions *options
         }
     }
 
+    if ((config->LogFile.TailStateFile) != NULL)
+    {
+        free(config->LogFile.TailStateFile);
+        config->LogFile.TailStateFile = NULL;
+    }
+
     /* Log Processes */
     for(int i = 0 ; i < DLT_SYSTEM_LOG_PROCESSES_MAX ; i++)
     {
@@ -124,8 +124,10 @@ int daemonize()
 void cleanup_processes(struct pollfd *pollfd, sd_journal *j, DltSystemConfiguration *config)
 {
     //Syslog cleanup
-    if (config->Syslog.Enable)
+    if (config->Syslog.Enable) {
+        syslog_cleanup();
         DLT_UNREGISTER_CONTEXT(syslogContext);
+    }
     
     //Journal cleanup
 #if defined(DLT_SYSTEMD_JOURNAL_ENABLE)
@@ -137,6 +139,7 @@ void cleanup_processes(struct pollfd *pollfd, sd_journal *j, DltSystemConfigurat
 
     //Logfile cleanup 
     if (config->LogFile.Enable) {
+        logfile_cleanup(config);
         for (int i = 0; i < config->LogFile.Count; i++)
             DLT_UNREGISTER_CONTEXT(logfileContext[i]);
     }
@@ -232,6 +235,12 @@ void start_dlt_system_processes(DltSystemConfiguration *config)
             if(config->LogFile.Enable)
                 logfile_init(config);
             fdcnt++;
+
+            //init FD for LogFile in tail mode
+            if (config->LogFile.Enable && (register_logfile_fd(pollfd, fdcnt, config) >= 0)) {
+                fdType[fdcnt] = fdType_logfile;
+                fdcnt++;
+            }
         }
     }
 
@@ -286,6 +295,9 @@ void start_dlt_system_processes(DltSystemConfiguration *config)
                 else if (fdType[i] == fdType_timer) {
                     timer_fd_handler(pollfd[i].fd, config);
                 }
+                else if (fdType[i] == fdType_logfile) {
+                    logfile_tail_fd_handler(config);
+                }
                 #if defined(DLT_SYSTEMD_JOURNAL_ENABLE)
                 else if((fdType[i] == fdType_journal) && (j != NULL)) {
                     if(sd_journal_process(j) == SD_JOURNAL_APPEND) {
@@ -48,16 +48,26 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
 
 #include <systemd/sd-journal.h>
 #include <poll.h>
 
 #include "dlt-system.h"
+#include "dlt_syslog_forward.h"
 
 DLT_IMPORT_CONTEXT(dltsystem)
 DLT_DECLARE_CONTEXT(syslogContext)
 #define RECV_BUF_SZ 1024
+/* Max number of datagrams read per wake-up */
+#define DLT_SYSTEM_SYSLOG_MAX_BATCH 256
+
+static SyslogOptions syslogOptions;
+static struct mmsghdr *syslogMsgs = NULL;
+static struct iovec *syslogIovecs = NULL;
+static char *syslogBuffers = NULL;
+static DltSyslogForward syslogForward;
 
 int init_socket(SyslogOptions opts)
 {
@@ -113,15 +123,14 @@ int read_socket(int sock)
 {
     DLT_LOG(dltsystem, DLT_LOG_DEBUG,
             DLT_STRING("dlt-system-syslog, read socket"));
-    char recv_data[RECV_BUF_SZ];
-    struct sockaddr_in client_addr;
-    socklen_t addr_len = sizeof(struct sockaddr_in);
+    int count;
+    int i;
 
-    int bytes_read = recvfrom(sock, recv_data, RECV_BUF_SZ, 0,
-                              (struct sockaddr *)&client_addr, &addr_len);
+    /* take all datagrams queued up to the batch size with one call */
+    count = recvmmsg(sock, syslogMsgs, (unsigned int)syslogOptions.BatchSize, MSG_DONTWAIT, NULL);
 
-    if (bytes_read == -1) {
-        if (errno == EINTR) {
+    if (count == -1) {
+        if ((errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK)) {
             return 0;
         }
         else {
@@ -131,19 +140,52 @@ int read_socket(int sock)
         }
     }
 
-    recv_data[bytes_read] = '\0';
-
-    if (bytes_read != 0)
-    {
-        DLT_LOG(syslogContext, DLT_LOG_INFO, DLT_STRING(recv_data));
-    }
+    for (i = 0; i < count; i++)
+        if (syslogMsgs[i].msg_len != 0)
+            dlt_syslog_forward_log(&syslogForward,
+                                   syslogBuffers + (size_t)i * RECV_BUF_SZ,
+                                   (int)syslogMsgs[i].msg_len);
 
-    return bytes_read;
+    return count;
 }
 
 int register_syslog_fd(struct pollfd *pollfd, int i, DltSystemConfiguration *config)
 {
     DLT_REGISTER_CONTEXT(syslogContext, config->Syslog.ContextId, "SYSLOG Adapter");
+    int j;
+
+    syslogOptions = config->Syslog;
+
+    if (syslogOptions.BatchSize < 1)
+        syslogOptions.BatchSize = 1;
+    else if (syslogOptions.BatchSize > DLT_SYSTEM_SYSLOG_MAX_BATCH)
+        syslogOptions.BatchSize = DLT_SYSTEM_SYSLOG_MAX_BATCH;
+
+    if (syslogOptions.TagContexts > DLT_SYSLOG_FORWARD_MAX_CONTEXTS)
+        syslogOptions.TagContexts = DLT_SYSLOG_FORWARD_MAX_CONTEXTS;
+
+    dlt_syslog_forward_init(&syslogForward, &syslogContext, "SYSLOG", DLT_LOG_INFO);
+    syslogForward.map_levels = syslogOptions.MapLogLevels;
+    syslogForward.use_timestamp = syslogOptions.UseOriginalTimestamp;
+    syslogForward.max_contexts = syslogOptions.TagContexts;
+
+    syslogMsgs = calloc((size_t)syslogOptions.BatchSize, sizeof(struct mmsghdr));
+    syslogIovecs = calloc((size_t)syslogOptions.BatchSize, sizeof(struct iovec));
+    syslogBuffers = malloc((size_t)syslogOptions.BatchSize * RECV_BUF_SZ);
+
+    if ((syslogMsgs == NULL) || (syslogIovecs == NULL) || (syslogBuffers == NULL)) {
+        DLT_LOG(dltsystem, DLT_LOG_ERROR, DLT_STRING("Could not allocate syslog buffers\n"));
+        syslog_cleanup();
+        return -1;
+    }
+
+    for (j = 0; j < syslogOptions.BatchSize; j++) {
+        syslogIovecs[j].iov_base = syslogBuffers + (size_t)j * RECV_BUF_SZ;
+        syslogIovecs[j].iov_len = RECV_BUF_SZ;
+        syslogMsgs[j].msg_hdr.msg_iov = &syslogIovecs[j];
+        syslogMsgs[j].msg_hdr.msg_iovlen = 1;
+    }
+
     int syslogSock = init_socket(config->Syslog);
     if (syslogSock < 0) {
         DLT_LOG(dltsystem, DLT_LOG_ERROR, DLT_STRING("Could not init syslog socket\n"));
@@ -157,4 +199,16 @@ int register_syslog_fd(struct pollfd *pollfd, int i, DltSystemConfiguration *con
 void syslog_fd_handler(int syslogSock)
 {
     read_socket(syslogSock);
-}
\ No newline at end of file
+}
+
+void syslog_cleanup(void)
+{
+    dlt_syslog_forward_free(&syslogForward);
+
+    free(syslogMsgs);
+    free(syslogIovecs);
+    free(syslogBuffers);
+    syslogMsgs = NULL;
+    syslogIovecs = NULL;
+    syslogBuffers = NULL;
+}
@@ -77,10 +77,11 @@
 *   - Journal file descriptor
 *   - Syslog file descriptor
 *   - Timer file descriptor for processing LogFile and LogProcesses every second
+*   - Inotify file descriptor for LogFile in tail mode
 *   - Inotify file descriptor for FileTransfer
 *   - Timer file descriptor for Watchdog 
 */
-#define MAX_FD_NUMBER   5
+#define MAX_FD_NUMBER   6
 
 /* Macros */
 #define MALLOC_ASSERT(x) if (x == NULL) { \
@@ -94,6 +95,7 @@ enum fdType {
     fdType_filetransfer,
     fdType_timer,
     fdType_watchdog,
+    fdType_logfile,
 };
 
 /**
@@ -117,6 +119,10 @@ typedef struct {
     int Enable;
     char ContextId[DLT_ID_SIZE];
     int Port;
+    int BatchSize;
+    int MapLogLevels;
+    int UseOriginalTimestamp;
+    int TagContexts;
 } SyslogOptions;
 
 /* Configuration journal options */
@@ -127,6 +133,8 @@ typedef struct {
     int Follow;
     int MapLogLevels;
     int UseOriginalTimestamp;
+    int BatchSize;
+    char *CursorFile;
 } JournalOptions;
 
 typedef struct {
@@ -156,6 +164,9 @@ typedef struct {
     char *Filename[DLT_SYSTEM_LOG_FILE_MAX];
     int Mode[DLT_SYSTEM_LOG_FILE_MAX];
     int TimeDelay[DLT_SYSTEM_LOG_FILE_MAX];
+
+    /* Offsets of the files in tail mode */
+    char *TailStateFile;
 } LogFileOptions;
 
 typedef struct {
@@ -204,13 +215,19 @@ void logfile_init(void *v_conf);
 void logprocess_init(void *v_conf);
 void register_journal_fd(sd_journal **j, struct pollfd *pollfd, int i,  DltSystemConfiguration *config);
 int register_syslog_fd(struct pollfd *pollfd, int i, DltSystemConfiguration *config);
+int register_logfile_fd(struct pollfd *pollfd, int i, DltSystemConfiguration *config);
 
 /* Routines that are called, when a fd event was raised. */
 void logfile_fd_handler(void *v_conf);
+void logfile_tail_fd_handler(void *v_conf);
 void logprocess_fd_handler(void *v_conf);
 void filetransfer_fd_handler(DltSystemConfiguration *config);
 void watchdog_fd_handler(int fd);
 void journal_fd_handler(sd_journal *j, DltSystemConfiguration *config);
 void syslog_fd_handler(int syslogSock);
 
+/* Cleanup routines. */
+void syslog_cleanup(void);
+void logfile_cleanup(void *v_conf);
+
 #endif /* DLT_SYSTEM_H_ */
@@ -0,0 +1,572 @@
+/*
+ * SPDX license identifier: MPL-2.0
+ *
+ * This file is part of GENIVI Project DLT - Diagnostic Log and Trace.
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License (MPL), v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ * For further information see http://www.genivi.org/.
+ */
+
+/*!
+ * \copyright
+ * License MPL-2.0: Mozilla Public License version 2.0 http://mozilla.org/MPL/2.0/.
+ *
+ * \file dlt-test-throughput.c
+ */
+
+/*
+ * Measures the throughput of a dlt-daemon: several processes, one
+ * application each, log from several threads as fast as possible while a
+ * client connected to the daemon counts the messages it receives.
+ *
+ * Without -d the daemon already running is measured. With -d the given
+ * dlt-daemon is started twice, once with PipelineMode = 0 and once with
+ * PipelineMode = 1, and both results are printed side by side. The
+ * applications connect to the IPC path the library was built with, so no
+ * other dlt-daemon may run at the same time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include "dlt.h"
+#include "dlt_client.h"
+
+#define DLT_TEST_THROUGHPUT_APID_PREFIX   "TP"
+#define DLT_TEST_THROUGHPUT_THREADS_MAX   64
+#define DLT_TEST_THROUGHPUT_PROCESSES_MAX 64
+#define DLT_TEST_THROUGHPUT_INGESTION_MAX 16   /* DLT_DAEMON_INGRESS_MAX_THREADS */
+#define DLT_TEST_THROUGHPUT_IDLE_MS       2000 /* stop when nothing is received for this long */
+#define DLT_TEST_THROUGHPUT_START_MS      5000 /* max time the started daemon takes to listen */
+#define DLT_TEST_THROUGHPUT_MODES         2
+
+typedef struct
+{
+    DltContext context;
+    pthread_t thread;
+    int messages;
+    char *payload;
+} DltTestThroughputThread;
+
+typedef struct
+{
+    int processes;
+    int threads;
+    int messages;
+    int size;
+    char *payload;
+    const char *host;
+    int port;
+} DltTestThroughputParams;
+
+typedef struct
+{
+    const char *name;
+    unsigned long logged;
+    unsigned long received;
+    unsigned long bytes;
+    double duration;
+} DltTestThroughputResult;
+
+static atomic_ulong received_messages;
+static atomic_ulong received_bytes;
+
+/**
+ * Print usage information of tool.
+ */
+static void usage(void)
+{
+    char version[255];
+
+    dlt_get_version(version, 255);
+
+    printf("Usage: dlt-test-throughput [options] [hostname]\n");
+    printf("Measure the throughput of a dlt-daemon.\n");
+    printf("%s \n", version);
+    printf("Options:\n");
+    printf("  -P processes  Number of logging processes, one application each (Default: 1)\n");
+    printf("  -t threads    Number of logging threads per process (Default: 4)\n");
+    printf("  -n messages   Number of messages per thread (Default: 100000)\n");
+    printf("  -s size       Payload size in bytes (Default: 64)\n");
+    printf("  -p port       Daemon port (Default: %d)\n", DLT_DAEMON_TCP_PORT);
+    printf("  -d daemon     Start this dlt-daemon without and with PipelineMode and\n");
+    printf("                compare both, no other dlt-daemon may be running\n");
+    printf("  -i threads    IngestionThreads of the pipelined daemon (Default: processes)\n");
+    printf("  -h            Usage\n");
+}
+
+static double dlt_test_throughput_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int dlt_test_throughput_callback(DltMessage *message, void *data)
+{
+    (void)data;
+
+    if ((message == NULL) || (message->extendedheader == NULL) ||
+        !DLT_IS_HTYP_UEH(message->standardheader->htyp) ||
+        (memcmp(message->extendedheader->apid, DLT_TEST_THROUGHPUT_APID_PREFIX,
+                strlen(DLT_TEST_THROUGHPUT_APID_PREFIX)) != 0))
+        return 0;
+
+    atomic_fetch_add(&received_messages, 1);
+    atomic_fetch_add(&received_bytes, (unsigned long)(message->headersize + message->datasize));
+
+    return 0;
+}
+
+static void *dlt_test_throughput_receive(void *arg)
+{
+    DltClient *client = (DltClient *)arg;
+
+    dlt_client_main_loop(client, NULL, 0);
+
+    return NULL;
+}
+
+static void *dlt_test_throughput_log(void *arg)
+{
+    DltTestThroughputThread *thread = (DltTestThroughputThread *)arg;
+    int i;
+
+    for (i = 0; i < thread->messages; i++)
+        dlt_log_string(&thread->context, DLT_LOG_INFO, thread->payload);
+
+    return NULL;
+}
+
+/* One logging process: registers, reports ready and logs once started */
+static void dlt_test_throughput_produce(DltTestThroughputParams *params,
+                                        int index,
+                                        int ready_fd,
+                                        int start_fd)
+{
+    DltTestThroughputThread threads[DLT_TEST_THROUGHPUT_THREADS_MAX];
+    char apid[DLT_ID_SIZE + 1];
+    char ctid[DLT_ID_SIZE + 1];
+    char c = 0;
+    int i;
+
+    snprintf(apid, sizeof(apid), "%s%02d", DLT_TEST_THROUGHPUT_APID_PREFIX, index);
+    dlt_register_app(apid, "Throughput test");
+
+    for (i = 0; i < params->threads; i++) {
+        snprintf(ctid, sizeof(ctid), "T%03d", i);
+        dlt_register_context(&threads[i].context, ctid, "Throughput test thread");
+        threads[i].messages = params->messages;
+        threads[i].payload = params->payload;
+    }
+
+    /* the start pipe is closed by the parent to start all processes */
+    if ((write(ready_fd, &c, 1) != 1) || (read(start_fd, &c, 1) < 0))
+        fprintf(stderr, "ERROR: Cannot synchronize process %d\n", index);
+
+    for (i = 0; i < params->threads; i++)
+        pthread_create(&threads[i].thread, NULL, dlt_test_throughput_log, &threads[i]);
+
+    for (i = 0; i < params->threads; i++)
+        pthread_join(threads[i].thread, NULL);
+
+    for (i = 0; i < params->threads; i++)
+        dlt_unregister_context(&threads[i].context);
+
+    dlt_unregister_app_flush_buffered_logs();
+    dlt_free();
+}
+
+/* Wait until a started daemon accepts connections */
+static int dlt_test_throughput_wait_port(int port)
+{
+    struct sockaddr_in addr;
+    double start = dlt_test_throughput_now();
+    int sock;
+    int ret;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    while ((dlt_test_throughput_now() - start) * 1000 < DLT_TEST_THROUGHPUT_START_MS) {
+        sock = socket(AF_INET, SOCK_STREAM, 0);
+
+        if (sock < 0)
+            return -1;
+
+        ret = connect(sock, (struct sockaddr *)&addr, sizeof(addr));
+        close(sock);
+
+        if (ret == 0)
+            return 0;
+
+        usleep(50000);
+    }
+
+    return -1;
+}
+
+static pid_t dlt_test_throughput_start_daemon(const char *daemon,
+                                              const char *config,
+                                              int port,
+                                              int pipelined,
+                                              int ingestion)
+{
+    char port_str[16];
+    FILE *file;
+    pid_t pid;
+
+    file = fopen(config, "w");
+
+    if (file == NULL) {
+        fprintf(stderr, "ERROR: Cannot write %s\n", config);
+        return -1;
+    }
+
+    /* only errors of the daemon are printed */
+    fprintf(file, "LoggingMode = 3\nLoggingLevel = 3\n");
+    fprintf(file, "PipelineMode = %d\nIngestionThreads = %d\n", pipelined, ingestion);
+    fclose(file);
+
+    snprintf(port_str, sizeof(port_str), "%d", port);
+
+    pid = fork();
+
+    if (pid == 0) {
+        execl(daemon, daemon, "-c", config, "-p", port_str, (char *)NULL);
+        fprintf(stderr, "ERROR: Cannot start %s: %s\n", daemon, strerror(errno));
+        _exit(1);
+    }
+
+    if (pid < 0)
+        return -1;
+
+    if (dlt_test_throughput_wait_port(port) != 0) {
+        fprintf(stderr, "ERROR: %s does not listen on port %d\n", daemon, port);
+        kill(pid, SIGTERM);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+
+    return pid;
+}
+
+static void dlt_test_throughput_stop_daemon(pid_t pid)
+{
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+static void dlt_test_throughput_close_pipes(int ready[2], int start_pipe[2])
+{
+    close(ready[0]);
+    close(ready[1]);
+    close(start_pipe[0]);
+    close(start_pipe[1]);
+}
+
+static int dlt_test_throughput_measure(DltTestThroughputParams *params,
+                                       DltTestThroughputResult *result)
+{
+    DltClient client;
+    pthread_t receiver;
+    pid_t pids[DLT_TEST_THROUGHPUT_PROCESSES_MAX];
+    int ready[2];
+    int start_pipe[2];
+    unsigned long last = 0;
+    double start, end, idle;
+    char c;
+    int i;
+
+    atomic_store(&received_messages, 0);
+    atomic_store(&received_bytes, 0);
+
+    if ((pipe(ready) != 0) || (pipe(start_pipe) != 0)) {
+        fprintf(stderr, "ERROR: Cannot create pipes\n");
+        return -1;
+    }
+
+    /* Connect the counting client first */
+    memset(&client, 0, sizeof(DltClient));
+    dlt_client_init_port(&client, params->port, 0);
+    dlt_client_register_message_callback(dlt_test_throughput_callback);
+
+    if (dlt_client_set_server_ip(&client, (char *)params->host) == -1) {
+        fprintf(stderr, "ERROR: Cannot set server ip\n");
+        dlt_test_throughput_close_pipes(ready, start_pipe);
+        return -1;
+    }
+
+    if (dlt_client_connect(&client, 0) == DLT_RETURN_ERROR) {
+        fprintf(stderr, "ERROR: Cannot connect to dlt-daemon\n");
+        dlt_client_cleanup(&client, 0);
+        dlt_test_throughput_close_pipes(ready, start_pipe);
+        return -1;
+    }
+
+    pthread_create(&receiver, NULL, dlt_test_throughput_receive, &client);
+
+    for (i = 0; i < params->processes; i++) {
+        pids[i] = fork();
+
+        if (pids[i] == 0) {
+            close(ready[0]);
+            close(start_pipe[1]);
+            dlt_test_throughput_produce(params, i, ready[1], start_pipe[0]);
+            _exit(0);
+        }
+    }
+
+    close(ready[1]);
+    close(start_pipe[0]);
+
+    /* all applications are registered before the time starts */
+    for (i = 0; i < params->processes; i++)
+        if ((pids[i] > 0) && (read(ready[0], &c, 1) != 1))
+            break;
+
+    start = dlt_test_throughput_now();
+    close(start_pipe[1]);
+
+    for (i = 0; i < params->processes; i++)
+        if (pids[i] > 0)
+            waitpid(pids[i], NULL, 0);
+
+    close(ready[0]);
+
+    /* wait until everything is received or nothing arrives anymore */
+    end = idle = dlt_test_throughput_now();
+    result->logged = (unsigned long)params->processes * (unsigned long)params->threads *
+        (unsigned long)params->messages;
+
+    while (atomic_load(&received_messages) < result->logged) {
+        usleep(10000);
+
+        if (atomic_load(&received_messages) != last) {
+            last = atomic_load(&received_messages);
+            end = idle = dlt_test_throughput_now();
+        }
+        else if ((dlt_test_throughput_now() - idle) * 1000 > DLT_TEST_THROUGHPUT_IDLE_MS) {
+            break;
+        }
+    }
+
+    if (atomic_load(&received_messages) >= result->logged)
+        end = dlt_test_throughput_now();
+
+    shutdown(client.sock, SHUT_RDWR);
+    pthread_join(receiver, NULL);
+    dlt_client_cleanup(&client, 0);
+
+    result->received = atomic_load(&received_messages);
+    result->bytes = atomic_load(&received_bytes);
+    result->duration = end - start;
+
+    return 0;
+}
+
+static void dlt_test_throughput_print(DltTestThroughputParams *params,
+                                      DltTestThroughputResult *results,
+                                      int count)
+{
+    int i;
+
+    printf("Processes:    %d\n", params->processes);
+    printf("Threads:      %d per process\n", params->threads);
+    printf("Payload:      %d bytes\n", params->size);
+    printf("Logged:       %lu messages\n\n", results[0].logged);
+
+    printf("%-14s", "");
+
+    for (i = 0; i < count; i++)
+        printf("%16s", results[i].name);
+
+    printf("\n%-14s", "Received:");
+
+    for (i = 0; i < count; i++)
+        printf("%16lu", results[i].received);
+
+    printf("\n%-14s", "Lost:");
+
+    for (i = 0; i < count; i++)
+        printf("%16lu", results[i].logged - results[i].received);
+
+    printf("\n%-14s", "Duration s:");
+
+    for (i = 0; i < count; i++)
+        printf("%16.3f", results[i].duration);
+
+    printf("\n%-14s", "Messages/s:");
+
+    for (i = 0; i < count; i++)
+        printf("%16.0f", (double)results[i].received / results[i].duration);
+
+    printf("\n%-14s", "MB/s:");
+
+    for (i = 0; i < count; i++)
+        printf("%16.2f", (double)results[i].bytes / results[i].duration / (1024 * 1024));
+
+    printf("\n");
+}
+
+/**
+ * Main function of tool.
+ */
+int main(int argc, char *argv[])
+{
+    DltTestThroughputParams params;
+    DltTestThroughputResult results[DLT_TEST_THROUGHPUT_MODES];
+    char config[] = "/tmp/dlt-test-throughput-XXXXXX";
+    char *daemon = NULL;
+    int ingestion = 0;
+    int count = 0;
+    int ret = 0;
+    int fd;
+    pid_t pid;
+    int c;
+
+    memset(&params, 0, sizeof(params));
+    memset(results, 0, sizeof(results));
+    params.processes = 1;
+    params.threads = 4;
+    params.messages = 100000;
+    params.size = 64;
+    params.port = DLT_DAEMON_TCP_PORT;
+    params.host = "localhost";
+
+    while ((c = getopt(argc, argv, "hP:t:n:s:p:d:i:")) != -1)
+        switch (c) {
+        case 'P':
+        {
+            params.processes = atoi(optarg);
+            break;
+        }
+        case 't':
+        {
+            params.threads = atoi(optarg);
+            break;
+        }
+        case 'n':
+        {
+            params.messages = atoi(optarg);
+            break;
+        }
+        case 's':
+        {
+            params.size = atoi(optarg);
+            break;
+        }
+        case 'p':
+        {
+            params.port = atoi(optarg);
+            break;
+        }
+        case 'd':
+        {
+            daemon = optarg;
+            break;
+        }
+        case 'i':
+        {
+            ingestion = atoi(optarg);
+            break;
+        }
+        case 'h':
+        default:
+        {
+            usage();
+            return -1;
+        }
+        }
+
+    if (ingestion == 0)
+        ingestion = (params.processes < DLT_TEST_THROUGHPUT_INGESTION_MAX) ?
+            params.processes : DLT_TEST_THROUGHPUT_INGESTION_MAX;
+
+    if ((params.processes < 1) || (params.processes > DLT_TEST_THROUGHPUT_PROCESSES_MAX) ||
+        (params.threads < 1) || (params.threads > DLT_TEST_THROUGHPUT_THREADS_MAX) ||
+        (params.messages < 1) || (params.size < 1) ||
+        (ingestion < 1) || (ingestion > DLT_TEST_THROUGHPUT_INGESTION_MAX)) {
+        fprintf(stderr, "ERROR: Invalid arguments\n");
+        usage();
+        return -1;
+    }
+
+    if (optind < argc)
+        params.host = argv[optind];
+
+    params.payload = malloc((size_t)params.size + 1);
+
+    if (params.payload == NULL)
+        return -1;
+
+    memset(params.payload, 'x', (size_t)params.size);
+    params.payload[params.size] = '\0';
+
+    /* the logging processes must not inherit buffered output */
+    fflush(stdout);
+
+    if (daemon == NULL) {
+        results[0].name = "running daemon";
+        ret = dlt_test_throughput_measure(&params, &results[0]);
+        count = 1;
+    }
+    else {
+        fd = mkstemp(config);
+
+        if (fd < 0) {
+            fprintf(stderr, "ERROR: Cannot create configuration file\n");
+            free(params.payload);
+            return -1;
+        }
+
+        close(fd);
+        params.host = "localhost";
+        results[0].name = "PipelineMode=0";
+        results[1].name = "PipelineMode=1";
+
+        for (count = 0; (count < DLT_TEST_THROUGHPUT_MODES) && (ret == 0); count++) {
+            pid = dlt_test_throughput_start_daemon(daemon, config, params.port, count, ingestion);
+
+            if (pid < 0) {
+                ret = -1;
+                break;
+            }
+
+            ret = dlt_test_throughput_measure(&params, &results[count]);
+            dlt_test_throughput_stop_daemon(pid);
+        }
+
+        unlink(config);
+
+        if (count == DLT_TEST_THROUGHPUT_MODES)
+            printf("IngestionThreads: %d in PipelineMode=1\n", ingestion);
+    }
+
+    if (ret == 0)
+        dlt_test_throughput_print(&params, results, count);
+
+    free(params.payload);
+
+    return ret;
+}